@@ -0,0 +1,567 @@
+#include "DataPack.h"
+#include "RegionData.h"
+#include "models/disease/ContactMatrix.h"
+#include "main.h"
+#include "log.h"
+#include <fstream>
+#include <string.h>
+
+// file layout:
+// header: magic[8], version, byte order mark, number of sections, reserved
+// section table: name[32], offset, size (for each section)
+// section data, each aligned to DATA_PACK_ALIGNMENT bytes
+// all values are written in native byte order; packs with a different byte order are rejected and regenerated
+
+#define DATA_PACK_MAGIC "EXDPACK"
+#define DATA_PACK_BYTE_ORDER_MARK 0x01020304
+#define DATA_PACK_SECTION_NAME_LENGTH 32
+#define DATA_PACK_ALIGNMENT 8
+
+struct DataPackHeader
+{
+    char magic[8];
+    quint32 version;
+    quint32 byteOrderMark;
+    quint32 numSections;
+    quint32 reserved;
+};
+
+struct DataPackSection
+{
+    char name[DATA_PACK_SECTION_NAME_LENGTH];
+    quint64 offset;
+    quint64 size;
+};
+
+// contents of a section to write: packed bytes for the small sections; the large population and travel sections
+// are written straight from region data, one row of floats at a time, since a QByteArray is limited to 2 GB and
+// an intermediate copy would double the memory needed for the travel matrix
+struct DataPackSectionContents
+{
+    DataPackSectionContents(std::string name, QByteArray bytes) : name(name), bytes(bytes), rowLength(0) { }
+
+    DataPackSectionContents(std::string name, const std::vector<const float *> &rows, quint64 rowLength) : name(name), rows(rows), rowLength(rowLength) { }
+
+    quint64 getSize() const
+    {
+        if(rows.empty() == true)
+        {
+            return (quint64)bytes.size();
+        }
+
+        return (quint64)rows.size() * rowLength * sizeof(float);
+    }
+
+    std::string name;
+    QByteArray bytes;
+    std::vector<const float *> rows;
+    quint64 rowLength;
+};
+
+// helpers for building sections
+static QByteArray packInts(const std::vector<int> &values)
+{
+    QByteArray bytes;
+
+    for(unsigned int i=0; i<values.size(); i++)
+    {
+        qint32 value = values[i];
+        bytes.append((const char *)&value, sizeof(value));
+    }
+
+    return bytes;
+}
+
+static QByteArray packFloats(const std::vector<float> &values)
+{
+    QByteArray bytes;
+
+    if(values.empty() != true)
+    {
+        bytes.append((const char *)&values[0], values.size() * sizeof(float));
+    }
+
+    return bytes;
+}
+
+static QByteArray packStrings(const std::vector<std::string> &strings)
+{
+    QByteArray bytes;
+
+    quint32 count = strings.size();
+    bytes.append((const char *)&count, sizeof(count));
+
+    for(unsigned int i=0; i<strings.size(); i++)
+    {
+        quint32 length = strings[i].size();
+        bytes.append((const char *)&length, sizeof(length));
+        bytes.append(strings[i].c_str(), length);
+    }
+
+    return bytes;
+}
+
+DataPack::DataPack()
+{
+    data_ = NULL;
+}
+
+DataPack::~DataPack()
+{
+    if(data_ != NULL)
+    {
+        file_.unmap(data_);
+    }
+}
+
+std::string DataPack::getFilename()
+{
+    return g_dataDirectory + "/" + DATA_PACK_FILENAME;
+}
+
+std::vector<std::string> DataPack::getSourceFilenames()
+{
+    std::vector<std::string> filenames;
+
+    filenames.push_back(g_dataDirectory + "/" + STRATIFICATIONS_FILENAME);
+    filenames.push_back(g_dataDirectory + "/fips_county_names_HSRs.csv");
+    filenames.push_back(g_dataDirectory + "/fips_age_group_populations.csv");
+    filenames.push_back(g_dataDirectory + "/age_groups_low_risk_fraction.csv");
+    filenames.push_back(g_dataDirectory + "/county_travel_fractions.csv");
+    filenames.push_back(g_dataDirectory + "/ILI/numCountyProviders.txt");
+    filenames.push_back(g_dataDirectory + "/ILI/providerStartProbabilities.txt");
+    filenames.push_back(g_dataDirectory + "/ILI/providerStopProbabilities.txt");
+    filenames.push_back(g_dataDirectory + "/ILI/providerNoiseData.txt");
+    filenames.push_back(g_dataDirectory + "/" + CONTACT_MATRIX_FILENAME);
+    filenames.push_back(g_dataDirectory + "/" + CONTACT_MATRIX_SUSCEPTIBILITIES_FILENAME);
+
+    return filenames;
+}
+
+bool DataPack::isUpToDate()
+{
+    QFileInfo packInfo(getFilename().c_str());
+
+    if(packInfo.exists() != true)
+    {
+        return false;
+    }
+
+    std::vector<std::string> sourceFilenames = getSourceFilenames();
+
+    for(unsigned int i=0; i<sourceFilenames.size(); i++)
+    {
+        QFileInfo sourceInfo(sourceFilenames[i].c_str());
+
+        if(sourceInfo.exists() == true && sourceInfo.lastModified() > packInfo.lastModified())
+        {
+            put_flog(LOG_INFO, "%s is newer than data pack", sourceFilenames[i].c_str());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+boost::shared_ptr<DataPack> DataPack::open()
+{
+    if(isUpToDate() != true)
+    {
+        return boost::shared_ptr<DataPack>();
+    }
+
+    boost::shared_ptr<DataPack> dataPack(new DataPack());
+
+    dataPack->file_.setFileName(getFilename().c_str());
+
+    if(dataPack->file_.open(QIODevice::ReadOnly) != true)
+    {
+        put_flog(LOG_ERROR, "could not open %s", getFilename().c_str());
+        return boost::shared_ptr<DataPack>();
+    }
+
+    quint64 fileSize = dataPack->file_.size();
+
+    if(fileSize < sizeof(DataPackHeader))
+    {
+        put_flog(LOG_ERROR, "data pack too small");
+        return boost::shared_ptr<DataPack>();
+    }
+
+    dataPack->data_ = dataPack->file_.map(0, fileSize);
+
+    if(dataPack->data_ == NULL)
+    {
+        put_flog(LOG_ERROR, "could not map %s", getFilename().c_str());
+        return boost::shared_ptr<DataPack>();
+    }
+
+    DataPackHeader header;
+    memcpy(&header, dataPack->data_, sizeof(header));
+
+    if(strncmp(header.magic, DATA_PACK_MAGIC, sizeof(header.magic)) != 0 || header.byteOrderMark != DATA_PACK_BYTE_ORDER_MARK)
+    {
+        put_flog(LOG_ERROR, "invalid data pack header");
+        return boost::shared_ptr<DataPack>();
+    }
+
+    if(header.version != DATA_PACK_VERSION)
+    {
+        put_flog(LOG_INFO, "data pack version %i, expected %i", header.version, DATA_PACK_VERSION);
+        return boost::shared_ptr<DataPack>();
+    }
+
+    if(sizeof(DataPackHeader) + header.numSections * sizeof(DataPackSection) > fileSize)
+    {
+        put_flog(LOG_ERROR, "truncated data pack section table");
+        return boost::shared_ptr<DataPack>();
+    }
+
+    for(unsigned int i=0; i<header.numSections; i++)
+    {
+        DataPackSection section;
+        memcpy(&section, dataPack->data_ + sizeof(DataPackHeader) + i * sizeof(DataPackSection), sizeof(section));
+
+        if(section.offset + section.size > fileSize)
+        {
+            put_flog(LOG_ERROR, "truncated data pack section %i", i);
+            return boost::shared_ptr<DataPack>();
+        }
+
+        std::string name(section.name, strnlen(section.name, DATA_PACK_SECTION_NAME_LENGTH));
+
+        dataPack->sections_[name] = std::pair<quint64, quint64>(section.offset, section.size);
+    }
+
+    put_flog(LOG_DEBUG, "mapped data pack with %i sections", header.numSections);
+
+    return dataPack;
+}
+
+bool DataPack::write(std::string filename, const RegionData &regionData)
+{
+    std::vector<DataPackSectionContents> sections;
+
+    // stratifications
+    std::vector<std::vector<std::string> > stratifications = EpidemicDataSet::getStratifications();
+
+    sections.push_back(DataPackSectionContents("stratificationNames", packStrings(EpidemicDataSet::getStratificationNames())));
+
+    for(unsigned int i=0; i<stratifications.size(); i++)
+    {
+        sections.push_back(DataPackSectionContents(std::string("stratifications") + QString::number(i).toStdString(), packStrings(stratifications[i])));
+    }
+
+    // nodes, in index order
+    const std::vector<int> &nodeIds = regionData.getNodeIds();
+
+    std::vector<std::string> nodeNames;
+    std::vector<std::string> nodeGroupNames;
+
+    for(unsigned int i=0; i<nodeIds.size(); i++)
+    {
+        nodeNames.push_back(regionData.getNodeName(nodeIds[i]));
+        nodeGroupNames.push_back(regionData.getNodeGroupName(nodeIds[i]));
+    }
+
+    sections.push_back(DataPackSectionContents("nodeIds", packInts(nodeIds)));
+    sections.push_back(DataPackSectionContents("nodeNames", packStrings(nodeNames)));
+    sections.push_back(DataPackSectionContents("nodeGroupNames", packStrings(nodeGroupNames)));
+
+    // population: [time (extent 1)][node][stratifications...]; copied to guarantee contiguous storage
+    blitz::Array<float, 2+NUM_STRATIFICATION_DIMENSIONS> population = regionData.getPopulation().copy();
+
+    sections.push_back(DataPackSectionContents("population", std::vector<const float *>(1, population.data()), (quint64)population.numElements()));
+
+    // travel: [node][node], one row per node
+    std::vector<const float *> travelRows;
+
+    for(int i=0; i<regionData.getNumNodes(); i++)
+    {
+        travelRows.push_back(regionData.getTravelRow(i));
+    }
+
+    sections.push_back(DataPackSectionContents("travel", travelRows, (quint64)regionData.getNumNodes()));
+
+    // ILI data
+    std::vector<float> numCountyProvidersValues = readValuesFile(g_dataDirectory + "/ILI/numCountyProviders.txt");
+    std::vector<int> numCountyProviders(numCountyProvidersValues.begin(), numCountyProvidersValues.end());
+
+    sections.push_back(DataPackSectionContents("iliNumCountyProviders", packInts(numCountyProviders)));
+    sections.push_back(DataPackSectionContents("iliProviderStartProbabilities", packFloats(readValuesFile(g_dataDirectory + "/ILI/providerStartProbabilities.txt"))));
+    sections.push_back(DataPackSectionContents("iliProviderStopProbabilities", packFloats(readValuesFile(g_dataDirectory + "/ILI/providerStopProbabilities.txt"))));
+    sections.push_back(DataPackSectionContents("iliProviderNoise", packFloats(readValuesFile(g_dataDirectory + "/ILI/providerNoiseData.txt"))));
+
+    // contact data
+    sections.push_back(DataPackSectionContents("contactRates", packFloats(readValuesFile(g_dataDirectory + "/" + CONTACT_MATRIX_FILENAME))));
+    sections.push_back(DataPackSectionContents("susceptibilities", packFloats(readValuesFile(g_dataDirectory + "/" + CONTACT_MATRIX_SUSCEPTIBILITIES_FILENAME))));
+
+    // header and section table
+    DataPackHeader header;
+    memset(&header, 0, sizeof(header));
+    strncpy(header.magic, DATA_PACK_MAGIC, sizeof(header.magic));
+    header.version = DATA_PACK_VERSION;
+    header.byteOrderMark = DATA_PACK_BYTE_ORDER_MARK;
+    header.numSections = sections.size();
+
+    QByteArray table;
+    quint64 offset = sizeof(DataPackHeader) + sections.size() * sizeof(DataPackSection);
+
+    for(unsigned int i=0; i<sections.size(); i++)
+    {
+        offset = (offset + DATA_PACK_ALIGNMENT - 1) / DATA_PACK_ALIGNMENT * DATA_PACK_ALIGNMENT;
+
+        DataPackSection section;
+        memset(&section, 0, sizeof(section));
+        strncpy(section.name, sections[i].name.c_str(), DATA_PACK_SECTION_NAME_LENGTH - 1);
+        section.offset = offset;
+        section.size = sections[i].getSize();
+
+        table.append((const char *)&section, sizeof(section));
+
+        offset += section.size;
+    }
+
+    // write to a temporary file, then move into place so readers never see a partial pack
+    QString tmpFilename = QString(filename.c_str()) + ".tmp";
+
+    QFile file(tmpFilename);
+
+    if(file.open(QIODevice::WriteOnly) != true)
+    {
+        put_flog(LOG_WARN, "could not open %s for writing", tmpFilename.toStdString().c_str());
+        return false;
+    }
+
+    if(file.write((const char *)&header, sizeof(header)) != (qint64)sizeof(header) || file.write(table) != (qint64)table.size())
+    {
+        put_flog(LOG_ERROR, "error writing data pack header");
+        file.remove();
+        return false;
+    }
+
+    for(unsigned int i=0; i<sections.size(); i++)
+    {
+        // padding
+        while(file.pos() % DATA_PACK_ALIGNMENT != 0)
+        {
+            file.putChar(0);
+        }
+
+        bool success = true;
+
+        if(sections[i].rows.empty() == true)
+        {
+            success = (file.write(sections[i].bytes) == (qint64)sections[i].bytes.size());
+        }
+        else
+        {
+            qint64 rowSize = (qint64)(sections[i].rowLength * sizeof(float));
+
+            for(unsigned int r=0; r<sections[i].rows.size() && success == true; r++)
+            {
+                success = (file.write((const char *)sections[i].rows[r], rowSize) == rowSize);
+            }
+        }
+
+        if(success != true)
+        {
+            put_flog(LOG_ERROR, "error writing section %s", sections[i].name.c_str());
+            file.remove();
+            return false;
+        }
+    }
+
+    if(file.flush() != true)
+    {
+        put_flog(LOG_ERROR, "error writing %s", tmpFilename.toStdString().c_str());
+        file.remove();
+        return false;
+    }
+
+    file.close();
+
+    // QFile::rename() does not replace an existing file; keep the previous pack until the new one is in place
+    QString oldFilename = QString(filename.c_str()) + ".old";
+
+    QFile::remove(oldFilename);
+
+    bool hadPack = QFile::exists(filename.c_str());
+
+    if(hadPack == true && QFile::rename(filename.c_str(), oldFilename) != true)
+    {
+        put_flog(LOG_ERROR, "could not replace %s", filename.c_str());
+        QFile::remove(tmpFilename);
+        return false;
+    }
+
+    if(QFile::rename(tmpFilename, filename.c_str()) != true)
+    {
+        put_flog(LOG_ERROR, "could not rename %s to %s", tmpFilename.toStdString().c_str(), filename.c_str());
+
+        if(hadPack == true)
+        {
+            QFile::rename(oldFilename, filename.c_str());
+        }
+
+        QFile::remove(tmpFilename);
+        return false;
+    }
+
+    QFile::remove(oldFilename);
+
+    put_flog(LOG_INFO, "wrote data pack %s", filename.c_str());
+
+    return true;
+}
+
+bool DataPack::update()
+{
+    if(isUpToDate() == true)
+    {
+        return true;
+    }
+
+    return build();
+}
+
+bool DataPack::build()
+{
+    // load the source files even if the pack looks current; the existing pack is only replaced once write()
+    // has succeeded, so a failed build leaves it in place
+    boost::shared_ptr<RegionData> regionData = RegionData::loadFromSourceFiles();
+
+    if(regionData == NULL)
+    {
+        put_flog(LOG_ERROR, "could not load source files");
+        return false;
+    }
+
+    if(write(getFilename(), *regionData) != true)
+    {
+        return false;
+    }
+
+    return isUpToDate();
+}
+
+bool DataPack::hasSection(const std::string &name)
+{
+    return sections_.count(name) != 0;
+}
+
+const float * DataPack::getFloats(const std::string &name, quint64 &count)
+{
+    quint64 size;
+    const uchar * section = getSection(name, size);
+
+    count = size / sizeof(float);
+
+    return (const float *)section;
+}
+
+std::vector<float> DataPack::getFloats(const std::string &name)
+{
+    quint64 count;
+    const float * values = getFloats(name, count);
+
+    if(values == NULL)
+    {
+        return std::vector<float>();
+    }
+
+    return std::vector<float>(values, values + count);
+}
+
+std::vector<int> DataPack::getInts(const std::string &name)
+{
+    quint64 size;
+    const uchar * section = getSection(name, size);
+
+    if(section == NULL)
+    {
+        return std::vector<int>();
+    }
+
+    const qint32 * values = (const qint32 *)section;
+
+    return std::vector<int>(values, values + size / sizeof(qint32));
+}
+
+std::vector<std::string> DataPack::getStrings(const std::string &name)
+{
+    std::vector<std::string> strings;
+
+    quint64 size;
+    const uchar * section = getSection(name, size);
+
+    if(section == NULL || size < sizeof(quint32))
+    {
+        return strings;
+    }
+
+    const uchar * end = section + size;
+
+    quint32 count;
+    memcpy(&count, section, sizeof(count));
+    section += sizeof(count);
+
+    for(unsigned int i=0; i<count; i++)
+    {
+        quint32 length;
+
+        if(section + sizeof(length) > end)
+        {
+            put_flog(LOG_ERROR, "truncated string section %s", name.c_str());
+            return std::vector<std::string>();
+        }
+
+        memcpy(&length, section, sizeof(length));
+        section += sizeof(length);
+
+        if(section + length > end)
+        {
+            put_flog(LOG_ERROR, "truncated string section %s", name.c_str());
+            return std::vector<std::string>();
+        }
+
+        strings.push_back(std::string((const char *)section, length));
+        section += length;
+    }
+
+    return strings;
+}
+
+std::vector<float> DataPack::readValuesFile(std::string filename)
+{
+    std::ifstream ifs(filename.c_str());
+
+    std::vector<float> values;
+
+    float n;
+
+    while(ifs >> n)
+    {
+        values.push_back(n);
+    }
+
+    ifs.close();
+
+    return values;
+}
+
+const uchar * DataPack::getSection(const std::string &name, quint64 &size)
+{
+    if(sections_.count(name) == 0)
+    {
+        put_flog(LOG_ERROR, "no such section %s", name.c_str());
+        size = 0;
+        return NULL;
+    }
+
+    std::pair<quint64, quint64> section = sections_[name];
+
+    size = section.second;
+
+    return data_ + section.first;
+}
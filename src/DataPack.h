@@ -0,0 +1,68 @@
+#ifndef DATA_PACK_H
+#define DATA_PACK_H
+
+// binary data pack containing all startup inputs (stratifications, nodes, population, travel, ILI data, contact data)
+// the pack is memory-mapped; DataPack::update() regenerates it from the source files whenever any of them is newer
+#define DATA_PACK_FILENAME "exercise.datapack"
+
+// must be incremented whenever the pack layout changes
+#define DATA_PACK_VERSION 2
+
+#include <QtCore>
+#include <boost/shared_ptr.hpp>
+#include <map>
+#include <string>
+#include <vector>
+
+class RegionData;
+
+class DataPack
+{
+    public:
+
+        ~DataPack();
+
+        // data pack in the data directory, and the source files it is generated from
+        static std::string getFilename();
+        static std::vector<std::string> getSourceFilenames();
+
+        // true if the data pack exists and is newer than all of its source files
+        static bool isUpToDate();
+
+        // open and map the data pack; returns NULL if it is missing, out of date, or invalid
+        static boost::shared_ptr<DataPack> open();
+
+        // write a data pack using region data loaded from the source files
+        static bool write(std::string filename, const RegionData &regionData);
+
+        // (re)generate the data pack in the data directory from the source files
+        static bool build();
+
+        // build() if the data pack is missing or out of date
+        static bool update();
+
+        bool hasSection(const std::string &name);
+
+        // section contents; pointers reference the mapped file and are valid for the lifetime of this object
+        const float * getFloats(const std::string &name, quint64 &count);
+        std::vector<float> getFloats(const std::string &name);
+        std::vector<int> getInts(const std::string &name);
+        std::vector<std::string> getStrings(const std::string &name);
+
+        // used by the source file fallback path and by build()
+        static std::vector<float> readValuesFile(std::string filename);
+
+    private:
+
+        DataPack();
+
+        QFile file_;
+        uchar * data_;
+
+        // section name -> (offset, size in bytes)
+        std::map<std::string, std::pair<quint64, quint64> > sections_;
+
+        const uchar * getSection(const std::string &name, quint64 &size);
+};
+
+#endif
@@ -0,0 +1,199 @@
+#include "EmulatorWidget.h"
+#include "ParameterEmulator.h"
+#include "Parameters.h"
+#include "EpidemicDataSet.h"
+#include "log.h"
+#include <QElapsedTimer>
+#include <algorithm>
+
+EmulatorWidget::EmulatorWidget(MainWindow * mainWindow)
+{
+    // add toolbar
+    QToolBar * toolbar = addToolBar("toolbar");
+
+    QAction * loadAction = new QAction("Load Emulator...", this);
+    loadAction->setStatusTip(tr("Load an emulator trained by exercise-emulator"));
+    connect(loadAction, SIGNAL(triggered()), this, SLOT(loadEmulator()));
+    toolbar->addAction(loadAction);
+
+    // group combobox, populated when an emulator is loaded
+    connect(&groupComboBox_, SIGNAL(currentIndexChanged(int)), this, SLOT(setGroupChoice(int)));
+    toolbar->addWidget(&groupComboBox_);
+
+    toolbar->addWidget(&statusLabel_);
+
+    setCentralWidget(&chartWidget_);
+
+    // make connections
+    connect((QObject *)mainWindow, SIGNAL(dataSetChanged(boost::shared_ptr<EpidemicDataSet>)), this, SLOT(setDataSet(boost::shared_ptr<EpidemicDataSet>)));
+
+    connect((QObject *)mainWindow, SIGNAL(numberOfTimestepsChanged()), this, SLOT(updateChart()));
+
+    connect(&g_parameters, SIGNAL(changed()), this, SLOT(updateChart()));
+}
+
+void EmulatorWidget::setDataSet(boost::shared_ptr<EpidemicDataSet> dataSet)
+{
+    dataSet_ = dataSet;
+
+    updateChart();
+}
+
+void EmulatorWidget::updateChart()
+{
+    // clear current plots
+    chartWidget_.clear();
+
+    chartWidget_.setTitle("All infected");
+    chartWidget_.setXAxisLabel("Time (days)");
+    chartWidget_.setYAxisLabel("Number of people");
+
+    if(emulator_ != NULL)
+    {
+        QElapsedTimer timer;
+        timer.start();
+
+        std::vector<double> outputs;
+        bool inRange = emulator_->predict(g_parameters, outputs);
+
+        // a group's curve, or the sum over all groups
+        std::vector<double> curve;
+
+        if(groupName_.empty() != true)
+        {
+            curve = emulator_->getCurve(outputs, groupName_);
+        }
+        else
+        {
+            std::vector<std::string> groupNames = emulator_->getCurveGroupNames();
+
+            for(unsigned int g=0; g<groupNames.size(); g++)
+            {
+                std::vector<double> groupCurve = emulator_->getCurve(outputs, groupNames[g]);
+
+                curve.resize(std::max(curve.size(), groupCurve.size()), 0.);
+
+                for(unsigned int t=0; t<groupCurve.size(); t++)
+                {
+                    curve[t] += groupCurve[t];
+                }
+            }
+        }
+
+        qint64 microseconds = timer.nsecsElapsed() / 1000;
+
+        boost::shared_ptr<ChartWidgetLine> line = chartWidget_.getLine();
+        line->setLabel("Emulated");
+        line->setWidth(2.);
+
+        for(unsigned int t=0; t<curve.size(); t++)
+        {
+            line->addPoint(t, curve[t]);
+        }
+
+        QString status = QString("emulated in %1 us").arg(microseconds);
+
+        if(inRange != true)
+        {
+            status += ", outside of the trained range";
+        }
+
+        statusLabel_.setText(status);
+    }
+
+    // the current data set's curve, as far as it has been simulated
+    std::vector<std::string> variableNames;
+
+    if(dataSet_ != NULL)
+    {
+        variableNames = dataSet_->getVariableNames();
+    }
+
+    if(std::find(variableNames.begin(), variableNames.end(), "All infected") != variableNames.end())
+    {
+        boost::shared_ptr<ChartWidgetLine> line = chartWidget_.getLine();
+        line->setLabel("Simulated");
+        line->setColor(0., 0., 0.);
+        line->setWidth(2.);
+
+        for(int t=0; t<dataSet_->getNumTimes(); t++)
+        {
+            if(groupName_.empty() != true)
+            {
+                line->addPoint(t, dataSet_->getValue("All infected", t, groupName_));
+            }
+            else
+            {
+                line->addPoint(t, dataSet_->getValue("All infected", t, NODES_ALL));
+            }
+        }
+    }
+
+    chartWidget_.resetBounds();
+}
+
+void EmulatorWidget::loadEmulator()
+{
+    QString filename = QFileDialog::getOpenFileName(this, "Load Emulator", "", "Emulator files (*.txt);;All files (*)");
+
+    if(filename.isEmpty() == true)
+    {
+        return;
+    }
+
+    boost::shared_ptr<ParameterEmulator> emulator(new ParameterEmulator());
+
+    if(emulator->load(filename.toStdString()) != true)
+    {
+        QMessageBox::warning(this, "Error", "Could not load emulator.", QMessageBox::Ok, QMessageBox::Ok);
+        return;
+    }
+
+    if(emulator->getCurveGroupNames().size() == 0)
+    {
+        QMessageBox::warning(this, "Error", "The emulator has no curves; train it from a sweep run with --curves.", QMessageBox::Ok, QMessageBox::Ok);
+        return;
+    }
+
+    emulator_ = emulator;
+
+    // the parameters it responds to
+    std::vector<std::string> parameterNames = emulator_->getParameterNames();
+
+    QString toolTip = "Emulated parameters:";
+
+    for(unsigned int i=0; i<parameterNames.size(); i++)
+    {
+        double min, max;
+        emulator_->getParameterRange(i, min, max);
+
+        toolTip += QString("\n%1: %2 - %3").arg(parameterNames[i].c_str()).arg(min).arg(max);
+    }
+
+    statusLabel_.setToolTip(toolTip);
+
+    // repopulating the combobox selects the first entry, which updates the chart
+    groupComboBox_.clear();
+    groupComboBox_.addItem("All");
+
+    std::vector<std::string> groupNames = emulator_->getCurveGroupNames();
+
+    for(unsigned int g=0; g<groupNames.size(); g++)
+    {
+        groupComboBox_.addItem(groupNames[g].c_str());
+    }
+}
+
+void EmulatorWidget::setGroupChoice(int choiceIndex)
+{
+    if(choiceIndex <= 0)
+    {
+        groupName_ = "";
+    }
+    else
+    {
+        groupName_ = groupComboBox_.itemText(choiceIndex).toStdString();
+    }
+
+    updateChart();
+}
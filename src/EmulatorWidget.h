@@ -0,0 +1,47 @@
+#ifndef EMULATOR_WIDGET_H
+#define EMULATOR_WIDGET_H
+
+#include "ChartWidget.h"
+#include <QtGui>
+#include <boost/shared_ptr.hpp>
+
+class MainWindow;
+class EpidemicDataSet;
+class ParameterEmulator;
+
+// live chart of the emulated epidemic curve for the current parameters, updated as they are edited, with the
+// curve of the current data set (e.g. a running simulation) for comparison
+class EmulatorWidget : public QMainWindow
+{
+    Q_OBJECT
+
+    public:
+
+        EmulatorWidget(MainWindow * mainWindow);
+
+    public slots:
+
+        void setDataSet(boost::shared_ptr<EpidemicDataSet> dataSet);
+        void updateChart();
+
+    private slots:
+
+        void loadEmulator();
+        void setGroupChoice(int choiceIndex);
+
+    private:
+
+        boost::shared_ptr<ParameterEmulator> emulator_;
+
+        boost::shared_ptr<EpidemicDataSet> dataSet_;
+
+        // selected group; empty for all groups
+        std::string groupName_;
+
+        // UI elements
+        ChartWidget chartWidget_;
+        QComboBox groupComboBox_;
+        QLabel statusLabel_;
+};
+
+#endif
@@ -1,13 +1,49 @@
 #include "EpidemicDataSet.h"
+#include "RegionData.h"
+#include "StockpileNetwork.h"
 #include "main.h"
 #include "log.h"
 #include <fstream>
+#include <algorithm>
 #include <boost/tokenizer.hpp>
 
 #if USE_NETCDF
     #include <netcdfcpp.h>
 #endif
 
+// subdomain of a slab [node][stratifications...] for a node index (or NODES_ALL) and stratification values
+template <typename T> static blitz::RectDomain<1+NUM_STRATIFICATION_DIMENSIONS> getSlabSubdomain(const blitz::Array<T, 1+NUM_STRATIFICATION_DIMENSIONS> &slab, int nodeIndex, const std::vector<int> &stratificationValues)
+{
+    // the full domain of the slab
+    blitz::TinyVector<int, 1+NUM_STRATIFICATION_DIMENSIONS> slabLowerBound = slab.lbound();
+    blitz::TinyVector<int, 1+NUM_STRATIFICATION_DIMENSIONS> slabUpperBound = slab.ubound();
+
+    // limit by node
+    if(nodeIndex != NODES_ALL)
+    {
+        slabLowerBound(0) = slabUpperBound(0) = nodeIndex;
+    }
+
+    // limit by stratification values
+    for(unsigned int i=0; i<stratificationValues.size(); i++)
+    {
+        if(stratificationValues[i] != STRATIFICATIONS_ALL)
+        {
+            slabLowerBound(1+i) = slabUpperBound(1+i) = stratificationValues[i];
+        }
+    }
+
+    return blitz::RectDomain<1+NUM_STRATIFICATION_DIMENSIONS>(slabLowerBound, slabUpperBound);
+}
+
+// the slab [node][stratifications...] of a regular variable at a dense time index, referencing the variable's data
+// the stratification dimensions are the fixed [age group][risk group][vaccinated] of StratificationLayout, so the
+// slice is spelled out rather than expanded from NUM_STRATIFICATION_DIMENSIONS
+template <typename T> static blitz::Array<T, 1+NUM_STRATIFICATION_DIMENSIONS> getTimeSlab(const blitz::Array<T, 2+NUM_STRATIFICATION_DIMENSIONS> &variable, int timeIndex)
+{
+    return variable(timeIndex, blitz::Range::all(), blitz::Range::all(), blitz::Range::all(), blitz::Range::all());
+}
+
 std::vector<std::string> EpidemicDataSet::stratificationNames_;
 std::vector<std::vector<std::string> > EpidemicDataSet::stratifications_;
 
@@ -17,48 +53,32 @@ EpidemicDataSet::EpidemicDataSet(const char * filename)
     isValid_ = false;
     numTimes_ = 1;
     numNodes_ = 0;
+    slabCacheCapacity_ = 1;
 
-    // load stratifications data
-    if(loadStratificationsFile() != true)
-    {
-        put_flog(LOG_ERROR, "could not load stratifications file");
-        return;
-    }
-
-    // load node name and group data
-    std::string nodeNameGroupFilename = g_dataDirectory + "/fips_county_names_HSRs.csv";
+    // static inputs are shared by all data sets
+    regionData_ = RegionData::getDefault();
 
-    if(loadNodeNameGroupFile(nodeNameGroupFilename.c_str()) != true)
+    if(regionData_ == NULL)
     {
-        put_flog(LOG_ERROR, "could not load file %s", nodeNameGroupFilename.c_str());
+        put_flog(LOG_ERROR, "could not load region data");
         return;
     }
 
-    // population data
-    std::string nodePopulationFilename = g_dataDirectory + "/fips_age_group_populations.csv";
+    numNodes_ = regionData_->getNumNodes();
 
-    if(loadNodePopulationFile(nodePopulationFilename.c_str()) != true)
-    {
-        put_flog(LOG_ERROR, "could not load file %s", nodePopulationFilename.c_str());
-        return;
-    }
+    // the population variable is modified by simulations, so each data set gets its own copy, as counts
+    blitz::Array<float, 2+NUM_STRATIFICATION_DIMENSIONS> regionPopulation = regionData_->getPopulation();
 
-    std::string nodePopulationSecondStratificationFilename = g_dataDirectory + "/age_groups_low_risk_fraction.csv";
+    blitz::TinyVector<int, 2+NUM_STRATIFICATION_DIMENSIONS> shape = regionPopulation.shape();
+    shape(0) = DENSE_VARIABLE_TIMES;
 
-    if(loadNodePopulationSecondStratificationFile(nodePopulationSecondStratificationFilename.c_str()) != true)
-    {
-        put_flog(LOG_ERROR, "could not load file %s", nodePopulationSecondStratificationFilename.c_str());
-        return;
-    }
+    blitz::Array<int, 2+NUM_STRATIFICATION_DIMENSIONS> population(shape);
+    population = 0;
 
-    // travel data
-    std::string nodeTravelFilename = g_dataDirectory + "/county_travel_fractions.csv";
+    // the region population has a single time, so its domain is the first dense time
+    population(blitz::RectDomain<2+NUM_STRATIFICATION_DIMENSIONS>(regionPopulation.lbound(), regionPopulation.ubound())) = blitz::cast<int>(regionPopulation + 0.5f);
 
-    if(loadNodeTravelFile(nodeTravelFilename.c_str()) != true)
-    {
-        put_flog(LOG_ERROR, "could not load file %s", nodeTravelFilename.c_str());
-        return;
-    }
+    variables_["population"].reference(population);
 
     // data set
     if(filename != NULL)
@@ -69,27 +89,58 @@ EpidemicDataSet::EpidemicDataSet(const char * filename)
             return;
         }
 
-        // todo: for now, duplicate population data over all times, since this isn't stored in the data set
-        for(int time=1; time<numTimes_; time++)
+        // population isn't stored in the data set; use the initial population for all times rather than duplicating it
+        if(fileVariables_.count("population") == 0)
         {
-            copyVariableToNewTimeStep("population");
+            timeInvariantVariables_.insert("population");
         }
     }
 
     isValid_ = true;
 }
 
+EpidemicDataSet::EpidemicDataSet(const EpidemicDataSet &dataSet)
+{
+    isValid_ = dataSet.isValid_;
+    numTimes_ = dataSet.numTimes_;
+    numNodes_ = dataSet.numNodes_;
+    regionData_ = dataSet.regionData_;
+
+    std::map<std::string, blitz::Array<int, 2+NUM_STRATIFICATION_DIMENSIONS> >::const_iterator iter;
+
+    for(iter=dataSet.variables_.begin(); iter!=dataSet.variables_.end(); iter++)
+    {
+        blitz::Array<int, 2+NUM_STRATIFICATION_DIMENSIONS> variable = iter->second.copy();
+        variables_[iter->first].reference(variable);
+    }
+
+    variableHistories_ = dataSet.variableHistories_;
+
+    // file variables are read through the same file; the slab cache starts empty
+    ncFile_ = dataSet.ncFile_;
+    fileVariables_ = dataSet.fileVariables_;
+    slabCacheCapacity_ = dataSet.slabCacheCapacity_;
+
+    timeInvariantVariables_ = dataSet.timeInvariantVariables_;
+    unstratifiedVariables_ = dataSet.unstratifiedVariables_;
+
+    if(dataSet.stockpileNetwork_ != NULL)
+    {
+        stockpileNetwork_ = dataSet.stockpileNetwork_->clone(this);
+    }
+}
+
 bool EpidemicDataSet::isValid()
 {
     return isValid_;
 }
 
-int EpidemicDataSet::getNumTimes()
+int EpidemicDataSet::getNumTimes() const
 {
     return numTimes_;
 }
 
-int EpidemicDataSet::getNumNodes()
+int EpidemicDataSet::getNumNodes() const
 {
     return numNodes_;
 }
@@ -120,9 +171,9 @@ std::vector<std::vector<std::string> > EpidemicDataSet::getStratifications()
     return stratifications_;
 }
 
-float EpidemicDataSet::getPopulation(int nodeId)
+double EpidemicDataSet::getPopulation(int nodeId)
 {
-    if(nodeIdToIndex_.count(nodeId) == 0)
+    if(regionData_->getNodeIndex(nodeId) == -1)
     {
         put_flog(LOG_ERROR, "could not map nodeId %i to an index", nodeId);
         return 0.;
@@ -131,9 +182,9 @@ float EpidemicDataSet::getPopulation(int nodeId)
     return getValue("population", 0, nodeId);
 }
 
-float EpidemicDataSet::getPopulation(std::vector<int> nodeIds)
+double EpidemicDataSet::getPopulation(const std::vector<int> &nodeIds)
 {
-    float population = 0.;
+    double population = 0.;
 
     for(unsigned int i=0; i<nodeIds.size(); i++)
     {
@@ -145,18 +196,26 @@ float EpidemicDataSet::getPopulation(std::vector<int> nodeIds)
 
 std::string EpidemicDataSet::getNodeName(int nodeId)
 {
-    if(nodeIdToName_.count(nodeId) == 0)
+    if(regionData_->getNodeIndex(nodeId) == -1)
     {
         put_flog(LOG_ERROR, "could not map nodeId %i to a name", nodeId);
         return std::string("");
     }
 
-    return nodeIdToName_[nodeId];
+    return regionData_->getNodeName(nodeId);
 }
 
 int EpidemicDataSet::getNodeIndex(int nodeId)
 {
-    return nodeIdToIndex_[nodeId];
+    int nodeIndex = regionData_->getNodeIndex(nodeId);
+
+    if(nodeIndex == -1)
+    {
+        put_flog(LOG_ERROR, "could not map nodeId %i to an index", nodeId);
+        return -1;
+    }
+
+    return nodeIndex;
 }
 
 std::vector<std::string> EpidemicDataSet::getVariableNames()
@@ -164,15 +223,21 @@ std::vector<std::string> EpidemicDataSet::getVariableNames()
     std::vector<std::string> variableNames;
 
     // regular variables
-    std::map<std::string, blitz::Array<float, 2+NUM_STRATIFICATION_DIMENSIONS> >::iterator iter;
+    std::map<std::string, blitz::Array<int, 2+NUM_STRATIFICATION_DIMENSIONS> >::iterator iter;
 
     for(iter=variables_.begin(); iter!=variables_.end(); iter++)
     {
         variableNames.push_back(iter->first);
     }
 
+    // file variables
+    for(std::map<std::string, NcVar *>::iterator iter3=fileVariables_.begin(); iter3!=fileVariables_.end(); iter3++)
+    {
+        variableNames.push_back(iter3->first);
+    }
+
     // derived variables
-    std::map<std::string, boost::function<float (int time, int nodeId, std::vector<int> stratificationValues)> >::iterator iter2;
+    std::map<std::string, boost::function<float (int time, int nodeId, const std::vector<int> &stratificationValues)> >::iterator iter2;
 
     for(iter2=derivedVariables_.begin(); iter2!=derivedVariables_.end(); iter2++)
     {
@@ -182,46 +247,52 @@ std::vector<std::string> EpidemicDataSet::getVariableNames()
     return variableNames;
 }
 
+bool EpidemicDataSet::isDerivedVariable(const std::string &varName)
+{
+    return derivedVariables_.count(varName) != 0;
+}
+
+bool EpidemicDataSet::isStratifiedVariable(const std::string &varName)
+{
+    return unstratifiedVariables_.count(varName) == 0;
+}
+
 std::vector<int> EpidemicDataSet::getNodeIds()
 {
-    return nodeIds_;
+    return regionData_->getNodeIds();
 }
 
 std::vector<int> EpidemicDataSet::getNodeIds(std::string groupName)
 {
-    if(groupNameToNodeIds_.count(groupName) == 0)
+    if(regionData_->hasGroup(groupName) != true)
     {
         put_flog(LOG_ERROR, "could not map group name %s to node ids", groupName.c_str());
         return std::vector<int>();
     }
 
-    return groupNameToNodeIds_[groupName];
+    return regionData_->getNodeIds(groupName);
 }
 
 std::vector<std::string> EpidemicDataSet::getGroupNames()
 {
-    std::vector<std::string> groupNames;
-
-    for(std::map<std::string, std::vector<int> >::iterator it=groupNameToNodeIds_.begin(); it!=groupNameToNodeIds_.end(); it++)
-    {
-        groupNames.push_back(it->first);
-    }
-
-    return groupNames;
+    return regionData_->getGroupNames();
 }
 
 float EpidemicDataSet::getTravel(int nodeId0, int nodeId1)
 {
-    if(nodeIdToIndex_.count(nodeId0) == 0 || nodeIdToIndex_.count(nodeId1) == 0)
+    int nodeIndex0 = regionData_->getNodeIndex(nodeId0);
+    int nodeIndex1 = regionData_->getNodeIndex(nodeId1);
+
+    if(nodeIndex0 == -1 || nodeIndex1 == -1)
     {
         put_flog(LOG_ERROR, "could not map a nodeId to an index for: %i, %i", nodeId0, nodeId1);
         return 0.;
     }
 
-    return travel_(nodeIdToIndex_[nodeId0], nodeIdToIndex_[nodeId1]);
+    return regionData_->getTravel(nodeIndex0, nodeIndex1);
 }
 
-float EpidemicDataSet::getValue(const std::string &varName, const int &time, const int &nodeId, const std::vector<int> &stratificationValues)
+double EpidemicDataSet::getValue(const std::string &varName, const int &time, const int &nodeId, const std::vector<int> &stratificationValues)
 {
     // handle derived variables
     if(derivedVariables_.count(varName) > 0)
@@ -229,59 +300,60 @@ float EpidemicDataSet::getValue(const std::string &varName, const int &time, con
         return derivedVariables_[varName](time, nodeId, stratificationValues);
     }
 
-    if(variables_.count(varName) == 0)
+    bool fileVariable = (fileVariables_.count(varName) != 0);
+
+    if(fileVariable != true && variables_.count(varName) == 0)
     {
         put_flog(LOG_ERROR, "no such variable %s (nodeId = %i)", varName.c_str(), nodeId);
         return 0.;
     }
-    else if(nodeId != NODES_ALL && nodeIdToIndex_.count(nodeId) == 0)
-    {
-        put_flog(LOG_ERROR, "could not map nodeId %i to an index (varName = %s)", nodeId, varName.c_str());
-        return 0.;
-    }
-
-    // the variable we're getting
-    blitz::Array<float, 2+NUM_STRATIFICATION_DIMENSIONS> variable = variables_[varName];
 
-    // the full domain
-    blitz::TinyVector<int, 2+NUM_STRATIFICATION_DIMENSIONS> lowerBound = variable.lbound();
-    blitz::TinyVector<int, 2+NUM_STRATIFICATION_DIMENSIONS> upperBound = variable.ubound();
+    int nodeIndex = NODES_ALL;
 
-    // make sure this variable is valid for the specified time
-    if(time < lowerBound(0) || time > upperBound(0))
+    if(nodeId != NODES_ALL)
     {
-        put_flog(LOG_WARN, "variable %s not valid for time %i", varName.c_str(), time);
-        return 0.;
+        nodeIndex = regionData_->getNodeIndex(nodeId);
     }
 
-    // limit by time
-    lowerBound(0) = upperBound(0) = time;
-
-    // limit by node
-    if(nodeId != NODES_ALL)
+    if(nodeId != NODES_ALL && nodeIndex == -1)
     {
-        lowerBound(1) = upperBound(1) = nodeIdToIndex_[nodeId];
+        put_flog(LOG_ERROR, "could not map nodeId %i to an index (varName = %s)", nodeId, varName.c_str());
+        return 0.;
     }
 
-    // limit by stratification values
-    for(unsigned int i=0; i<stratificationValues.size(); i++)
+    if(fileVariable == true)
     {
-        if(stratificationValues[i] != STRATIFICATIONS_ALL)
+        if(time < 0 || time >= numTimes_)
         {
-            lowerBound(2+i) = upperBound(2+i) = stratificationValues[i];
+            put_flog(LOG_WARN, "variable %s not valid for time %i", varName.c_str(), time);
+            return 0.;
         }
+
+        blitz::Array<float, 1+NUM_STRATIFICATION_DIMENSIONS> slab = getFileVariableSlab(varName, time);
+
+        if(slab.size() == 0)
+        {
+            return 0.;
+        }
+
+        return blitz::sum(slab(getSlabSubdomain(slab, nodeIndex, stratificationValues)));
     }
 
-    // the subdomain
-    blitz::RectDomain<2+NUM_STRATIFICATION_DIMENSIONS> subdomain(lowerBound, upperBound);
+    // regular variables
+    long long count;
+
+    if(getCount(varName, time, nodeIndex, stratificationValues, count) != true)
+    {
+        put_flog(LOG_WARN, "variable %s not valid for time %i", varName.c_str(), time);
+        return 0.;
+    }
 
-    // return the sum of the array over the subdomain
-    return blitz::sum(variable(subdomain));
+    return (double)count;
 }
 
-float EpidemicDataSet::getValue(const std::string &varName, const int &time, const int &nodeId, const std::vector<std::vector<int> > &stratificationValuesSet)
+double EpidemicDataSet::getValue(const std::string &varName, const int &time, const int &nodeId, const std::vector<std::vector<int> > &stratificationValuesSet)
 {
-    float value = 0.;
+    double value = 0.;
 
     for(unsigned int i=0; i<stratificationValuesSet.size(); i++)
     {
@@ -291,22 +363,22 @@ float EpidemicDataSet::getValue(const std::string &varName, const int &time, con
     return value;
 }
 
-float EpidemicDataSet::getValue(const std::string &varName, const int &time, const std::string &groupName, const std::vector<int> &stratificationValues)
+double EpidemicDataSet::getValue(const std::string &varName, const int &time, const std::string &groupName, const std::vector<int> &stratificationValues)
 {
-    if(variables_.count(varName) == 0 && derivedVariables_.count(varName) == 0)
+    if(variables_.count(varName) == 0 && derivedVariables_.count(varName) == 0 && fileVariables_.count(varName) == 0)
     {
         put_flog(LOG_ERROR, "no such variable %s", varName.c_str());
         return 0.;
     }
-    else if(groupNameToNodeIds_.count(groupName) == 0)
+    else if(regionData_->hasGroup(groupName) != true)
     {
         put_flog(LOG_ERROR, "could not map group name %s to node ids", groupName.c_str());
         return 0.;
     }
 
-    std::vector<int> nodeIds = groupNameToNodeIds_[groupName];
+    const std::vector<int> &nodeIds = regionData_->getNodeIds(groupName);
 
-    float value = 0.;
+    double value = 0.;
 
     for(unsigned int i=0; i<nodeIds.size(); i++)
     {
@@ -326,23 +398,41 @@ bool EpidemicDataSet::newVariable(std::string varName)
 
     // full shape
     blitz::TinyVector<int, 2+NUM_STRATIFICATION_DIMENSIONS> shape;
-    shape(0) = numTimes_;
+    shape(0) = DENSE_VARIABLE_TIMES;
     shape(1) = numNodes_;
 
+    int blockSize = 1;
+
     for(int j=0; j<NUM_STRATIFICATION_DIMENSIONS; j++)
     {
         shape(2 + j) = stratifications_[j].size();
+        blockSize *= stratifications_[j].size();
     }
 
     // create the variable
-    blitz::Array<float, 2+NUM_STRATIFICATION_DIMENSIONS> var(shape);
+    blitz::Array<int, 2+NUM_STRATIFICATION_DIMENSIONS> var(shape);
 
     // initialize values to zero
-    var = 0.;
+    var = 0;
 
     // add the variable to the vector
     variables_[varName].reference(var);
 
+    // times before the ring buffer are zero too
+    if(numTimes_ > DENSE_VARIABLE_TIMES)
+    {
+        VariableHistory history(numNodes_, blockSize);
+
+        std::vector<int> zeros(numNodes_ * blockSize, 0);
+
+        for(int t=0; t<numTimes_ - DENSE_VARIABLE_TIMES; t++)
+        {
+            history.append(&zeros[0]);
+        }
+
+        variableHistories_[varName] = history;
+    }
+
     return true;
 }
 
@@ -360,10 +450,15 @@ bool EpidemicDataSet::copyVariable(std::string sourceVarName, std::string destVa
         return false;
     }
 
-    blitz::Array<float, 2+NUM_STRATIFICATION_DIMENSIONS> varCopy = variables_[sourceVarName].copy();
+    blitz::Array<int, 2+NUM_STRATIFICATION_DIMENSIONS> varCopy = variables_[sourceVarName].copy();
 
     variables_[destVarName].reference(varCopy);
 
+    if(variableHistories_.count(sourceVarName) != 0)
+    {
+        variableHistories_[destVarName] = variableHistories_[sourceVarName];
+    }
+
     return true;
 }
 
@@ -375,470 +470,545 @@ bool EpidemicDataSet::copyVariableToNewTimeStep(std::string varName)
         return false;
     }
 
-    // get current shape of variable
-    blitz::TinyVector<int, 2+NUM_STRATIFICATION_DIMENSIONS> shape = variables_[varName].shape();
-
-    // add a time step
-    shape(0) = shape(0) + 1;
+    blitz::Array<int, 2+NUM_STRATIFICATION_DIMENSIONS> &variable = variables_[varName];
 
-    // resize variable for the new shape
-    variables_[varName].resizeAndPreserve(shape);
+    int newTime = numTimes_ - 1;
 
-    // copy data to the new time step
+    if(newTime < 1 || getFirstDenseTime(varName) != std::max(0, newTime - DENSE_VARIABLE_TIMES))
+    {
+        put_flog(LOG_ERROR, "variable %s is not at time %i", varName.c_str(), newTime - 1);
+        return false;
+    }
 
-    // the full domain
-    blitz::TinyVector<int, 2+NUM_STRATIFICATION_DIMENSIONS> lowerBound = variables_[varName].lbound();
-    blitz::TinyVector<int, 2+NUM_STRATIFICATION_DIMENSIONS> upperBound = variables_[varName].ubound();
+    int newTimeIndex = getDenseTimeIndex(newTime);
 
-    // domain for previous time and new time
-    lowerBound(0) = upperBound(0) = variables_[varName].extent(0) - 2;
-    blitz::RectDomain<2+NUM_STRATIFICATION_DIMENSIONS> subdomain0(lowerBound, upperBound);
+    // the new time replaces the oldest dense time, which moves to the history
+    if(newTime >= DENSE_VARIABLE_TIMES)
+    {
+        if(variableHistories_.count(varName) == 0)
+        {
+            variableHistories_[varName] = VariableHistory(variable.extent(1), variable.size() / (variable.extent(0) * variable.extent(1)));
+        }
 
-    lowerBound(0) = upperBound(0) = variables_[varName].extent(0) - 1;
-    blitz::RectDomain<2+NUM_STRATIFICATION_DIMENSIONS> subdomain1(lowerBound, upperBound);
+        // variables are allocated contiguously, so a time is [node][stratifications...] in order
+        variableHistories_[varName].append(variable.data() + newTimeIndex * variable.stride(0));
+    }
 
-    // make the copy
-    variables_[varName](subdomain1) = variables_[varName](subdomain0);
+    // copy data to the new time step
+    blitz::Array<int, 1+NUM_STRATIFICATION_DIMENSIONS> newSlab = getTimeSlab(variable, newTimeIndex);
+    newSlab = getTimeSlab(variable, getDenseTimeIndex(newTime - 1));
 
     return true;
 }
 
 blitz::Array<float, 1+NUM_STRATIFICATION_DIMENSIONS> EpidemicDataSet::getVariableAtTime(std::string varName, int time)
 {
+    if(fileVariables_.count(varName) != 0)
+    {
+        return getFileVariableSlab(varName, time);
+    }
+
+    if(timeInvariantVariables_.count(varName) != 0)
+    {
+        time = 0;
+    }
+
     if(variables_.count(varName) == 0)
     {
         put_flog(LOG_ERROR, "no such variable %s", varName.c_str());
         return blitz::Array<float, 1+NUM_STRATIFICATION_DIMENSIONS>();
     }
 
-    if(time >= variables_[varName].extent(0))
+    if(time < 0 || time >= numTimes_)
     {
-        put_flog(LOG_ERROR, "time %i >= time extent %i", time, variables_[varName].extent(0));
+        put_flog(LOG_ERROR, "time %i out of range [0, %i]", time, numTimes_ - 1);
         return blitz::Array<float, 1+NUM_STRATIFICATION_DIMENSIONS>();
     }
 
-    // this should produce a slice that references the data in the original variable array
-    blitz::Array<float, 1+NUM_STRATIFICATION_DIMENSIONS> subVar = variables_[varName](time, blitz::Range::all(), BOOST_PP_ENUM(NUM_STRATIFICATION_DIMENSIONS, TEXT, blitz::Range::all()));
+    blitz::Array<int, 1+NUM_STRATIFICATION_DIMENSIONS> counts;
 
-    return subVar;
+    if(time < getFirstDenseTime(varName))
+    {
+        counts.reference(getHistorySlab(varName, time));
+    }
+    else
+    {
+        counts.reference(getTimeSlab(variables_[varName], getDenseTimeIndex(time)));
+    }
+
+    blitz::Array<float, 1+NUM_STRATIFICATION_DIMENSIONS> values(counts.shape());
+    values = blitz::cast<float>(counts);
+
+    return values;
 }
 
-blitz::Array<float, 1+NUM_STRATIFICATION_DIMENSIONS> EpidemicDataSet::getVariableAtFinalTime(std::string varName)
+blitz::Array<int, 1+NUM_STRATIFICATION_DIMENSIONS> EpidemicDataSet::getVariableAtFinalTime(std::string varName)
 {
     if(variables_.count(varName) == 0)
     {
-        put_flog(LOG_ERROR, "no such variable %s", varName.c_str());
-        return blitz::Array<float, 1+NUM_STRATIFICATION_DIMENSIONS>();
+        put_flog(LOG_ERROR, "no such regular variable %s", varName.c_str());
+        return blitz::Array<int, 1+NUM_STRATIFICATION_DIMENSIONS>();
     }
 
-    // this should produce a slice that references the data in the original variable array
-    int finalTime = variables_[varName].extent(0) - 1;
+    // time-invariant variables are only stored for time 0
+    int finalTime = numTimes_ - 1;
+
+    if(timeInvariantVariables_.count(varName) != 0)
+    {
+        finalTime = 0;
+    }
 
-    blitz::Array<float, 1+NUM_STRATIFICATION_DIMENSIONS> subVar = variables_[varName](finalTime, blitz::Range::all(), BOOST_PP_ENUM(NUM_STRATIFICATION_DIMENSIONS, TEXT, blitz::Range::all()));
+    // this should produce a slice that references the data in the original variable array
+    blitz::Array<int, 1+NUM_STRATIFICATION_DIMENSIONS> subVar = getTimeSlab(variables_[varName], getDenseTimeIndex(finalTime));
 
     return subVar;
 }
 
-boost::shared_ptr<StockpileNetwork> EpidemicDataSet::getStockpileNetwork()
-{
-    return stockpileNetwork_;
-}
-
-bool EpidemicDataSet::loadNetCdfFile(const char * filename)
+blitz::Array<float, 1+NUM_STRATIFICATION_DIMENSIONS> EpidemicDataSet::getFileVariableSlab(const std::string &varName, int time)
 {
-#if USE_NETCDF // TODO: should handle this differently
-    // change netcdf library error behavior
-    NcError err(NcError::verbose_nonfatal);
-
-    // open the netcdf file
-    NcFile ncFile(filename, NcFile::ReadOnly);
+#if USE_NETCDF
+    if(fileVariables_.count(varName) == 0)
+    {
+        put_flog(LOG_ERROR, "no such file variable %s", varName.c_str());
+        return blitz::Array<float, 1+NUM_STRATIFICATION_DIMENSIONS>();
+    }
 
-    if(!ncFile.is_valid())
+    if(time < 0 || time >= numTimes_)
     {
-        put_flog(LOG_FATAL, "invalid file %s", filename);
-        return false;
+        put_flog(LOG_ERROR, "time %i out of range for variable %s", time, varName.c_str());
+        return blitz::Array<float, 1+NUM_STRATIFICATION_DIMENSIONS>();
     }
 
-    // get dimensions
-    NcDim * timeDim = ncFile.get_dim("time");
-    NcDim * nodesDim = ncFile.get_dim("nodes");
-    NcDim * stratificationsDim = ncFile.get_dim("stratifications");
+    SlabKey key(varName, time);
 
-    if(timeDim == NULL || nodesDim == NULL || stratificationsDim == NULL)
+    // cache hit: move to front
+    std::map<SlabKey, SlabList::iterator>::iterator indexIter = slabCacheIndex_.find(key);
+
+    if(indexIter != slabCacheIndex_.end())
     {
-        put_flog(LOG_FATAL, "could not find a required dimension");
-        return false;
+        slabCache_.splice(slabCache_.begin(), slabCache_, indexIter->second);
+
+        return indexIter->second->second;
     }
 
-    numTimes_ = timeDim->size();
+    // cache miss: read the slab from the file
+    blitz::TinyVector<int, 1+NUM_STRATIFICATION_DIMENSIONS> shape;
+    shape(0) = numNodes_;
 
-    // make sure we have the expected number of nodes
-    if(nodesDim->size() != numNodes_)
+    long numStratifications = 1;
+
+    for(int j=0; j<NUM_STRATIFICATION_DIMENSIONS; j++)
     {
-        put_flog(LOG_FATAL, "got %i nodes, expected %i", nodesDim->size(), numNodes_);
-        return false;
+        shape(1 + j) = stratifications_[j].size();
+        numStratifications *= stratifications_[j].size();
     }
 
-    put_flog(LOG_DEBUG, "file contains %i timesteps, %i nodes", numTimes_, numNodes_);
+    blitz::Array<float, 1+NUM_STRATIFICATION_DIMENSIONS> slab(shape);
 
-    // make sure number of stratifications matches our expectation...
-    int numExpectedStratifications = 1;
+    NcError err(NcError::verbose_nonfatal);
 
-    for(unsigned int i=0; i<NUM_STRATIFICATION_DIMENSIONS; i++)
+    NcVar * ncVar = fileVariables_[varName];
+
+    if(ncVar->set_cur(time, 0, 0) != true || ncVar->get(slab.data(), 1, numNodes_, numStratifications) != true)
     {
-        numExpectedStratifications *= stratifications_[i].size();
+        put_flog(LOG_ERROR, "could not read variable %s at time %i", varName.c_str(), time);
+        return blitz::Array<float, 1+NUM_STRATIFICATION_DIMENSIONS>();
     }
 
-    if(stratificationsDim->size() != numExpectedStratifications)
+    // evict least recently used slabs
+    while(slabCache_.size() >= slabCacheCapacity_)
     {
-        put_flog(LOG_FATAL, "got %i stratifications, expected %i", stratificationsDim->size(), numExpectedStratifications);
-        return false;
+        slabCacheIndex_.erase(slabCache_.back().first);
+        slabCache_.pop_back();
     }
 
-    // get all float variables with dimensions (time, nodes, stratifications)
-    for(int i=0; i<ncFile.num_vars(); i++)
-    {
-        NcVar * ncVar = ncFile.get_var(i);
+    slabCache_.push_front(std::pair<SlabKey, blitz::Array<float, 1+NUM_STRATIFICATION_DIMENSIONS> >(key, slab));
+    slabCacheIndex_[key] = slabCache_.begin();
 
-        if(ncVar->num_dims() == 3 && ncVar->type() == ncFloat && strcmp(ncVar->get_dim(0)->name(), "time") == 0 && strcmp(ncVar->get_dim(1)->name(), "nodes") == 0 && strcmp(ncVar->get_dim(2)->name(), "stratifications") == 0)
-        {
-            put_flog(LOG_INFO, "found variable: %s", ncVar->name());
+    return slab;
+#else
+    return blitz::Array<float, 1+NUM_STRATIFICATION_DIMENSIONS>();
+#endif
+}
 
-            // full shape
-            blitz::TinyVector<int, 2+NUM_STRATIFICATION_DIMENSIONS> shape;
-            shape(0) = numTimes_;
-            shape(1) = numNodes_;
+boost::shared_ptr<StockpileNetwork> EpidemicDataSet::getStockpileNetwork()
+{
+    return stockpileNetwork_;
+}
 
-            for(int j=0; j<NUM_STRATIFICATION_DIMENSIONS; j++)
-            {
-                shape(2 + j) = stratifications_[j].size();
-            }
+void EpidemicDataSet::getVariableMemoryUsage(long &bytes, long &denseBytes)
+{
+    bytes = denseBytes = 0;
 
-            blitz::Array<float, 2+NUM_STRATIFICATION_DIMENSIONS> var((float *)ncVar->values()->base(), shape, blitz::duplicateData);
+    std::map<std::string, blitz::Array<int, 2+NUM_STRATIFICATION_DIMENSIONS> >::iterator iter;
 
-            variables_[std::string(ncVar->name())].reference(var);
+    for(iter=variables_.begin(); iter!=variables_.end(); iter++)
+    {
+        long timeBytes = iter->second.size() / iter->second.extent(0) * sizeof(int);
+
+        bytes += iter->second.size() * sizeof(int);
+        denseBytes += (timeInvariantVariables_.count(iter->first) != 0 ? 1 : numTimes_) * timeBytes;
+
+        if(variableHistories_.count(iter->first) != 0)
+        {
+            bytes += variableHistories_[iter->first].getBytes();
         }
     }
-#endif
-    return true;
 }
 
-bool EpidemicDataSet::loadStratificationsFile()
+int EpidemicDataSet::getDenseTimeIndex(int time)
 {
-    std::string filename = g_dataDirectory + "/" + STRATIFICATIONS_FILENAME;
+    return time % DENSE_VARIABLE_TIMES;
+}
 
-    std::ifstream in(filename.c_str());
+int EpidemicDataSet::getFirstDenseTime(const std::string &varName) const
+{
+    std::map<std::string, VariableHistory>::const_iterator iter = variableHistories_.find(varName);
 
-    if(in.is_open() != true)
+    if(iter == variableHistories_.end())
     {
-        put_flog(LOG_ERROR, "could not load file %s", filename.c_str());
-        return false;
+        return 0;
     }
 
-    // clear existing entries
-    stratificationNames_.clear();
-    stratifications_.clear();
+    return iter->second.getNumTimes();
+}
 
-    // use boost tokenizer to parse the file
-    typedef boost::tokenizer< boost::escaped_list_separator<char> > Tokenizer;
+int EpidemicDataSet::findNodeIndex(int nodeId) const
+{
+    return regionData_->getNodeIndex(nodeId);
+}
 
-    std::vector<std::string> vec;
-    std::string line;
+bool EpidemicDataSet::hasRegularVariable(const std::string &varName) const
+{
+    return variables_.find(varName) != variables_.end();
+}
 
-    // read names of stratifications
-    getline(in, line);
-    Tokenizer tok(line);
-    vec.assign(tok.begin(), tok.end());
+bool EpidemicDataSet::getCount(const std::string &varName, int time, int nodeIndex, const std::vector<int> &stratificationValues, long long &count) const
+{
+    count = 0;
 
-    // make sure this matches what we expect
-    if(vec.size() != NUM_STRATIFICATION_DIMENSIONS)
+    std::map<std::string, blitz::Array<int, 2+NUM_STRATIFICATION_DIMENSIONS> >::const_iterator iter = variables_.find(varName);
+
+    if(iter == variables_.end() || stratificationValues.size() > NUM_STRATIFICATION_DIMENSIONS)
     {
-        put_flog(LOG_ERROR, "got %i stratification dimensions, expected %i", vec.size(), NUM_STRATIFICATION_DIMENSIONS);
         return false;
     }
 
-    stratificationNames_ = vec;
+    const blitz::Array<int, 2+NUM_STRATIFICATION_DIMENSIONS> &variable = iter->second;
 
-    // read stratification value names
-    for(unsigned int i=0; i<NUM_STRATIFICATION_DIMENSIONS; i++)
+    // time-invariant variables are only stored for time 0
+    if(timeInvariantVariables_.find(varName) != timeInvariantVariables_.end() && time >= 0 && time < numTimes_)
     {
-        vec.clear();
-
-        getline(in, line);
-        Tokenizer tok(line);
-        vec.assign(tok.begin(), tok.end());
-
-        stratifications_.push_back(vec);
+        time = 0;
     }
 
-    return true;
-}
-
-bool EpidemicDataSet::loadNodeNameGroupFile(const char * filename)
-{
-    std::ifstream in(filename);
+    // the subdomain, excluding time: [node][stratifications...]
+    blitz::TinyVector<int, 1+NUM_STRATIFICATION_DIMENSIONS> lowerBound;
+    blitz::TinyVector<int, 1+NUM_STRATIFICATION_DIMENSIONS> upperBound;
 
-    if(in.is_open() != true)
+    for(int d=0; d<1+NUM_STRATIFICATION_DIMENSIONS; d++)
     {
-        put_flog(LOG_ERROR, "could not load file %s", filename);
-        return false;
+        lowerBound(d) = variable.lbound(1+d);
+        upperBound(d) = variable.ubound(1+d);
     }
 
-    // clear existing entries
-    numNodes_ = 0;
-    nodeIds_.clear();
-    nodeIdToIndex_.clear();
-    nodeIdToName_.clear();
-    nodeIdToGroupName_.clear();
-    groupNameToNodeIds_.clear();
-
-    // use boost tokenizer to parse the file
-    typedef boost::tokenizer< boost::escaped_list_separator<char> > Tokenizer;
-
-    std::vector<std::string> vec;
-    std::string line;
-
-    // read (and ignore) header
-    getline(in, line);
-
-    int index = 0;
-
-    while(getline(in, line))
+    // limit by node
+    if(nodeIndex != NODES_ALL)
     {
-        Tokenizer tok(line);
-
-        vec.assign(tok.begin(), tok.end());
-
-        if(vec.size() != 3)
+        if(nodeIndex < lowerBound(0) || nodeIndex > upperBound(0))
         {
-            put_flog(LOG_ERROR, "number of values != 3, == %i", vec.size());
             return false;
         }
 
-        int nodeId = atoi(vec[0].c_str());
-
-        // nodeId vector
-        nodeIds_.push_back(nodeId);
-
-        // nodeId -> index mapping
-        nodeIdToIndex_[nodeId] = index;
+        lowerBound(0) = upperBound(0) = nodeIndex;
+    }
 
-        // nodeId -> name mapping
-        nodeIdToName_[nodeId] = vec[1];
+    // limit by stratification values
+    bool allStratifications = true;
 
-        // nodeId -> group name mapping
-        nodeIdToGroupName_[nodeId] = vec[2];
+    for(unsigned int i=0; i<stratificationValues.size(); i++)
+    {
+        if(stratificationValues[i] != STRATIFICATIONS_ALL)
+        {
+            if(stratificationValues[i] < lowerBound(1+i) || stratificationValues[i] > upperBound(1+i))
+            {
+                return false;
+            }
 
-        // group name -> nodeIds indexing
-        groupNameToNodeIds_[vec[2]].push_back(nodeId);
+            lowerBound(1+i) = upperBound(1+i) = stratificationValues[i];
 
-        index++;
+            allStratifications = false;
+        }
     }
 
-    numNodes_ = index;
-
-    return true;
-}
-
-bool EpidemicDataSet::loadNodePopulationFile(const char * filename)
-{
-    // make sure we have appropriate number of stratifications
-    if(stratifications_.size() < 1)
+    if(time < 0 || time >= numTimes_)
     {
-        put_flog(LOG_ERROR, "need at least 1 stratification, got %i", stratifications_.size());
         return false;
     }
 
-    std::ifstream in(filename);
+    std::map<std::string, VariableHistory>::const_iterator historyIter = variableHistories_.find(varName);
 
-    if(in.is_open() != true)
+    // times before the dense times are in the history
+    if(historyIter != variableHistories_.end() && time < historyIter->second.getNumTimes())
     {
-        put_flog(LOG_ERROR, "could not load file %s", filename);
-        return false;
-    }
-
-    // full shape of population variable: [time][node][stratifications...]
-    blitz::TinyVector<int, 2+NUM_STRATIFICATION_DIMENSIONS> shape;
-    shape(0) = 1; // one time step
-    shape(1) = numNodes_;
+        for(int n=lowerBound(0); n<=upperBound(0); n++)
+        {
+            const unsigned int * mask;
+            const int * values;
 
-    for(int j=0; j<NUM_STRATIFICATION_DIMENSIONS; j++)
-    {
-        shape(2 + j) = stratifications_[j].size();
-    }
+            if(historyIter->second.findBlock(time, n, mask, values) != true)
+            {
+                return false;
+            }
 
-    blitz::Array<float, 2+NUM_STRATIFICATION_DIMENSIONS> population(shape);
+            // all-zero block
+            if(mask == NULL)
+            {
+                continue;
+            }
 
-    population = 0.;
+            // walk the block in storage order, with its stratification values
+            blitz::TinyVector<int, NUM_STRATIFICATION_DIMENSIONS> index;
 
-    // the data file contains population data stratified only by the first stratification
-    // stratification values of 0 are assumed for all other stratifications
+            for(int d=0; d<NUM_STRATIFICATION_DIMENSIONS; d++)
+            {
+                index(d) = variable.lbound(2+d);
+            }
 
-    // use boost tokenizer to parse the file
-    typedef boost::tokenizer< boost::escaped_list_separator<char> > Tokenizer;
+            for(int i=0; ; i++)
+            {
+                if((mask[i / 32] & (1u << (i % 32))) != 0)
+                {
+                    bool selected = true;
+
+                    for(int d=0; d<NUM_STRATIFICATION_DIMENSIONS; d++)
+                    {
+                        if(index(d) < lowerBound(1+d) || index(d) > upperBound(1+d))
+                        {
+                            selected = false;
+                            break;
+                        }
+                    }
+
+                    if(selected == true)
+                    {
+                        count += *values;
+                    }
+
+                    values++;
+                }
+
+                // next stratification values; the last dimension varies fastest
+                int d = NUM_STRATIFICATION_DIMENSIONS-1;
+
+                for(; d>=0; d--)
+                {
+                    if(++index(d) <= variable.ubound(2+d))
+                    {
+                        break;
+                    }
+
+                    index(d) = variable.lbound(2+d);
+                }
+
+                if(d < 0)
+                {
+                    break;
+                }
+            }
+        }
 
-    std::vector<std::string> vec;
-    std::string line;
+        return true;
+    }
 
-    // read (and ignore) header
-    getline(in, line);
+    // values at time
+    const int * timeValues = variable.data() + getDenseTimeIndex(time) * variable.stride(0);
 
-    while(getline(in, line))
+    // all stratifications of a range of nodes are contiguous: sum them in a plain loop the compiler can vectorize
+    if(allStratifications == true && variable.isStorageContiguous() == true)
     {
-        Tokenizer tok(line);
+        const int * values = timeValues + (lowerBound(0) - variable.lbound(1)) * variable.stride(1);
+        int numValues = (upperBound(0) - lowerBound(0) + 1) * variable.stride(1);
 
-        vec.assign(tok.begin(), tok.end());
-
-        if(vec.size() != 1+stratifications_[0].size())
+        for(int i=0; i<numValues; i++)
         {
-            put_flog(LOG_ERROR, "number of values != %i, == %i", 1+stratifications_[0].size(), vec.size());
-            return false;
+            count += values[i];
         }
 
-        int time = 0;
-        int nodeId = atoi(vec[0].c_str());
+        return true;
+    }
+
+    // otherwise walk the subdomain: [node][stratifications...], the last dimension varying fastest
+    blitz::TinyVector<int, 1+NUM_STRATIFICATION_DIMENSIONS> index = lowerBound;
+
+    while(true)
+    {
+        int offset = 0;
 
-        if(nodeIdToIndex_.count(nodeId) == 0)
+        for(int d=0; d<1+NUM_STRATIFICATION_DIMENSIONS; d++)
         {
-            put_flog(LOG_ERROR, "could not map nodeId %i to an index", nodeId);
-            return false;
+            offset += (index(d) - variable.lbound(1+d)) * variable.stride(1+d);
         }
 
-        int nodeIndex = nodeIdToIndex_[nodeId];
+        count += timeValues[offset];
 
-        for(int i=0; i<(int)stratifications_[0].size(); i++)
-        {
-            // array position; all indices initialized to 0
-            blitz::TinyVector<int, 2+NUM_STRATIFICATION_DIMENSIONS> index(0);
+        int d = NUM_STRATIFICATION_DIMENSIONS;
 
-            index(0) = time;
-            index(1) = nodeIndex;
-            index(2) = i;
+        for(; d>=0; d--)
+        {
+            if(++index(d) <= upperBound(d))
+            {
+                break;
+            }
 
-            // all other stratification indices are zero
+            index(d) = lowerBound(d);
+        }
 
-            population(index) = atof(vec[1+i].c_str());
+        if(d < 0)
+        {
+            break;
         }
     }
 
-    // add to regular variables map
-    variables_["population"].reference(population);
-
     return true;
 }
 
-bool EpidemicDataSet::loadNodePopulationSecondStratificationFile(const char * filename)
+blitz::Array<int, 1+NUM_STRATIFICATION_DIMENSIONS> EpidemicDataSet::getHistorySlab(const std::string &varName, int time, int nodeIndex)
 {
-    // load data file indicating fractional split for the second stratification
-    // stratification values of 0 are assumed for all subsequent stratifications
+    if(variableHistories_.count(varName) == 0 || time < 0 || time >= variableHistories_[varName].getNumTimes())
+    {
+        put_flog(LOG_ERROR, "variable %s has no history for time %i", varName.c_str(), time);
+        return blitz::Array<int, 1+NUM_STRATIFICATION_DIMENSIONS>();
+    }
+
+    blitz::TinyVector<int, 1+NUM_STRATIFICATION_DIMENSIONS> lowerBound(0);
+    blitz::TinyVector<int, 1+NUM_STRATIFICATION_DIMENSIONS> shape;
+    shape(0) = numNodes_;
 
-    // make sure we have appropriate number of stratifications
-    if(stratifications_.size() < 2)
+    for(int j=0; j<NUM_STRATIFICATION_DIMENSIONS; j++)
     {
-        put_flog(LOG_ERROR, "need at least 2 stratifications, got %i", stratifications_.size());
-        return false;
+        shape(1 + j) = stratifications_[j].size();
     }
 
-    // the second stratification should be of size 2
-    if(stratifications_[1].size() != 2)
+    if(nodeIndex != NODES_ALL)
     {
-        put_flog(LOG_ERROR, "expected 2 stratifications, got %i", stratifications_[1].size());
-        return false;
+        lowerBound(0) = nodeIndex;
+        shape(0) = 1;
     }
 
-    std::ifstream in(filename);
+    blitz::Array<int, 1+NUM_STRATIFICATION_DIMENSIONS> slab(lowerBound, shape);
 
-    if(in.is_open() != true)
+    if(nodeIndex != NODES_ALL)
     {
-        put_flog(LOG_ERROR, "could not load file %s", filename);
-        return false;
+        variableHistories_[varName].getBlock(time, nodeIndex, slab.data());
+    }
+    else
+    {
+        variableHistories_[varName].getTime(time, slab.data());
     }
 
-    // use boost tokenizer to parse the file
-    typedef boost::tokenizer< boost::escaped_list_separator<char> > Tokenizer;
+    return slab;
+}
 
-    std::vector<std::string> vec;
-    std::string line;
 
-    // read (and ignore) header
-    getline(in, line);
+bool EpidemicDataSet::loadNetCdfFile(const char * filename)
+{
+#if USE_NETCDF // TODO: should handle this differently
+    // change netcdf library error behavior
+    NcError err(NcError::verbose_nonfatal);
 
-    // read data (one line)
-    getline(in, line);
+    // open the netcdf file; it is kept open so variables can be read lazily
+    boost::shared_ptr<NcFile> ncFile(new NcFile(filename, NcFile::ReadOnly));
 
-    Tokenizer tok(line);
+    if(!ncFile->is_valid())
+    {
+        put_flog(LOG_FATAL, "invalid file %s", filename);
+        return false;
+    }
 
-    vec.assign(tok.begin(), tok.end());
+    // get dimensions
+    NcDim * timeDim = ncFile->get_dim("time");
+    NcDim * nodesDim = ncFile->get_dim("nodes");
+    NcDim * stratificationsDim = ncFile->get_dim("stratifications");
 
-    if(vec.size() != stratifications_[0].size())
+    if(timeDim == NULL || nodesDim == NULL || stratificationsDim == NULL)
     {
-        put_flog(LOG_ERROR, "number of values != %i, == %i", stratifications_[0].size(), vec.size());
+        put_flog(LOG_FATAL, "could not find a required dimension");
         return false;
     }
 
-    int time = 0;
+    numTimes_ = timeDim->size();
 
-    for(int i=0; i<(int)nodeIds_.size(); i++)
+    // make sure we have the expected number of nodes
+    if(nodesDim->size() != numNodes_)
     {
-        int nodeId = nodeIds_[i];
+        put_flog(LOG_FATAL, "got %i nodes, expected %i", nodesDim->size(), numNodes_);
+        return false;
+    }
 
-        if(nodeIdToIndex_.count(nodeId) == 0)
-        {
-            put_flog(LOG_ERROR, "could not map nodeId %i to an index", nodeId);
-            return false;
-        }
+    put_flog(LOG_DEBUG, "file contains %i timesteps, %i nodes", numTimes_, numNodes_);
 
-        int nodeIndex = nodeIdToIndex_[nodeId];
+    // make sure number of stratifications matches our expectation...
+    int numExpectedStratifications = 1;
 
-        for(int j=0; j<(int)stratifications_[0].size(); j++)
-        {
-            // get total value over the first stratification
-            std::vector<int> stratificationValues(NUM_STRATIFICATION_DIMENSIONS, STRATIFICATIONS_ALL);
-            stratificationValues[0] = j;
+    for(unsigned int i=0; i<NUM_STRATIFICATION_DIMENSIONS; i++)
+    {
+        numExpectedStratifications *= stratifications_[i].size();
+    }
 
-            float total = getValue("population", time, nodeId, stratificationValues);
+    if(stratificationsDim->size() != numExpectedStratifications)
+    {
+        put_flog(LOG_FATAL, "got %i stratifications, expected %i", stratificationsDim->size(), numExpectedStratifications);
+        return false;
+    }
 
-            float fraction0 = atof(vec[j].c_str());
+    // get all float variables with dimensions (time, nodes, stratifications)
+    for(int i=0; i<ncFile->num_vars(); i++)
+    {
+        NcVar * ncVar = ncFile->get_var(i);
 
-            float value0 = total * fraction0;
-            float value1 = total * (1. - fraction0);
+        if(ncVar->num_dims() == 3 && ncVar->type() == ncFloat && strcmp(ncVar->get_dim(0)->name(), "time") == 0 && strcmp(ncVar->get_dim(1)->name(), "nodes") == 0 && strcmp(ncVar->get_dim(2)->name(), "stratifications") == 0)
+        {
+            put_flog(LOG_INFO, "found variable: %s", ncVar->name());
+
+            // values are read on demand, one time slab at a time
+            fileVariables_[std::string(ncVar->name())] = ncVar;
 
-            // array position; all indices initialized to 0
-            blitz::TinyVector<int, 2+NUM_STRATIFICATION_DIMENSIONS> index(0);
+            // file variables take precedence over regular variables of the same name
+            variables_.erase(std::string(ncVar->name()));
+        }
+    }
 
-            index(0) = time;
-            index(1) = nodeIndex;
-            index(2) = j;
+    ncFile_ = ncFile;
 
-            index(3) = 0;
-            variables_["population"](index) = value0;
+    // bound the slab cache by memory rather than by number of slabs
+    unsigned int slabSize = numExpectedStratifications * numNodes_ * sizeof(float);
 
-            index(3) = 1;
-            variables_["population"](index) = value1;
-        }
+    if(slabSize > 0)
+    {
+        slabCacheCapacity_ = std::max<unsigned int>(1, (unsigned int)NETCDF_SLAB_CACHE_MEGABYTES * 1024 * 1024 / slabSize);
     }
 
+    put_flog(LOG_DEBUG, "slab cache capacity: %i slabs", slabCacheCapacity_);
+#endif
     return true;
 }
 
-bool EpidemicDataSet::loadNodeTravelFile(const char * filename)
+bool EpidemicDataSet::loadStratificationsFile()
 {
-    std::ifstream in(filename);
+    std::string filename = g_dataDirectory + "/" + STRATIFICATIONS_FILENAME;
+
+    std::ifstream in(filename.c_str());
 
     if(in.is_open() != true)
     {
-        put_flog(LOG_ERROR, "could not load file %s", filename);
+        put_flog(LOG_ERROR, "could not load file %s", filename.c_str());
         return false;
     }
 
-    // full shape of travel variable: [node][node]
-    blitz::TinyVector<float, 2> shape;
-    shape(0) = numNodes_;
-    shape(1) = numNodes_;
-
-    blitz::Array<float, 2> travel(shape);
-
-    travel = 0.;
+    // clear existing entries
+    stratificationNames_.clear();
+    stratifications_.clear();
 
     // use boost tokenizer to parse the file
     typedef boost::tokenizer< boost::escaped_list_separator<char> > Tokenizer;
@@ -846,39 +1016,31 @@ bool EpidemicDataSet::loadNodeTravelFile(const char * filename)
     std::vector<std::string> vec;
     std::string line;
 
-    // read (and ignore) header
+    // read names of stratifications
     getline(in, line);
+    Tokenizer tok(line);
+    vec.assign(tok.begin(), tok.end());
 
-    int index = 0;
-
-    while(getline(in, line))
+    // make sure this matches what we expect
+    if(vec.size() != NUM_STRATIFICATION_DIMENSIONS)
     {
-        Tokenizer tok(line);
-
-        vec.assign(tok.begin(), tok.end());
+        put_flog(LOG_ERROR, "got %i stratification dimensions, expected %i", vec.size(), NUM_STRATIFICATION_DIMENSIONS);
+        return false;
+    }
 
-        if((int)vec.size() != numNodes_)
-        {
-            put_flog(LOG_ERROR, "number of values != %i, == %i", numNodes_, vec.size());
-            return false;
-        }
+    stratificationNames_ = vec;
 
-        for(int i=0; i<(int)vec.size(); i++)
-        {
-            travel(index, i) = atof(vec[i].c_str());
-        }
+    // read stratification value names
+    for(unsigned int i=0; i<NUM_STRATIFICATION_DIMENSIONS; i++)
+    {
+        vec.clear();
 
-        index++;
-    }
+        getline(in, line);
+        Tokenizer tok(line);
+        vec.assign(tok.begin(), tok.end());
 
-    // we should have read numNodes_ lines
-    if(index != numNodes_)
-    {
-        put_flog(LOG_ERROR, "expected %i lines, read %i", numNodes_, index);
-        return false;
+        stratifications_.push_back(vec);
     }
 
-    travel_.reference(travel);
-
     return true;
 }
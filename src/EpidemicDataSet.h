@@ -1,27 +1,36 @@
 #ifndef EPIDEMIC_DATA_SET_H
 #define EPIDEMIC_DATA_SET_H
 
+#include "VariableHistory.h"
+#include <list>
 #include <map>
+#include <set>
 #include <vector>
 #include <blitz/array.h>
 #include <boost/shared_ptr.hpp>
 #include <boost/function.hpp>
 
 class StockpileNetwork;
+class RegionData;
+class NcFile;
+class NcVar;
 
 // must be defined at compile time, and match definition in stratifications file
-// stratifications: [age group][risk group][vaccinated]
+// stratifications: [age group][risk group][vaccinated], as in StratificationLayout; this is the rank of the
+// runtime-shaped arrays of data sets, whose extents come from the stratifications file
 #define NUM_STRATIFICATION_DIMENSIONS 3
 #define STRATIFICATIONS_FILENAME "stratifications.csv"
 
 #define STRATIFICATIONS_ALL -1
 
-#define NODES_ALL -1
+// memory budget for time slabs of variables read lazily from NetCDF files
+#define NETCDF_SLAB_CACHE_MEGABYTES 256
+
+// times of regular variables kept dense, in a ring buffer; older times are moved to a compressed history
+// simulations write the newest time and read the one before it directly, so this must be at least 2
+#define DENSE_VARIABLE_TIMES 8
 
-// used for argument expansion
-#include <boost/preprocessor/repetition/enum.hpp>
-#define TEXT(z, n, text) text
-#define VECTOR_TO_ARGS(z, n, text) text[n]
+#define NODES_ALL -1
 
 class EpidemicDataSet
 {
@@ -32,40 +41,74 @@ class EpidemicDataSet
 
         bool isValid();
 
-        int getNumTimes();
-        int getNumNodes();
+        int getNumTimes() const;
+        int getNumNodes() const;
 
         static std::vector<std::string> getStratificationNames();
         static std::vector<std::vector<std::string> > getStratifications();
 
-        float getPopulation(int nodeId);
-        float getPopulation(std::vector<int> nodeIds);
+        // populations are summed in double precision, exactly for the integer counts of regions of any size
+        double getPopulation(int nodeId);
+        double getPopulation(const std::vector<int> &nodeIds);
         std::string getNodeName(int nodeId);
+
+        // returns -1 (and logs an error) if the node does not exist; ids from getNodeIds() always exist
         int getNodeIndex(int nodeId);
 
         std::vector<int> getNodeIds();
         std::vector<int> getNodeIds(std::string groupName);
         std::vector<std::string> getGroupNames();
         std::vector<std::string> getVariableNames();
+        bool isDerivedVariable(const std::string &varName);
+
+        // false for variables with a single value per node, which is attributed to the first stratum
+        bool isStratifiedVariable(const std::string &varName);
 
         float getTravel(int nodeId0, int nodeId1);
 
-        float getValue(const std::string &varName, const int &time, const int &nodeId, const std::vector<int> &stratificationValues=std::vector<int>());
-        float getValue(const std::string &varName, const int &time, const int &nodeId, const std::vector<std::vector<int> > &stratificationValuesSet);
-        float getValue(const std::string &varName, const int &time, const std::string &groupName, const std::vector<int> &stratificationValues=std::vector<int>());
+        // sums of regular variables are exact; they are accumulated from integer counts
+        double getValue(const std::string &varName, const int &time, const int &nodeId, const std::vector<int> &stratificationValues=std::vector<int>());
+        double getValue(const std::string &varName, const int &time, const int &nodeId, const std::vector<std::vector<int> > &stratificationValuesSet);
+        double getValue(const std::string &varName, const int &time, const std::string &groupName, const std::vector<int> &stratificationValues=std::vector<int>());
 
         bool newVariable(std::string varName);
         bool copyVariable(std::string sourceVarName, std::string destVarName);
+        // copy the previous time of a variable to the new time, moving the time it replaces in the ring buffer to the
+        // history; numTimes_ must already include the new time
         bool copyVariableToNewTimeStep(std::string varName);
 
-        // both of these return arrays that reference the original data!
+        // values of a variable at a time, as a copy; for variables read from a file, a cached slab
         blitz::Array<float, 1+NUM_STRATIFICATION_DIMENSIONS> getVariableAtTime(std::string varName, int time);
-        blitz::Array<float, 1+NUM_STRATIFICATION_DIMENSIONS> getVariableAtFinalTime(std::string varName);
+
+        // counts of a regular variable at the final time; this references the original data!
+        blitz::Array<int, 1+NUM_STRATIFICATION_DIMENSIONS> getVariableAtFinalTime(std::string varName);
 
         boost::shared_ptr<StockpileNetwork> getStockpileNetwork();
 
+        // memory of regular variables, as stored and as it would be if every time were dense
+        void getVariableMemoryUsage(long &bytes, long &denseBytes);
+
+        // const queries, for concurrent readers
+        // these neither modify the data set nor allocate, so any number of threads may call them at once while no thread
+        // changes the data set (simulating or appending a time, adding variables, loading)
+        // unlike getValue(), only regular variables are supported (derived variables call into the owner and file
+        // variables go through the slab cache) and errors are returned rather than logged
+
+        // returns -1 if the node does not exist
+        int findNodeIndex(int nodeId) const;
+
+        bool hasRegularVariable(const std::string &varName) const;
+
+        // sum of a regular variable at time over a node index (or NODES_ALL) and stratification values (entries may be
+        // STRATIFICATIONS_ALL; missing trailing entries are all stratifications)
+        // returns false if the variable, time, node index or stratification values are not valid
+        bool getCount(const std::string &varName, int time, int nodeIndex, const std::vector<int> &stratificationValues, long long &count) const;
+
     protected:
 
+        // deep copy of regular variables and the stockpile network; derived variables must be bound again by subclasses
+        EpidemicDataSet(const EpidemicDataSet &dataSet);
+
         bool isValid_;
 
         // dimensionality
@@ -76,39 +119,59 @@ class EpidemicDataSet
         static std::vector<std::string> stratificationNames_;
         static std::vector<std::vector<std::string> > stratifications_;
 
-        // node id's
-        std::vector<int> nodeIds_;
+        // shared static geography, population and travel inputs
+        boost::shared_ptr<const RegionData> regionData_;
 
-        // maps node id to array index
-        std::map<int, int> nodeIdToIndex_;
+        // all regular variables, as counts of people, for the most recent DENSE_VARIABLE_TIMES times
+        // the time dimension is a ring buffer of DENSE_VARIABLE_TIMES entries: time t is at getDenseTimeIndex(t)
+        std::map<std::string, blitz::Array<int, 2+NUM_STRATIFICATION_DIMENSIONS> > variables_;
 
-        // maps node id to name
-        std::map<int, std::string> nodeIdToName_;
+        // compressed times of regular variables before their dense times
+        std::map<std::string, VariableHistory> variableHistories_;
 
-        // maps node id to group name
-        std::map<int, std::string> nodeIdToGroupName_;
+        // variables read lazily from a NetCDF file; the file stays open for the lifetime of the data set
+        boost::shared_ptr<NcFile> ncFile_;
+        std::map<std::string, NcVar *> fileVariables_;
 
-        // maps group name to node id's
-        std::map<std::string, std::vector<int> > groupNameToNodeIds_;
+        // LRU cache of file variable time slabs: (variable, time) -> [node][stratifications...]
+        // most recently used slabs are at the front of the list
+        typedef std::pair<std::string, int> SlabKey;
+        typedef std::list<std::pair<SlabKey, blitz::Array<float, 1+NUM_STRATIFICATION_DIMENSIONS> > > SlabList;
 
-        // node -> node travel fractions
-        blitz::Array<float, 2> travel_;
+        SlabList slabCache_;
+        std::map<SlabKey, SlabList::iterator> slabCacheIndex_;
+        unsigned int slabCacheCapacity_;
 
-        // all regular variables
-        std::map<std::string, blitz::Array<float, 2+NUM_STRATIFICATION_DIMENSIONS> > variables_;
+        // regular variables stored only for time 0 and valid for all times
+        std::set<std::string> timeInvariantVariables_;
+
+        // variables not broken down by stratification; see isStratifiedVariable()
+        std::set<std::string> unstratifiedVariables_;
 
         // all derived variables
-        std::map<std::string, boost::function<float (int time, int nodeId, std::vector<int> stratificationValues)> > derivedVariables_;
+        std::map<std::string, boost::function<float (int time, int nodeId, const std::vector<int> &stratificationValues)> > derivedVariables_;
 
         // stockpile network
         boost::shared_ptr<StockpileNetwork> stockpileNetwork_;
 
         bool loadNetCdfFile(const char * filename);
+
+        // slab of a file variable at time; returns an empty array on error
+        blitz::Array<float, 1+NUM_STRATIFICATION_DIMENSIONS> getFileVariableSlab(const std::string &varName, int time);
         static bool loadStratificationsFile();
-        bool loadNodeNameGroupFile(const char * filename);
-        bool loadNodePopulationFile(const char * filename);
-        bool loadNodePopulationSecondStratificationFile(const char * filename);
-        bool loadNodeTravelFile(const char * filename);
+
+        // index of a dense time in the time dimension of regular variables
+        static int getDenseTimeIndex(int time);
+
+        // oldest time of a regular variable not in its compressed history
+        int getFirstDenseTime(const std::string &varName) const;
+
+        // slab of a regular variable at a time in its compressed history: [node][stratifications...]
+        // with a node index, only that node is decoded and the slab's node dimension starts at the index
+        blitz::Array<int, 1+NUM_STRATIFICATION_DIMENSIONS> getHistorySlab(const std::string &varName, int time, int nodeIndex=NODES_ALL);
+
+        // loads stratifications along with the rest of the base data
+        friend class RegionData;
 };
 
 #endif
@@ -9,11 +9,8 @@ EpidemicMapWidget::EpidemicMapWidget()
     setColorMapMaxLabel("1%");
 }
 
-void EpidemicMapWidget::setTime(int time)
+void EpidemicMapWidget::recolorCounties()
 {
-    MapWidget::setTime(time);
-
-    // recolor counties
     if(dataSet_ != NULL)
     {
         std::map<int, boost::shared_ptr<MapShape> >::iterator iter;
@@ -30,13 +27,6 @@ void EpidemicMapWidget::setTime(int time)
             iter->second->setColor(r, g, b);
         }
     }
-
-    // force redraw
-    update();
-
-#if USE_DISPLAYCLUSTER
-    exportSVGToDisplayCluster();
-#endif
 }
 
 void EpidemicMapWidget::render(QPainter * painter)
@@ -46,6 +36,14 @@ void EpidemicMapWidget::render(QPainter * painter)
 }
 
 void EpidemicMapWidget::renderCountyTravel(QPainter * painter)
+{
+    MapFrame frame;
+    captureOverlay(frame);
+
+    renderOverlay(painter, frame);
+}
+
+void EpidemicMapWidget::captureOverlay(MapFrame &frame)
 {
     // parameters
     float infectiousTravelerThreshhold = 1.;
@@ -88,8 +86,8 @@ void EpidemicMapWidget::renderCountyTravel(QPainter * painter)
                 {
                     float alpha = std::min<float>(.5, std::max<float>(.005, infectiousTravelers / infectiousTravelerAlphaScale));
 
-                    painter->setBrush(QBrush(QColor::fromRgbF(1, 0, 0, alpha)));
-                    painter->setPen(QPen(QBrush(QColor::fromRgbF(1, 0, 0, alpha * .1)), .1));
+                    frame.overlayBrushes.push_back(QBrush(QColor::fromRgbF(1, 0, 0, alpha)));
+                    frame.overlayPens.push_back(QPen(QBrush(QColor::fromRgbF(1, 0, 0, alpha * .1)), .1));
 
                     QVector<QPointF> points;
                     points.push_back(QPointF(lon0, lat0));
@@ -103,8 +101,7 @@ void EpidemicMapWidget::renderCountyTravel(QPainter * painter)
                     vec *= 10;
                     points.push_back(QPointF(lon0 - vec.y(), lat0 + vec.x()));
 
-                    QPolygonF polygon(points);
-                    painter->drawPolygon(polygon);
+                    frame.overlayPolygons.push_back(QPolygonF(points));
                 }
             }
         }
@@ -9,13 +9,12 @@ class EpidemicMapWidget : public MapWidget
 
         EpidemicMapWidget();
 
-        // re-implemented virtual methods
-        void setTime(int time);
-
     private:
 
-        // re-implemented virtual render method
+        // re-implemented virtual methods
         void render(QPainter * painter);
+        void recolorCounties();
+        void captureOverlay(MapFrame &frame);
 
         // travel between counties
         void renderCountyTravel(QPainter * painter);
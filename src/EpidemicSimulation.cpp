@@ -1,5 +1,6 @@
 #include "EpidemicSimulation.h"
 #include "StockpileNetwork.h"
+#include "Parameters.h"
 #include "log.h"
 
 EpidemicSimulation::EpidemicSimulation()
@@ -40,7 +41,7 @@ EpidemicSimulation::EpidemicSimulation()
     stockpileNetwork_ = stockpileNetwork;
 }
 
-int EpidemicSimulation::expose(int num, int nodeId, std::vector<int> stratificationValues)
+int EpidemicSimulation::expose(int num, int nodeId, const std::vector<int> &stratificationValues)
 {
     return transition(num, "susceptible", "exposed", nodeId, stratificationValues);
 }
@@ -50,47 +51,110 @@ void EpidemicSimulation::simulate()
 {
     put_flog(LOG_DEBUG, "");
 
+    profile_.beginDay(numTimes_);
+
     numTimes_++;
 
     // copy all variables to a new time
-    std::map<std::string, blitz::Array<float, 2+NUM_STRATIFICATION_DIMENSIONS> >::iterator iter;
+    profile_.beginPhase(SIMULATION_PHASE_COPY_VARIABLES);
+
+    std::map<std::string, blitz::Array<int, 2+NUM_STRATIFICATION_DIMENSIONS> >::iterator iter;
 
     for(iter=variables_.begin(); iter!=variables_.end(); iter++)
     {
         copyVariableToNewTimeStep(iter->first);
     }
 
+    profile_.endPhase(SIMULATION_PHASE_COPY_VARIABLES);
+
     // evolve stockpile network
+    profile_.beginPhase(SIMULATION_PHASE_STOCKPILES);
+
     stockpileNetwork_->evolve(numTimes_-1);
+
+    profile_.endPhase(SIMULATION_PHASE_STOCKPILES);
+
+    profile_.endDay();
+}
+
+boost::shared_ptr<EpidemicSimulation> EpidemicSimulation::clone()
+{
+    put_flog(LOG_ERROR, "clone() not implemented for this simulation");
+
+    return boost::shared_ptr<EpidemicSimulation>();
 }
 
-int EpidemicSimulation::transition(int num, std::string sourceVarName, std::string destVarName, int nodeId, std::vector<int> stratificationValues)
+void EpidemicSimulation::seed(unsigned long seed)
 {
-    blitz::Array<float, 1+NUM_STRATIFICATION_DIMENSIONS> sourceVarAtFinalTime = getVariableAtFinalTime(sourceVarName);
-    blitz::Array<float, 1+NUM_STRATIFICATION_DIMENSIONS> destVarAtFinalTime = getVariableAtFinalTime(destVarName);
+    // no random number generators in the base simulation
+}
+
+SimulationProfile &EpidemicSimulation::getProfile()
+{
+    return profile_;
+}
 
-    if(sourceVarAtFinalTime.size() == 0 || destVarAtFinalTime.size() == 0)
+Parameters &EpidemicSimulation::getParameters()
+{
+    if(parameters_ != NULL)
+    {
+        return *parameters_;
+    }
+
+    return g_parameters;
+}
+
+void EpidemicSimulation::setParameters(boost::shared_ptr<Parameters> parameters)
+{
+    parameters_ = parameters;
+}
+
+int EpidemicSimulation::transition(int num, const std::string &sourceVarName, const std::string &destVarName, int nodeId, const StratumIndex &stratumIndex)
+{
+    if(variables_.count(sourceVarName) == 0 || variables_.count(destVarName) == 0)
     {
         put_flog(LOG_ERROR, "could not transition, one of the variables does not exist");
-        return 0.;
+        return 0;
     }
 
+    blitz::Array<int, 2+NUM_STRATIFICATION_DIMENSIONS> &sourceVar = variables_[sourceVarName];
+    blitz::Array<int, 2+NUM_STRATIFICATION_DIMENSIONS> &destVar = variables_[destVarName];
+
     // todo: validate nodeIndex, stratification values are in bounds
 
-    int numSourceVar = sourceVarAtFinalTime(nodeIdToIndex_[nodeId], BOOST_PP_ENUM(NUM_STRATIFICATION_DIMENSIONS, VECTOR_TO_ARGS, stratificationValues));
+    int finalTimeIndex = getDenseTimeIndex(numTimes_ - 1);
+    int nodeIndex = getNodeIndex(nodeId);
+
+    if(nodeIndex == -1)
+    {
+        return 0;
+    }
+
+    int &numSourceVar = sourceVar(finalTimeIndex, nodeIndex, stratumIndex.ageGroup, stratumIndex.riskGroup, stratumIndex.vaccinated);
 
     int numTransition = num;
 
     if(numTransition > numSourceVar)
     {
-        put_flog(LOG_WARN, "bounding transition amount of %i to source quantity %i (%s -> %s)", num, numSourceVar, sourceVarName.c_str(), destVarName.c_str());
+        put_slog(LOG_WARN, "event=bounded_transition requested=%i available=%i source=\"%s\" destination=\"%s\" node=%i", num, numSourceVar, sourceVarName.c_str(), destVarName.c_str(), nodeId);
 
         numTransition = numSourceVar;
     }
 
-    sourceVarAtFinalTime(nodeIdToIndex_[nodeId], BOOST_PP_ENUM(NUM_STRATIFICATION_DIMENSIONS, VECTOR_TO_ARGS, stratificationValues)) -= numTransition;
+    numSourceVar -= numTransition;
 
-    destVarAtFinalTime(nodeIdToIndex_[nodeId], BOOST_PP_ENUM(NUM_STRATIFICATION_DIMENSIONS, VECTOR_TO_ARGS, stratificationValues)) += numTransition;
+    destVar(finalTimeIndex, nodeIndex, stratumIndex.ageGroup, stratumIndex.riskGroup, stratumIndex.vaccinated) += numTransition;
 
     return numTransition;
 }
+
+int EpidemicSimulation::transition(int num, const std::string &sourceVarName, const std::string &destVarName, int nodeId, const std::vector<int> &stratificationValues)
+{
+    if(stratificationValues.size() != NUM_STRATIFICATION_DIMENSIONS)
+    {
+        put_flog(LOG_ERROR, "could not transition, got %i stratification values", (int)stratificationValues.size());
+        return 0;
+    }
+
+    return transition(num, sourceVarName, destVarName, nodeId, StratumIndex(stratificationValues));
+}
@@ -2,6 +2,10 @@
 #define EPIDEMIC_SIMULATION_H
 
 #include "EpidemicDataSet.h"
+#include "SimulationProfile.h"
+#include "StratifiedArray.h"
+
+class Parameters;
 
 class EpidemicSimulation : public EpidemicDataSet
 {
@@ -11,13 +15,36 @@ class EpidemicSimulation : public EpidemicDataSet
 
         // expose <num> people in <nodeId> from the subset <stratificationValues>; returns number of actually exposed people
         // this moves them from the susceptible variable to the exposed variable
-        virtual int expose(int num, int nodeId, std::vector<int> stratificationValues);
+        virtual int expose(int num, int nodeId, const std::vector<int> &stratificationValues);
 
         virtual void simulate();
 
+        // an independent copy of the current simulation state, e.g. for what-if evaluations
+        // returns NULL if the model does not support it
+        virtual boost::shared_ptr<EpidemicSimulation> clone();
+
+        // seed the random number generators of the simulation
+        virtual void seed(unsigned long seed);
+
+        // timings and counters for simulate(), if enabled
+        SimulationProfile &getProfile();
+
+        // model parameters; the global parameters unless the simulation was given its own (e.g. in a parameter sweep)
+        // copies made by clone() share the parameters of the original
+        Parameters &getParameters();
+        void setParameters(boost::shared_ptr<Parameters> parameters);
+
     protected:
 
-        int transition(int num, std::string sourceVarName, std::string destVarName, int nodeId, std::vector<int> stratificationValues);
+        SimulationProfile profile_;
+
+        // NULL for the global parameters
+        boost::shared_ptr<Parameters> parameters_;
+
+        // move <num> people of a stratification in <nodeId> between variables at the final time, bounded by the number
+        // available; returns the number moved
+        int transition(int num, const std::string &sourceVarName, const std::string &destVarName, int nodeId, const StratumIndex &stratumIndex);
+        int transition(int num, const std::string &sourceVarName, const std::string &destVarName, int nodeId, const std::vector<int> &stratificationValues);
 
 };
 
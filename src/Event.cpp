@@ -5,3 +5,8 @@ Event::Event()
 {
     put_flog(LOG_DEBUG, "");
 }
+
+void Event::compile(EventMonitor * monitor)
+{
+    // no aggregates needed by default
+}
@@ -13,6 +13,10 @@ class Event : public boost::enable_shared_from_this<Event>
 
         Event();
 
+        // called once when the event is added to a monitor: register the group aggregates the event needs
+        virtual void compile(EventMonitor * monitor);
+
+        // called once per new time step, after the monitor has computed its group aggregates
         virtual boost::shared_ptr<EventMessage> check(EventMonitor * monitor) = 0;
 };
 
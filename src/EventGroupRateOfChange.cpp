@@ -0,0 +1,87 @@
+#include "EventGroupRateOfChange.h"
+#include "EventMonitor.h"
+#include "EventMessage.h"
+#include "EpidemicDataSet.h"
+#include "log.h"
+#include <boost/lexical_cast.hpp>
+
+EventGroupRateOfChange::EventGroupRateOfChange(std::string groupName, std::string varName, int days, std::vector<float> thresholds, float minimumValue)
+{
+    // assign values
+    groupName_ = groupName;
+    varName_ = varName;
+    days_ = days;
+    thresholds_ = thresholds;
+    minimumValue_ = minimumValue;
+
+    // defaults
+    groupIndex_ = -1;
+    valueAggregateIndex_ = -1;
+    previousValueAggregateIndex_ = -1;
+}
+
+void EventGroupRateOfChange::compile(EventMonitor * monitor)
+{
+    groupIndex_ = monitor->getGroupIndex(groupName_);
+
+    if(groupIndex_ == -1)
+    {
+        put_flog(LOG_ERROR, "no such group %s", groupName_.c_str());
+        return;
+    }
+
+    valueAggregateIndex_ = monitor->registerGroupAggregate(varName_);
+    previousValueAggregateIndex_ = monitor->registerGroupAggregate(varName_, days_);
+}
+
+boost::shared_ptr<EventMessage> EventGroupRateOfChange::check(EventMonitor * monitor)
+{
+    // when a threshold event occurs, the lower thresholds will also be erased
+
+    boost::shared_ptr<EpidemicDataSet> dataSet = monitor->getDataSet();
+
+    if(dataSet == NULL)
+    {
+        put_flog(LOG_ERROR, "unable to get EpidemicDataSet");
+        return boost::shared_ptr<EventMessage>();
+    }
+
+    int time = dataSet->getNumTimes()-1;
+
+    // need a full period of history
+    if(groupIndex_ == -1 || time < days_)
+    {
+        return boost::shared_ptr<EventMessage>();
+    }
+
+    float value = monitor->getGroupAggregate(valueAggregateIndex_, groupIndex_);
+    float previousValue = monitor->getGroupAggregate(previousValueAggregateIndex_, groupIndex_);
+
+    if(previousValue < minimumValue_ || previousValue <= 0.)
+    {
+        return boost::shared_ptr<EventMessage>();
+    }
+
+    float growth = (value - previousValue) / previousValue;
+
+    for(int i=thresholds_.size()-1; i>=0; i--)
+    {
+        if(growth >= thresholds_[i])
+        {
+            char percentageString[64];
+            sprintf(percentageString, "%.0f", growth * 100.);
+
+            std::string messageString = "<b>Day " + boost::lexical_cast<std::string>(time) + "</b>: ";
+            messageString += varName_ + " in " + groupName_ + " increased by " + std::string(percentageString) + "% (to " + boost::lexical_cast<std::string>((int)value) + ") over the last " + boost::lexical_cast<std::string>(days_) + " days.";
+
+            std::string shortMessageString = "+" + std::string(percentageString) + "%-" + groupName_;
+
+            // erase this and previous thresholds, since they've already been exceeded
+            thresholds_.erase(thresholds_.begin(), thresholds_.begin() + i+1);
+
+            return boost::shared_ptr<EventMessage>(new EventMessage(shared_from_this(), messageString, shortMessageString, time, 1));
+        }
+    }
+
+    return boost::shared_ptr<EventMessage>();
+}
@@ -0,0 +1,36 @@
+#ifndef EVENT_GROUP_RATE_OF_CHANGE_H
+#define EVENT_GROUP_RATE_OF_CHANGE_H
+
+#include "Event.h"
+#include <vector>
+#include <string>
+
+class EventMonitor;
+struct EventMessage;
+
+// fires when a variable in a group has grown by a fraction (e.g. 1.0 == doubled) over the last days
+// growth is only considered once the earlier value is at least minimumValue
+class EventGroupRateOfChange : public Event
+{
+    public:
+
+        EventGroupRateOfChange(std::string groupName, std::string varName, int days, std::vector<float> thresholds, float minimumValue);
+
+        void compile(EventMonitor * monitor);
+        boost::shared_ptr<EventMessage> check(EventMonitor * monitor);
+
+    private:
+
+        std::string groupName_;
+        std::string varName_;
+        int days_;
+        std::vector<float> thresholds_;
+        float minimumValue_;
+
+        // compiled indices into the monitor's group aggregates
+        int groupIndex_;
+        int valueAggregateIndex_;
+        int previousValueAggregateIndex_;
+};
+
+#endif
@@ -0,0 +1,86 @@
+#include "EventGroupRatio.h"
+#include "EventMonitor.h"
+#include "EventMessage.h"
+#include "EpidemicDataSet.h"
+#include "log.h"
+#include <boost/lexical_cast.hpp>
+
+EventGroupRatio::EventGroupRatio(std::string groupName, std::string numeratorVarName, std::string denominatorVarName, std::vector<float> thresholds, float minimumDenominator)
+{
+    // assign values
+    groupName_ = groupName;
+    numeratorVarName_ = numeratorVarName;
+    denominatorVarName_ = denominatorVarName;
+    thresholds_ = thresholds;
+    minimumDenominator_ = minimumDenominator;
+
+    // defaults
+    groupIndex_ = -1;
+    numeratorAggregateIndex_ = -1;
+    denominatorAggregateIndex_ = -1;
+}
+
+void EventGroupRatio::compile(EventMonitor * monitor)
+{
+    groupIndex_ = monitor->getGroupIndex(groupName_);
+
+    if(groupIndex_ == -1)
+    {
+        put_flog(LOG_ERROR, "no such group %s", groupName_.c_str());
+        return;
+    }
+
+    numeratorAggregateIndex_ = monitor->registerGroupAggregate(numeratorVarName_);
+    denominatorAggregateIndex_ = monitor->registerGroupAggregate(denominatorVarName_);
+}
+
+boost::shared_ptr<EventMessage> EventGroupRatio::check(EventMonitor * monitor)
+{
+    // when a threshold event occurs, the lower thresholds will also be erased
+
+    boost::shared_ptr<EpidemicDataSet> dataSet = monitor->getDataSet();
+
+    if(dataSet == NULL)
+    {
+        put_flog(LOG_ERROR, "unable to get EpidemicDataSet");
+        return boost::shared_ptr<EventMessage>();
+    }
+
+    if(groupIndex_ == -1)
+    {
+        return boost::shared_ptr<EventMessage>();
+    }
+
+    int time = dataSet->getNumTimes()-1;
+
+    float numerator = monitor->getGroupAggregate(numeratorAggregateIndex_, groupIndex_);
+    float denominator = monitor->getGroupAggregate(denominatorAggregateIndex_, groupIndex_);
+
+    if(denominator < minimumDenominator_ || denominator <= 0.)
+    {
+        return boost::shared_ptr<EventMessage>();
+    }
+
+    float ratio = numerator / denominator;
+
+    for(int i=thresholds_.size()-1; i>=0; i--)
+    {
+        if(ratio >= thresholds_[i])
+        {
+            char percentageString[64];
+            sprintf(percentageString, "%.2f", ratio * 100.);
+
+            std::string messageString = "<b>Day " + boost::lexical_cast<std::string>(time) + "</b>: ";
+            messageString += numeratorVarName_ + " is now " + std::string(percentageString) + "% of " + denominatorVarName_ + " in " + groupName_ + ".";
+
+            std::string shortMessageString = std::string(percentageString) + "%r-" + groupName_;
+
+            // erase this and previous thresholds, since they've already been exceeded
+            thresholds_.erase(thresholds_.begin(), thresholds_.begin() + i+1);
+
+            return boost::shared_ptr<EventMessage>(new EventMessage(shared_from_this(), messageString, shortMessageString, time, 0));
+        }
+    }
+
+    return boost::shared_ptr<EventMessage>();
+}
@@ -0,0 +1,36 @@
+#ifndef EVENT_GROUP_RATIO_H
+#define EVENT_GROUP_RATIO_H
+
+#include "Event.h"
+#include <vector>
+#include <string>
+
+class EventMonitor;
+struct EventMessage;
+
+// fires when the ratio of two variables in a group (e.g. deceased / All infected) reaches a threshold
+// the ratio is only considered once the denominator is at least minimumDenominator
+class EventGroupRatio : public Event
+{
+    public:
+
+        EventGroupRatio(std::string groupName, std::string numeratorVarName, std::string denominatorVarName, std::vector<float> thresholds, float minimumDenominator);
+
+        void compile(EventMonitor * monitor);
+        boost::shared_ptr<EventMessage> check(EventMonitor * monitor);
+
+    private:
+
+        std::string groupName_;
+        std::string numeratorVarName_;
+        std::string denominatorVarName_;
+        std::vector<float> thresholds_;
+        float minimumDenominator_;
+
+        // compiled indices into the monitor's group aggregates
+        int groupIndex_;
+        int numeratorAggregateIndex_;
+        int denominatorAggregateIndex_;
+};
+
+#endif
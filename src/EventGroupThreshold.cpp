@@ -12,6 +12,29 @@ EventGroupThreshold::EventGroupThreshold(std::string groupName, std::string varN
     varName_ = varName;
     thresholds_ = thresholds;
     fractional_ = fractional;
+
+    // defaults
+    groupIndex_ = -1;
+    valueAggregateIndex_ = -1;
+    populationAggregateIndex_ = -1;
+}
+
+void EventGroupThreshold::compile(EventMonitor * monitor)
+{
+    groupIndex_ = monitor->getGroupIndex(groupName_);
+
+    if(groupIndex_ == -1)
+    {
+        put_flog(LOG_ERROR, "no such group %s", groupName_.c_str());
+        return;
+    }
+
+    valueAggregateIndex_ = monitor->registerGroupAggregate(varName_);
+
+    if(fractional_ == true)
+    {
+        populationAggregateIndex_ = monitor->registerGroupAggregate("population");
+    }
 }
 
 boost::shared_ptr<EventMessage> EventGroupThreshold::check(EventMonitor * monitor)
@@ -29,13 +52,23 @@ boost::shared_ptr<EventMessage> EventGroupThreshold::check(EventMonitor * monito
         return boost::shared_ptr<EventMessage>();
     }
 
+    if(groupIndex_ == -1)
+    {
+        return boost::shared_ptr<EventMessage>();
+    }
+
     int time = dataSet->getNumTimes()-1;
 
-    for(int i=thresholds_.size()-1; i>=0; i--)
+    float value = monitor->getGroupAggregate(valueAggregateIndex_, groupIndex_);
+    float population = 0.;
+
+    if(fractional_ == true)
     {
-        float value = dataSet->getValue(varName_, dataSet->getNumTimes()-1, groupName_);
-        float population = dataSet->getValue("population", dataSet->getNumTimes()-1, groupName_);
+        population = monitor->getGroupAggregate(populationAggregateIndex_, groupIndex_);
+    }
 
+    for(int i=thresholds_.size()-1; i>=0; i--)
+    {
         if(fractional_ == false && value >= thresholds_[i])
         {
             std::string messageString = "<b>Day " + boost::lexical_cast<std::string>(time) + "</b>: ";
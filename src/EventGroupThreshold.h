@@ -14,6 +14,7 @@ class EventGroupThreshold : public Event
 
         EventGroupThreshold(std::string groupName, std::string varName, std::vector<float> thresholds, bool fractional);
 
+        void compile(EventMonitor * monitor);
         boost::shared_ptr<EventMessage> check(EventMonitor * monitor);
 
     private:
@@ -23,6 +24,11 @@ class EventGroupThreshold : public Event
         std::vector<float> thresholds_;
         bool fractional_;
 
+        // compiled indices into the monitor's group aggregates
+        int groupIndex_;
+        int valueAggregateIndex_;
+        int populationAggregateIndex_;
+
         // message corresponding to a detected event
         boost::shared_ptr<EventMessage> message_;
 };
@@ -2,9 +2,11 @@
 #include "MainWindow.h"
 #include "EpidemicDataSet.h"
 #include "Event.h"
+#include "EventGroupRateOfChange.h"
 #include "EventGroupThreshold.h"
 #include "EventMessage.h"
 #include "log.h"
+#include <algorithm>
 
 EventMonitor::EventMonitor(MainWindow * mainWindow)
 {
@@ -41,10 +43,16 @@ void EventMonitor::setDataSet(boost::shared_ptr<EpidemicDataSet> dataSet)
 {
     dataSet_ = dataSet;
 
-    // clear existing events and messages
+    // clear existing events, messages and aggregates
     events_.clear();
     messages_.clear();
 
+    groupNames_.clear();
+    nodeGroupIndices_.clear();
+    aggregates_.clear();
+    aggregateIndices_.clear();
+    aggregateValues_.clear();
+
     emit(clearMessages());
 
     if(dataSet == NULL)
@@ -52,6 +60,20 @@ void EventMonitor::setDataSet(boost::shared_ptr<EpidemicDataSet> dataSet)
         return;
     }
 
+    // group membership of each node
+    groupNames_ = dataSet->getGroupNames();
+    nodeGroupIndices_.resize(dataSet->getNumNodes());
+
+    for(unsigned int i=0; i<groupNames_.size(); i++)
+    {
+        std::vector<int> nodeIds = dataSet->getNodeIds(groupNames_[i]);
+
+        for(unsigned int j=0; j<nodeIds.size(); j++)
+        {
+            nodeGroupIndices_[dataSet->getNodeIndex(nodeIds[j])].push_back(i);
+        }
+    }
+
     // new default events
     // todo: change these to something for sensible...
     std::vector<std::string> groupNames = dataSet->getGroupNames();
@@ -79,9 +101,60 @@ void EventMonitor::setDataSet(boost::shared_ptr<EpidemicDataSet> dataSet)
 
         boost::shared_ptr<Event> event2(new EventGroupThreshold(groupNames[i], "deceased", deceasedThresholds, false));
 
-        events_.push_back(event1);
-        events_.push_back(event2);
+        // infections doubling within a week
+        std::vector<float> infectedGrowthThresholds;
+        infectedGrowthThresholds.push_back(1.);
+
+        boost::shared_ptr<Event> event3(new EventGroupRateOfChange(groupNames[i], "All infected", 7, infectedGrowthThresholds, 100.));
+
+        addEvent(event1);
+        addEvent(event2);
+        addEvent(event3);
+    }
+}
+
+void EventMonitor::addEvent(boost::shared_ptr<Event> event)
+{
+    event->compile(this);
+
+    events_.push_back(event);
+}
+
+int EventMonitor::registerGroupAggregate(std::string varName, int timeOffset)
+{
+    std::pair<std::string, int> aggregate(varName, timeOffset);
+
+    if(aggregateIndices_.count(aggregate) == 0)
+    {
+        aggregateIndices_[aggregate] = aggregates_.size();
+        aggregates_.push_back(aggregate);
+        aggregateValues_.push_back(std::vector<float>(groupNames_.size(), 0.));
+    }
+
+    return aggregateIndices_[aggregate];
+}
+
+int EventMonitor::getGroupIndex(std::string groupName)
+{
+    std::vector<std::string>::iterator iter = std::find(groupNames_.begin(), groupNames_.end(), groupName);
+
+    if(iter == groupNames_.end())
+    {
+        return -1;
+    }
+
+    return iter - groupNames_.begin();
+}
+
+float EventMonitor::getGroupAggregate(int aggregateIndex, int groupIndex)
+{
+    if(aggregateIndex < 0 || aggregateIndex >= (int)aggregateValues_.size() || groupIndex < 0 || groupIndex >= (int)groupNames_.size())
+    {
+        put_flog(LOG_ERROR, "invalid aggregate index %i or group index %i", aggregateIndex, groupIndex);
+        return 0.;
     }
+
+    return aggregateValues_[aggregateIndex][groupIndex];
 }
 
 void EventMonitor::setTime(int time)
@@ -91,6 +164,13 @@ void EventMonitor::setTime(int time)
 
 void EventMonitor::checkForEvents()
 {
+    if(dataSet_ == NULL)
+    {
+        return;
+    }
+
+    computeGroupAggregates();
+
     for(unsigned int i=0; i<events_.size(); i++)
     {
         boost::shared_ptr<EventMessage> message = events_[i]->check(this);
@@ -105,3 +185,62 @@ void EventMonitor::checkForEvents()
         }
     }
 }
+
+void EventMonitor::computeGroupAggregates()
+{
+    int latestTime = dataSet_->getNumTimes() - 1;
+
+    std::vector<int> nodeIds = dataSet_->getNodeIds();
+
+    for(unsigned int a=0; a<aggregates_.size(); a++)
+    {
+        const std::string &varName = aggregates_[a].first;
+        int time = std::max(0, latestTime - aggregates_[a].second);
+
+        std::vector<float> &values = aggregateValues_[a];
+        values.assign(groupNames_.size(), 0.);
+
+        // regular variables are summed directly from the time slab; derived variables are evaluated per node
+        blitz::Array<float, 1+NUM_STRATIFICATION_DIMENSIONS> slab;
+
+        bool derived = dataSet_->isDerivedVariable(varName);
+
+        if(derived != true)
+        {
+            slab.reference(dataSet_->getVariableAtTime(varName, time));
+
+            if(slab.size() == 0)
+            {
+                continue;
+            }
+        }
+
+        for(unsigned int n=0; n<nodeIds.size() && n<nodeGroupIndices_.size(); n++)
+        {
+            if(nodeGroupIndices_[n].size() == 0)
+            {
+                continue;
+            }
+
+            float value;
+
+            if(derived == true)
+            {
+                value = dataSet_->getValue(varName, time, nodeIds[n]);
+            }
+            else
+            {
+                blitz::TinyVector<int, 1+NUM_STRATIFICATION_DIMENSIONS> lowerBound = slab.lbound();
+                blitz::TinyVector<int, 1+NUM_STRATIFICATION_DIMENSIONS> upperBound = slab.ubound();
+                lowerBound(0) = upperBound(0) = n;
+
+                value = blitz::sum(slab(blitz::RectDomain<1+NUM_STRATIFICATION_DIMENSIONS>(lowerBound, upperBound)));
+            }
+
+            for(unsigned int g=0; g<nodeGroupIndices_[n].size(); g++)
+            {
+                values[nodeGroupIndices_[n][g]] += value;
+            }
+        }
+    }
+}
@@ -2,6 +2,9 @@
 #define EVENT_MONITOR_H
 
 #include <QtGui>
+#include <map>
+#include <string>
+#include <utility>
 #include <vector>
 #include <boost/shared_ptr.hpp>
 
@@ -23,6 +26,21 @@ class EventMonitor : public QObject
 
         std::vector<boost::shared_ptr<EventMessage> > getMessages();
 
+        // add an event; the event is compiled against this monitor's data set
+        void addEvent(boost::shared_ptr<Event> event);
+
+        // group aggregates are computed once per time step, in a single pass over nodes for each variable,
+        // and shared by all events
+
+        // register the sum of varName over each group, timeOffset days before the latest time; returns the aggregate index
+        int registerGroupAggregate(std::string varName, int timeOffset=0);
+
+        // index of group; -1 if it doesn't exist
+        int getGroupIndex(std::string groupName);
+
+        // value of a registered aggregate for a group, computed for the latest time
+        float getGroupAggregate(int aggregateIndex, int groupIndex);
+
     signals:
 
         void clearMessages();
@@ -47,6 +65,19 @@ class EventMonitor : public QObject
 
         // the resulting event messages
         std::vector<boost::shared_ptr<EventMessage> > messages_;
+
+        // groups, and the group indices of each node index
+        std::vector<std::string> groupNames_;
+        std::vector<std::vector<int> > nodeGroupIndices_;
+
+        // registered aggregates: (variable name, time offset)
+        std::vector<std::pair<std::string, int> > aggregates_;
+        std::map<std::pair<std::string, int>, int> aggregateIndices_;
+
+        // aggregate values: [aggregate index][group index]
+        std::vector<std::vector<float> > aggregateValues_;
+
+        void computeGroupAggregates();
 };
 
 #endif
@@ -10,11 +10,8 @@ IliMapWidget::IliMapWidget()
     setColorMapMaxLabel("1%");
 }
 
-void IliMapWidget::setTime(int time)
+void IliMapWidget::recolorCounties()
 {
-    MapWidget::setTime(time);
-
-    // recolor counties
     if(dataSet_ != NULL)
     {
         std::map<int, boost::shared_ptr<MapShape> >::iterator iter;
@@ -28,9 +25,7 @@ void IliMapWidget::setTime(int time)
 
             if(simulation != NULL)
             {
-                std::vector<Provider> providers = simulation->getIliProviders();
-
-                if(providers[simulation->getNodeIndex(iter->first)].status.size() == 0)
+                if(simulation->getNumIliProviders(iter->first) == 0)
                 {
                     hasProvider = false;
                 }
@@ -57,13 +52,6 @@ void IliMapWidget::setTime(int time)
             }
         }
     }
-
-    // force redraw
-    update();
-
-#if USE_DISPLAYCLUSTER
-    exportSVGToDisplayCluster();
-#endif
 }
 
 void IliMapWidget::render(QPainter * painter)
@@ -9,13 +9,11 @@ class IliMapWidget : public MapWidget
 
         IliMapWidget();
 
-        // re-implemented virtual methods
-        void setTime(int time);
-
     private:
 
-        // re-implemented virtual render method
+        // re-implemented virtual methods
         void render(QPainter * painter);
+        void recolorCounties();
 };
 
 #endif
@@ -0,0 +1,456 @@
+#include "IliParticleFilter.h"
+#include "EpidemicSimulation.h"
+#include "models/disease/StochasticSEATIRD.h"
+#include "models/MersenneTwister.h"
+#include "log.h"
+#include <QtConcurrentMap>
+#include <algorithm>
+#include <cmath>
+
+// lower bound on the variance of an observation (in people), for nodes with few infections and little report noise
+#define ILI_PARTICLE_FILTER_MINIMUM_VARIANCE 1.
+
+// log(2 pi), for the Gaussian density
+#define ILI_PARTICLE_FILTER_LOG_2PI 1.8378770664093453
+
+// advances a particle to an observation and returns the log-likelihood of the observation; used from worker threads
+// each particle only touches its own state
+struct IliParticleRunner
+{
+    typedef double result_type;
+
+    IliParticleRunner(const IliObservation * observation) : observation_(observation) { }
+
+    double operator()(const boost::shared_ptr<StochasticSEATIRD> &particle) const
+    {
+        while(particle->getNumTimes() - 1 < observation_->time)
+        {
+            particle->simulate();
+        }
+
+        double logLikelihood = 0.;
+
+        int firstTime = std::max(1, observation_->time - ILI_PARTICLE_FILTER_DAYS_PER_OBSERVATION + 1);
+
+        for(std::map<int, float>::const_iterator iter=observation_->reports.begin(); iter!=observation_->reports.end(); iter++)
+        {
+            // moments of the mean of the daily reports, which are correlated through the providers' reporting status
+            float reportMean, reportVariance;
+            particle->getIliReportMoments(firstTime, observation_->time, iter->first, reportMean, reportVariance);
+
+            double mean = reportMean;
+            double variance = std::max(ILI_PARTICLE_FILTER_MINIMUM_VARIANCE, (double)reportVariance);
+
+            double residual = (double)iter->second - mean;
+
+            logLikelihood += -0.5 * (ILI_PARTICLE_FILTER_LOG_2PI + log(variance) + residual * residual / variance);
+        }
+
+        return logLikelihood;
+    }
+
+    const IliObservation * observation_;
+};
+
+IliParticleFilter::IliParticleFilter(boost::shared_ptr<EpidemicSimulation> simulation)
+{
+    simulation_ = simulation;
+
+    // defaults
+    numParticles_ = ILI_PARTICLE_FILTER_DEFAULT_NUM_PARTICLES;
+    resampleThreshold_ = ILI_PARTICLE_FILTER_DEFAULT_RESAMPLE_THRESHOLD;
+    seed_ = 0;
+
+    effectiveSampleSize_ = 0.;
+    logLikelihood_ = 0.;
+}
+
+void IliParticleFilter::setNumParticles(int numParticles)
+{
+    numParticles_ = numParticles;
+}
+
+void IliParticleFilter::setResampleThreshold(double resampleThreshold)
+{
+    resampleThreshold_ = resampleThreshold;
+}
+
+void IliParticleFilter::setSeed(unsigned long seed)
+{
+    seed_ = seed;
+}
+
+bool IliParticleFilter::readObservations(std::string filename, std::vector<IliObservation> &observations)
+{
+    QFile file(filename.c_str());
+
+    if(file.open(QIODevice::ReadOnly | QIODevice::Text) != true)
+    {
+        put_flog(LOG_ERROR, "could not open %s", filename.c_str());
+        return false;
+    }
+
+    std::map<int, IliObservation> observationsByTime;
+
+    int lineNumber = 0;
+
+    while(file.atEnd() != true)
+    {
+        QString line = QString(file.readLine()).trimmed();
+        lineNumber++;
+
+        if(line.isEmpty() == true || line.startsWith("#") == true)
+        {
+            continue;
+        }
+
+        QStringList fields = line.split(',');
+
+        bool ok[3] = { false, false, false };
+
+        int time = 0;
+        int nodeId = 0;
+        float report = 0.;
+
+        if(fields.size() == 3)
+        {
+            time = fields[0].trimmed().toInt(&ok[0]);
+            nodeId = fields[1].trimmed().toInt(&ok[1]);
+            report = fields[2].trimmed().toFloat(&ok[2]);
+        }
+
+        if(ok[0] != true || ok[1] != true || ok[2] != true)
+        {
+            put_flog(LOG_ERROR, "%s:%i: expected time, node id, ILI reports", filename.c_str(), lineNumber);
+            return false;
+        }
+
+        observationsByTime[time].time = time;
+        observationsByTime[time].reports[nodeId] = report;
+    }
+
+    observations.clear();
+
+    for(std::map<int, IliObservation>::iterator iter=observationsByTime.begin(); iter!=observationsByTime.end(); iter++)
+    {
+        observations.push_back(iter->second);
+    }
+
+    put_flog(LOG_INFO, "read %i observations from %s", (int)observations.size(), filename.c_str());
+
+    return true;
+}
+
+bool IliParticleFilter::assimilate(const IliObservation &observation, QWidget * progressParent)
+{
+    if(particles_.size() == 0 && createParticles() != true)
+    {
+        return false;
+    }
+
+    if(observation.time <= getTime())
+    {
+        put_flog(LOG_ERROR, "observation at time %i is not after the particles' time %i", observation.time, getTime());
+        return false;
+    }
+
+    // only nodes with ILI providers are informative
+    IliObservation validObservation;
+    validObservation.time = observation.time;
+
+    for(std::map<int, float>::const_iterator iter=observation.reports.begin(); iter!=observation.reports.end(); iter++)
+    {
+        if(particles_[0]->findNodeIndex(iter->first) == -1)
+        {
+            put_flog(LOG_WARN, "ignoring unknown node id %i", iter->first);
+        }
+        else if(particles_[0]->getNumIliProviders(iter->first) > 0)
+        {
+            validObservation.reports[iter->first] = iter->second;
+        }
+    }
+
+    QList<boost::shared_ptr<StochasticSEATIRD> > particles;
+
+    for(unsigned int i=0; i<particles_.size(); i++)
+    {
+        particles.push_back(particles_[i]);
+    }
+
+    QList<double> logLikelihoods;
+
+    if(progressParent != NULL)
+    {
+        QProgressDialog progressDialog(progressParent);
+        progressDialog.setWindowModality(Qt::WindowModal);
+        progressDialog.setLabelText(QString("Assimilating ILI reports for day %1...").arg(observation.time));
+
+        QFutureWatcher<double> futureWatcher;
+
+        QObject::connect(&futureWatcher, SIGNAL(finished()), &progressDialog, SLOT(reset()));
+        QObject::connect(&progressDialog, SIGNAL(canceled()), &futureWatcher, SLOT(cancel()));
+        QObject::connect(&futureWatcher, SIGNAL(progressRangeChanged(int, int)), &progressDialog, SLOT(setRange(int, int)));
+        QObject::connect(&futureWatcher, SIGNAL(progressValueChanged(int)), &progressDialog, SLOT(setValue(int)));
+
+        futureWatcher.setFuture(QtConcurrent::mapped(particles, IliParticleRunner(&validObservation)));
+
+        progressDialog.exec();
+
+        futureWatcher.waitForFinished();
+
+        if(futureWatcher.future().isCanceled() == true)
+        {
+            // the particles are now at different times; start over from the scenario on the next call
+            particles_.clear();
+
+            return false;
+        }
+
+        logLikelihoods = futureWatcher.future().results();
+    }
+    else
+    {
+        logLikelihoods = QtConcurrent::blockingMapped<QList<double> >(particles, IliParticleRunner(&validObservation));
+    }
+
+    // update the (normalized, log) weights, and the marginal likelihood by its increment log(sum(w_i * L_i))
+    std::vector<double> logWeights(particles_.size());
+
+    double maxLogWeight = -HUGE_VAL;
+
+    for(unsigned int i=0; i<particles_.size(); i++)
+    {
+        logWeights[i] = logWeights_[i] + logLikelihoods[i];
+        maxLogWeight = std::max(maxLogWeight, logWeights[i]);
+
+        lastLogLikelihoods_[i] = logLikelihoods[i];
+    }
+
+    double sum = 0.;
+
+    for(unsigned int i=0; i<particles_.size(); i++)
+    {
+        sum += exp(logWeights[i] - maxLogWeight);
+    }
+
+    double logNormalization = maxLogWeight + log(sum);
+
+    logLikelihood_ += logNormalization;
+
+    double sumSquaredWeights = 0.;
+
+    for(unsigned int i=0; i<particles_.size(); i++)
+    {
+        logWeights_[i] = logWeights[i] - logNormalization;
+        sumSquaredWeights += exp(2. * logWeights_[i]);
+    }
+
+    effectiveSampleSize_ = 1. / sumSquaredWeights;
+
+    put_flog(LOG_INFO, "day %i: %i nodes observed, effective sample size %f / %i", observation.time, (int)validObservation.reports.size(), effectiveSampleSize_, (int)particles_.size());
+
+    if(effectiveSampleSize_ < resampleThreshold_ * (double)particles_.size())
+    {
+        resample();
+    }
+
+    return true;
+}
+
+int IliParticleFilter::getTime()
+{
+    if(particles_.size() == 0)
+    {
+        return simulation_->getNumTimes() - 1;
+    }
+
+    return particles_[0]->getNumTimes() - 1;
+}
+
+int IliParticleFilter::getNumParticles()
+{
+    return particles_.size();
+}
+
+boost::shared_ptr<EpidemicSimulation> IliParticleFilter::getParticle(int index)
+{
+    return particles_[index];
+}
+
+std::vector<double> IliParticleFilter::getWeights()
+{
+    std::vector<double> weights;
+
+    for(unsigned int i=0; i<logWeights_.size(); i++)
+    {
+        weights.push_back(exp(logWeights_[i]));
+    }
+
+    return weights;
+}
+
+double IliParticleFilter::getEffectiveSampleSize()
+{
+    return effectiveSampleSize_;
+}
+
+double IliParticleFilter::getLogLikelihood()
+{
+    return logLikelihood_;
+}
+
+boost::shared_ptr<EpidemicSimulation> IliParticleFilter::getMostLikelyParticle()
+{
+    if(particles_.size() == 0)
+    {
+        return boost::shared_ptr<EpidemicSimulation>();
+    }
+
+    return particles_[std::max_element(lastLogLikelihoods_.begin(), lastLogLikelihoods_.end()) - lastLogLikelihoods_.begin()];
+}
+
+double IliParticleFilter::getWeightedMean(std::string varName, int time, int nodeId)
+{
+    double mean = 0.;
+
+    for(unsigned int i=0; i<particles_.size(); i++)
+    {
+        mean += exp(logWeights_[i]) * particles_[i]->getValue(varName, time, nodeId);
+    }
+
+    return mean;
+}
+
+double IliParticleFilter::getWeightedQuantile(std::string varName, int time, int nodeId, double q)
+{
+    std::vector<std::pair<double, double> > values;
+
+    for(unsigned int i=0; i<particles_.size(); i++)
+    {
+        values.push_back(std::pair<double, double>(particles_[i]->getValue(varName, time, nodeId), exp(logWeights_[i])));
+    }
+
+    if(values.size() == 0)
+    {
+        return 0.;
+    }
+
+    std::sort(values.begin(), values.end());
+
+    double cumulativeWeight = 0.;
+
+    for(unsigned int i=0; i<values.size(); i++)
+    {
+        cumulativeWeight += values[i].second;
+
+        if(cumulativeWeight >= q)
+        {
+            return values[i].first;
+        }
+    }
+
+    return values.back().first;
+}
+
+bool IliParticleFilter::createParticles()
+{
+    if(simulation_ == NULL || numParticles_ < 1)
+    {
+        put_flog(LOG_ERROR, "invalid simulation or number of particles");
+        return false;
+    }
+
+    rand_ = boost::shared_ptr<MTRand>(new MTRand((MTRand::uint32)seed_));
+
+    particles_.clear();
+
+    for(int i=0; i<numParticles_; i++)
+    {
+        boost::shared_ptr<StochasticSEATIRD> particle = boost::dynamic_pointer_cast<StochasticSEATIRD>(simulation_->clone());
+
+        if(particle == NULL)
+        {
+            put_flog(LOG_ERROR, "calibration needs a StochasticSEATIRD simulation");
+            particles_.clear();
+            return false;
+        }
+
+        particle->seed(rand_->randInt());
+
+        particles_.push_back(particle);
+    }
+
+    logWeights_.assign(numParticles_, -log((double)numParticles_));
+    lastLogLikelihoods_.assign(numParticles_, 0.);
+
+    effectiveSampleSize_ = numParticles_;
+    logLikelihood_ = 0.;
+
+    put_flog(LOG_INFO, "created %i particles at day %i", numParticles_, getTime());
+
+    return true;
+}
+
+void IliParticleFilter::resample()
+{
+    int numParticles = particles_.size();
+
+    // systematic resampling: one uniform offset, then evenly spaced points through the cumulative weights
+    std::vector<int> numCopies(numParticles, 0);
+
+    double u = rand_->randExc() / (double)numParticles;
+    double cumulativeWeight = exp(logWeights_[0]);
+
+    int i = 0;
+
+    for(int j=0; j<numParticles; j++)
+    {
+        while(u > cumulativeWeight && i < numParticles - 1)
+        {
+            i++;
+            cumulativeWeight += exp(logWeights_[i]);
+        }
+
+        numCopies[i]++;
+
+        u += 1. / (double)numParticles;
+    }
+
+    // a surviving particle keeps its first copy; further copies are made from it and reseeded so their futures diverge
+    std::vector<boost::shared_ptr<StochasticSEATIRD> > particles;
+    std::vector<double> lastLogLikelihoods;
+
+    int numSurviving = 0;
+
+    for(int i=0; i<numParticles; i++)
+    {
+        if(numCopies[i] > 0)
+        {
+            numSurviving++;
+        }
+
+        for(int c=0; c<numCopies[i]; c++)
+        {
+            if(c == 0)
+            {
+                particles.push_back(particles_[i]);
+            }
+            else
+            {
+                boost::shared_ptr<StochasticSEATIRD> particle = boost::dynamic_pointer_cast<StochasticSEATIRD>(particles_[i]->clone());
+                particle->seed(rand_->randInt());
+
+                particles.push_back(particle);
+            }
+
+            lastLogLikelihoods.push_back(lastLogLikelihoods_[i]);
+        }
+    }
+
+    particles_ = particles;
+    lastLogLikelihoods_ = lastLogLikelihoods;
+
+    logWeights_.assign(numParticles, -log((double)numParticles));
+
+    put_flog(LOG_INFO, "resampled: %i of %i particles survived", numSurviving, numParticles);
+}
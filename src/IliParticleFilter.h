@@ -0,0 +1,103 @@
+#ifndef ILI_PARTICLE_FILTER_H
+#define ILI_PARTICLE_FILTER_H
+
+// defaults; a few hundred particles assimilate a week in seconds on a workstation
+#define ILI_PARTICLE_FILTER_DEFAULT_NUM_PARTICLES 200
+
+// resample when the effective sample size falls below this fraction of the number of particles
+#define ILI_PARTICLE_FILTER_DEFAULT_RESAMPLE_THRESHOLD 0.5
+
+// days covered by an observation, ending at its time
+#define ILI_PARTICLE_FILTER_DAYS_PER_OBSERVATION 7
+
+#include <QtGui>
+#include <boost/shared_ptr.hpp>
+#include <map>
+#include <string>
+#include <vector>
+
+class EpidemicSimulation;
+class StochasticSEATIRD;
+class MTRand;
+
+// observed ILI for a week: the mean daily "ILI reports" value of each reporting node over the days ending at time
+struct IliObservation
+{
+    int time;
+
+    std::map<int, float> reports;
+};
+
+// sequential Monte Carlo calibration of a StochasticSEATIRD scenario against observed ILI
+//
+// the particles are copies of the scenario, advanced independently in worker threads; at each observation every
+// particle is weighted by the likelihood of the observed reports under the ILI surveillance model (a Gaussian with the
+// moments of IliSurveillance::getReportMoments() for the average over the observation's days)
+// when the weights degenerate, particles are resampled systematically: duplicates are copies of their parent,
+// reseeded so that their futures diverge
+class IliParticleFilter
+{
+    public:
+
+        IliParticleFilter(boost::shared_ptr<EpidemicSimulation> simulation);
+
+        void setNumParticles(int numParticles);
+        void setResampleThreshold(double resampleThreshold);
+        void setSeed(unsigned long seed);
+
+        // read observations from a CSV file with lines: time, node id, mean daily ILI reports
+        // lines starting with '#' are ignored; observations are sorted by time
+        static bool readObservations(std::string filename, std::vector<IliObservation> &observations);
+
+        // advance the particles to the observation's time and weight them by it; particles are created from the
+        // scenario on the first call
+        // progress is shown in a dialog with parent progressParent if given; returns false on error or cancel
+        bool assimilate(const IliObservation &observation, QWidget * progressParent=NULL);
+
+        // time of the particles (the last simulated time)
+        int getTime();
+
+        int getNumParticles();
+        boost::shared_ptr<EpidemicSimulation> getParticle(int index);
+
+        // normalized weights
+        std::vector<double> getWeights();
+
+        // effective sample size of the weights before the last resampling
+        double getEffectiveSampleSize();
+
+        // log of the estimated marginal likelihood of all observations assimilated so far
+        double getLogLikelihood();
+
+        // the particle with the highest likelihood at the last observation
+        boost::shared_ptr<EpidemicSimulation> getMostLikelyParticle();
+
+        // weighted mean and quantile of a variable over the particles
+        double getWeightedMean(std::string varName, int time, int nodeId);
+        double getWeightedQuantile(std::string varName, int time, int nodeId, double q);
+
+    private:
+
+        boost::shared_ptr<EpidemicSimulation> simulation_;
+
+        int numParticles_;
+        double resampleThreshold_;
+        unsigned long seed_;
+
+        std::vector<boost::shared_ptr<StochasticSEATIRD> > particles_;
+        std::vector<double> logWeights_;
+
+        // log-likelihoods of the last observation
+        std::vector<double> lastLogLikelihoods_;
+
+        double effectiveSampleSize_;
+        double logLikelihood_;
+
+        // draws seeds for particles and the resampling offset
+        boost::shared_ptr<MTRand> rand_;
+
+        bool createParticles();
+        void resample();
+};
+
+#endif
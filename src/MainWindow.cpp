@@ -2,6 +2,8 @@
 #include "IliMapWidget.h"
 #include "EpidemicMapWidget.h"
 #include "StockpileMapWidget.h"
+#include "MapFrameExporter.h"
+#include "NetCdfWriter.h"
 #include "EventMonitor.h"
 #include "EventMonitorWidget.h"
 #include "TimelineWidget.h"
@@ -16,8 +18,12 @@
 #include "EpidemicInfoWidget.h"
 #include "EpidemicChartWidget.h"
 #include "StockpileChartWidget.h"
+#include "SimulationProfileWidget.h"
+#include "EmulatorWidget.h"
+#include "IliParticleFilter.h"
 #include "models/disease/StochasticSEATIRD.h"
 #include "main.h"
+#include "log.h"
 
 MainWindow::MainWindow()
 {
@@ -48,6 +54,23 @@ MainWindow::MainWindow()
     newChartAction->setStatusTip("New chart");
     connect(newChartAction, SIGNAL(triggered()), this, SLOT(newChart()));
 
+    // export map movie action
+    QAction * exportMapMovieAction = new QAction("Export Map Movie", this);
+    exportMapMovieAction->setStatusTip("Export the current map over all days to a movie or image sequence");
+    connect(exportMapMovieAction, SIGNAL(triggered()), this, SLOT(exportMapMovie()));
+
+    // calibrate to ILI reports action
+    QAction * calibrateToIliReportsAction = new QAction("Calibrate to ILI Reports", this);
+    calibrateToIliReportsAction->setStatusTip("Continue the simulation from the particle that best matches observed ILI reports");
+    connect(calibrateToIliReportsAction, SIGNAL(triggered()), this, SLOT(calibrateToIliReports()));
+
+#if USE_NETCDF
+    // save simulation output action
+    QAction * saveSimulationOutputAction = new QAction("Save Simulation Output", this);
+    saveSimulationOutputAction->setStatusTip("Save the simulation to a file, continuing as new days are simulated");
+    connect(saveSimulationOutputAction, SIGNAL(triggered()), this, SLOT(saveSimulationOutput()));
+#endif
+
 #if USE_DISPLAYCLUSTER
     // connect to DisplayCluster action
     QAction * connectToDisplayClusterAction = new QAction("Connect to DisplayCluster", this);
@@ -64,6 +87,12 @@ MainWindow::MainWindow()
     fileMenu->addAction(newSimulationAction);
     // fileMenu->addAction(openDataSetAction);
     fileMenu->addAction(newChartAction);
+    fileMenu->addAction(exportMapMovieAction);
+    fileMenu->addAction(calibrateToIliReportsAction);
+
+#if USE_NETCDF
+    fileMenu->addAction(saveSimulationOutputAction);
+#endif
 
 #if USE_DISPLAYCLUSTER
     fileMenu->addAction(connectToDisplayClusterAction);
@@ -76,23 +105,23 @@ MainWindow::MainWindow()
     toolbar->addAction(newChartAction);
 
     // make map widgets the main view
-    QTabWidget * tabWidget = new QTabWidget();
+    mapTabWidget_ = new QTabWidget();
 
     IliMapWidget * iliMapWidget = new IliMapWidget();
-    tabWidget->addTab(iliMapWidget, "ILI View");
+    mapTabWidget_->addTab(iliMapWidget, "ILI View");
 
     EpidemicMapWidget * epidemicMapWidget = new EpidemicMapWidget();
-    tabWidget->addTab(epidemicMapWidget, "Infected");
+    mapTabWidget_->addTab(epidemicMapWidget, "Infected");
 
     StockpileMapWidget * antiviralsStockpileMapWidget = new StockpileMapWidget();
     antiviralsStockpileMapWidget->setType(STOCKPILE_ANTIVIRALS);
-    tabWidget->addTab(antiviralsStockpileMapWidget, "Antivirals Stockpile");
+    mapTabWidget_->addTab(antiviralsStockpileMapWidget, "Antivirals Stockpile");
 
     StockpileMapWidget * vaccinesStockpileMapWidget = new StockpileMapWidget();
     vaccinesStockpileMapWidget->setType(STOCKPILE_VACCINES);
-    tabWidget->addTab(vaccinesStockpileMapWidget, "Vaccines Stockpile");
+    mapTabWidget_->addTab(vaccinesStockpileMapWidget, "Vaccines Stockpile");
 
-    setCentralWidget(tabWidget);
+    setCentralWidget(mapTabWidget_);
 
     // create event monitor and widget
     EventMonitor * eventMonitor = new EventMonitor(this);
@@ -169,6 +198,11 @@ MainWindow::MainWindow()
     infoDockWidget->setWidget(new EpidemicInfoWidget(this));
     addDockWidget(Qt::LeftDockWidgetArea, infoDockWidget);
 
+    // simulation profile dock
+    QDockWidget * profileDockWidget = new QDockWidget("Profile", this);
+    profileDockWidget->setWidget(new SimulationProfileWidget(this));
+    addDockWidget(Qt::LeftDockWidgetArea, profileDockWidget);
+
     // tabify parameters, initial cases, stockpile network, and info docks
     tabifyDockWidget(parametersDockWidget, initialCasesDockWidget);
     tabifyDockWidget(parametersDockWidget, stockpileNetworkDockWidget);
@@ -176,6 +210,7 @@ MainWindow::MainWindow()
     tabifyDockWidget(parametersDockWidget, priorityGroupDefinitionDockWidget);
     tabifyDockWidget(parametersDockWidget, npiDefinitionDockWidget);
     tabifyDockWidget(parametersDockWidget, infoDockWidget);
+    tabifyDockWidget(parametersDockWidget, profileDockWidget);
 
     // chart docks
 
@@ -189,6 +224,12 @@ MainWindow::MainWindow()
     chartDockWidget->setWidget(new StockpileChartWidget(this));
     addDockWidget(Qt::BottomDockWidgetArea, chartDockWidget);
 
+    // and an emulated epidemic curve, tabified with the stockpile chart
+    QDockWidget * emulatorDockWidget = new QDockWidget("Emulator", this);
+    emulatorDockWidget->setWidget(new EmulatorWidget(this));
+    addDockWidget(Qt::BottomDockWidgetArea, emulatorDockWidget);
+    tabifyDockWidget(chartDockWidget, emulatorDockWidget);
+
     // make other signal / slot connections
     connect(this, SIGNAL(dataSetChanged(boost::shared_ptr<EpidemicDataSet>)), iliMapWidget, SLOT(setDataSet(boost::shared_ptr<EpidemicDataSet>)));
     connect(this, SIGNAL(dataSetChanged(boost::shared_ptr<EpidemicDataSet>)), epidemicMapWidget, SLOT(setDataSet(boost::shared_ptr<EpidemicDataSet>)));
@@ -316,6 +357,14 @@ bool MainWindow::nextTimestep()
 
                 simulation->simulate();
 
+#if USE_NETCDF
+                // queue the new day for writing
+                if(netCdfWriter_ != NULL)
+                {
+                    netCdfWriter_->appendNewTimes();
+                }
+#endif
+
                 // since we've changed the number of timesteps
                 emit(numberOfTimestepsChanged());
             }
@@ -349,6 +398,11 @@ void MainWindow::newSimulation()
     // use StochasticSEATIRD model
     boost::shared_ptr<EpidemicSimulation> simulation(new StochasticSEATIRD());
 
+#if USE_NETCDF
+    // finish writing output for the previous simulation
+    netCdfWriter_.reset();
+#endif
+
     dataSet_ = simulation;
 
     emit(dataSetChanged(dataSet_));
@@ -394,6 +448,150 @@ void MainWindow::newChart()
     }
 }
 
+void MainWindow::exportMapMovie()
+{
+    if(dataSet_ == NULL)
+    {
+        QMessageBox::warning(this, "Error", "No active simulation or data set.", QMessageBox::Ok, QMessageBox::Ok);
+        return;
+    }
+
+    MapWidget * mapWidget = dynamic_cast<MapWidget *>(mapTabWidget_->currentWidget());
+
+    if(mapWidget == NULL)
+    {
+        put_flog(LOG_ERROR, "current tab is not a map widget");
+        return;
+    }
+
+    QString filename = QFileDialog::getSaveFileName(this, "Export Map Movie", "", "Movie files (*.avi);;PNG image sequence (*.png)");
+
+    if(!filename.isEmpty())
+    {
+        // default to a movie if no extension given
+        if(filename.endsWith(".avi", Qt::CaseInsensitive) != true && filename.endsWith(".png", Qt::CaseInsensitive) != true)
+        {
+            filename.append(".avi");
+        }
+
+        MapFrameExporter exporter(mapWidget);
+
+        if(exporter.exportFrames(filename.toStdString(), 0, dataSet_->getNumTimes() - 1, this) != true)
+        {
+            QMessageBox::warning(this, "Error", "Map movie was not exported.", QMessageBox::Ok, QMessageBox::Ok);
+        }
+    }
+}
+
+void MainWindow::calibrateToIliReports()
+{
+    boost::shared_ptr<EpidemicSimulation> simulation = boost::dynamic_pointer_cast<EpidemicSimulation>(dataSet_);
+
+    if(simulation == NULL)
+    {
+        QMessageBox::warning(this, "Error", "No active simulation. Click 'New Simulation' in the menu to begin.", QMessageBox::Ok, QMessageBox::Ok);
+        return;
+    }
+
+    QString filename = QFileDialog::getOpenFileName(this, "Calibrate to ILI Reports", "", "ILI report files (*.csv)");
+
+    if(filename.isEmpty())
+    {
+        return;
+    }
+
+    std::vector<IliObservation> observations;
+
+    if(IliParticleFilter::readObservations(filename.toStdString(), observations) != true)
+    {
+        QMessageBox::warning(this, "Error", "Could not read ILI reports.", QMessageBox::Ok, QMessageBox::Ok);
+        return;
+    }
+
+    // continue the previous calibration if its result is still the active simulation
+    if(particleFilter_ == NULL || calibratedDataSet_ != dataSet_)
+    {
+        // the particles start from the simulation, so it needs its initial cases
+        if(simulation->getNumTimes() == 1)
+        {
+            initialCasesWidget_->applyCases();
+        }
+
+        particleFilter_ = boost::shared_ptr<IliParticleFilter>(new IliParticleFilter(simulation));
+    }
+
+    int numAssimilated = 0;
+
+    for(unsigned int i=0; i<observations.size(); i++)
+    {
+        if(observations[i].time <= particleFilter_->getTime())
+        {
+            continue;
+        }
+
+        if(particleFilter_->assimilate(observations[i], this) != true)
+        {
+            break;
+        }
+
+        numAssimilated++;
+    }
+
+    boost::shared_ptr<EpidemicSimulation> mostLikelyParticle = particleFilter_->getMostLikelyParticle();
+
+    if(numAssimilated == 0 || mostLikelyParticle == NULL)
+    {
+        QMessageBox::warning(this, "Error", "No ILI reports were assimilated.", QMessageBox::Ok, QMessageBox::Ok);
+        return;
+    }
+
+    put_flog(LOG_INFO, "assimilated %i observations, log-likelihood %f", numAssimilated, particleFilter_->getLogLikelihood());
+
+#if USE_NETCDF
+    // the output was for the uncalibrated simulation
+    netCdfWriter_.reset();
+#endif
+
+    // a copy, so simulating ahead does not move the filter's particle
+    dataSet_ = mostLikelyParticle->clone();
+    calibratedDataSet_ = dataSet_;
+
+    emit(dataSetChanged(dataSet_));
+
+    setTime(dataSet_->getNumTimes() - 1);
+}
+
+#if USE_NETCDF
+void MainWindow::saveSimulationOutput()
+{
+    boost::shared_ptr<EpidemicSimulation> simulation = boost::dynamic_pointer_cast<EpidemicSimulation>(dataSet_);
+
+    if(simulation == NULL)
+    {
+        QMessageBox::warning(this, "Error", "No active simulation. Click 'New Simulation' in the menu to begin.", QMessageBox::Ok, QMessageBox::Ok);
+        return;
+    }
+
+    QString filename = QFileDialog::getSaveFileName(this, "Save Simulation Output", "", "Simulation files (*.nc)");
+
+    if(!filename.isEmpty())
+    {
+        if(filename.endsWith(".nc") != true)
+        {
+            filename.append(".nc");
+        }
+
+        // finish any previous output before starting the new one
+        netCdfWriter_.reset();
+
+        netCdfWriter_ = boost::shared_ptr<NetCdfWriter>(new NetCdfWriter(simulation, filename.toStdString()));
+
+        // write the days simulated so far; later days are written as they are simulated
+        netCdfWriter_->appendNewTimes();
+    }
+}
+#endif
+
 void MainWindow::resetTimeSlider()
 {
     if(dataSet_ != NULL)
@@ -9,6 +9,8 @@
 
 class EpidemicDataSet;
 class EpidemicInitialCasesWidget;
+class IliParticleFilter;
+class NetCdfWriter;
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
@@ -45,11 +47,29 @@ class MainWindow : public QMainWindow {
 
         EpidemicInitialCasesWidget * initialCasesWidget_;
 
+        QTabWidget * mapTabWidget_;
+
+        // calibration of the simulation against ILI reports; kept so later weeks can be assimilated without starting
+        // over, while the calibrated simulation is the active one
+        boost::shared_ptr<IliParticleFilter> particleFilter_;
+        boost::shared_ptr<EpidemicDataSet> calibratedDataSet_;
+
+#if USE_NETCDF
+        // streams simulation output to a file, if enabled
+        boost::shared_ptr<NetCdfWriter> netCdfWriter_;
+#endif
+
     private slots:
 
         void newSimulation();
         void openDataSet();
         void newChart();
+        void exportMapMovie();
+        void calibrateToIliReports();
+
+#if USE_NETCDF
+        void saveSimulationOutput();
+#endif
         void resetTimeSlider();
 
 #if USE_DISPLAYCLUSTER
@@ -0,0 +1,313 @@
+#include "MapFrameExporter.h"
+#include "log.h"
+#include <QtConcurrentMap>
+#include <algorithm>
+
+// renders and encodes a single frame; used from worker threads
+struct MapFrameRenderer
+{
+    typedef QByteArray result_type;
+
+    MapFrameRenderer(MapWidget * mapWidget, QSize size, const char * format, int quality) : mapWidget_(mapWidget), size_(size), format_(format), quality_(quality) { }
+
+    QByteArray operator()(const MapFrame &frame) const
+    {
+        // QPainter on a QImage needs no GL context, so this is safe outside the GUI thread
+        QImage image(size_, QImage::Format_RGB32);
+
+        QPainter painter(&image);
+        painter.setRenderHint(QPainter::Antialiasing);
+
+        mapWidget_->renderFrame(&painter, frame, size_);
+
+        painter.end();
+
+        QByteArray bytes;
+        QBuffer buffer(&bytes);
+        buffer.open(QIODevice::WriteOnly);
+
+        if(image.save(&buffer, format_, quality_) != true)
+        {
+            put_flog(LOG_ERROR, "could not encode frame for time %i", frame.time);
+        }
+
+        return bytes;
+    }
+
+    MapWidget * mapWidget_;
+    QSize size_;
+    const char * format_;
+    int quality_;
+};
+
+// little-endian helpers for AVI writing
+static void writeFourCC(QDataStream &stream, const char * fourCC)
+{
+    stream.writeRawData(fourCC, 4);
+}
+
+static void writeChunkHeader(QDataStream &stream, const char * fourCC, quint32 size)
+{
+    writeFourCC(stream, fourCC);
+    stream << size;
+}
+
+MapFrameExporter::MapFrameExporter(MapWidget * mapWidget)
+{
+    mapWidget_ = mapWidget;
+
+    // defaults
+    size_ = QSize(MAP_FRAME_EXPORTER_DEFAULT_WIDTH, MAP_FRAME_EXPORTER_DEFAULT_HEIGHT);
+    framesPerSecond_ = MAP_FRAME_EXPORTER_DEFAULT_FRAMES_PER_SECOND;
+}
+
+void MapFrameExporter::setSize(QSize size)
+{
+    size_ = size;
+}
+
+void MapFrameExporter::setFramesPerSecond(int framesPerSecond)
+{
+    framesPerSecond_ = framesPerSecond;
+}
+
+bool MapFrameExporter::exportFrames(std::string filename, int startTime, int endTime, QWidget * progressParent)
+{
+    if(mapWidget_ == NULL || endTime < startTime)
+    {
+        put_flog(LOG_ERROR, "invalid map widget or time range [%i, %i]", startTime, endTime);
+        return false;
+    }
+
+    bool movie = QString(filename.c_str()).endsWith(".avi", Qt::CaseInsensitive);
+
+    // capturing frames touches the widget and data set, so is done here in the GUI thread
+    // everything else only reads the captured frames
+    std::vector<MapFrame> frames = mapWidget_->captureFrames(startTime, endTime);
+
+    put_flog(LOG_INFO, "captured %i frames", (int)frames.size());
+
+    std::vector<QByteArray> encodedFrames;
+
+    bool success;
+
+    if(movie == true)
+    {
+        success = encodeFrames(frames, "JPG", MAP_FRAME_EXPORTER_JPEG_QUALITY, progressParent, encodedFrames);
+    }
+    else
+    {
+        success = encodeFrames(frames, "PNG", -1, progressParent, encodedFrames);
+    }
+
+    if(success != true)
+    {
+        put_flog(LOG_INFO, "export canceled");
+        return false;
+    }
+
+    if(movie == true)
+    {
+        return writeMJPEGMovie(filename, encodedFrames);
+    }
+    else
+    {
+        return writePNGSequence(filename, encodedFrames);
+    }
+}
+
+bool MapFrameExporter::encodeFrames(const std::vector<MapFrame> &frames, const char * format, int quality, QWidget * progressParent, std::vector<QByteArray> &encodedFrames)
+{
+    QList<MapFrame> frameList;
+
+    for(unsigned int i=0; i<frames.size(); i++)
+    {
+        frameList.push_back(frames[i]);
+    }
+
+    QProgressDialog progressDialog(progressParent);
+    progressDialog.setWindowModality(Qt::WindowModal);
+    progressDialog.setLabelText("Rendering frames...");
+
+    QFutureWatcher<QByteArray> futureWatcher;
+
+    QObject::connect(&futureWatcher, SIGNAL(finished()), &progressDialog, SLOT(reset()));
+    QObject::connect(&progressDialog, SIGNAL(canceled()), &futureWatcher, SLOT(cancel()));
+    QObject::connect(&futureWatcher, SIGNAL(progressRangeChanged(int, int)), &progressDialog, SLOT(setRange(int, int)));
+    QObject::connect(&futureWatcher, SIGNAL(progressValueChanged(int)), &progressDialog, SLOT(setValue(int)));
+
+    futureWatcher.setFuture(QtConcurrent::mapped(frameList, MapFrameRenderer(mapWidget_, size_, format, quality)));
+
+    progressDialog.exec();
+
+    futureWatcher.waitForFinished();
+
+    if(futureWatcher.future().isCanceled() == true)
+    {
+        return false;
+    }
+
+    // results of mapped() are in the same order as the input frames
+    QList<QByteArray> results = futureWatcher.future().results();
+
+    encodedFrames.assign(results.begin(), results.end());
+
+    return true;
+}
+
+bool MapFrameExporter::writePNGSequence(std::string filename, const std::vector<QByteArray> &encodedFrames)
+{
+    QString baseName = filename.c_str();
+
+    if(baseName.endsWith(".png", Qt::CaseInsensitive) == true)
+    {
+        baseName.chop(4);
+    }
+
+    for(unsigned int i=0; i<encodedFrames.size(); i++)
+    {
+        QString frameFilename = baseName + QString("-%1.png").arg(i, 4, 10, QChar('0'));
+
+        QFile file(frameFilename);
+
+        if(file.open(QIODevice::WriteOnly) != true || file.write(encodedFrames[i]) != encodedFrames[i].size())
+        {
+            put_flog(LOG_ERROR, "could not write %s", frameFilename.toStdString().c_str());
+            return false;
+        }
+    }
+
+    put_flog(LOG_INFO, "wrote %i frames to %s-*.png", (int)encodedFrames.size(), baseName.toStdString().c_str());
+
+    return true;
+}
+
+bool MapFrameExporter::writeMJPEGMovie(std::string filename, const std::vector<QByteArray> &encodedFrames)
+{
+    QFile file(filename.c_str());
+
+    if(file.open(QIODevice::WriteOnly) != true)
+    {
+        put_flog(LOG_ERROR, "could not open %s", filename.c_str());
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setByteOrder(QDataStream::LittleEndian);
+
+    quint32 numFrames = encodedFrames.size();
+    quint32 width = size_.width();
+    quint32 height = size_.height();
+
+    // chunk data is padded to even sizes
+    quint32 moviSize = 4;
+    quint32 maxFrameSize = 0;
+
+    for(unsigned int i=0; i<encodedFrames.size(); i++)
+    {
+        quint32 frameSize = encodedFrames[i].size();
+
+        moviSize += 8 + frameSize + (frameSize % 2);
+        maxFrameSize = std::max(maxFrameSize, frameSize);
+    }
+
+    // LIST hdrl: 'hdrl' + avih chunk + LIST strl (strh chunk + strf chunk)
+    const quint32 avihSize = 56;
+    const quint32 strhSize = 56;
+    const quint32 strfSize = 40;
+    const quint32 strlSize = 4 + (8 + strhSize) + (8 + strfSize);
+    const quint32 hdrlSize = 4 + (8 + avihSize) + (8 + strlSize);
+    const quint32 idx1Size = 16 * numFrames;
+
+    const quint32 AVIF_HASINDEX = 0x10;
+    const quint32 AVIIF_KEYFRAME = 0x10;
+
+    writeChunkHeader(stream, "RIFF", 4 + (8 + hdrlSize) + (8 + moviSize) + (8 + idx1Size));
+    writeFourCC(stream, "AVI ");
+
+    writeChunkHeader(stream, "LIST", hdrlSize);
+    writeFourCC(stream, "hdrl");
+
+    // main AVI header
+    writeChunkHeader(stream, "avih", avihSize);
+    stream << (quint32)(1000000 / framesPerSecond_); // microseconds per frame
+    stream << (quint32)(maxFrameSize * framesPerSecond_); // max bytes per second
+    stream << (quint32)0; // padding granularity
+    stream << AVIF_HASINDEX;
+    stream << numFrames;
+    stream << (quint32)0; // initial frames
+    stream << (quint32)1; // streams
+    stream << maxFrameSize; // suggested buffer size
+    stream << width << height;
+    stream << (quint32)0 << (quint32)0 << (quint32)0 << (quint32)0; // reserved
+
+    writeChunkHeader(stream, "LIST", strlSize);
+    writeFourCC(stream, "strl");
+
+    // stream header
+    writeChunkHeader(stream, "strh", strhSize);
+    writeFourCC(stream, "vids");
+    writeFourCC(stream, "MJPG");
+    stream << (quint32)0; // flags
+    stream << (quint16)0 << (quint16)0; // priority, language
+    stream << (quint32)0; // initial frames
+    stream << (quint32)1 << (quint32)framesPerSecond_; // scale, rate
+    stream << (quint32)0; // start
+    stream << numFrames; // length
+    stream << maxFrameSize; // suggested buffer size
+    stream << (quint32)0xffffffff; // quality (default)
+    stream << (quint32)0; // sample size
+    stream << (quint16)0 << (quint16)0 << (quint16)width << (quint16)height; // frame rectangle
+
+    // stream format (BITMAPINFOHEADER)
+    writeChunkHeader(stream, "strf", strfSize);
+    stream << strfSize;
+    stream << width << height;
+    stream << (quint16)1 << (quint16)24; // planes, bit count
+    writeFourCC(stream, "MJPG");
+    stream << (quint32)(width * height * 3); // image size
+    stream << (quint32)0 << (quint32)0; // pixels per meter
+    stream << (quint32)0 << (quint32)0; // colors used, colors important
+
+    // frames
+    writeChunkHeader(stream, "LIST", moviSize);
+    writeFourCC(stream, "movi");
+
+    for(unsigned int i=0; i<encodedFrames.size(); i++)
+    {
+        writeChunkHeader(stream, "00dc", encodedFrames[i].size());
+        stream.writeRawData(encodedFrames[i].constData(), encodedFrames[i].size());
+
+        if(encodedFrames[i].size() % 2 != 0)
+        {
+            stream << (quint8)0;
+        }
+    }
+
+    // index; offsets are relative to the 'movi' fourcc
+    writeChunkHeader(stream, "idx1", idx1Size);
+
+    quint32 offset = 4;
+
+    for(unsigned int i=0; i<encodedFrames.size(); i++)
+    {
+        quint32 frameSize = encodedFrames[i].size();
+
+        writeFourCC(stream, "00dc");
+        stream << AVIIF_KEYFRAME;
+        stream << offset;
+        stream << frameSize;
+
+        offset += 8 + frameSize + (frameSize % 2);
+    }
+
+    if(stream.status() != QDataStream::Ok)
+    {
+        put_flog(LOG_ERROR, "error writing %s", filename.c_str());
+        return false;
+    }
+
+    put_flog(LOG_INFO, "wrote %i frames to %s", numFrames, filename.c_str());
+
+    return true;
+}
@@ -0,0 +1,49 @@
+#ifndef MAP_FRAME_EXPORTER_H
+#define MAP_FRAME_EXPORTER_H
+
+// default size of exported frames
+#define MAP_FRAME_EXPORTER_DEFAULT_WIDTH 1400
+#define MAP_FRAME_EXPORTER_DEFAULT_HEIGHT 1200
+
+// default frame rate of exported movies
+#define MAP_FRAME_EXPORTER_DEFAULT_FRAMES_PER_SECOND 10
+
+// JPEG quality of frames in exported movies
+#define MAP_FRAME_EXPORTER_JPEG_QUALITY 90
+
+#include "MapWidget.h"
+#include <QtGui>
+#include <string>
+#include <vector>
+
+// renders a range of times of a map widget offscreen to QImages in worker threads
+// output is either a numbered PNG sequence (base-0000.png, base-0001.png, ...) or a single motion JPEG AVI file
+class MapFrameExporter
+{
+    public:
+
+        MapFrameExporter(MapWidget * mapWidget);
+
+        void setSize(QSize size);
+        void setFramesPerSecond(int framesPerSecond);
+
+        // export frames for times [startTime, endTime] to filename
+        // if filename ends in .avi a movie is written; otherwise a PNG sequence is written using filename as the base name
+        // progress is shown in a dialog with parent progressParent; returns false on error or cancel
+        bool exportFrames(std::string filename, int startTime, int endTime, QWidget * progressParent=NULL);
+
+    private:
+
+        MapWidget * mapWidget_;
+
+        QSize size_;
+        int framesPerSecond_;
+
+        // render and encode all frames concurrently; returns false if canceled
+        bool encodeFrames(const std::vector<MapFrame> &frames, const char * format, int quality, QWidget * progressParent, std::vector<QByteArray> &encodedFrames);
+
+        bool writePNGSequence(std::string filename, const std::vector<QByteArray> &encodedFrames);
+        bool writeMJPEGMovie(std::string filename, const std::vector<QByteArray> &encodedFrames);
+};
+
+#endif
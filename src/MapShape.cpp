@@ -42,7 +42,19 @@ void MapShape::setColor(float r, float g, float b)
     b_ = b;
 }
 
+void MapShape::getColor(float &r, float &g, float &b)
+{
+    r = r_;
+    g = g_;
+    b = b_;
+}
+
 void MapShape::render(QPainter * painter)
+{
+    render(painter, QColor::fromRgbF(r_, g_, b_, 1.));
+}
+
+void MapShape::render(QPainter * painter, const QColor &color)
 {
     QVector<QPointF> points;
 
@@ -53,7 +65,7 @@ void MapShape::render(QPainter * painter)
 
     QPolygonF polygon(points);
 
-    painter->setBrush(QBrush(QColor::fromRgbF(r_ , g_, b_, 1.)));
+    painter->setBrush(QBrush(color));
     painter->setPen(QPen(QBrush(QColor::fromRgbF(.5, .5, .5, 1.)), .03));
 
     painter->drawPolygon(polygon);
@@ -9,6 +9,7 @@ struct MapVertex {
 };
 
 class QPainter;
+class QColor;
 
 class MapShape
 {
@@ -23,9 +24,13 @@ class MapShape
         void getCentroid(double &lat, double &lon);
 
         void setColor(float r, float g, float b);
+        void getColor(float &r, float &g, float &b);
 
         void render(QPainter * painter);
 
+        // render with the given color instead of the shape's color; the shape is not modified
+        void render(QPainter * painter, const QColor &color);
+
     private:
 
         std::vector<MapVertex> vertices_;
@@ -70,9 +70,96 @@ void MapWidget::setDataSet(boost::shared_ptr<EpidemicDataSet> dataSet)
     dataSet_ = dataSet;
 }
 
+std::vector<MapFrame> MapWidget::captureFrames(int startTime, int endTime)
+{
+    std::vector<MapFrame> frames;
+
+    int currentTime = time_;
+
+    for(int t=startTime; t<=endTime; t++)
+    {
+        MapFrame frame;
+        frame.time = t;
+
+        time_ = t;
+        recolorCounties();
+
+        std::map<int, boost::shared_ptr<MapShape> >::iterator iter;
+
+        for(iter=counties_.begin(); iter!=counties_.end(); iter++)
+        {
+            float r, g, b;
+            iter->second->getColor(r, g, b);
+
+            frame.countyColors.push_back(QColor::fromRgbF(r, g, b, 1.));
+        }
+
+        captureOverlay(frame);
+
+        frames.push_back(frame);
+    }
+
+    // restore current time
+    time_ = currentTime;
+    recolorCounties();
+
+    return frames;
+}
+
+void MapWidget::renderFrame(QPainter * painter, const MapFrame &frame, QSize size)
+{
+    if(frame.countyColors.size() != counties_.size())
+    {
+        put_flog(LOG_ERROR, "frame has %i county colors, expected %i", (int)frame.countyColors.size(), (int)counties_.size());
+        return;
+    }
+
+    // draw a black background over the full image
+    painter->fillRect(QRect(QPoint(0,0), size), QColor::fromRgbF(0,0,0,1));
+
+    // set logical coordinates of the render window
+    painter->setWindow(viewRect_.toRect());
+
+    // counties, using the frame's colors rather than the shapes' current colors
+    std::map<int, boost::shared_ptr<MapShape> >::iterator iter;
+    int index = 0;
+
+    for(iter=counties_.begin(); iter!=counties_.end(); iter++)
+    {
+        iter->second->render(painter, frame.countyColors[index]);
+        index++;
+    }
+
+    renderOverlay(painter, frame);
+
+    // title, legend, and day label are positioned in image coordinates
+    painter->setWindow(QRect(QPoint(0,0), size));
+
+    renderTitleAndLegend(painter, false);
+
+    // draw day label under the title
+    QFont dayFont = painter->font();
+    dayFont.setPixelSize(32);
+
+    painter->setFont(dayFont);
+    painter->setPen(QColor::fromRgbF(1,1,1,1));
+
+    QPoint dayPosition = painter->window().topRight() + QPoint(-600, 100 + 4 * 32);
+    painter->drawText(dayPosition, QString("Day ") + QString::number(frame.time));
+}
+
 void MapWidget::setTime(int time)
 {
     time_ = time;
+
+    recolorCounties();
+
+    // force redraw
+    update();
+
+#if USE_DISPLAYCLUSTER
+    exportSVGToDisplayCluster();
+#endif
 }
 
 #if USE_DISPLAYCLUSTER
@@ -113,6 +200,11 @@ void MapWidget::renderAll(QPainter * painter, bool uiRender)
     // derived class rendering
     render(painter);
 
+    renderTitleAndLegend(painter, uiRender);
+}
+
+void MapWidget::renderTitleAndLegend(QPainter * painter, bool uiRender)
+{
     // draw title
     painter->resetTransform();
 
@@ -214,6 +306,17 @@ void MapWidget::renderAll(QPainter * painter, bool uiRender)
     painter->drawText(legendMin, colorMapMinLabel_.c_str());
 }
 
+void MapWidget::renderOverlay(QPainter * painter, const MapFrame &frame)
+{
+    for(unsigned int i=0; i<frame.overlayPolygons.size(); i++)
+    {
+        painter->setBrush(frame.overlayBrushes[i]);
+        painter->setPen(frame.overlayPens[i]);
+
+        painter->drawPolygon(frame.overlayPolygons[i]);
+    }
+}
+
 void MapWidget::paintEvent(QPaintEvent* event)
 {
     makeCurrent();
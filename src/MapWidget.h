@@ -6,10 +6,26 @@
 #include <QtSvg>
 #include <boost/shared_ptr.hpp>
 #include <map>
+#include <vector>
 
 class EpidemicDataSet;
 class MapShape;
 
+// everything time-dependent needed to render a map at one time
+// frames are self-contained, so they can be rendered from worker threads while the widget moves on
+struct MapFrame
+{
+    int time;
+
+    // county colors, in the same order as the counties map
+    std::vector<QColor> countyColors;
+
+    // additional polygons drawn over the counties (e.g. travel)
+    std::vector<QPolygonF> overlayPolygons;
+    std::vector<QBrush> overlayBrushes;
+    std::vector<QPen> overlayPens;
+};
+
 class MapWidget : public QGLWidget
 {
     Q_OBJECT
@@ -24,6 +40,13 @@ class MapWidget : public QGLWidget
         void setColorMapMinLabel(std::string label);
         void setColorMapMaxLabel(std::string label);
 
+        // capture frames for times [startTime, endTime]; the widget's current time is unchanged
+        std::vector<MapFrame> captureFrames(int startTime, int endTime);
+
+        // render a captured frame offscreen (e.g. to a QImage) using logical coordinates of size
+        // this does not modify the widget and may be called concurrently from multiple threads
+        void renderFrame(QPainter * painter, const MapFrame &frame, QSize size);
+
     public slots:
 
         virtual void setDataSet(boost::shared_ptr<EpidemicDataSet> dataSet);
@@ -64,7 +87,16 @@ class MapWidget : public QGLWidget
         // render() method placeholder for derived classes
         virtual void render(QPainter * painter) { }
 
+        // recolor county shapes for time_; placeholder for derived classes
+        // this is done in setTime() rather than render(), since render() won't be called if the map is offscreen
+        virtual void recolorCounties() { }
+
+        // add overlay polygons for time_ to frame; placeholder for derived classes
+        virtual void captureOverlay(MapFrame &frame) { }
+
         void renderAll(QPainter * painter, bool uiRender);
+        void renderTitleAndLegend(QPainter * painter, bool uiRender);
+        void renderOverlay(QPainter * painter, const MapFrame &frame);
 
         // reimplemented from QGLWidget
         void paintEvent(QPaintEvent* event);
@@ -0,0 +1,292 @@
+#include "NetCdfWriter.h"
+#include "EpidemicDataSet.h"
+#include "log.h"
+
+#if USE_NETCDF
+    #include <netcdfcpp.h>
+#endif
+
+NetCdfWriter::NetCdfWriter(boost::shared_ptr<EpidemicDataSet> dataSet, std::string filename)
+{
+    dataSet_ = dataSet;
+    filename_ = filename;
+
+    numNodes_ = dataSet->getNumNodes();
+
+    std::vector<std::vector<std::string> > stratifications = EpidemicDataSet::getStratifications();
+
+    numStratifications_ = 1;
+
+    for(unsigned int i=0; i<stratifications.size(); i++)
+    {
+        numStratifications_ *= stratifications[i].size();
+    }
+
+    nextTime_ = 0;
+    finished_ = false;
+    valid_ = true;
+
+    start();
+}
+
+NetCdfWriter::~NetCdfWriter()
+{
+    mutex_.lock();
+    finished_ = true;
+    queueNotEmpty_.wakeAll();
+    mutex_.unlock();
+
+    // the thread drains the queue before exiting
+    wait();
+}
+
+void NetCdfWriter::appendTime(int time)
+{
+    Frame frame = captureFrame(time);
+
+    QMutexLocker locker(&mutex_);
+
+    queue_.push_back(frame);
+    queueNotEmpty_.wakeAll();
+
+    nextTime_ = time + 1;
+}
+
+void NetCdfWriter::appendNewTimes()
+{
+    while(nextTime_ < dataSet_->getNumTimes())
+    {
+        appendTime(nextTime_);
+    }
+}
+
+bool NetCdfWriter::isValid()
+{
+    QMutexLocker locker(&mutex_);
+
+    return valid_;
+}
+
+void NetCdfWriter::run()
+{
+#if USE_NETCDF
+    // all NetCDF calls for this file are made from this thread
+    NcError err(NcError::verbose_nonfatal);
+
+    NcFile ncFile(filename_.c_str(), NcFile::Replace, NULL, 0, NcFile::Netcdf4);
+
+    if(!ncFile.is_valid())
+    {
+        put_flog(LOG_ERROR, "could not create file %s", filename_.c_str());
+
+        QMutexLocker locker(&mutex_);
+        valid_ = false;
+    }
+
+    // time is the unlimited dimension
+    NcDim * timeDim = NULL;
+    NcDim * nodesDim = NULL;
+    NcDim * stratificationsDim = NULL;
+
+    if(ncFile.is_valid())
+    {
+        timeDim = ncFile.add_dim("time");
+        nodesDim = ncFile.add_dim("nodes", numNodes_);
+        stratificationsDim = ncFile.add_dim("stratifications", numStratifications_);
+    }
+
+    std::map<std::string, NcVar *> ncVars;
+
+    while(true)
+    {
+        std::vector<Frame> frames;
+
+        mutex_.lock();
+
+        while(queue_.empty() == true && finished_ != true)
+        {
+            queueNotEmpty_.wait(&mutex_);
+        }
+
+        frames.swap(queue_);
+
+        bool finished = finished_;
+        bool valid = valid_;
+
+        mutex_.unlock();
+
+        std::vector<Run> runs = getRuns(frames);
+
+        for(unsigned int r=0; r<runs.size() && valid == true; r++)
+        {
+            const Run &run = runs[r];
+
+            if(ncVars.count(run.varName) == 0)
+            {
+                NcVar * ncVar = ncFile.add_var(run.varName.c_str(), ncFloat, timeDim, nodesDim, stratificationsDim);
+
+                if(ncVar == NULL)
+                {
+                    put_flog(LOG_ERROR, "could not create variable %s", run.varName.c_str());
+                    valid = false;
+                    break;
+                }
+
+                size_t chunks[3] = { NETCDF_WRITER_TIME_CHUNK_LENGTH, 1, (size_t)numStratifications_ };
+
+                if(nc_def_var_chunking(ncFile.id(), ncVar->id(), NC_CHUNKED, chunks) != NC_NOERR)
+                {
+                    put_flog(LOG_WARN, "could not set chunking for variable %s", run.varName.c_str());
+                }
+
+                // a day touches one chunk per node, so the cache must hold a full row of chunks
+                size_t chunkCacheSize = (size_t)numNodes_ * NETCDF_WRITER_TIME_CHUNK_LENGTH * numStratifications_ * sizeof(float);
+
+                nc_set_var_chunk_cache(ncFile.id(), ncVar->id(), chunkCacheSize, numNodes_ + 1, 0.75);
+
+                ncVars[run.varName] = ncVar;
+            }
+
+            NcVar * ncVar = ncVars[run.varName];
+
+            if(ncVar->set_cur(run.startTime, 0, 0) != true || ncVar->put(&run.values[0], run.numTimes, numNodes_, numStratifications_) != true)
+            {
+                put_flog(LOG_ERROR, "could not write variable %s at times %i-%i", run.varName.c_str(), run.startTime, run.startTime + run.numTimes - 1);
+                valid = false;
+                break;
+            }
+        }
+
+        if(frames.size() > 0 && valid == true)
+        {
+            // make the completed days available to readers
+            ncFile.sync();
+
+            put_flog(LOG_DEBUG, "wrote %i times through time %i", (int)frames.size(), frames.back().time);
+        }
+
+        if(valid != true)
+        {
+            QMutexLocker locker(&mutex_);
+            valid_ = false;
+        }
+
+        if(finished == true)
+        {
+            break;
+        }
+    }
+
+    ncFile.close();
+#else
+    put_flog(LOG_ERROR, "NetCDF support not enabled");
+
+    QMutexLocker locker(&mutex_);
+    valid_ = false;
+#endif
+}
+
+NetCdfWriter::Frame NetCdfWriter::captureFrame(int time)
+{
+    Frame frame;
+    frame.time = time;
+
+    std::vector<std::vector<std::string> > stratifications = EpidemicDataSet::getStratifications();
+
+    std::vector<int> nodeIds = dataSet_->getNodeIds();
+    std::vector<std::string> varNames = dataSet_->getVariableNames();
+
+    for(unsigned int v=0; v<varNames.size(); v++)
+    {
+        std::vector<float> values;
+
+        if(dataSet_->isDerivedVariable(varNames[v]) == true && dataSet_->isStratifiedVariable(varNames[v]) != true)
+        {
+            // a single value per node, stored in the first stratum so sums over strata are correct
+            values.assign(numNodes_ * numStratifications_, 0.);
+
+            for(unsigned int n=0; n<nodeIds.size(); n++)
+            {
+                values[n * numStratifications_] = dataSet_->getValue(varNames[v], time, nodeIds[n], std::vector<int>());
+            }
+        }
+        else if(dataSet_->isDerivedVariable(varNames[v]) == true)
+        {
+            // derived variables are evaluated for every node and full stratification
+            values.reserve(numNodes_ * numStratifications_);
+
+            for(unsigned int n=0; n<nodeIds.size(); n++)
+            {
+                for(int s=0; s<numStratifications_; s++)
+                {
+                    std::vector<int> stratificationValues(stratifications.size());
+
+                    int remainder = s;
+
+                    for(int j=(int)stratifications.size()-1; j>=0; j--)
+                    {
+                        stratificationValues[j] = remainder % stratifications[j].size();
+                        remainder /= stratifications[j].size();
+                    }
+
+                    values.push_back(dataSet_->getValue(varNames[v], time, nodeIds[n], stratificationValues));
+                }
+            }
+        }
+        else
+        {
+            // a contiguous copy of [node][stratifications...]
+            blitz::Array<float, 1+NUM_STRATIFICATION_DIMENSIONS> slab = dataSet_->getVariableAtTime(varNames[v], time).copy();
+
+            if(slab.numElements() != numNodes_ * numStratifications_)
+            {
+                put_flog(LOG_ERROR, "unexpected size for variable %s at time %i", varNames[v].c_str(), time);
+                continue;
+            }
+
+            values.assign(slab.data(), slab.data() + slab.numElements());
+        }
+
+        frame.variables.push_back(std::pair<std::string, std::vector<float> >(varNames[v], values));
+    }
+
+    return frame;
+}
+
+std::vector<NetCdfWriter::Run> NetCdfWriter::getRuns(const std::vector<Frame> &frames)
+{
+    std::vector<Run> runs;
+
+    // index of the last run of each variable
+    std::map<std::string, unsigned int> lastRuns;
+
+    for(unsigned int f=0; f<frames.size(); f++)
+    {
+        for(unsigned int v=0; v<frames[f].variables.size(); v++)
+        {
+            const std::string &varName = frames[f].variables[v].first;
+            const std::vector<float> &values = frames[f].variables[v].second;
+
+            std::map<std::string, unsigned int>::iterator iter = lastRuns.find(varName);
+
+            // start a new run unless this time continues the variable's last run
+            if(iter == lastRuns.end() || runs[iter->second].startTime + runs[iter->second].numTimes != frames[f].time)
+            {
+                Run run;
+                run.varName = varName;
+                run.startTime = frames[f].time;
+                run.numTimes = 0;
+
+                runs.push_back(run);
+                lastRuns[varName] = runs.size() - 1;
+            }
+
+            Run &run = runs[lastRuns[varName]];
+
+            run.values.insert(run.values.end(), values.begin(), values.end());
+            run.numTimes++;
+        }
+    }
+
+    return runs;
+}
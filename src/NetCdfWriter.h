@@ -0,0 +1,86 @@
+#ifndef NETCDF_WRITER_H
+#define NETCDF_WRITER_H
+
+// chunk length along the time dimension; chunks span one node and all stratifications,
+// so reading the time series of a single node touches few chunks
+#define NETCDF_WRITER_TIME_CHUNK_LENGTH 32
+
+#include <QtCore>
+#include <boost/shared_ptr.hpp>
+#include <string>
+#include <utility>
+#include <vector>
+
+class EpidemicDataSet;
+
+// streams the variables of a data set to a NetCDF file, one time step at a time
+// values are captured in the calling thread and written from a background thread, using the
+// (time, nodes, stratifications) layout expected by EpidemicDataSet::loadNetCdfFile()
+// all time steps queued while the writer thread is busy are written and synced as one batch
+class NetCdfWriter : public QThread
+{
+    public:
+
+        NetCdfWriter(boost::shared_ptr<EpidemicDataSet> dataSet, std::string filename);
+
+        // waits for all queued time steps to be written and closes the file
+        ~NetCdfWriter();
+
+        // capture all regular and derived variables at time and queue them for writing
+        void appendTime(int time);
+
+        // capture all times not yet appended, up to the data set's final time
+        void appendNewTimes();
+
+        // true until an error occurs writing the file
+        bool isValid();
+
+    protected:
+
+        // reimplemented from QThread
+        void run();
+
+    private:
+
+        struct Frame
+        {
+            int time;
+
+            // (variable name, values [node][stratifications...] flattened)
+            std::vector<std::pair<std::string, std::vector<float> > > variables;
+        };
+
+        // consecutive times of one variable, written with a single put
+        struct Run
+        {
+            std::string varName;
+            int startTime;
+            int numTimes;
+
+            // values [time][node][stratifications...] flattened
+            std::vector<float> values;
+        };
+
+        boost::shared_ptr<EpidemicDataSet> dataSet_;
+        std::string filename_;
+
+        int numNodes_;
+        int numStratifications_;
+
+        // next time to be appended
+        int nextTime_;
+
+        // queue shared with the writer thread
+        QMutex mutex_;
+        QWaitCondition queueNotEmpty_;
+        std::vector<Frame> queue_;
+        bool finished_;
+        bool valid_;
+
+        Frame captureFrame(int time);
+
+        // group the frames of a batch into runs of consecutive times per variable
+        static std::vector<Run> getRuns(const std::vector<Frame> &frames);
+};
+
+#endif
@@ -19,10 +19,11 @@ class Npi
         std::vector<int> getNodeIds();
 
         // for the collection of Npis, at the given nodeId, time, two age groups: determine the effectiveness of all Npis combined
-        static double getNpiEffectiveness(std::vector<boost::shared_ptr<Npi> > npis, int nodeId, int time, int ageI, int ageJ);
+        static double getNpiEffectiveness(const std::vector<boost::shared_ptr<Npi> > &npis, int nodeId, int time, int ageI, int ageJ);
 
         // using the above, determine is all Npis combined are effective in stopping a contact
-        static bool isNpiEffective(std::vector<boost::shared_ptr<Npi> > npis, int nodeId, int time, int ageI, int ageJ);
+        // the caller's random number generator is used, so concurrent simulations don't share state
+        static bool isNpiEffective(const std::vector<boost::shared_ptr<Npi> > &npis, int nodeId, int time, int ageI, int ageJ, MTRand &rand);
 
     private:
 
@@ -31,9 +32,6 @@ class Npi
         int duration_;
         std::vector<double> ageEffectiveness_;
         std::vector<int> nodeIds_;
-
-        // random number generator
-        static MTRand rand_;
 };
 
 #endif
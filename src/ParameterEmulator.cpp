@@ -0,0 +1,521 @@
+#include "ParameterEmulator.h"
+#include "ParameterSweep.h"
+#include "Parameters.h"
+#include "log.h"
+#include <QtCore>
+#include <algorithm>
+#include <cmath>
+
+ParameterEmulator::ParameterEmulator()
+{
+    // defaults
+    degree_ = 0;
+}
+
+bool ParameterEmulator::train(const ParameterSweepCube &cube, int degree, double ridge, int holdoutStride)
+{
+    parameterNames_ = cube.getParameterNames();
+    outputNames_ = cube.getMetricNames();
+    degree_ = degree;
+
+    coefficients_.clear();
+
+    std::vector<std::vector<double> > designPoints = cube.getDesignPoints();
+
+    if(parameterNames_.size() == 0 || designPoints.size() == 0 || degree_ < 0)
+    {
+        put_flog(LOG_ERROR, "nothing to train on");
+        return false;
+    }
+
+    // scale each parameter's design range to [-1, 1]
+    parameterMins_.assign(parameterNames_.size(), 0.);
+    parameterMaxs_.assign(parameterNames_.size(), 0.);
+
+    for(unsigned int i=0; i<parameterNames_.size(); i++)
+    {
+        parameterMins_[i] = parameterMaxs_[i] = designPoints[0][i];
+
+        for(unsigned int p=1; p<designPoints.size(); p++)
+        {
+            parameterMins_[i] = std::min(parameterMins_[i], designPoints[p][i]);
+            parameterMaxs_[i] = std::max(parameterMaxs_[i], designPoints[p][i]);
+        }
+    }
+
+    createTerms();
+    createCurveIndices();
+
+    int numTerms = terms_.size();
+    int numOutputs = outputNames_.size();
+
+    // normal equations: (A^T A + ridge * n * I) C = A^T Y, one row of A per completed replicate
+    std::vector<double> ata(numTerms * numTerms, 0.);
+    std::vector<double> aty(numTerms * numOutputs, 0.);
+    int numRows = 0;
+
+    std::vector<double> termValues;
+
+    for(unsigned int p=0; p<designPoints.size(); p++)
+    {
+        if(holdoutStride > 0 && p % holdoutStride == 0)
+        {
+            continue;
+        }
+
+        evaluateTerms(designPoints[p], termValues);
+
+        for(int r=0; r<cube.getNumReplicates(); r++)
+        {
+            std::vector<float> metrics = cube.getResult(p, r);
+
+            if(metrics.size() == 0)
+            {
+                continue;
+            }
+
+            for(int i=0; i<numTerms; i++)
+            {
+                for(int j=0; j<numTerms; j++)
+                {
+                    ata[i*numTerms + j] += termValues[i] * termValues[j];
+                }
+
+                for(int m=0; m<numOutputs; m++)
+                {
+                    aty[i*numOutputs + m] += termValues[i] * metrics[m];
+                }
+            }
+
+            numRows++;
+        }
+    }
+
+    if(numRows < numTerms)
+    {
+        put_flog(LOG_ERROR, "%i completed replicates for %i terms; use a lower degree or a larger sweep", numRows, numTerms);
+        return false;
+    }
+
+    // the constant term is not penalized
+    for(int i=1; i<numTerms; i++)
+    {
+        ata[i*numTerms + i] += ridge * (double)numRows;
+    }
+
+    if(solveNormalEquations(numTerms, ata, aty, numOutputs, coefficients_) != true)
+    {
+        put_flog(LOG_ERROR, "singular system; the design does not vary some parameter, or the degree is too high");
+        coefficients_.clear();
+        return false;
+    }
+
+    put_flog(LOG_INFO, "trained degree %i emulator: %i parameters, %i terms, %i outputs, %i replicates", degree_, (int)parameterNames_.size(), numTerms, numOutputs, numRows);
+
+    return true;
+}
+
+bool ParameterEmulator::solveNormalEquations(int n, std::vector<double> &matrix, const std::vector<double> &rightHandSides, int numOutputs, std::vector<double> &solutions)
+{
+    // Cholesky factorization, in place in the lower triangle
+    for(int j=0; j<n; j++)
+    {
+        double d = matrix[j*n + j];
+
+        for(int k=0; k<j; k++)
+        {
+            d -= matrix[j*n + k] * matrix[j*n + k];
+        }
+
+        if(d <= 0.)
+        {
+            return false;
+        }
+
+        matrix[j*n + j] = sqrt(d);
+
+        for(int i=j+1; i<n; i++)
+        {
+            double s = matrix[i*n + j];
+
+            for(int k=0; k<j; k++)
+            {
+                s -= matrix[i*n + k] * matrix[j*n + k];
+            }
+
+            matrix[i*n + j] = s / matrix[j*n + j];
+        }
+    }
+
+    // forward and back substitution for each output
+    solutions.assign(n * numOutputs, 0.);
+
+    std::vector<double> y(n);
+
+    for(int m=0; m<numOutputs; m++)
+    {
+        for(int i=0; i<n; i++)
+        {
+            double s = rightHandSides[i*numOutputs + m];
+
+            for(int k=0; k<i; k++)
+            {
+                s -= matrix[i*n + k] * y[k];
+            }
+
+            y[i] = s / matrix[i*n + i];
+        }
+
+        for(int i=n-1; i>=0; i--)
+        {
+            double s = y[i];
+
+            for(int k=i+1; k<n; k++)
+            {
+                s -= matrix[k*n + i] * solutions[k*numOutputs + m];
+            }
+
+            solutions[i*numOutputs + m] = s / matrix[i*n + i];
+        }
+    }
+
+    return true;
+}
+
+void ParameterEmulator::getLegendrePolynomials(double x, int degree, std::vector<double> &values)
+{
+    values.assign(degree + 1, 1.);
+
+    if(degree >= 1)
+    {
+        values[1] = x;
+    }
+
+    for(int n=1; n<degree; n++)
+    {
+        values[n+1] = ((double)(2*n + 1) * x * values[n] - (double)n * values[n-1]) / (double)(n + 1);
+    }
+}
+
+bool ParameterEmulator::isValid() const
+{
+    return coefficients_.size() > 0;
+}
+
+bool ParameterEmulator::save(std::string filename) const
+{
+    QFile file(filename.c_str());
+
+    if(file.open(QIODevice::WriteOnly | QIODevice::Text) != true)
+    {
+        put_flog(LOG_ERROR, "could not open %s", filename.c_str());
+        return false;
+    }
+
+    // tab-separated, since group names may contain spaces
+    QTextStream stream(&file);
+    stream.setRealNumberPrecision(17);
+
+    stream << "# exercise parameter emulator\n";
+    stream << "degree\t" << degree_ << "\n";
+
+    for(unsigned int i=0; i<parameterNames_.size(); i++)
+    {
+        stream << "parameter\t" << parameterNames_[i].c_str() << "\t" << parameterMins_[i] << "\t" << parameterMaxs_[i] << "\n";
+    }
+
+    for(unsigned int m=0; m<outputNames_.size(); m++)
+    {
+        stream << "output\t" << outputNames_[m].c_str() << "\n";
+    }
+
+    // the terms are recreated from the degree on loading; one line of coefficients per term
+    for(unsigned int t=0; t<terms_.size(); t++)
+    {
+        stream << "coefficients";
+
+        for(unsigned int m=0; m<outputNames_.size(); m++)
+        {
+            stream << "\t" << coefficients_[t*outputNames_.size() + m];
+        }
+
+        stream << "\n";
+    }
+
+    put_flog(LOG_INFO, "wrote %s", filename.c_str());
+
+    return stream.status() == QTextStream::Ok;
+}
+
+bool ParameterEmulator::load(std::string filename)
+{
+    QFile file(filename.c_str());
+
+    if(file.open(QIODevice::ReadOnly | QIODevice::Text) != true)
+    {
+        put_flog(LOG_ERROR, "could not open %s", filename.c_str());
+        return false;
+    }
+
+    parameterNames_.clear();
+    parameterMins_.clear();
+    parameterMaxs_.clear();
+    outputNames_.clear();
+    coefficients_.clear();
+    degree_ = 0;
+
+    QTextStream stream(&file);
+
+    while(stream.atEnd() != true)
+    {
+        QStringList fields = stream.readLine().split('\t');
+
+        if(fields.size() < 2 || fields[0].startsWith("#") == true)
+        {
+            continue;
+        }
+
+        if(fields[0] == "degree")
+        {
+            degree_ = fields[1].toInt();
+        }
+        else if(fields[0] == "parameter" && fields.size() == 4)
+        {
+            parameterNames_.push_back(fields[1].toStdString());
+            parameterMins_.push_back(fields[2].toDouble());
+            parameterMaxs_.push_back(fields[3].toDouble());
+        }
+        else if(fields[0] == "output")
+        {
+            outputNames_.push_back(fields[1].toStdString());
+        }
+        else if(fields[0] == "coefficients")
+        {
+            for(int i=1; i<fields.size(); i++)
+            {
+                coefficients_.push_back(fields[i].toDouble());
+            }
+        }
+    }
+
+    createTerms();
+    createCurveIndices();
+
+    if(parameterNames_.size() == 0 || coefficients_.size() != terms_.size() * outputNames_.size())
+    {
+        put_flog(LOG_ERROR, "invalid emulator file %s", filename.c_str());
+        coefficients_.clear();
+        return false;
+    }
+
+    put_flog(LOG_INFO, "loaded degree %i emulator: %i parameters, %i outputs", degree_, (int)parameterNames_.size(), (int)outputNames_.size());
+
+    return true;
+}
+
+std::vector<std::string> ParameterEmulator::getParameterNames() const
+{
+    return parameterNames_;
+}
+
+std::vector<std::string> ParameterEmulator::getOutputNames() const
+{
+    return outputNames_;
+}
+
+int ParameterEmulator::getDegree() const
+{
+    return degree_;
+}
+
+int ParameterEmulator::getNumTerms() const
+{
+    return terms_.size();
+}
+
+void ParameterEmulator::getParameterRange(int index, double &min, double &max) const
+{
+    min = parameterMins_[index];
+    max = parameterMaxs_[index];
+}
+
+bool ParameterEmulator::predict(const std::vector<double> &parameterValues, std::vector<double> &outputs) const
+{
+    std::vector<double> termValues;
+
+    bool inRange = evaluateTerms(parameterValues, termValues);
+
+    int numOutputs = outputNames_.size();
+
+    outputs.assign(numOutputs, 0.);
+
+    for(unsigned int t=0; t<terms_.size(); t++)
+    {
+        const double * coefficients = &coefficients_[t*numOutputs];
+        double termValue = termValues[t];
+
+        for(int m=0; m<numOutputs; m++)
+        {
+            outputs[m] += termValue * coefficients[m];
+        }
+    }
+
+    return inRange;
+}
+
+bool ParameterEmulator::predict(Parameters &parameters, std::vector<double> &outputs) const
+{
+    std::vector<double> parameterValues(parameterNames_.size(), 0.);
+
+    for(unsigned int i=0; i<parameterNames_.size(); i++)
+    {
+        parameters.getValue(parameterNames_[i], parameterValues[i]);
+    }
+
+    return predict(parameterValues, outputs);
+}
+
+std::vector<std::string> ParameterEmulator::getCurveGroupNames() const
+{
+    std::vector<std::string> groupNames;
+
+    for(std::map<std::string, std::vector<int> >::const_iterator iter=curveIndices_.begin(); iter!=curveIndices_.end(); iter++)
+    {
+        groupNames.push_back(iter->first);
+    }
+
+    return groupNames;
+}
+
+std::vector<double> ParameterEmulator::getCurve(const std::vector<double> &outputs, std::string groupName) const
+{
+    std::vector<double> curve;
+
+    std::map<std::string, std::vector<int> >::const_iterator iter = curveIndices_.find(groupName);
+
+    if(iter == curveIndices_.end())
+    {
+        return curve;
+    }
+
+    for(unsigned int t=0; t<iter->second.size(); t++)
+    {
+        // the expected value of a count is not negative, but the polynomial may dip below zero
+        curve.push_back(std::max(0., outputs[iter->second[t]]));
+    }
+
+    return curve;
+}
+
+void ParameterEmulator::createTerms()
+{
+    // all combinations of exponents with a total of at most degree_, in order of increasing total degree
+    terms_.clear();
+
+    std::vector<int> exponents(parameterNames_.size(), 0);
+
+    for(int total=0; total<=degree_; total++)
+    {
+        // enumerate the compositions of total into parameterNames_.size() non-negative parts
+        exponents.assign(parameterNames_.size(), 0);
+
+        if(exponents.size() == 0)
+        {
+            break;
+        }
+
+        exponents.back() = total;
+
+        while(true)
+        {
+            terms_.push_back(exponents);
+
+            // next composition: move one unit from the last nonzero part (other than the first) to its left neighbor,
+            // and collect the rest in the last part
+            int i = (int)exponents.size() - 1;
+
+            while(i > 0 && exponents[i] == 0)
+            {
+                i--;
+            }
+
+            if(i == 0)
+            {
+                break;
+            }
+
+            int rest = exponents[i] - 1;
+            exponents[i] = 0;
+            exponents[i-1]++;
+            exponents.back() += rest;
+        }
+    }
+}
+
+void ParameterEmulator::createCurveIndices()
+{
+    // outputs named "infected.<group>.day<t>"
+    curveIndices_.clear();
+
+    for(unsigned int m=0; m<outputNames_.size(); m++)
+    {
+        const std::string &name = outputNames_[m];
+
+        size_t dayPosition = name.rfind(".day");
+
+        if(name.compare(0, 9, "infected.") != 0 || dayPosition == std::string::npos || dayPosition < 9)
+        {
+            continue;
+        }
+
+        std::string groupName = name.substr(9, dayPosition - 9);
+        unsigned int day = QString(name.substr(dayPosition + 4).c_str()).toUInt();
+
+        std::vector<int> &indices = curveIndices_[groupName];
+
+        if(indices.size() <= day)
+        {
+            indices.resize(day + 1, m);
+        }
+
+        indices[day] = m;
+    }
+}
+
+bool ParameterEmulator::evaluateTerms(const std::vector<double> &parameterValues, std::vector<double> &termValues) const
+{
+    bool inRange = true;
+
+    // Legendre polynomials of each scaled parameter, up to the degree
+    std::vector<std::vector<double> > legendre(parameterNames_.size());
+
+    for(unsigned int i=0; i<parameterNames_.size(); i++)
+    {
+        double x = 0.;
+
+        if(parameterMaxs_[i] > parameterMins_[i])
+        {
+            x = 2. * (parameterValues[i] - parameterMins_[i]) / (parameterMaxs_[i] - parameterMins_[i]) - 1.;
+        }
+
+        if(x < -1. || x > 1.)
+        {
+            inRange = false;
+            x = std::max(-1., std::min(1., x));
+        }
+
+        getLegendrePolynomials(x, degree_, legendre[i]);
+    }
+
+    termValues.assign(terms_.size(), 1.);
+
+    for(unsigned int t=0; t<terms_.size(); t++)
+    {
+        for(unsigned int i=0; i<terms_[t].size(); i++)
+        {
+            termValues[t] *= legendre[i][terms_[t][i]];
+        }
+    }
+
+    return inRange;
+}
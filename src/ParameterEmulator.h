@@ -0,0 +1,91 @@
+#ifndef PARAMETER_EMULATOR_H
+#define PARAMETER_EMULATOR_H
+
+#define PARAMETER_EMULATOR_DEFAULT_DEGREE 2
+#define PARAMETER_EMULATOR_DEFAULT_RIDGE 1e-6
+
+#include <map>
+#include <string>
+#include <vector>
+
+class Parameters;
+class ParameterSweepCube;
+
+// a fast surrogate of the model's expected outputs as a function of swept parameters, for interactive exploration
+//
+// the emulator is a polynomial chaos expansion: every output (summary metrics and, if the sweep recorded them, the
+// daily curves of all infected per group) is a linear combination of products of Legendre polynomials in the
+// parameters scaled to [-1, 1] over the range of the design, up to a total degree
+// coefficients are fit by least squares (with a small ridge penalty) to every completed replicate of a sweep, so
+// the fit is to the expected value over the model's stochasticity
+//
+// evaluation costs (number of terms) x (number of outputs) multiply-adds: microseconds for a few parameters
+class ParameterEmulator
+{
+    public:
+
+        ParameterEmulator();
+
+        // fit to the completed replicates of a sweep
+        // with a holdout stride k > 0, every k-th design point is left out, e.g. for validation
+        bool train(const ParameterSweepCube &cube, int degree, double ridge, int holdoutStride=0);
+
+        bool isValid() const;
+
+        bool save(std::string filename) const;
+        bool load(std::string filename);
+
+        std::vector<std::string> getParameterNames() const;
+        std::vector<std::string> getOutputNames() const;
+        int getDegree() const;
+        int getNumTerms() const;
+
+        // trained range of a parameter
+        void getParameterRange(int index, double &min, double &max) const;
+
+        // expected outputs for parameter values (in getParameterNames() order)
+        // values outside the trained range are clamped to it; returns false if any was
+        bool predict(const std::vector<double> &parameterValues, std::vector<double> &outputs) const;
+
+        // same, for the emulated parameters' current values in a parameters object
+        bool predict(Parameters &parameters, std::vector<double> &outputs) const;
+
+        // groups with emulated curves, and a group's curve (indexed by day) from predicted outputs
+        std::vector<std::string> getCurveGroupNames() const;
+        std::vector<double> getCurve(const std::vector<double> &outputs, std::string groupName) const;
+
+        // solve the symmetric positive definite n x n system (row-major) for numOutputs right hand sides, each
+        // stored at [i * numOutputs + m], by Cholesky factorization; the matrix is overwritten by its factor
+        // returns false if the matrix is not positive definite
+        static bool solveNormalEquations(int n, std::vector<double> &matrix, const std::vector<double> &rightHandSides, int numOutputs, std::vector<double> &solutions);
+
+        // Legendre polynomials P_0(x) .. P_degree(x)
+        static void getLegendrePolynomials(double x, int degree, std::vector<double> &values);
+
+    private:
+
+        std::vector<std::string> parameterNames_;
+        std::vector<double> parameterMins_;
+        std::vector<double> parameterMaxs_;
+
+        int degree_;
+
+        // exponents of each parameter's Legendre polynomial, for each term
+        std::vector<std::vector<int> > terms_;
+
+        std::vector<std::string> outputNames_;
+
+        // coefficient of term t for output m at [t * number of outputs + m]
+        std::vector<double> coefficients_;
+
+        // output indices of each group's curve, by day
+        std::map<std::string, std::vector<int> > curveIndices_;
+
+        void createTerms();
+        void createCurveIndices();
+
+        // the terms' values at parameter values; returns false if any value was clamped
+        bool evaluateTerms(const std::vector<double> &parameterValues, std::vector<double> &termValues) const;
+};
+
+#endif
@@ -0,0 +1,815 @@
+#include "ParameterSweep.h"
+#include "EpidemicSimulation.h"
+#include "Parameters.h"
+#include "models/MersenneTwister.h"
+#include "log.h"
+#include <algorithm>
+#include <cmath>
+
+// identifies sweep result files, and their format version
+#define PARAMETER_SWEEP_CUBE_MAGIC 0x45585357
+#define PARAMETER_SWEEP_CUBE_VERSION 1
+
+ParameterSweepCube::ParameterSweepCube()
+{
+    // defaults
+    numReplicates_ = 0;
+    numDays_ = 0;
+    firstSeed_ = 0;
+    recordsOffset_ = 0;
+}
+
+bool ParameterSweepCube::open(std::string filename, const std::vector<std::string> &parameterNames, const std::vector<std::vector<double> > &designPoints, const std::vector<std::string> &metricNames, int numReplicates, int numDays, unsigned long firstSeed)
+{
+    QMutexLocker locker(&mutex_);
+
+    file_.close();
+    file_.setFileName(filename.c_str());
+
+    if(file_.exists() == true)
+    {
+        // resume: the existing file must describe the same sweep
+        if(file_.open(QIODevice::ReadWrite) != true || readHeader() != true)
+        {
+            put_flog(LOG_ERROR, "could not read %s", filename.c_str());
+            return false;
+        }
+
+        if(parameterNames_ != parameterNames || designPoints_ != designPoints || metricNames_ != metricNames || numReplicates_ != numReplicates || numDays_ != numDays || firstSeed_ != firstSeed)
+        {
+            put_flog(LOG_ERROR, "%s holds a different sweep; use another file to start a new sweep", filename.c_str());
+            file_.close();
+            return false;
+        }
+
+        return readCompletion();
+    }
+
+    parameterNames_ = parameterNames;
+    designPoints_ = designPoints;
+    metricNames_ = metricNames;
+    numReplicates_ = numReplicates;
+    numDays_ = numDays;
+    firstSeed_ = firstSeed;
+
+    if(file_.open(QIODevice::ReadWrite) != true || writeHeader() != true)
+    {
+        put_flog(LOG_ERROR, "could not write %s", filename.c_str());
+        return false;
+    }
+
+    // all records start out incomplete (zero completion flag)
+    complete_.assign(designPoints_.size() * numReplicates_, false);
+
+    if(file_.resize(recordsOffset_ + (qint64)complete_.size() * getRecordSize()) != true)
+    {
+        put_flog(LOG_ERROR, "could not write %s", filename.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool ParameterSweepCube::open(std::string filename)
+{
+    QMutexLocker locker(&mutex_);
+
+    file_.close();
+    file_.setFileName(filename.c_str());
+
+    if(file_.open(QIODevice::ReadOnly) != true || readHeader() != true)
+    {
+        put_flog(LOG_ERROR, "could not read %s", filename.c_str());
+        return false;
+    }
+
+    return readCompletion();
+}
+
+std::vector<std::string> ParameterSweepCube::getParameterNames() const
+{
+    return parameterNames_;
+}
+
+std::vector<std::vector<double> > ParameterSweepCube::getDesignPoints() const
+{
+    return designPoints_;
+}
+
+std::vector<std::string> ParameterSweepCube::getMetricNames() const
+{
+    return metricNames_;
+}
+
+int ParameterSweepCube::getNumReplicates() const
+{
+    return numReplicates_;
+}
+
+int ParameterSweepCube::getNumDays() const
+{
+    return numDays_;
+}
+
+unsigned long ParameterSweepCube::getFirstSeed() const
+{
+    return firstSeed_;
+}
+
+bool ParameterSweepCube::isComplete(int pointIndex, int replicate) const
+{
+    QMutexLocker locker(&mutex_);
+
+    return complete_[pointIndex * numReplicates_ + replicate];
+}
+
+int ParameterSweepCube::getNumComplete() const
+{
+    QMutexLocker locker(&mutex_);
+
+    return (int)std::count(complete_.begin(), complete_.end(), true);
+}
+
+std::vector<float> ParameterSweepCube::getResult(int pointIndex, int replicate) const
+{
+    QMutexLocker locker(&mutex_);
+
+    std::vector<float> metrics;
+
+    int record = pointIndex * numReplicates_ + replicate;
+
+    if(complete_[record] != true)
+    {
+        return metrics;
+    }
+
+    // QFile::seek() is not const, but reading does not change the state seen by callers
+    QFile &file = const_cast<QFile &>(file_);
+
+    file.seek(recordsOffset_ + (qint64)record * getRecordSize() + 1);
+
+    QDataStream stream(&file);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    for(unsigned int i=0; i<metricNames_.size(); i++)
+    {
+        float value;
+        stream >> value;
+
+        metrics.push_back(value);
+    }
+
+    return metrics;
+}
+
+bool ParameterSweepCube::setResult(int pointIndex, int replicate, const std::vector<float> &metrics)
+{
+    QMutexLocker locker(&mutex_);
+
+    if(metrics.size() != metricNames_.size())
+    {
+        put_flog(LOG_ERROR, "expected %i metrics, got %i", (int)metricNames_.size(), (int)metrics.size());
+        return false;
+    }
+
+    int record = pointIndex * numReplicates_ + replicate;
+
+    QDataStream stream(&file_);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    // the metrics first and the completion flag last, so an interrupted write leaves the record incomplete
+    file_.seek(recordsOffset_ + (qint64)record * getRecordSize() + 1);
+
+    for(unsigned int i=0; i<metrics.size(); i++)
+    {
+        stream << metrics[i];
+    }
+
+    file_.flush();
+
+    file_.seek(recordsOffset_ + (qint64)record * getRecordSize());
+    stream << (quint8)1;
+
+    file_.flush();
+
+    if(stream.status() != QDataStream::Ok)
+    {
+        put_flog(LOG_ERROR, "could not write record %i", record);
+        return false;
+    }
+
+    complete_[record] = true;
+
+    return true;
+}
+
+bool ParameterSweepCube::getSummary(int pointIndex, int metricIndex, double &mean, double &standardDeviation) const
+{
+    std::vector<double> values;
+
+    for(int r=0; r<numReplicates_; r++)
+    {
+        std::vector<float> metrics = getResult(pointIndex, r);
+
+        if(metrics.size() > 0)
+        {
+            values.push_back(metrics[metricIndex]);
+        }
+    }
+
+    if(values.size() == 0)
+    {
+        return false;
+    }
+
+    mean = 0.;
+
+    for(unsigned int i=0; i<values.size(); i++)
+    {
+        mean += values[i];
+    }
+
+    mean /= (double)values.size();
+
+    standardDeviation = 0.;
+
+    for(unsigned int i=0; i<values.size(); i++)
+    {
+        standardDeviation += (values[i] - mean) * (values[i] - mean);
+    }
+
+    if(values.size() > 1)
+    {
+        standardDeviation = sqrt(standardDeviation / (double)(values.size() - 1));
+    }
+
+    return true;
+}
+
+qint64 ParameterSweepCube::getRecordSize() const
+{
+    // completion flag and single-precision metrics
+    return 1 + 4 * (qint64)metricNames_.size();
+}
+
+bool ParameterSweepCube::writeHeader()
+{
+    QDataStream stream(&file_);
+    stream.setVersion(QDataStream::Qt_4_6);
+
+    stream << (quint32)PARAMETER_SWEEP_CUBE_MAGIC << (quint32)PARAMETER_SWEEP_CUBE_VERSION;
+    stream << (quint32)parameterNames_.size() << (quint32)designPoints_.size() << (quint32)metricNames_.size();
+    stream << (qint32)numReplicates_ << (qint32)numDays_ << (quint64)firstSeed_;
+
+    for(unsigned int i=0; i<parameterNames_.size(); i++)
+    {
+        stream << QString(parameterNames_[i].c_str());
+    }
+
+    for(unsigned int i=0; i<metricNames_.size(); i++)
+    {
+        stream << QString(metricNames_[i].c_str());
+    }
+
+    for(unsigned int p=0; p<designPoints_.size(); p++)
+    {
+        for(unsigned int i=0; i<designPoints_[p].size(); i++)
+        {
+            stream << designPoints_[p][i];
+        }
+    }
+
+    recordsOffset_ = file_.pos();
+
+    return stream.status() == QDataStream::Ok;
+}
+
+bool ParameterSweepCube::readHeader()
+{
+    QDataStream stream(&file_);
+    stream.setVersion(QDataStream::Qt_4_6);
+
+    quint32 magic, version, numParameters, numPoints, numMetrics;
+    qint32 numReplicates, numDays;
+    quint64 firstSeed;
+
+    stream >> magic >> version;
+
+    if(magic != PARAMETER_SWEEP_CUBE_MAGIC || version != PARAMETER_SWEEP_CUBE_VERSION)
+    {
+        put_flog(LOG_ERROR, "not a sweep result file, or an unsupported version");
+        return false;
+    }
+
+    stream >> numParameters >> numPoints >> numMetrics >> numReplicates >> numDays >> firstSeed;
+
+    parameterNames_.clear();
+    metricNames_.clear();
+    designPoints_.clear();
+
+    for(unsigned int i=0; i<numParameters; i++)
+    {
+        QString name;
+        stream >> name;
+
+        parameterNames_.push_back(name.toStdString());
+    }
+
+    for(unsigned int i=0; i<numMetrics; i++)
+    {
+        QString name;
+        stream >> name;
+
+        metricNames_.push_back(name.toStdString());
+    }
+
+    for(unsigned int p=0; p<numPoints; p++)
+    {
+        std::vector<double> point(numParameters);
+
+        for(unsigned int i=0; i<numParameters; i++)
+        {
+            stream >> point[i];
+        }
+
+        designPoints_.push_back(point);
+    }
+
+    numReplicates_ = numReplicates;
+    numDays_ = numDays;
+    firstSeed_ = (unsigned long)firstSeed;
+
+    recordsOffset_ = file_.pos();
+
+    return stream.status() == QDataStream::Ok;
+}
+
+bool ParameterSweepCube::readCompletion()
+{
+    int numRecords = designPoints_.size() * numReplicates_;
+
+    complete_.assign(numRecords, false);
+
+    if(file_.size() < recordsOffset_ + (qint64)numRecords * getRecordSize())
+    {
+        put_flog(LOG_ERROR, "truncated sweep result file");
+        return false;
+    }
+
+    for(int r=0; r<numRecords; r++)
+    {
+        char flag = 0;
+
+        file_.seek(recordsOffset_ + (qint64)r * getRecordSize());
+        file_.getChar(&flag);
+
+        complete_[r] = (flag != 0);
+    }
+
+    return true;
+}
+
+// worker thread of a sweep
+class ParameterSweepThread : public QThread
+{
+    public:
+
+        ParameterSweepThread(ParameterSweep * sweep, int threadIndex)
+        {
+            sweep_ = sweep;
+            threadIndex_ = threadIndex;
+        }
+
+    protected:
+
+        void run()
+        {
+            int task;
+
+            while(sweep_->takeTask(threadIndex_, task) == true)
+            {
+                sweep_->runTask(task);
+            }
+        }
+
+    private:
+
+        ParameterSweep * sweep_;
+        int threadIndex_;
+};
+
+ParameterSweep::ParameterSweep()
+{
+    // defaults
+    numReplicates_ = PARAMETER_SWEEP_DEFAULT_NUM_REPLICATES;
+    numDays_ = PARAMETER_SWEEP_DEFAULT_NUM_DAYS;
+    firstSeed_ = 1;
+    recordCurves_ = false;
+
+    baseParameters_ = NULL;
+    numTasks_ = 0;
+}
+
+bool ParameterSweep::setGridDesign(const std::vector<ParameterSweepRange> &ranges)
+{
+    if(checkRanges(ranges) != true)
+    {
+        return false;
+    }
+
+    parameterNames_.clear();
+    designPoints_.clear();
+
+    for(unsigned int i=0; i<ranges.size(); i++)
+    {
+        parameterNames_.push_back(ranges[i].name);
+    }
+
+    // full factorial design; the last parameter varies fastest
+    std::vector<int> levelIndices(ranges.size(), 0);
+
+    while(true)
+    {
+        std::vector<double> point;
+
+        for(unsigned int i=0; i<ranges.size(); i++)
+        {
+            if(ranges[i].levels > 1)
+            {
+                point.push_back(ranges[i].min + (ranges[i].max - ranges[i].min) * (double)levelIndices[i] / (double)(ranges[i].levels - 1));
+            }
+            else
+            {
+                point.push_back(0.5 * (ranges[i].min + ranges[i].max));
+            }
+        }
+
+        designPoints_.push_back(point);
+
+        // next combination
+        int i = (int)ranges.size() - 1;
+
+        while(i >= 0 && ++levelIndices[i] == ranges[i].levels)
+        {
+            levelIndices[i] = 0;
+            i--;
+        }
+
+        if(i < 0)
+        {
+            break;
+        }
+    }
+
+    put_flog(LOG_INFO, "grid design over %i parameters: %i points", (int)ranges.size(), (int)designPoints_.size());
+
+    return true;
+}
+
+bool ParameterSweep::setLatinHypercubeDesign(const std::vector<ParameterSweepRange> &ranges, int numPoints, unsigned long seed)
+{
+    if(checkRanges(ranges) != true)
+    {
+        return false;
+    }
+
+    if(numPoints < 1)
+    {
+        put_flog(LOG_ERROR, "need at least one design point");
+        return false;
+    }
+
+    parameterNames_.clear();
+    designPoints_.assign(numPoints, std::vector<double>(ranges.size(), 0.));
+
+    MTRand rand((MTRand::uint32)seed);
+
+    for(unsigned int i=0; i<ranges.size(); i++)
+    {
+        parameterNames_.push_back(ranges[i].name);
+
+        // one point in each of numPoints equal strata, in random order
+        std::vector<int> strata(numPoints);
+
+        for(int p=0; p<numPoints; p++)
+        {
+            strata[p] = p;
+        }
+
+        for(int p=numPoints-1; p>0; p--)
+        {
+            std::swap(strata[p], strata[rand.randInt(p)]);
+        }
+
+        for(int p=0; p<numPoints; p++)
+        {
+            double u = ((double)strata[p] + rand.rand()) / (double)numPoints;
+
+            designPoints_[p][i] = ranges[i].min + u * (ranges[i].max - ranges[i].min);
+        }
+    }
+
+    put_flog(LOG_INFO, "Latin hypercube design over %i parameters: %i points", (int)ranges.size(), numPoints);
+
+    return true;
+}
+
+std::vector<std::string> ParameterSweep::getParameterNames() const
+{
+    return parameterNames_;
+}
+
+std::vector<std::vector<double> > ParameterSweep::getDesignPoints() const
+{
+    return designPoints_;
+}
+
+void ParameterSweep::setNumReplicates(int numReplicates)
+{
+    numReplicates_ = numReplicates;
+}
+
+void ParameterSweep::setNumDays(int numDays)
+{
+    numDays_ = numDays;
+}
+
+void ParameterSweep::setFirstSeed(unsigned long firstSeed)
+{
+    firstSeed_ = firstSeed;
+}
+
+void ParameterSweep::setRecordCurves(bool recordCurves)
+{
+    recordCurves_ = recordCurves;
+}
+
+std::vector<std::string> ParameterSweep::getMetricNames()
+{
+    const char * names[] = { "final_size", "peak_day", "peak_infected", "deceased", "treated", "vaccinated" };
+
+    return std::vector<std::string>(names, names + sizeof(names) / sizeof(names[0]));
+}
+
+bool ParameterSweep::run(std::string filename, boost::shared_ptr<EpidemicSimulation> initialSimulation, Parameters &baseParameters, boost::function<void (boost::shared_ptr<EpidemicSimulation>)> initialCases, int numThreads)
+{
+    if(designPoints_.size() == 0 || numReplicates_ < 1 || numDays_ < 1)
+    {
+        put_flog(LOG_ERROR, "empty sweep");
+        return false;
+    }
+
+    metricNames_ = getMetricNames();
+    groupNames_.clear();
+
+    if(recordCurves_ == true)
+    {
+        groupNames_ = initialSimulation->getGroupNames();
+
+        for(unsigned int g=0; g<groupNames_.size(); g++)
+        {
+            for(int t=0; t<=numDays_; t++)
+            {
+                metricNames_.push_back("infected." + groupNames_[g] + ".day" + QString::number(t).toStdString());
+            }
+        }
+    }
+
+    if(cube_.open(filename, parameterNames_, designPoints_, metricNames_, numReplicates_, numDays_, firstSeed_) != true)
+    {
+        return false;
+    }
+
+    initialSimulation_ = initialSimulation;
+    baseParameters_ = &baseParameters;
+    initialCases_ = initialCases;
+
+    numThreads = std::max(1, numThreads);
+
+    // remaining tasks, dealt out in contiguous blocks so each thread starts on its own design points
+    std::vector<int> tasks;
+
+    for(int t=0; t<(int)designPoints_.size() * numReplicates_; t++)
+    {
+        if(cube_.isComplete(t / numReplicates_, t % numReplicates_) != true)
+        {
+            tasks.push_back(t);
+        }
+    }
+
+    numTasks_ = (int)tasks.size();
+    numCompleted_ = 0;
+
+    put_flog(LOG_INFO, "%i design points x %i replicates: %i to run (%i already complete) on %i threads", (int)designPoints_.size(), numReplicates_, numTasks_, (int)designPoints_.size() * numReplicates_ - numTasks_, numThreads);
+
+    queueMutexes_.clear();
+    queues_.assign(numThreads, std::deque<int>());
+
+    for(int i=0; i<numThreads; i++)
+    {
+        queueMutexes_.push_back(boost::shared_ptr<QMutex>(new QMutex()));
+
+        int first = (int)((qint64)numTasks_ * i / numThreads);
+        int last = (int)((qint64)numTasks_ * (i+1) / numThreads);
+
+        queues_[i].assign(tasks.begin() + first, tasks.begin() + last);
+    }
+
+    std::vector<boost::shared_ptr<ParameterSweepThread> > threads;
+
+    for(int i=0; i<numThreads; i++)
+    {
+        threads.push_back(boost::shared_ptr<ParameterSweepThread>(new ParameterSweepThread(this, i)));
+        threads[i]->start();
+    }
+
+    for(int i=0; i<numThreads; i++)
+    {
+        threads[i]->wait();
+    }
+
+    initialSimulation_.reset();
+    baseParameters_ = NULL;
+
+    int numComplete = cube_.getNumComplete();
+
+    put_flog(LOG_INFO, "%i / %i replicates complete", numComplete, (int)designPoints_.size() * numReplicates_);
+
+    return numComplete == (int)designPoints_.size() * numReplicates_;
+}
+
+bool ParameterSweep::takeTask(int threadIndex, int &task)
+{
+    // own queue first, from the front
+    {
+        QMutexLocker locker(queueMutexes_[threadIndex].get());
+
+        if(queues_[threadIndex].empty() != true)
+        {
+            task = queues_[threadIndex].front();
+            queues_[threadIndex].pop_front();
+
+            return true;
+        }
+    }
+
+    // then steal from the back of the other queues
+    for(unsigned int i=1; i<queues_.size(); i++)
+    {
+        int victim = (threadIndex + i) % queues_.size();
+
+        QMutexLocker locker(queueMutexes_[victim].get());
+
+        if(queues_[victim].empty() != true)
+        {
+            task = queues_[victim].back();
+            queues_[victim].pop_back();
+
+            return true;
+        }
+    }
+
+    // tasks are never added during a run, so no more work
+    return false;
+}
+
+void ParameterSweep::runTask(int task)
+{
+    int pointIndex = task / numReplicates_;
+    int replicate = task % numReplicates_;
+
+    // this replicate's parameters
+    boost::shared_ptr<Parameters> parameters(new Parameters());
+    parameters->copyValues(*baseParameters_);
+
+    for(unsigned int i=0; i<parameterNames_.size(); i++)
+    {
+        parameters->setValue(parameterNames_[i], designPoints_[pointIndex][i]);
+    }
+
+    boost::shared_ptr<EpidemicSimulation> simulation;
+
+    {
+        QMutexLocker locker(&copyMutex_);
+
+        simulation = initialSimulation_->clone();
+    }
+
+    if(simulation == NULL)
+    {
+        put_flog(LOG_ERROR, "could not copy simulation");
+        return;
+    }
+
+    simulation->setParameters(parameters);
+    simulation->seed(firstSeed_ + replicate);
+
+    if(initialCases_.empty() != true)
+    {
+        initialCases_(simulation);
+    }
+
+    for(int d=0; d<numDays_; d++)
+    {
+        simulation->simulate();
+    }
+
+    cube_.setResult(pointIndex, replicate, getMetrics(simulation));
+
+    {
+        QMutexLocker locker(&copyMutex_);
+
+        simulation.reset();
+    }
+
+    int numCompleted = numCompleted_.fetchAndAddRelaxed(1) + 1;
+
+    // progress at roughly every 5%
+    if(numCompleted == numTasks_ || numCompleted % std::max(1, numTasks_ / 20) == 0)
+    {
+        put_flog(LOG_INFO, "completed %i / %i replicates", numCompleted, numTasks_);
+    }
+}
+
+bool ParameterSweep::checkRanges(const std::vector<ParameterSweepRange> &ranges)
+{
+    if(ranges.size() == 0)
+    {
+        put_flog(LOG_ERROR, "no parameters to sweep");
+        return false;
+    }
+
+    // validate the names against a scratch parameters object
+    Parameters parameters;
+
+    for(unsigned int i=0; i<ranges.size(); i++)
+    {
+        double value;
+
+        if(parameters.getValue(ranges[i].name, value) != true)
+        {
+            return false;
+        }
+
+        if(ranges[i].levels < 1 || ranges[i].max < ranges[i].min)
+        {
+            put_flog(LOG_ERROR, "invalid range for %s", ranges[i].name.c_str());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+std::vector<float> ParameterSweep::getMetrics(boost::shared_ptr<EpidemicSimulation> simulation)
+{
+    int endTime = simulation->getNumTimes() - 1;
+
+    double population = simulation->getValue("population", 0, NODES_ALL);
+
+    // peak of all infected
+    int peakDay = 0;
+    double peakInfected = -1.;
+
+    for(int t=0; t<=endTime; t++)
+    {
+        double infected = simulation->getValue("All infected", t, NODES_ALL);
+
+        if(infected > peakInfected)
+        {
+            peakDay = t;
+            peakInfected = infected;
+        }
+    }
+
+    // vaccinations are only counted daily
+    double vaccinated = 0.;
+
+    for(int t=0; t<=endTime; t++)
+    {
+        vaccinated += simulation->getValue("vaccinated (daily)", t, NODES_ALL);
+    }
+
+    std::vector<float> metrics;
+
+    // in getMetricNames() order
+    metrics.push_back((float)(population - simulation->getValue("susceptible", endTime, NODES_ALL)));
+    metrics.push_back((float)peakDay);
+    metrics.push_back((float)peakInfected);
+    metrics.push_back(simulation->getValue("deceased", endTime, NODES_ALL));
+    metrics.push_back(simulation->getValue("treated", endTime, NODES_ALL));
+    metrics.push_back((float)vaccinated);
+
+    // curves, for the days simulated in this sweep
+    int firstTime = endTime - numDays_;
+
+    for(unsigned int g=0; g<groupNames_.size(); g++)
+    {
+        for(int t=0; t<=numDays_; t++)
+        {
+            metrics.push_back(simulation->getValue("All infected", firstTime + t, groupNames_[g]));
+        }
+    }
+
+    return metrics;
+}
@@ -0,0 +1,165 @@
+#ifndef PARAMETER_SWEEP_H
+#define PARAMETER_SWEEP_H
+
+#define PARAMETER_SWEEP_DEFAULT_NUM_REPLICATES 10
+#define PARAMETER_SWEEP_DEFAULT_NUM_DAYS 120
+
+#include <QtCore>
+#include <boost/shared_ptr.hpp>
+#include <boost/function.hpp>
+#include <deque>
+#include <string>
+#include <vector>
+
+class EpidemicSimulation;
+class Parameters;
+
+// range of one swept parameter, named as in Parameters::getValueNames()
+struct ParameterSweepRange
+{
+    std::string name;
+
+    double min;
+    double max;
+
+    // number of values for grid designs, including both ends of the range
+    int levels;
+};
+
+// the result file of a sweep: summary metrics for every replicate of every design point
+//
+// the header holds the parameter names, the design, the metric names and the run settings; it is followed by one
+// fixed-size record per (design point, replicate), in design point order: a completion flag and one float per metric
+// records are written as they complete, so an interrupted sweep is resumed by opening the same file again
+class ParameterSweepCube
+{
+    public:
+
+        ParameterSweepCube();
+
+        // create a new file, or open an existing one with the same header to resume it
+        bool open(std::string filename, const std::vector<std::string> &parameterNames, const std::vector<std::vector<double> > &designPoints, const std::vector<std::string> &metricNames, int numReplicates, int numDays, unsigned long firstSeed);
+
+        // open an existing file, e.g. to summarize or fit it
+        bool open(std::string filename);
+
+        std::vector<std::string> getParameterNames() const;
+        std::vector<std::vector<double> > getDesignPoints() const;
+        std::vector<std::string> getMetricNames() const;
+        int getNumReplicates() const;
+        int getNumDays() const;
+        unsigned long getFirstSeed() const;
+
+        bool isComplete(int pointIndex, int replicate) const;
+        int getNumComplete() const;
+
+        // metrics of a completed replicate
+        std::vector<float> getResult(int pointIndex, int replicate) const;
+
+        // write the metrics of a replicate and mark it complete; may be called from any thread
+        bool setResult(int pointIndex, int replicate, const std::vector<float> &metrics);
+
+        // mean and standard deviation of a metric over the completed replicates of a design point
+        bool getSummary(int pointIndex, int metricIndex, double &mean, double &standardDeviation) const;
+
+    private:
+
+        QFile file_;
+
+        // serializes access to file_
+        mutable QMutex mutex_;
+
+        std::vector<std::string> parameterNames_;
+        std::vector<std::vector<double> > designPoints_;
+        std::vector<std::string> metricNames_;
+        int numReplicates_;
+        int numDays_;
+        unsigned long firstSeed_;
+
+        // offset of the first record
+        qint64 recordsOffset_;
+
+        // completed replicates, indexed by record
+        std::vector<bool> complete_;
+
+        qint64 getRecordSize() const;
+
+        bool writeHeader();
+        bool readHeader();
+        bool readCompletion();
+};
+
+// runs every replicate of every design point of a sweep over Parameters, on all cores
+//
+// each replicate is a copy of an initial simulation given its own Parameters: a copy of the base parameters with
+// the design point's values; replicate r is seeded with first seed + r at every design point (common random numbers),
+// so differences between design points are not masked by sampling noise
+//
+// the work is divided into per-thread queues of consecutive replicates; a thread whose queue is empty steals from the
+// back of another thread's queue, so uneven run times (e.g. high R0 points) do not leave cores idle
+class ParameterSweep
+{
+    public:
+
+        ParameterSweep();
+
+        // designs; either replaces the current design
+        bool setGridDesign(const std::vector<ParameterSweepRange> &ranges);
+        bool setLatinHypercubeDesign(const std::vector<ParameterSweepRange> &ranges, int numPoints, unsigned long seed);
+
+        std::vector<std::string> getParameterNames() const;
+        std::vector<std::vector<double> > getDesignPoints() const;
+
+        void setNumReplicates(int numReplicates);
+        void setNumDays(int numDays);
+        void setFirstSeed(unsigned long firstSeed);
+
+        // also record the daily curve of all infected for each group, as metrics named "infected.<group>.day<t>"
+        // (e.g. as training data for a ParameterEmulator)
+        void setRecordCurves(bool recordCurves);
+
+        // summary metrics computed for each replicate, not including curves
+        static std::vector<std::string> getMetricNames();
+
+        // run the replicates not yet in the result file
+        // initialCases is called on each replicate's simulation after its parameters are set
+        bool run(std::string filename, boost::shared_ptr<EpidemicSimulation> initialSimulation, Parameters &baseParameters, boost::function<void (boost::shared_ptr<EpidemicSimulation>)> initialCases, int numThreads);
+
+        // used by the worker threads
+        bool takeTask(int threadIndex, int &task);
+        void runTask(int task);
+
+    private:
+
+        std::vector<std::string> parameterNames_;
+        std::vector<std::vector<double> > designPoints_;
+
+        int numReplicates_;
+        int numDays_;
+        unsigned long firstSeed_;
+        bool recordCurves_;
+
+        // state of a run
+        std::vector<std::string> metricNames_;
+        std::vector<std::string> groupNames_;
+        ParameterSweepCube cube_;
+        boost::shared_ptr<EpidemicSimulation> initialSimulation_;
+        Parameters * baseParameters_;
+        boost::function<void (boost::shared_ptr<EpidemicSimulation>)> initialCases_;
+
+        // per-thread task queues (task = design point * replicates + replicate)
+        std::vector<boost::shared_ptr<QMutex> > queueMutexes_;
+        std::vector<std::deque<int> > queues_;
+
+        // copying the initial simulation and destroying copies touch shared reference counts, so they are serialized
+        QMutex copyMutex_;
+
+        QAtomicInt numCompleted_;
+        int numTasks_;
+
+        bool checkRanges(const std::vector<ParameterSweepRange> &ranges);
+
+        std::vector<float> getMetrics(boost::shared_ptr<EpidemicSimulation> simulation);
+};
+
+#endif
@@ -47,6 +47,165 @@ Parameters::Parameters()
     vaccineLatencyPeriod_ = 14;
     vaccineAdherence_ = 0.8;
     vaccineCapacity_ = 0.001;
+
+    rho_ = 0.39;
+
+    // 0-4, 5-24, 25-49, 50-64, 65+ year olds
+    double travelReductions[] = { 10., 2., 1., 1., 2. };
+    travelReductions_.assign(travelReductions, travelReductions + sizeof(travelReductions) / sizeof(travelReductions[0]));
+}
+
+void Parameters::copyValues(const Parameters &parameters)
+{
+    R0_ = parameters.R0_;
+    betaScale_ = parameters.betaScale_;
+    tau_ = parameters.tau_;
+    kappa_ = parameters.kappa_;
+    chi_ = parameters.chi_;
+    gamma_ = parameters.gamma_;
+    nu_ = parameters.nu_;
+    antiviralEffectiveness_ = parameters.antiviralEffectiveness_;
+    antiviralAdherence_ = parameters.antiviralAdherence_;
+    antiviralCapacity_ = parameters.antiviralCapacity_;
+    vaccineEffectiveness_ = parameters.vaccineEffectiveness_;
+    vaccineLatencyPeriod_ = parameters.vaccineLatencyPeriod_;
+    vaccineAdherence_ = parameters.vaccineAdherence_;
+    vaccineCapacity_ = parameters.vaccineCapacity_;
+    rho_ = parameters.rho_;
+    travelReductions_ = parameters.travelReductions_;
+
+    // priority groups, NPIs, and selections are not modified after creation, so they can be shared
+    priorityGroups_ = parameters.priorityGroups_;
+    npis_ = parameters.npis_;
+    antiviralPriorityGroupSelections_ = parameters.antiviralPriorityGroupSelections_;
+    vaccinePriorityGroupSelections_ = parameters.vaccinePriorityGroupSelections_;
+
+    emit(changed());
+}
+
+std::vector<std::string> Parameters::getValueNames()
+{
+    const char * names[] = { "R0", "betaScale", "tau", "kappa", "chi", "gamma", "antiviralEffectiveness", "antiviralAdherence", "antiviralCapacity", "vaccineEffectiveness", "vaccineLatencyPeriod", "vaccineAdherence", "vaccineCapacity", "rho" };
+
+    std::vector<std::string> valueNames(names, names + sizeof(names) / sizeof(names[0]));
+
+    for(unsigned int i=0; i<nu_.size(); i++)
+    {
+        valueNames.push_back("nu" + QString::number(i).toStdString());
+    }
+
+    for(unsigned int i=0; i<travelReductions_.size(); i++)
+    {
+        valueNames.push_back("travelReduction" + QString::number(i).toStdString());
+    }
+
+    return valueNames;
+}
+
+bool Parameters::getValue(const std::string &name, double &value)
+{
+    if(name == "R0") value = R0_;
+    else if(name == "betaScale") value = betaScale_;
+    else if(name == "tau") value = tau_;
+    else if(name == "kappa") value = kappa_;
+    else if(name == "chi") value = chi_;
+    else if(name == "gamma") value = gamma_;
+    else if(name == "antiviralEffectiveness") value = antiviralEffectiveness_;
+    else if(name == "antiviralAdherence") value = antiviralAdherence_;
+    else if(name == "antiviralCapacity") value = antiviralCapacity_;
+    else if(name == "vaccineEffectiveness") value = vaccineEffectiveness_;
+    else if(name == "vaccineLatencyPeriod") value = (double)vaccineLatencyPeriod_;
+    else if(name == "vaccineAdherence") value = vaccineAdherence_;
+    else if(name == "vaccineCapacity") value = vaccineCapacity_;
+    else if(name == "rho") value = rho_;
+    else if(name.size() > 15 && name.compare(0, 15, "travelReduction") == 0)
+    {
+        bool ok;
+        unsigned int index = QString(name.substr(15).c_str()).toUInt(&ok);
+
+        if(ok != true || index >= travelReductions_.size())
+        {
+            put_flog(LOG_ERROR, "unknown parameter %s", name.c_str());
+            return false;
+        }
+
+        value = travelReductions_[index];
+    }
+    else if(name.size() > 2 && name.compare(0, 2, "nu") == 0)
+    {
+        bool ok;
+        unsigned int index = QString(name.substr(2).c_str()).toUInt(&ok);
+
+        if(ok != true || index >= nu_.size())
+        {
+            put_flog(LOG_ERROR, "unknown parameter %s", name.c_str());
+            return false;
+        }
+
+        value = nu_[index];
+    }
+    else
+    {
+        put_flog(LOG_ERROR, "unknown parameter %s", name.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool Parameters::setValue(const std::string &name, double value)
+{
+    if(name == "R0") R0_ = value;
+    else if(name == "betaScale") betaScale_ = value;
+    else if(name == "tau") tau_ = value;
+    else if(name == "kappa") kappa_ = value;
+    else if(name == "chi") chi_ = value;
+    else if(name == "gamma") gamma_ = value;
+    else if(name == "antiviralEffectiveness") antiviralEffectiveness_ = value;
+    else if(name == "antiviralAdherence") antiviralAdherence_ = value;
+    else if(name == "antiviralCapacity") antiviralCapacity_ = value;
+    else if(name == "vaccineEffectiveness") vaccineEffectiveness_ = value;
+    else if(name == "vaccineLatencyPeriod") vaccineLatencyPeriod_ = (int)(value + 0.5);
+    else if(name == "vaccineAdherence") vaccineAdherence_ = value;
+    else if(name == "vaccineCapacity") vaccineCapacity_ = value;
+    else if(name == "rho") rho_ = value;
+    else if(name.size() > 15 && name.compare(0, 15, "travelReduction") == 0)
+    {
+        bool ok;
+        unsigned int index = QString(name.substr(15).c_str()).toUInt(&ok);
+
+        if(ok != true || index >= travelReductions_.size())
+        {
+            put_flog(LOG_ERROR, "unknown parameter %s", name.c_str());
+            return false;
+        }
+
+        travelReductions_[index] = value;
+    }
+    else if(name.size() > 2 && name.compare(0, 2, "nu") == 0)
+    {
+        bool ok;
+        unsigned int index = QString(name.substr(2).c_str()).toUInt(&ok);
+
+        if(ok != true || index >= nu_.size())
+        {
+            put_flog(LOG_ERROR, "unknown parameter %s", name.c_str());
+            return false;
+        }
+
+        nu_[index] = value;
+    }
+    else
+    {
+        put_flog(LOG_ERROR, "unknown parameter %s", name.c_str());
+        return false;
+    }
+
+    put_flog(LOG_DEBUG, "%s: %f", name.c_str(), value);
+
+    emit(changed());
+
+    return true;
 }
 
 double Parameters::getR0()
@@ -125,6 +284,21 @@ double Parameters::getVaccineCapacity()
     return vaccineCapacity_;
 }
 
+double Parameters::getRho()
+{
+    return rho_;
+}
+
+double Parameters::getTravelReduction(int index)
+{
+    if(index < 0 || index >= (int)travelReductions_.size())
+    {
+        return 1.;
+    }
+
+    return travelReductions_[index];
+}
+
 std::vector<boost::shared_ptr<PriorityGroup> > Parameters::getPriorityGroups()
 {
     return priorityGroups_;
@@ -150,6 +324,8 @@ void Parameters::setR0(double value)
     R0_ = value;
 
     put_flog(LOG_DEBUG, "%f", value);
+
+    emit(changed());
 }
 
 void Parameters::setBetaScale(double value)
@@ -157,6 +333,8 @@ void Parameters::setBetaScale(double value)
     betaScale_ = value;
 
     put_flog(LOG_DEBUG, "%f", value);
+
+    emit(changed());
 }
 
 void Parameters::setTau(double value)
@@ -164,6 +342,8 @@ void Parameters::setTau(double value)
     tau_ = value;
 
     put_flog(LOG_DEBUG, "%f", value);
+
+    emit(changed());
 }
 
 void Parameters::setKappa(double value)
@@ -171,6 +351,8 @@ void Parameters::setKappa(double value)
     kappa_ = value;
 
     put_flog(LOG_DEBUG, "%f", value);
+
+    emit(changed());
 }
 
 void Parameters::setChi(double value)
@@ -178,6 +360,8 @@ void Parameters::setChi(double value)
     chi_ = value;
 
     put_flog(LOG_DEBUG, "%f", value);
+
+    emit(changed());
 }
 
 void Parameters::setGamma(double value)
@@ -185,6 +369,17 @@ void Parameters::setGamma(double value)
     gamma_ = value;
 
     put_flog(LOG_DEBUG, "%f", value);
+
+    emit(changed());
+}
+
+void Parameters::setRho(double value)
+{
+    rho_ = value;
+
+    put_flog(LOG_DEBUG, "%f", value);
+
+    emit(changed());
 }
 
 void Parameters::setNu(double value)
@@ -204,6 +399,8 @@ void Parameters::setNu(double value)
         nu_[index] = value;
 
         put_flog(LOG_DEBUG, "%i: %f", index, value);
+
+        emit(changed());
     }
     else
     {
@@ -216,6 +413,8 @@ void Parameters::setAntiviralEffectiveness(double value)
     antiviralEffectiveness_ = value;
 
     put_flog(LOG_DEBUG, "%f", value);
+
+    emit(changed());
 }
 
 void Parameters::setAntiviralAdherence(double value)
@@ -223,6 +422,8 @@ void Parameters::setAntiviralAdherence(double value)
     antiviralAdherence_ = value;
 
     put_flog(LOG_DEBUG, "%f", value);
+
+    emit(changed());
 }
 
 void Parameters::setAntiviralCapacity(double value)
@@ -230,6 +431,8 @@ void Parameters::setAntiviralCapacity(double value)
     antiviralCapacity_ = value;
 
     put_flog(LOG_DEBUG, "%f", value);
+
+    emit(changed());
 }
 
 void Parameters::setVaccineEffectiveness(double value)
@@ -237,6 +440,8 @@ void Parameters::setVaccineEffectiveness(double value)
     vaccineEffectiveness_ = value;
 
     put_flog(LOG_DEBUG, "%f", value);
+
+    emit(changed());
 }
 
 void Parameters::setVaccineLatencyPeriod(int value)
@@ -244,6 +449,8 @@ void Parameters::setVaccineLatencyPeriod(int value)
     vaccineLatencyPeriod_ = value;
 
     put_flog(LOG_DEBUG, "%i", value);
+
+    emit(changed());
 }
 
 void Parameters::setVaccineAdherence(double value)
@@ -251,6 +458,8 @@ void Parameters::setVaccineAdherence(double value)
     vaccineAdherence_ = value;
 
     put_flog(LOG_DEBUG, "%f", value);
+
+    emit(changed());
 }
 
 void Parameters::setVaccineCapacity(double value)
@@ -258,6 +467,8 @@ void Parameters::setVaccineCapacity(double value)
     vaccineCapacity_ = value;
 
     put_flog(LOG_DEBUG, "%f", value);
+
+    emit(changed());
 }
 
 void Parameters::addPriorityGroup(boost::shared_ptr<PriorityGroup> priorityGroup)
@@ -16,6 +16,16 @@ class Parameters : public QObject
 
         Parameters();
 
+        // copy all values (including those not exposed through ParametersWidget) from another parameters object
+        void copyValues(const Parameters &parameters);
+
+        // access to the scalar values by name, e.g. for parameter sweeps
+        // names are those of the setters without the "set" prefix (R0, betaScale, ..., vaccineCapacity);
+        // the age-specific case fatality rates are named nu0, nu1, ..., and the travel reductions travelReduction0, ...
+        std::vector<std::string> getValueNames();
+        bool getValue(const std::string &name, double &value);
+        bool setValue(const std::string &name, double value);
+
         double getR0();
         double getBetaScale();
         double getTau();
@@ -32,6 +42,11 @@ class Parameters : public QObject
         double getVaccineCapacity();
 
         // for parameters not exposed through ParametersWidget
+        double getRho();
+
+        // 1 for age groups without a travel reduction
+        double getTravelReduction(int index);
+
         std::vector<boost::shared_ptr<PriorityGroup> > getPriorityGroups();
 
         std::vector<boost::shared_ptr<Npi> > getNpis();
@@ -41,6 +56,9 @@ class Parameters : public QObject
 
     signals:
 
+        // emitted when any of the scalar values changes
+        void changed();
+
         // for parameters not exposed through ParametersWidget
         void priorityGroupAdded(boost::shared_ptr<PriorityGroup> priorityGroup);
 
@@ -64,6 +82,8 @@ class Parameters : public QObject
         void setVaccineCapacity(double value);
 
         // for parameters not exposed through ParametersWidget
+        void setRho(double value);
+
         void addPriorityGroup(boost::shared_ptr<PriorityGroup> priorityGroup);
 
         void clearNpis();
@@ -125,6 +145,12 @@ class Parameters : public QObject
         // the parameters below are not exposed through ParametersWidget!
         //////////////////////////////////////////////////////////////////
 
+        // contacts of travelers, relative to those of residents
+        double rho_;
+
+        // age-specific divisor of travel flows: the young and the old travel less
+        std::vector<double> travelReductions_;
+
         // priority groups
         std::vector<boost::shared_ptr<PriorityGroup> > priorityGroups_;
 
@@ -1,11 +1,12 @@
 #include "PriorityGroupSelections.h"
 #include "PriorityGroup.h"
 #include "log.h"
-#include <set>
 
 PriorityGroupSelections::PriorityGroupSelections(std::vector<boost::shared_ptr<PriorityGroup> > priorityGroups)
 {
     priorityGroups_ = priorityGroups;
+
+    compile();
 }
 
 std::vector<boost::shared_ptr<PriorityGroup> > PriorityGroupSelections::getPriorityGroups()
@@ -15,79 +16,112 @@ std::vector<boost::shared_ptr<PriorityGroup> > PriorityGroupSelections::getPrior
 
 std::vector<std::vector<int> > PriorityGroupSelections::getStratificationValuesSet2(int thirdIndexValue)
 {
-    // use a set container to only keep unique stratification values entries
-    std::set<std::vector<int> > set;
+    std::vector<std::vector<int> > vector;
 
-    for(unsigned int i=0; i<priorityGroups_.size(); i++)
+    for(unsigned int i=0; i<ageRiskStratumIndices_.size(); i++)
     {
-        std::vector<std::vector<int> > svv = priorityGroups_[i]->getStratificationVectorValues();
+        std::vector<int> stratificationValues = ageRiskStratumIndices_[i].getStratificationValues();
 
-        for(unsigned int j0=0; j0<svv[0].size(); j0++)
-        {
-            for(unsigned int j1=0; j1<svv[1].size(); j1++)
-            {
-                std::vector<int> stratificationValues;
+        // forcing 3rd index
+        stratificationValues[2] = thirdIndexValue;
 
-                // warn if we find STRATIFICATIONS_ALL values
-                // we want a non-overlapping set of stratification values -- using STRATIFICATIONS_ALL doesn't allow us to preserve that
-                if(svv[0][j0] == STRATIFICATIONS_ALL || svv[1][j1] == STRATIFICATIONS_ALL)
-                {
-                    put_flog(LOG_WARN, "found unexpected STRATIFICATIONS_ALL value!");
-                }
+        vector.push_back(stratificationValues);
+    }
 
-                stratificationValues.push_back(svv[0][j0]);
-                stratificationValues.push_back(svv[1][j1]);
+    return vector;
+}
 
-                // forcing 3rd index
-                stratificationValues.push_back(thirdIndexValue);
+std::vector<std::vector<int> > PriorityGroupSelections::getStratificationValuesSet()
+{
+    std::vector<std::vector<int> > vector;
 
-                set.insert(stratificationValues);
-            }
-        }
+    for(unsigned int i=0; i<stratumIndices_.size(); i++)
+    {
+        vector.push_back(stratumIndices_[i].getStratificationValues());
     }
 
-    // convert the set to a vector for simplicity
-    std::vector<std::vector<int> > vector(set.begin(), set.end());
-
     return vector;
 }
 
-std::vector<std::vector<int> > PriorityGroupSelections::getStratificationValuesSet()
+const std::vector<StratumIndex> & PriorityGroupSelections::getStratumIndices() const
+{
+    return stratumIndices_;
+}
+
+const std::vector<StratumIndex> & PriorityGroupSelections::getAgeRiskStratumIndices() const
+{
+    return ageRiskStratumIndices_;
+}
+
+void PriorityGroupSelections::compile()
 {
-    // use a set container to only keep unique stratification values entries
-    std::set<std::vector<int> > set;
+    // masks over the layout keep only unique stratification values; ageRiskMask only uses vaccinated == 0
+    StratifiedArray<bool> mask(false);
+    StratifiedArray<bool> ageRiskMask(false);
 
     for(unsigned int i=0; i<priorityGroups_.size(); i++)
     {
         std::vector<std::vector<int> > svv = priorityGroups_[i]->getStratificationVectorValues();
 
+        if(svv.size() != NUM_STRATIFICATION_DIMENSIONS)
+        {
+            put_flog(LOG_ERROR, "priority group %s has %i stratification dimensions", priorityGroups_[i]->getName().c_str(), (int)svv.size());
+            continue;
+        }
+
         for(unsigned int j0=0; j0<svv[0].size(); j0++)
         {
             for(unsigned int j1=0; j1<svv[1].size(); j1++)
             {
+                int a = svv[0][j0];
+                int r = svv[1][j1];
+
+                // warn if we find STRATIFICATIONS_ALL values
+                // we want a non-overlapping set of stratification values -- using STRATIFICATIONS_ALL doesn't allow us to preserve that
+                if(a < 0 || a >= DefaultStratificationLayout::numAgeGroups || r < 0 || r >= DefaultStratificationLayout::numRiskGroups)
+                {
+                    put_flog(LOG_WARN, "found unexpected stratification values %i %i", a, r);
+                    continue;
+                }
+
+                ageRiskMask(a, r, 0) = true;
+
                 for(unsigned int j2=0; j2<svv[2].size(); j2++)
                 {
-                    std::vector<int> stratificationValues;
+                    int v = svv[2][j2];
 
-                    // warn if we find STRATIFICATIONS_ALL values
-                    // we want a non-overlapping set of stratification values -- using STRATIFICATIONS_ALL doesn't allow us to preserve that
-                    if(svv[0][j0] == STRATIFICATIONS_ALL || svv[1][j1] == STRATIFICATIONS_ALL || svv[2][j2] == STRATIFICATIONS_ALL)
+                    if(v < 0 || v >= DefaultStratificationLayout::numVaccinatedGroups)
                     {
-                        put_flog(LOG_WARN, "found unexpected STRATIFICATIONS_ALL value!");
+                        put_flog(LOG_WARN, "found unexpected stratification value %i", v);
+                        continue;
                     }
 
-                    stratificationValues.push_back(svv[0][j0]);
-                    stratificationValues.push_back(svv[1][j1]);
-                    stratificationValues.push_back(svv[2][j2]);
-
-                    set.insert(stratificationValues);
+                    mask(a, r, v) = true;
                 }
             }
         }
     }
 
-    // convert the set to a vector for simplicity
-    std::vector<std::vector<int> > vector(set.begin(), set.end());
+    // index lists in layout order
+    stratumIndices_.clear();
+    ageRiskStratumIndices_.clear();
 
-    return vector;
+    for(int a=0; a<DefaultStratificationLayout::numAgeGroups; a++)
+    {
+        for(int r=0; r<DefaultStratificationLayout::numRiskGroups; r++)
+        {
+            if(ageRiskMask(a, r, 0) == true)
+            {
+                ageRiskStratumIndices_.push_back(StratumIndex(a, r, 0));
+            }
+
+            for(int v=0; v<DefaultStratificationLayout::numVaccinatedGroups; v++)
+            {
+                if(mask(a, r, v) == true)
+                {
+                    stratumIndices_.push_back(StratumIndex(a, r, v));
+                }
+            }
+        }
+    }
 }
@@ -2,11 +2,15 @@
 #define PRIORITY_GROUP_SELECTIONS_H
 
 #include "EpidemicDataSet.h"
+#include "StratifiedArray.h"
 #include <boost/shared_ptr.hpp>
 #include <vector>
 
 class PriorityGroup;
 
+// selections are immutable: Parameters replaces them as a whole when they change, so the stratifications they cover
+// are compiled once on construction into index lists over the stratification layout, and treatments iterate those
+// lists without building sets for every node and day
 class PriorityGroupSelections
 {
     public:
@@ -24,9 +28,20 @@ class PriorityGroupSelections
         // this returns a unique non-overlapping set of stratification values.
         std::vector<std::vector<int> > getStratificationValuesSet();
 
+        // compiled stratifications, unique and in [age group][risk group][vaccinated] order
+        const std::vector<StratumIndex> &getStratumIndices() const;
+
+        // compiled (age group, risk group) pairs, only considering the first 2 indices; vaccinated is 0
+        const std::vector<StratumIndex> &getAgeRiskStratumIndices() const;
+
     private:
 
         std::vector<boost::shared_ptr<PriorityGroup> > priorityGroups_;
+
+        std::vector<StratumIndex> stratumIndices_;
+        std::vector<StratumIndex> ageRiskStratumIndices_;
+
+        void compile();
 };
 
 #endif
@@ -0,0 +1,659 @@
+#include "RegionData.h"
+#include "DataPack.h"
+#include "main.h"
+#include "log.h"
+#include <fstream>
+#include <boost/tokenizer.hpp>
+#include <boost/weak_ptr.hpp>
+#include <QtCore>
+
+boost::shared_ptr<const RegionData> RegionData::getDefault()
+{
+    // data sets may be created from multiple threads
+    static QMutex mutex;
+    static boost::weak_ptr<const RegionData> defaultRegionData;
+
+    QMutexLocker locker(&mutex);
+
+    boost::shared_ptr<const RegionData> regionData = defaultRegionData.lock();
+
+    if(regionData == NULL)
+    {
+        regionData = load();
+
+        defaultRegionData = regionData;
+    }
+
+    return regionData;
+}
+
+boost::shared_ptr<RegionData> RegionData::load()
+{
+    boost::shared_ptr<RegionData> regionData(new RegionData());
+
+    // load from the data pack if it is current, otherwise from the source files
+    boost::shared_ptr<DataPack> dataPack = DataPack::open();
+
+    // the data pack is only written by explicit calls to DataPack::update() / DataPack::build(), so loading never
+    // writes to the data directory
+    if(dataPack == NULL || regionData->loadDataPack(dataPack) != true)
+    {
+        if(regionData->loadSourceFiles() != true)
+        {
+            return boost::shared_ptr<RegionData>();
+        }
+    }
+
+    regionData->buildNodeIndexTable();
+
+    return regionData;
+}
+
+boost::shared_ptr<RegionData> RegionData::loadFromSourceFiles()
+{
+    boost::shared_ptr<RegionData> regionData(new RegionData());
+
+    if(regionData->loadSourceFiles() != true)
+    {
+        return boost::shared_ptr<RegionData>();
+    }
+
+    regionData->buildNodeIndexTable();
+
+    return regionData;
+}
+
+RegionData::RegionData()
+{
+    numNodes_ = 0;
+    minNodeId_ = 0;
+}
+
+int RegionData::getNumNodes() const
+{
+    return numNodes_;
+}
+
+const std::vector<int> &RegionData::getNodeIds() const
+{
+    return nodeIds_;
+}
+
+int RegionData::getNodeIndex(int nodeId) const
+{
+    if(nodeIndexTable_.empty() != true)
+    {
+        // unsigned comparison also rejects ids below minNodeId_
+        unsigned int offset = (unsigned int)(nodeId - minNodeId_);
+
+        if(offset >= nodeIndexTable_.size())
+        {
+            return -1;
+        }
+
+        return nodeIndexTable_[offset];
+    }
+
+    std::map<int, int>::const_iterator iter = nodeIdToIndex_.find(nodeId);
+
+    if(iter == nodeIdToIndex_.end())
+    {
+        return -1;
+    }
+
+    return iter->second;
+}
+
+std::string RegionData::getNodeName(int nodeId) const
+{
+    std::map<int, std::string>::const_iterator iter = nodeIdToName_.find(nodeId);
+
+    if(iter == nodeIdToName_.end())
+    {
+        return std::string("");
+    }
+
+    return iter->second;
+}
+
+std::string RegionData::getNodeGroupName(int nodeId) const
+{
+    std::map<int, std::string>::const_iterator iter = nodeIdToGroupName_.find(nodeId);
+
+    if(iter == nodeIdToGroupName_.end())
+    {
+        return std::string("");
+    }
+
+    return iter->second;
+}
+
+bool RegionData::hasGroup(const std::string &groupName) const
+{
+    return groupNameToNodeIds_.count(groupName) != 0;
+}
+
+std::vector<std::string> RegionData::getGroupNames() const
+{
+    std::vector<std::string> groupNames;
+
+    for(std::map<std::string, std::vector<int> >::const_iterator it=groupNameToNodeIds_.begin(); it!=groupNameToNodeIds_.end(); it++)
+    {
+        groupNames.push_back(it->first);
+    }
+
+    return groupNames;
+}
+
+const std::vector<int> &RegionData::getNodeIds(const std::string &groupName) const
+{
+    static const std::vector<int> empty;
+
+    std::map<std::string, std::vector<int> >::const_iterator iter = groupNameToNodeIds_.find(groupName);
+
+    if(iter == groupNameToNodeIds_.end())
+    {
+        return empty;
+    }
+
+    return iter->second;
+}
+
+float RegionData::getTravel(int nodeIndex0, int nodeIndex1) const
+{
+    return travel_(nodeIndex0, nodeIndex1);
+}
+
+const float * RegionData::getTravelRow(int nodeIndex0) const
+{
+    return &travel_(nodeIndex0, 0);
+}
+
+blitz::Array<float, 2+NUM_STRATIFICATION_DIMENSIONS> RegionData::getPopulation() const
+{
+    return population_;
+}
+
+bool RegionData::loadDataPack(boost::shared_ptr<DataPack> dataPack)
+{
+    // stratifications
+    std::vector<std::string> stratificationNames = dataPack->getStrings("stratificationNames");
+
+    if(stratificationNames.size() != NUM_STRATIFICATION_DIMENSIONS)
+    {
+        put_flog(LOG_ERROR, "got %i stratification dimensions, expected %i", stratificationNames.size(), NUM_STRATIFICATION_DIMENSIONS);
+        return false;
+    }
+
+    std::vector<std::vector<std::string> > stratifications;
+
+    for(unsigned int i=0; i<NUM_STRATIFICATION_DIMENSIONS; i++)
+    {
+        stratifications.push_back(dataPack->getStrings(std::string("stratifications") + QString::number(i).toStdString()));
+    }
+
+    // nodes
+    std::vector<int> nodeIds = dataPack->getInts("nodeIds");
+    std::vector<std::string> nodeNames = dataPack->getStrings("nodeNames");
+    std::vector<std::string> nodeGroupNames = dataPack->getStrings("nodeGroupNames");
+
+    if(nodeNames.size() != nodeIds.size() || nodeGroupNames.size() != nodeIds.size())
+    {
+        put_flog(LOG_ERROR, "inconsistent node sections");
+        return false;
+    }
+
+    int numNodes = nodeIds.size();
+
+    if(numNodes > REGION_MAX_NODES)
+    {
+        put_flog(LOG_ERROR, "%i nodes, at most %i are supported", numNodes, REGION_MAX_NODES);
+        return false;
+    }
+
+    // population and travel
+    blitz::TinyVector<int, 2+NUM_STRATIFICATION_DIMENSIONS> shape;
+    shape(0) = 1; // one time step
+    shape(1) = numNodes;
+
+    // counts are compared in 64 bits: the travel matrix of a large region has more than 2^31 values
+    quint64 numPopulationValues = numNodes;
+
+    for(int j=0; j<NUM_STRATIFICATION_DIMENSIONS; j++)
+    {
+        shape(2 + j) = stratifications[j].size();
+        numPopulationValues *= stratifications[j].size();
+    }
+
+    quint64 populationCount, travelCount;
+    const float * populationData = dataPack->getFloats("population", populationCount);
+    const float * travelData = dataPack->getFloats("travel", travelCount);
+
+    if(populationData == NULL || populationCount != numPopulationValues || travelData == NULL || travelCount != (quint64)numNodes * (quint64)numNodes)
+    {
+        put_flog(LOG_ERROR, "inconsistent population or travel sections");
+        return false;
+    }
+
+    // everything is consistent; commit
+    EpidemicDataSet::stratificationNames_ = stratificationNames;
+    EpidemicDataSet::stratifications_ = stratifications;
+
+    numNodes_ = numNodes;
+    nodeIds_ = nodeIds;
+    nodeIdToIndex_.clear();
+    nodeIdToName_.clear();
+    nodeIdToGroupName_.clear();
+    groupNameToNodeIds_.clear();
+
+    for(int i=0; i<numNodes_; i++)
+    {
+        nodeIdToIndex_[nodeIds_[i]] = i;
+        nodeIdToName_[nodeIds_[i]] = nodeNames[i];
+        nodeIdToGroupName_[nodeIds_[i]] = nodeGroupNames[i];
+        groupNameToNodeIds_[nodeGroupNames[i]].push_back(nodeIds_[i]);
+    }
+
+    // population is copied, since data sets copy it again and the mapping may not be writable
+    blitz::Array<float, 2+NUM_STRATIFICATION_DIMENSIONS> population((float *)populationData, shape, blitz::duplicateData);
+    population_.reference(population);
+
+    // travel is read-only, so reference the mapped data directly
+    blitz::Array<float, 2> travel((float *)travelData, blitz::shape(numNodes_, numNodes_), blitz::neverDeleteData);
+    travel_.reference(travel);
+
+    dataPack_ = dataPack;
+
+    put_flog(LOG_DEBUG, "loaded data pack");
+
+    return true;
+}
+
+bool RegionData::loadSourceFiles()
+{
+    // load stratifications data
+    if(EpidemicDataSet::loadStratificationsFile() != true)
+    {
+        put_flog(LOG_ERROR, "could not load stratifications file");
+        return false;
+    }
+
+    // load node name and group data
+    std::string nodeNameGroupFilename = g_dataDirectory + "/fips_county_names_HSRs.csv";
+
+    if(loadNodeNameGroupFile(nodeNameGroupFilename.c_str()) != true)
+    {
+        put_flog(LOG_ERROR, "could not load file %s", nodeNameGroupFilename.c_str());
+        return false;
+    }
+
+    // population data
+    std::string nodePopulationFilename = g_dataDirectory + "/fips_age_group_populations.csv";
+
+    if(loadNodePopulationFile(nodePopulationFilename.c_str()) != true)
+    {
+        put_flog(LOG_ERROR, "could not load file %s", nodePopulationFilename.c_str());
+        return false;
+    }
+
+    std::string nodePopulationSecondStratificationFilename = g_dataDirectory + "/age_groups_low_risk_fraction.csv";
+
+    if(loadNodePopulationSecondStratificationFile(nodePopulationSecondStratificationFilename.c_str()) != true)
+    {
+        put_flog(LOG_ERROR, "could not load file %s", nodePopulationSecondStratificationFilename.c_str());
+        return false;
+    }
+
+    // travel data
+    std::string nodeTravelFilename = g_dataDirectory + "/county_travel_fractions.csv";
+
+    if(loadNodeTravelFile(nodeTravelFilename.c_str()) != true)
+    {
+        put_flog(LOG_ERROR, "could not load file %s", nodeTravelFilename.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool RegionData::loadNodeNameGroupFile(const char * filename)
+{
+    std::ifstream in(filename);
+
+    if(in.is_open() != true)
+    {
+        put_flog(LOG_ERROR, "could not load file %s", filename);
+        return false;
+    }
+
+    // clear existing entries
+    numNodes_ = 0;
+    nodeIds_.clear();
+    nodeIdToIndex_.clear();
+    nodeIdToName_.clear();
+    nodeIdToGroupName_.clear();
+    groupNameToNodeIds_.clear();
+
+    // use boost tokenizer to parse the file
+    typedef boost::tokenizer< boost::escaped_list_separator<char> > Tokenizer;
+
+    std::vector<std::string> vec;
+    std::string line;
+
+    // read (and ignore) header
+    getline(in, line);
+
+    int index = 0;
+
+    while(getline(in, line))
+    {
+        Tokenizer tok(line);
+
+        vec.assign(tok.begin(), tok.end());
+
+        if(vec.size() != 3)
+        {
+            put_flog(LOG_ERROR, "number of values != 3, == %i", vec.size());
+            return false;
+        }
+
+        int nodeId = atoi(vec[0].c_str());
+
+        // nodeId vector
+        nodeIds_.push_back(nodeId);
+
+        // nodeId -> index mapping
+        nodeIdToIndex_[nodeId] = index;
+
+        // nodeId -> name mapping
+        nodeIdToName_[nodeId] = vec[1];
+
+        // nodeId -> group name mapping
+        nodeIdToGroupName_[nodeId] = vec[2];
+
+        // group name -> nodeIds indexing
+        groupNameToNodeIds_[vec[2]].push_back(nodeId);
+
+        index++;
+    }
+
+    numNodes_ = index;
+
+    if(numNodes_ > REGION_MAX_NODES)
+    {
+        put_flog(LOG_ERROR, "%i nodes, at most %i are supported", numNodes_, REGION_MAX_NODES);
+        return false;
+    }
+
+    return true;
+}
+
+bool RegionData::loadNodePopulationFile(const char * filename)
+{
+    // make sure we have appropriate number of stratifications
+    if(EpidemicDataSet::stratifications_.size() < 1)
+    {
+        put_flog(LOG_ERROR, "need at least 1 stratification, got %i", EpidemicDataSet::stratifications_.size());
+        return false;
+    }
+
+    std::ifstream in(filename);
+
+    if(in.is_open() != true)
+    {
+        put_flog(LOG_ERROR, "could not load file %s", filename);
+        return false;
+    }
+
+    // full shape of population variable: [time][node][stratifications...]
+    blitz::TinyVector<int, 2+NUM_STRATIFICATION_DIMENSIONS> shape;
+    shape(0) = 1; // one time step
+    shape(1) = numNodes_;
+
+    for(int j=0; j<NUM_STRATIFICATION_DIMENSIONS; j++)
+    {
+        shape(2 + j) = EpidemicDataSet::stratifications_[j].size();
+    }
+
+    blitz::Array<float, 2+NUM_STRATIFICATION_DIMENSIONS> population(shape);
+
+    population = 0.;
+
+    // the data file contains population data stratified only by the first stratification
+    // stratification values of 0 are assumed for all other stratifications
+
+    // use boost tokenizer to parse the file
+    typedef boost::tokenizer< boost::escaped_list_separator<char> > Tokenizer;
+
+    std::vector<std::string> vec;
+    std::string line;
+
+    // read (and ignore) header
+    getline(in, line);
+
+    while(getline(in, line))
+    {
+        Tokenizer tok(line);
+
+        vec.assign(tok.begin(), tok.end());
+
+        if(vec.size() != 1+EpidemicDataSet::stratifications_[0].size())
+        {
+            put_flog(LOG_ERROR, "number of values != %i, == %i", 1+EpidemicDataSet::stratifications_[0].size(), vec.size());
+            return false;
+        }
+
+        int time = 0;
+        int nodeId = atoi(vec[0].c_str());
+
+        if(nodeIdToIndex_.count(nodeId) == 0)
+        {
+            put_flog(LOG_ERROR, "could not map nodeId %i to an index", nodeId);
+            return false;
+        }
+
+        int nodeIndex = nodeIdToIndex_[nodeId];
+
+        for(int i=0; i<(int)EpidemicDataSet::stratifications_[0].size(); i++)
+        {
+            // array position; all indices initialized to 0
+            blitz::TinyVector<int, 2+NUM_STRATIFICATION_DIMENSIONS> index(0);
+
+            index(0) = time;
+            index(1) = nodeIndex;
+            index(2) = i;
+
+            // all other stratification indices are zero
+
+            population(index) = atof(vec[1+i].c_str());
+        }
+    }
+
+    population_.reference(population);
+
+    return true;
+}
+
+bool RegionData::loadNodePopulationSecondStratificationFile(const char * filename)
+{
+    // load data file indicating fractional split for the second stratification
+    // stratification values of 0 are assumed for all subsequent stratifications
+
+    // make sure we have appropriate number of stratifications
+    if(EpidemicDataSet::stratifications_.size() < 2)
+    {
+        put_flog(LOG_ERROR, "need at least 2 stratifications, got %i", EpidemicDataSet::stratifications_.size());
+        return false;
+    }
+
+    // the second stratification should be of size 2
+    if(EpidemicDataSet::stratifications_[1].size() != 2)
+    {
+        put_flog(LOG_ERROR, "expected 2 stratifications, got %i", EpidemicDataSet::stratifications_[1].size());
+        return false;
+    }
+
+    std::ifstream in(filename);
+
+    if(in.is_open() != true)
+    {
+        put_flog(LOG_ERROR, "could not load file %s", filename);
+        return false;
+    }
+
+    // use boost tokenizer to parse the file
+    typedef boost::tokenizer< boost::escaped_list_separator<char> > Tokenizer;
+
+    std::vector<std::string> vec;
+    std::string line;
+
+    // read (and ignore) header
+    getline(in, line);
+
+    // read data (one line)
+    getline(in, line);
+
+    Tokenizer tok(line);
+
+    vec.assign(tok.begin(), tok.end());
+
+    if(vec.size() != EpidemicDataSet::stratifications_[0].size())
+    {
+        put_flog(LOG_ERROR, "number of values != %i, == %i", EpidemicDataSet::stratifications_[0].size(), vec.size());
+        return false;
+    }
+
+    int time = 0;
+
+    for(int i=0; i<(int)nodeIds_.size(); i++)
+    {
+        int nodeId = nodeIds_[i];
+
+        if(nodeIdToIndex_.count(nodeId) == 0)
+        {
+            put_flog(LOG_ERROR, "could not map nodeId %i to an index", nodeId);
+            return false;
+        }
+
+        int nodeIndex = nodeIdToIndex_[nodeId];
+
+        for(int j=0; j<(int)EpidemicDataSet::stratifications_[0].size(); j++)
+        {
+            // get total value over the first stratification
+            float total = blitz::sum(population_(time, nodeIndex, j, blitz::Range::all(), blitz::Range::all()));
+
+            float fraction0 = atof(vec[j].c_str());
+
+            float value0 = total * fraction0;
+            float value1 = total * (1. - fraction0);
+
+            // array position; all indices initialized to 0
+            blitz::TinyVector<int, 2+NUM_STRATIFICATION_DIMENSIONS> index(0);
+
+            index(0) = time;
+            index(1) = nodeIndex;
+            index(2) = j;
+
+            index(3) = 0;
+            population_(index) = value0;
+
+            index(3) = 1;
+            population_(index) = value1;
+        }
+    }
+
+    return true;
+}
+
+bool RegionData::loadNodeTravelFile(const char * filename)
+{
+    std::ifstream in(filename);
+
+    if(in.is_open() != true)
+    {
+        put_flog(LOG_ERROR, "could not load file %s", filename);
+        return false;
+    }
+
+    // full shape of travel variable: [node][node]
+    blitz::TinyVector<float, 2> shape;
+    shape(0) = numNodes_;
+    shape(1) = numNodes_;
+
+    blitz::Array<float, 2> travel(shape);
+
+    travel = 0.;
+
+    // use boost tokenizer to parse the file
+    typedef boost::tokenizer< boost::escaped_list_separator<char> > Tokenizer;
+
+    std::vector<std::string> vec;
+    std::string line;
+
+    // read (and ignore) header
+    getline(in, line);
+
+    int index = 0;
+
+    while(getline(in, line))
+    {
+        Tokenizer tok(line);
+
+        vec.assign(tok.begin(), tok.end());
+
+        if((int)vec.size() != numNodes_)
+        {
+            put_flog(LOG_ERROR, "number of values != %i, == %i", numNodes_, vec.size());
+            return false;
+        }
+
+        for(int i=0; i<(int)vec.size(); i++)
+        {
+            travel(index, i) = atof(vec[i].c_str());
+        }
+
+        index++;
+    }
+
+    // we should have read numNodes_ lines
+    if(index != numNodes_)
+    {
+        put_flog(LOG_ERROR, "expected %i lines, read %i", numNodes_, index);
+        return false;
+    }
+
+    travel_.reference(travel);
+
+    return true;
+}
+
+void RegionData::buildNodeIndexTable()
+{
+    nodeIndexTable_.clear();
+
+    if(nodeIdToIndex_.empty() == true)
+    {
+        return;
+    }
+
+    // node ids are sorted in the map
+    int minNodeId = nodeIdToIndex_.begin()->first;
+    int maxNodeId = nodeIdToIndex_.rbegin()->first;
+
+    // ids such as FIPS codes are clustered; don't build a table for ids spread far beyond the number of nodes
+    long long tableSize = (long long)maxNodeId - (long long)minNodeId + 1;
+
+    if(tableSize > 64 * (long long)nodeIdToIndex_.size() + 1024)
+    {
+        put_flog(LOG_INFO, "node ids too sparse for an index table (%lli ids for %i nodes)", tableSize, (int)nodeIdToIndex_.size());
+        return;
+    }
+
+    minNodeId_ = minNodeId;
+    nodeIndexTable_.assign((size_t)tableSize, -1);
+
+    for(std::map<int, int>::const_iterator iter=nodeIdToIndex_.begin(); iter!=nodeIdToIndex_.end(); iter++)
+    {
+        nodeIndexTable_[iter->first - minNodeId_] = iter->second;
+    }
+}
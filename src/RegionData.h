@@ -0,0 +1,105 @@
+#ifndef REGION_DATA_H
+#define REGION_DATA_H
+
+// the travel matrix is dense, and blitz indexes arrays with int, so it can hold at most 2^31 - 1 values
+// (the matrix is then 8.6 GB in memory)
+#define REGION_MAX_NODES 46340
+
+#include "EpidemicDataSet.h"
+#include <map>
+#include <string>
+#include <vector>
+#include <blitz/array.h>
+#include <boost/shared_ptr.hpp>
+
+class DataPack;
+
+// static geography, population and travel inputs for a region
+// these never change between simulations, so one immutable instance is shared by all data sets
+class RegionData
+{
+    public:
+
+        // shared region data for the data directory; loaded on first use and released when no data set references it
+        // returns NULL if the data could not be loaded
+        static boost::shared_ptr<const RegionData> getDefault();
+
+        // load a new (unshared) instance from the data pack or the source files
+        static boost::shared_ptr<RegionData> load();
+
+        // load a new (unshared) instance from the source files only, e.g. to (re)generate the data pack
+        static boost::shared_ptr<RegionData> loadFromSourceFiles();
+
+        int getNumNodes() const;
+
+        const std::vector<int> &getNodeIds() const;
+
+        // returns -1 if the node does not exist
+        // a lookup in a dense table: safe for concurrent callers and does not allocate
+        int getNodeIndex(int nodeId) const;
+
+        // returns an empty string if the node does not exist
+        std::string getNodeName(int nodeId) const;
+        std::string getNodeGroupName(int nodeId) const;
+
+        bool hasGroup(const std::string &groupName) const;
+        std::vector<std::string> getGroupNames() const;
+
+        // returns an empty vector if the group does not exist
+        const std::vector<int> &getNodeIds(const std::string &groupName) const;
+
+        float getTravel(int nodeIndex0, int nodeIndex1) const;
+
+        // contiguous travel fractions from a node to all nodes, in node index order
+        const float * getTravelRow(int nodeIndex0) const;
+
+        // initial population: [time (extent 1)][node index][stratifications...]
+        // this references shared data; data sets must copy it before modifying
+        blitz::Array<float, 2+NUM_STRATIFICATION_DIMENSIONS> getPopulation() const;
+
+    private:
+
+        RegionData();
+
+        int numNodes_;
+
+        // node id's
+        std::vector<int> nodeIds_;
+
+        // maps node id to array index
+        std::map<int, int> nodeIdToIndex_;
+
+        // dense node id to array index table: [nodeId - minNodeId_], -1 for ids that are not nodes
+        // empty if the node ids are too sparse, in which case nodeIdToIndex_ is searched
+        int minNodeId_;
+        std::vector<int> nodeIndexTable_;
+
+        // maps node id to name
+        std::map<int, std::string> nodeIdToName_;
+
+        // maps node id to group name
+        std::map<int, std::string> nodeIdToGroupName_;
+
+        // maps group name to node id's
+        std::map<std::string, std::vector<int> > groupNameToNodeIds_;
+
+        // node -> node travel fractions
+        blitz::Array<float, 2> travel_;
+
+        // initial population
+        blitz::Array<float, 2+NUM_STRATIFICATION_DIMENSIONS> population_;
+
+        // data pack the data was loaded from, if any; travel_ references its mapped memory
+        boost::shared_ptr<DataPack> dataPack_;
+
+        bool loadDataPack(boost::shared_ptr<DataPack> dataPack);
+        bool loadSourceFiles();
+        bool loadNodeNameGroupFile(const char * filename);
+        bool loadNodePopulationFile(const char * filename);
+        bool loadNodePopulationSecondStratificationFile(const char * filename);
+        bool loadNodeTravelFile(const char * filename);
+
+        void buildNodeIndexTable();
+};
+
+#endif
@@ -0,0 +1,250 @@
+#include "SimulationProfile.h"
+#include "log.h"
+#include <QtCore>
+
+SimulationProfile::SimulationProfile()
+{
+    // defaults
+    enabled_ = false;
+    dayDepth_ = 0;
+
+    timer_.start();
+}
+
+SimulationProfile::SimulationProfile(const SimulationProfile &profile)
+{
+    enabled_ = false;
+    dayDepth_ = 0;
+
+    eventTypeNames_ = profile.eventTypeNames_;
+
+    timer_.start();
+}
+
+std::string SimulationProfile::getPhaseName(SIMULATION_PHASE phase)
+{
+    switch(phase)
+    {
+        case SIMULATION_PHASE_COPY_VARIABLES: return "copy variables";
+        case SIMULATION_PHASE_STOCKPILES: return "stockpiles";
+        case SIMULATION_PHASE_ANTIVIRALS: return "antivirals";
+        case SIMULATION_PHASE_VACCINES: return "vaccines";
+        case SIMULATION_PHASE_PRECOMPUTE: return "precompute";
+        case SIMULATION_PHASE_EVENTS: return "events";
+        case SIMULATION_PHASE_TRAVEL: return "travel";
+        case SIMULATION_PHASE_ILI: return "ILI";
+        default: return "unknown";
+    }
+}
+
+void SimulationProfile::setEnabled(bool enabled)
+{
+    enabled_ = enabled;
+
+    // a day in progress is not recorded
+    dayDepth_ = 0;
+}
+
+bool SimulationProfile::isEnabled() const
+{
+    return enabled_;
+}
+
+void SimulationProfile::setEventTypeNames(const std::vector<std::string> &eventTypeNames)
+{
+    eventTypeNames_ = eventTypeNames;
+}
+
+std::vector<std::string> SimulationProfile::getEventTypeNames() const
+{
+    return eventTypeNames_;
+}
+
+void SimulationProfile::beginDay(int time)
+{
+    if(enabled_ != true)
+    {
+        return;
+    }
+
+    if(dayDepth_++ > 0)
+    {
+        return;
+    }
+
+    currentDay_.time = time;
+    currentDay_.phaseStarts.assign(-1);
+    currentDay_.phaseDurations.assign(0);
+    currentDay_.eventCounts.assign(eventTypeNames_.size(), 0);
+    currentDay_.queueSize = 0;
+    currentDay_.exposures = 0;
+
+    currentDay_.start = getMicroseconds();
+}
+
+void SimulationProfile::endDay()
+{
+    if(enabled_ != true || dayDepth_ == 0)
+    {
+        return;
+    }
+
+    if(--dayDepth_ > 0)
+    {
+        return;
+    }
+
+    currentDay_.duration = getMicroseconds() - currentDay_.start;
+
+    days_.push_back(currentDay_);
+}
+
+void SimulationProfile::beginPhase(SIMULATION_PHASE phase)
+{
+    if(enabled_ != true || dayDepth_ == 0)
+    {
+        return;
+    }
+
+    currentDay_.phaseStarts[phase] = getMicroseconds();
+}
+
+void SimulationProfile::endPhase(SIMULATION_PHASE phase)
+{
+    if(enabled_ != true || dayDepth_ == 0 || currentDay_.phaseStarts[phase] < 0)
+    {
+        return;
+    }
+
+    currentDay_.phaseDurations[phase] = getMicroseconds() - currentDay_.phaseStarts[phase];
+}
+
+const std::vector<SimulationProfileDay> &SimulationProfile::getDays() const
+{
+    return days_;
+}
+
+void SimulationProfile::clear()
+{
+    days_.clear();
+}
+
+bool SimulationProfile::writeCsv(std::string filename) const
+{
+    QFile file(filename.c_str());
+
+    if(file.open(QIODevice::WriteOnly | QIODevice::Text) != true)
+    {
+        put_flog(LOG_ERROR, "could not open %s", filename.c_str());
+        return false;
+    }
+
+    QTextStream stream(&file);
+
+    // header
+    stream << "time,total_ms";
+
+    for(int p=0; p<NUM_SIMULATION_PHASES; p++)
+    {
+        stream << "," << QString(getPhaseName((SIMULATION_PHASE)p).c_str()).replace(' ', '_') << "_ms";
+    }
+
+    stream << ",queue_size,exposures";
+
+    for(unsigned int i=0; i<eventTypeNames_.size(); i++)
+    {
+        stream << ",events_" << eventTypeNames_[i].c_str();
+    }
+
+    stream << "\n";
+
+    for(unsigned int d=0; d<days_.size(); d++)
+    {
+        const SimulationProfileDay &day = days_[d];
+
+        stream << day.time << "," << (double)day.duration / 1000.;
+
+        for(int p=0; p<NUM_SIMULATION_PHASES; p++)
+        {
+            stream << "," << (double)day.phaseDurations[p] / 1000.;
+        }
+
+        stream << "," << day.queueSize << "," << day.exposures;
+
+        for(unsigned int i=0; i<day.eventCounts.size(); i++)
+        {
+            stream << "," << day.eventCounts[i];
+        }
+
+        stream << "\n";
+    }
+
+    put_flog(LOG_INFO, "wrote %i days to %s", (int)days_.size(), filename.c_str());
+
+    return true;
+}
+
+bool SimulationProfile::writeChromeTrace(std::string filename) const
+{
+    QFile file(filename.c_str());
+
+    if(file.open(QIODevice::WriteOnly | QIODevice::Text) != true)
+    {
+        put_flog(LOG_ERROR, "could not open %s", filename.c_str());
+        return false;
+    }
+
+    QTextStream stream(&file);
+
+    stream << "{\"traceEvents\":[\n";
+
+    bool first = true;
+
+    for(unsigned int d=0; d<days_.size(); d++)
+    {
+        const SimulationProfileDay &day = days_[d];
+
+        // the day, with its counters as arguments
+        if(first != true)
+        {
+            stream << ",\n";
+        }
+
+        first = false;
+
+        stream << "{\"name\":\"day " << day.time << "\",\"cat\":\"day\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":" << day.start << ",\"dur\":" << day.duration;
+        stream << ",\"args\":{\"queue size\":" << day.queueSize << ",\"exposures\":" << day.exposures;
+
+        for(unsigned int i=0; i<day.eventCounts.size() && i<eventTypeNames_.size(); i++)
+        {
+            stream << ",\"" << eventTypeNames_[i].c_str() << "\":" << day.eventCounts[i];
+        }
+
+        stream << "}}";
+
+        // the phases
+        for(int p=0; p<NUM_SIMULATION_PHASES; p++)
+        {
+            if(day.phaseStarts[p] < 0)
+            {
+                continue;
+            }
+
+            stream << ",\n{\"name\":\"" << getPhaseName((SIMULATION_PHASE)p).c_str() << "\",\"cat\":\"phase\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":" << day.phaseStarts[p] << ",\"dur\":" << day.phaseDurations[p] << "}";
+        }
+
+        // counters, drawn as tracks
+        stream << ",\n{\"name\":\"counters\",\"ph\":\"C\",\"pid\":1,\"ts\":" << day.start << ",\"args\":{\"queue size\":" << day.queueSize << ",\"exposures\":" << day.exposures << "}}";
+    }
+
+    stream << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+    put_flog(LOG_INFO, "wrote %i days to %s", (int)days_.size(), filename.c_str());
+
+    return true;
+}
+
+qint64 SimulationProfile::getMicroseconds() const
+{
+    return timer_.nsecsElapsed() / 1000;
+}
@@ -0,0 +1,117 @@
+#ifndef SIMULATION_PROFILE_H
+#define SIMULATION_PROFILE_H
+
+#include <QElapsedTimer>
+#include <boost/array.hpp>
+#include <string>
+#include <vector>
+
+// phases of a simulated day
+enum SIMULATION_PHASE { SIMULATION_PHASE_COPY_VARIABLES, SIMULATION_PHASE_STOCKPILES, SIMULATION_PHASE_ANTIVIRALS, SIMULATION_PHASE_VACCINES, SIMULATION_PHASE_PRECOMPUTE, SIMULATION_PHASE_EVENTS, SIMULATION_PHASE_TRAVEL, SIMULATION_PHASE_ILI, NUM_SIMULATION_PHASES };
+
+// measurements for one simulated day
+struct SimulationProfileDay
+{
+    // the day simulated to
+    int time;
+
+    // start (relative to the start of the profile) and duration of each phase, in microseconds
+    // phases not run on this day have a start of -1
+    boost::array<qint64, NUM_SIMULATION_PHASES> phaseStarts;
+    boost::array<qint64, NUM_SIMULATION_PHASES> phaseDurations;
+
+    qint64 start;
+    qint64 duration;
+
+    // number of events processed, by event type
+    std::vector<int> eventCounts;
+
+    // number of queued event schedules at the end of the day
+    int queueSize;
+
+    // number of new exposures
+    int exposures;
+};
+
+// per-phase timings and counters for simulate()
+// disabled by default; when disabled, every call returns after a single test
+class SimulationProfile
+{
+    public:
+
+        SimulationProfile();
+
+        // copies start empty and disabled: a profile describes the run of one simulation object
+        SimulationProfile(const SimulationProfile &profile);
+
+        static std::string getPhaseName(SIMULATION_PHASE phase);
+
+        void setEnabled(bool enabled);
+        bool isEnabled() const;
+
+        // names of the event types counted by countEvent(), set by the model
+        void setEventTypeNames(const std::vector<std::string> &eventTypeNames);
+        std::vector<std::string> getEventTypeNames() const;
+
+        // calls may be nested (e.g. a model's simulate() calling its base class); only the outermost call records a day
+        void beginDay(int time);
+        void endDay();
+
+        void beginPhase(SIMULATION_PHASE phase);
+        void endPhase(SIMULATION_PHASE phase);
+
+        // counters for the current day
+        inline void countEvent(int type)
+        {
+            if(enabled_ == true && dayDepth_ > 0)
+            {
+                currentDay_.eventCounts[type]++;
+            }
+        }
+
+        inline void countExposures(int num)
+        {
+            if(enabled_ == true && dayDepth_ > 0)
+            {
+                currentDay_.exposures += num;
+            }
+        }
+
+        inline void setQueueSize(int size)
+        {
+            if(enabled_ == true && dayDepth_ > 0)
+            {
+                currentDay_.queueSize = size;
+            }
+        }
+
+        const std::vector<SimulationProfileDay> &getDays() const;
+
+        void clear();
+
+        // one row per day: time, total and per-phase durations (milliseconds), queue size, exposures, event counts by type
+        bool writeCsv(std::string filename) const;
+
+        // trace event format, viewable in chrome://tracing or Perfetto: one complete event per day and per phase
+        bool writeChromeTrace(std::string filename) const;
+
+    private:
+
+        // not assignable
+        SimulationProfile &operator=(const SimulationProfile &);
+
+        bool enabled_;
+
+        std::vector<std::string> eventTypeNames_;
+
+        QElapsedTimer timer_;
+
+        int dayDepth_;
+        SimulationProfileDay currentDay_;
+
+        std::vector<SimulationProfileDay> days_;
+
+        qint64 getMicroseconds() const;
+};
+
+#endif
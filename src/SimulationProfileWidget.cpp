@@ -0,0 +1,202 @@
+#include "SimulationProfileWidget.h"
+#include "SimulationProfile.h"
+#include "EpidemicSimulation.h"
+#include "log.h"
+
+SimulationProfileWidget::SimulationProfileWidget(MainWindow * mainWindow)
+{
+    QVBoxLayout * layout = new QVBoxLayout();
+    setLayout(layout);
+
+    enabledCheckBox_.setText("Profile simulated days");
+    connect(&enabledCheckBox_, SIGNAL(toggled(bool)), this, SLOT(setProfilingEnabled(bool)));
+    layout->addWidget(&enabledCheckBox_);
+
+    // table: one row per phase and counter
+    tableWidget_.setColumnCount(3);
+    tableWidget_.setHorizontalHeaderLabels(QStringList() << "" << "Last day" << "Mean");
+    tableWidget_.horizontalHeader()->setResizeMode(QHeaderView::Stretch);
+    tableWidget_.verticalHeader()->hide();
+    tableWidget_.setEditTriggers(QAbstractItemView::NoEditTriggers);
+    layout->addWidget(&tableWidget_);
+
+    QHBoxLayout * buttonsLayout = new QHBoxLayout();
+    layout->addLayout(buttonsLayout);
+
+    QPushButton * clearButton = new QPushButton("&Clear");
+    connect(clearButton, SIGNAL(clicked()), this, SLOT(clear()));
+    buttonsLayout->addWidget(clearButton);
+
+    QPushButton * exportCsvButton = new QPushButton("Export CSV...");
+    connect(exportCsvButton, SIGNAL(clicked()), this, SLOT(exportCsv()));
+    buttonsLayout->addWidget(exportCsvButton);
+
+    QPushButton * exportChromeTraceButton = new QPushButton("Export Trace...");
+    connect(exportChromeTraceButton, SIGNAL(clicked()), this, SLOT(exportChromeTrace()));
+    buttonsLayout->addWidget(exportChromeTraceButton);
+
+    // make connections
+    connect((QObject *)mainWindow, SIGNAL(dataSetChanged(boost::shared_ptr<EpidemicDataSet>)), this, SLOT(setDataSet(boost::shared_ptr<EpidemicDataSet>)));
+
+    connect((QObject *)mainWindow, SIGNAL(numberOfTimestepsChanged()), this, SLOT(updateProfile()));
+}
+
+void SimulationProfileWidget::setDataSet(boost::shared_ptr<EpidemicDataSet> dataSet)
+{
+    simulation_ = boost::dynamic_pointer_cast<EpidemicSimulation>(dataSet);
+
+    // keep profiling new simulations if it was enabled
+    if(simulation_ != NULL)
+    {
+        simulation_->getProfile().setEnabled(enabledCheckBox_.isChecked());
+    }
+
+    updateProfile();
+}
+
+void SimulationProfileWidget::updateProfile()
+{
+    tableWidget_.setRowCount(0);
+
+    if(simulation_ == NULL || simulation_->getProfile().getDays().size() == 0)
+    {
+        return;
+    }
+
+    const SimulationProfile &profile = simulation_->getProfile();
+    const std::vector<SimulationProfileDay> &days = profile.getDays();
+    const SimulationProfileDay &lastDay = days.back();
+
+    // means over all profiled days
+    double totalMean = 0.;
+    std::vector<double> phaseMeans(NUM_SIMULATION_PHASES, 0.);
+    double queueSizeMean = 0.;
+    double exposuresMean = 0.;
+    std::vector<double> eventCountMeans(lastDay.eventCounts.size(), 0.);
+
+    for(unsigned int d=0; d<days.size(); d++)
+    {
+        totalMean += (double)days[d].duration / (double)days.size();
+
+        for(int p=0; p<NUM_SIMULATION_PHASES; p++)
+        {
+            phaseMeans[p] += (double)days[d].phaseDurations[p] / (double)days.size();
+        }
+
+        queueSizeMean += (double)days[d].queueSize / (double)days.size();
+        exposuresMean += (double)days[d].exposures / (double)days.size();
+
+        for(unsigned int i=0; i<eventCountMeans.size() && i<days[d].eventCounts.size(); i++)
+        {
+            eventCountMeans[i] += (double)days[d].eventCounts[i] / (double)days.size();
+        }
+    }
+
+    // rows: total, phases (milliseconds), then counters
+    std::vector<QString> names;
+    std::vector<QString> lastValues;
+    std::vector<QString> meanValues;
+
+    names.push_back("Total (ms)");
+    lastValues.push_back(QString::number((double)lastDay.duration / 1000., 'f', 2));
+    meanValues.push_back(QString::number(totalMean / 1000., 'f', 2));
+
+    for(int p=0; p<NUM_SIMULATION_PHASES; p++)
+    {
+        names.push_back(QString(SimulationProfile::getPhaseName((SIMULATION_PHASE)p).c_str()) + " (ms)");
+        lastValues.push_back(QString::number((double)lastDay.phaseDurations[p] / 1000., 'f', 2));
+        meanValues.push_back(QString::number(phaseMeans[p] / 1000., 'f', 2));
+    }
+
+    names.push_back("Queued schedules");
+    lastValues.push_back(QString::number(lastDay.queueSize));
+    meanValues.push_back(QString::number(queueSizeMean, 'f', 0));
+
+    names.push_back("Exposures");
+    lastValues.push_back(QString::number(lastDay.exposures));
+    meanValues.push_back(QString::number(exposuresMean, 'f', 0));
+
+    std::vector<std::string> eventTypeNames = profile.getEventTypeNames();
+
+    for(unsigned int i=0; i<eventCountMeans.size() && i<eventTypeNames.size(); i++)
+    {
+        names.push_back(QString("Events: ") + eventTypeNames[i].c_str());
+        lastValues.push_back(QString::number(lastDay.eventCounts[i]));
+        meanValues.push_back(QString::number(eventCountMeans[i], 'f', 0));
+    }
+
+    tableWidget_.setRowCount(names.size());
+
+    for(unsigned int i=0; i<names.size(); i++)
+    {
+        tableWidget_.setItem(i, 0, new QTableWidgetItem(names[i]));
+        tableWidget_.setItem(i, 1, new QTableWidgetItem(lastValues[i]));
+        tableWidget_.setItem(i, 2, new QTableWidgetItem(meanValues[i]));
+    }
+}
+
+void SimulationProfileWidget::setProfilingEnabled(bool enabled)
+{
+    if(simulation_ != NULL)
+    {
+        simulation_->getProfile().setEnabled(enabled);
+    }
+}
+
+void SimulationProfileWidget::clear()
+{
+    if(simulation_ != NULL)
+    {
+        simulation_->getProfile().clear();
+    }
+
+    updateProfile();
+}
+
+void SimulationProfileWidget::exportCsv()
+{
+    if(simulation_ == NULL)
+    {
+        QMessageBox::warning(this, "Error", "No active simulation.", QMessageBox::Ok, QMessageBox::Ok);
+        return;
+    }
+
+    QString filename = QFileDialog::getSaveFileName(this, "Export Profile", "", "CSV files (*.csv)");
+
+    if(!filename.isEmpty())
+    {
+        if(filename.endsWith(".csv") != true)
+        {
+            filename.append(".csv");
+        }
+
+        if(simulation_->getProfile().writeCsv(filename.toStdString()) != true)
+        {
+            QMessageBox::warning(this, "Error", "Profile was not exported.", QMessageBox::Ok, QMessageBox::Ok);
+        }
+    }
+}
+
+void SimulationProfileWidget::exportChromeTrace()
+{
+    if(simulation_ == NULL)
+    {
+        QMessageBox::warning(this, "Error", "No active simulation.", QMessageBox::Ok, QMessageBox::Ok);
+        return;
+    }
+
+    QString filename = QFileDialog::getSaveFileName(this, "Export Profile Trace", "", "Trace files (*.json)");
+
+    if(!filename.isEmpty())
+    {
+        if(filename.endsWith(".json") != true)
+        {
+            filename.append(".json");
+        }
+
+        if(simulation_->getProfile().writeChromeTrace(filename.toStdString()) != true)
+        {
+            QMessageBox::warning(this, "Error", "Profile was not exported.", QMessageBox::Ok, QMessageBox::Ok);
+        }
+    }
+}
@@ -0,0 +1,42 @@
+#ifndef SIMULATION_PROFILE_WIDGET_H
+#define SIMULATION_PROFILE_WIDGET_H
+
+#include <QtGui>
+#include <boost/shared_ptr.hpp>
+
+class MainWindow;
+class EpidemicDataSet;
+class EpidemicSimulation;
+
+// live view of a simulation's profile: per-phase timings of the last simulated day and the mean over all profiled days,
+// and the day's counters
+class SimulationProfileWidget : public QWidget
+{
+    Q_OBJECT
+
+    public:
+
+        SimulationProfileWidget(MainWindow * mainWindow);
+
+    public slots:
+
+        void setDataSet(boost::shared_ptr<EpidemicDataSet> dataSet);
+        void updateProfile();
+
+    private slots:
+
+        void setProfilingEnabled(bool enabled);
+        void clear();
+        void exportCsv();
+        void exportChromeTrace();
+
+    private:
+
+        boost::shared_ptr<EpidemicSimulation> simulation_;
+
+        // UI elements
+        QCheckBox enabledCheckBox_;
+        QTableWidget tableWidget_;
+};
+
+#endif
@@ -1,14 +1,34 @@
 #include "Stockpile.h"
 #include "log.h"
+#include <algorithm>
+
+// orders change log entries by time
+static bool compareChangeTime(const std::pair<int, int> &change, int time)
+{
+    return change.first < time;
+}
 
 Stockpile::Stockpile(std::string name)
 {
     name_ = name;
 
-    boost::array<int, NUM_STOCKPILE_TYPES> zeros;
-    zeros.fill(0);
+    numTimes_ = 1;
 
-    num_.push_back(zeros);
+    for(int i=0; i<NUM_STOCKPILE_TYPES; i++)
+    {
+        changes_[i].push_back(std::pair<int, int>(0, 0));
+    }
+}
+
+boost::shared_ptr<Stockpile> Stockpile::clone()
+{
+    boost::shared_ptr<Stockpile> stockpile(new Stockpile(name_));
+
+    stockpile->numTimes_ = numTimes_;
+    stockpile->changes_ = changes_;
+    stockpile->nodeIds_ = nodeIds_;
+
+    return stockpile;
 }
 
 std::string Stockpile::getTypeName(STOCKPILE_TYPE type)
@@ -34,13 +54,24 @@ std::string Stockpile::getName()
 
 int Stockpile::getNum(int time, STOCKPILE_TYPE type)
 {
-    if(time >= (int)num_.size())
+    if(time >= numTimes_)
     {
-        put_flog(LOG_ERROR, "time %i >= %i", time, num_.size());
+        put_flog(LOG_ERROR, "time %i >= %i", time, numTimes_);
         return 0;
     }
 
-    return num_[time][type];
+    const std::vector<std::pair<int, int> > &changes = changes_[type];
+
+    // current value
+    if(time >= changes.back().first)
+    {
+        return changes.back().second;
+    }
+
+    // last change at or before time
+    std::vector<std::pair<int, int> >::const_iterator iter = std::lower_bound(changes.begin(), changes.end(), time + 1, compareChangeTime);
+
+    return (iter - 1)->second;
 }
 
 void Stockpile::setNodeIds(std::vector<int> nodeIds)
@@ -55,16 +86,47 @@ std::vector<int> Stockpile::getNodeIds()
 
 void Stockpile::copyToNewTimeStep()
 {
-    num_.push_back(num_.back());
+    // values carry forward until changed
+    numTimes_++;
 }
 
 void Stockpile::setNum(int time, int num, STOCKPILE_TYPE type)
 {
-    if(time >= (int)num_.size())
+    if(time >= numTimes_)
     {
-        put_flog(LOG_ERROR, "time %i >= %i", time, num_.size());
+        put_flog(LOG_ERROR, "time %i >= %i", time, numTimes_);
         return;
     }
 
-    num_[time][type] = num;
+    if(getNum(time, type) == num)
+    {
+        return;
+    }
+
+    std::vector<std::pair<int, int> > &changes = changes_[type];
+
+    // the value at time + 1 is unchanged
+    bool hasNextTime = (time + 1 < numTimes_);
+    int nextNum = 0;
+
+    if(hasNextTime == true)
+    {
+        nextNum = getNum(time + 1, type);
+    }
+
+    std::vector<std::pair<int, int> >::iterator iter = std::lower_bound(changes.begin(), changes.end(), time, compareChangeTime);
+
+    if(iter != changes.end() && iter->first == time)
+    {
+        iter->second = num;
+    }
+    else
+    {
+        iter = changes.insert(iter, std::pair<int, int>(time, num));
+    }
+
+    if(hasNextTime == true && (iter + 1 == changes.end() || (iter + 1)->first != time + 1))
+    {
+        changes.insert(iter + 1, std::pair<int, int>(time + 1, nextNum));
+    }
 }
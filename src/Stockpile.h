@@ -3,8 +3,10 @@
 
 #include <QtGui>
 #include <string>
+#include <utility>
 #include <vector>
 #include <boost/array.hpp>
+#include <boost/shared_ptr.hpp>
 
 enum STOCKPILE_TYPE { STOCKPILE_ANTIVIRALS, STOCKPILE_VACCINES, NUM_STOCKPILE_TYPES };
 
@@ -16,6 +18,9 @@ class Stockpile : public QObject
 
         Stockpile(std::string name);
 
+        // a new stockpile with the same name, nodeIds and history
+        boost::shared_ptr<Stockpile> clone();
+
         static std::string getTypeName(STOCKPILE_TYPE type);
 
         std::string getName();
@@ -36,8 +41,12 @@ class Stockpile : public QObject
         // name for the stockpile
         std::string name_;
 
-        // number of available resource at each timestep
-        std::vector<boost::array<int, NUM_STOCKPILE_TYPES> > num_;
+        // number of timesteps
+        int numTimes_;
+
+        // change log of the number of available resource for each type: (time, num) sorted by time
+        // each entry holds from its time until the next entry; the last entry is the current value
+        boost::array<std::vector<std::pair<int, int> >, NUM_STOCKPILE_TYPES> changes_;
 
         // nodeIds serviced from this stockpile
         std::vector<int> nodeIds_;
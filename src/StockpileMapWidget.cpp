@@ -36,11 +36,8 @@ void StockpileMapWidget::setDataSet(boost::shared_ptr<EpidemicDataSet> dataSet)
     }
 }
 
-void StockpileMapWidget::setTime(int time)
+void StockpileMapWidget::recolorCounties()
 {
-    MapWidget::setTime(time);
-
-    // do coloring here, since render() won't be called if the map is offscreen (for SVG export)
     if(stockpileNetwork_ != NULL)
     {
         // get nodeIds
@@ -69,13 +66,6 @@ void StockpileMapWidget::setTime(int time)
             }
         }
     }
-
-    // force redraw
-    update();
-
-#if USE_DISPLAYCLUSTER
-    exportSVGToDisplayCluster();
-#endif
 }
 
 void StockpileMapWidget::setType(STOCKPILE_TYPE type)
@@ -15,7 +15,6 @@ class StockpileMapWidget : public MapWidget
 
         // re-implemented virtual methods
         void setDataSet(boost::shared_ptr<EpidemicDataSet> dataSet);
-        void setTime(int time);
 
         void setType(STOCKPILE_TYPE type);
 
@@ -25,8 +24,9 @@ class StockpileMapWidget : public MapWidget
 
         STOCKPILE_TYPE type_;
 
-        // re-implemented virtual render method
+        // re-implemented virtual methods
         void render(QPainter * painter);
+        void recolorCounties();
 };
 
 #endif
@@ -1,5 +1,6 @@
 #include "StockpileNetwork.h"
 #include "EpidemicDataSet.h"
+#include "RegionData.h"
 #include "StockpileNetworkDistribution.h"
 #include "log.h"
 #include <boost/lexical_cast.hpp>
@@ -8,14 +9,69 @@ StockpileNetwork::StockpileNetwork(EpidemicDataSet * dataSet)
 {
     dataSet_ = dataSet;
 
+    // defaults
+    totalPopulation_ = -1.;
+
+    regionData_ = RegionData::getDefault();
+
     std::vector<int> nodeIds = dataSet->getNodeIds();
 
+    nodeStockpiles_.resize(nodeIds.size());
+
     for(unsigned int i=0; i<nodeIds.size(); i++)
     {
         boost::shared_ptr<Stockpile> stockpile(new Stockpile(boost::lexical_cast<std::string>(nodeIds[i])));
 
-        nodeStockpiles_[nodeIds[i]] = stockpile;
+        nodeStockpiles_[dataSet->getNodeIndex(nodeIds[i])] = stockpile;
+    }
+}
+
+boost::shared_ptr<StockpileNetwork> StockpileNetwork::clone(EpidemicDataSet * dataSet)
+{
+    boost::shared_ptr<StockpileNetwork> network(new StockpileNetwork(dataSet));
+
+    for(unsigned int i=0; i<stockpiles_.size(); i++)
+    {
+        network->addStockpile(stockpiles_[i]->clone());
+    }
+
+    for(unsigned int i=0; i<nodeStockpiles_.size() && i<network->nodeStockpiles_.size(); i++)
+    {
+        network->nodeStockpiles_[i] = nodeStockpiles_[i]->clone();
     }
+
+    std::map<boost::shared_ptr<Stockpile>, boost::shared_ptr<Stockpile> > stockpileMap = getStockpileMap(network);
+
+    // distributions are added in their original order, so they are applied in the same order
+    for(unsigned int i=0; i<distributions_.size(); i++)
+    {
+        network->addDistribution(distributions_[i]->clone(stockpileMap));
+    }
+
+    return network;
+}
+
+std::map<boost::shared_ptr<Stockpile>, boost::shared_ptr<Stockpile> > StockpileNetwork::getStockpileMap(boost::shared_ptr<StockpileNetwork> network)
+{
+    std::map<boost::shared_ptr<Stockpile>, boost::shared_ptr<Stockpile> > stockpileMap;
+
+    if(network->stockpiles_.size() != stockpiles_.size() || network->nodeStockpiles_.size() != nodeStockpiles_.size())
+    {
+        put_flog(LOG_ERROR, "networks do not correspond");
+        return stockpileMap;
+    }
+
+    for(unsigned int i=0; i<stockpiles_.size(); i++)
+    {
+        stockpileMap[stockpiles_[i]] = network->stockpiles_[i];
+    }
+
+    for(unsigned int i=0; i<nodeStockpiles_.size(); i++)
+    {
+        stockpileMap[nodeStockpiles_[i]] = network->nodeStockpiles_[i];
+    }
+
+    return stockpileMap;
 }
 
 void StockpileNetwork::addStockpile(boost::shared_ptr<Stockpile> stockpile)
@@ -29,6 +85,19 @@ void StockpileNetwork::addDistribution(boost::shared_ptr<StockpileNetworkDistrib
     distribution->setNetwork(shared_from_this());
 
     distributions_.push_back(distribution);
+
+    // schedule departure and arrival
+    int departureTime = distribution->getTime();
+    int arrivalTime = distribution->getTime() + distribution->getTransferTime();
+
+    distributionCalendar_[departureTime].push_back(distribution);
+
+    if(arrivalTime != departureTime)
+    {
+        distributionCalendar_[arrivalTime].push_back(distribution);
+    }
+
+    distributionArrivals_[arrivalTime].push_back(distribution);
 }
 
 EpidemicDataSet * StockpileNetwork::getDataSet()
@@ -45,11 +114,17 @@ std::vector<boost::shared_ptr<StockpileNetworkDistribution> > StockpileNetwork::
 {
     std::vector<boost::shared_ptr<StockpileNetworkDistribution> > pendingDistributions;
 
-    for(unsigned int i=0; i<distributions_.size(); i++)
+    // only distributions arriving after nowTime can be pending
+    std::map<int, std::vector<boost::shared_ptr<StockpileNetworkDistribution> > >::iterator iter;
+
+    for(iter=distributionArrivals_.upper_bound(nowTime); iter!=distributionArrivals_.end(); iter++)
     {
-        if(nowTime >= distributions_[i]->getTime() && nowTime < distributions_[i]->getTime() + distributions_[i]->getTransferTime())
+        for(unsigned int i=0; i<iter->second.size(); i++)
         {
-            pendingDistributions.push_back(distributions_[i]);
+            if(nowTime >= iter->second[i]->getTime())
+            {
+                pendingDistributions.push_back(iter->second[i]);
+            }
         }
     }
 
@@ -58,14 +133,53 @@ std::vector<boost::shared_ptr<StockpileNetworkDistribution> > StockpileNetwork::
 
 boost::shared_ptr<Stockpile> StockpileNetwork::getNodeStockpile(int nodeId)
 {
-    if(nodeStockpiles_.count(nodeId) == 0)
+    int nodeIndex = -1;
+
+    if(regionData_ != NULL)
+    {
+        nodeIndex = regionData_->getNodeIndex(nodeId);
+    }
+
+    if(nodeIndex < 0 || nodeIndex >= (int)nodeStockpiles_.size())
     {
         put_flog(LOG_ERROR, "no node stockpile for nodeId %i", nodeId);
 
         return boost::shared_ptr<Stockpile>();
     }
 
-    return nodeStockpiles_[nodeId];
+    return nodeStockpiles_[nodeIndex];
+}
+
+boost::shared_ptr<Stockpile> StockpileNetwork::getNodeStockpileByIndex(int nodeIndex)
+{
+    if(nodeIndex < 0 || nodeIndex >= (int)nodeStockpiles_.size())
+    {
+        put_flog(LOG_ERROR, "no node stockpile for node index %i", nodeIndex);
+
+        return boost::shared_ptr<Stockpile>();
+    }
+
+    return nodeStockpiles_[nodeIndex];
+}
+
+double StockpileNetwork::getTotalPopulation()
+{
+    if(totalPopulation_ < 0.)
+    {
+        totalPopulation_ = dataSet_->getPopulation(dataSet_->getNodeIds());
+    }
+
+    return totalPopulation_;
+}
+
+double StockpileNetwork::getPopulation(boost::shared_ptr<Stockpile> stockpile)
+{
+    return getStockpilePopulation(stockpile).population;
+}
+
+const std::vector<float> & StockpileNetwork::getNodePopulationFractions(boost::shared_ptr<Stockpile> stockpile)
+{
+    return getStockpilePopulation(stockpile).nodeFractions;
 }
 
 void StockpileNetwork::evolve(int nowTime)
@@ -76,18 +190,48 @@ void StockpileNetwork::evolve(int nowTime)
         stockpiles_[i]->copyToNewTimeStep();
     }
 
-    std::map<int, boost::shared_ptr<Stockpile> >::iterator iter;
-
-    for(iter=nodeStockpiles_.begin(); iter!=nodeStockpiles_.end(); iter++)
+    for(unsigned int i=0; i<nodeStockpiles_.size(); i++)
     {
-        iter->second->copyToNewTimeStep();
+        nodeStockpiles_[i]->copyToNewTimeStep();
     }
 
-    // apply distributions
+    // apply distributions departing or arriving today
     // for now, don't delete any of the distribution objects -- leave them in place
-    for(unsigned int i=0; i<distributions_.size(); i++)
+    std::map<int, std::vector<boost::shared_ptr<StockpileNetworkDistribution> > >::iterator calendarIter = distributionCalendar_.find(nowTime);
+
+    if(calendarIter != distributionCalendar_.end())
     {
-        // apply() only does something at the appropriate nowTime
-        distributions_[i]->apply(nowTime);
+        // distributions added during apply() are not scheduled until the next call
+        std::vector<boost::shared_ptr<StockpileNetworkDistribution> > distributions = calendarIter->second;
+
+        for(unsigned int i=0; i<distributions.size(); i++)
+        {
+            distributions[i]->apply(nowTime);
+        }
     }
 }
+
+StockpileNetwork::StockpilePopulation & StockpileNetwork::getStockpilePopulation(boost::shared_ptr<Stockpile> stockpile)
+{
+    std::vector<int> nodeIds = stockpile->getNodeIds();
+
+    std::map<boost::shared_ptr<Stockpile>, StockpilePopulation>::iterator iter = stockpilePopulations_.find(stockpile);
+
+    if(iter != stockpilePopulations_.end() && iter->second.nodeIds == nodeIds)
+    {
+        return iter->second;
+    }
+
+    StockpilePopulation &stockpilePopulation = stockpilePopulations_[stockpile];
+
+    stockpilePopulation.nodeIds = nodeIds;
+    stockpilePopulation.population = dataSet_->getPopulation(nodeIds);
+    stockpilePopulation.nodeFractions.clear();
+
+    for(unsigned int i=0; i<nodeIds.size(); i++)
+    {
+        stockpilePopulation.nodeFractions.push_back((float)(dataSet_->getPopulation(nodeIds[i]) / stockpilePopulation.population));
+    }
+
+    return stockpilePopulation;
+}
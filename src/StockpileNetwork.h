@@ -2,11 +2,13 @@
 #define STOCKPILE_NETWORK_H
 
 #include "Stockpile.h"
+#include <map>
 #include <vector>
 #include <boost/shared_ptr.hpp>
 #include <boost/enable_shared_from_this.hpp>
 
 class EpidemicDataSet;
+class RegionData;
 class StockpileNetworkDistribution;
 
 class StockpileNetwork : public boost::enable_shared_from_this<StockpileNetwork>
@@ -15,6 +17,12 @@ class StockpileNetwork : public boost::enable_shared_from_this<StockpileNetwork>
 
         StockpileNetwork(EpidemicDataSet * dataSet);
 
+        // a copy of this network, its stockpiles and distributions, owned by dataSet
+        boost::shared_ptr<StockpileNetwork> clone(EpidemicDataSet * dataSet);
+
+        // map of the stockpiles of this network to the corresponding stockpiles of a clone of this network
+        std::map<boost::shared_ptr<Stockpile>, boost::shared_ptr<Stockpile> > getStockpileMap(boost::shared_ptr<StockpileNetwork> network);
+
         void addStockpile(boost::shared_ptr<Stockpile> stockpile);
         void addDistribution(boost::shared_ptr<StockpileNetworkDistribution> distribution);
 
@@ -25,6 +33,14 @@ class StockpileNetwork : public boost::enable_shared_from_this<StockpileNetwork>
         std::vector<boost::shared_ptr<StockpileNetworkDistribution> > getPendingDistributions(int nowTime);
 
         boost::shared_ptr<Stockpile> getNodeStockpile(int nodeId);
+        boost::shared_ptr<Stockpile> getNodeStockpileByIndex(int nodeIndex);
+
+        // cached population values used for pro-rata distributions
+        double getTotalPopulation();
+        double getPopulation(boost::shared_ptr<Stockpile> stockpile);
+
+        // fraction of the stockpile's population in each of its nodeIds, in the order of getNodeIds()
+        const std::vector<float> & getNodePopulationFractions(boost::shared_ptr<Stockpile> stockpile);
 
         void evolve(int nowTime);
 
@@ -36,9 +52,32 @@ class StockpileNetwork : public boost::enable_shared_from_this<StockpileNetwork>
         std::vector<boost::shared_ptr<Stockpile> > stockpiles_;
         std::vector<boost::shared_ptr<StockpileNetworkDistribution> > distributions_;
 
-        // local stockpiles for each node
+        // distributions departing or arriving on each day, in the order they were added
+        std::map<int, std::vector<boost::shared_ptr<StockpileNetworkDistribution> > > distributionCalendar_;
+
+        // distributions by arrival day, for pending distribution queries
+        std::map<int, std::vector<boost::shared_ptr<StockpileNetworkDistribution> > > distributionArrivals_;
+
+        struct StockpilePopulation
+        {
+            // nodeIds the values were computed for; recomputed if the stockpile's nodeIds change
+            std::vector<int> nodeIds;
+
+            double population;
+            std::vector<float> nodeFractions;
+        };
+
+        double totalPopulation_;
+        std::map<boost::shared_ptr<Stockpile>, StockpilePopulation> stockpilePopulations_;
+
+        StockpilePopulation & getStockpilePopulation(boost::shared_ptr<Stockpile> stockpile);
+
+        // for nodeId -> node index lookups
+        boost::shared_ptr<const RegionData> regionData_;
+
+        // local stockpiles for each node, indexed by node index
         // these stockpiles are made available for interventions
-        std::map<int, boost::shared_ptr<Stockpile> > nodeStockpiles_;
+        std::vector<boost::shared_ptr<Stockpile> > nodeStockpiles_;
 };
 
 #endif
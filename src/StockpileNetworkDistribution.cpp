@@ -3,6 +3,25 @@
 #include "EpidemicDataSet.h"
 #include "log.h"
 
+// corresponding stockpile in stockpileMap; NULL stockpiles map to NULL
+static boost::shared_ptr<Stockpile> getMappedStockpile(const std::map<boost::shared_ptr<Stockpile>, boost::shared_ptr<Stockpile> > &stockpileMap, boost::shared_ptr<Stockpile> stockpile)
+{
+    if(stockpile == NULL)
+    {
+        return boost::shared_ptr<Stockpile>();
+    }
+
+    std::map<boost::shared_ptr<Stockpile>, boost::shared_ptr<Stockpile> >::const_iterator iter = stockpileMap.find(stockpile);
+
+    if(iter == stockpileMap.end())
+    {
+        put_flog(LOG_ERROR, "no corresponding stockpile for %s", stockpile->getName().c_str());
+        return boost::shared_ptr<Stockpile>();
+    }
+
+    return iter->second;
+}
+
 StockpileNetworkDistribution::StockpileNetworkDistribution(int time, boost::shared_ptr<Stockpile> sourceStockpile, boost::shared_ptr<Stockpile> destinationStockpile, STOCKPILE_TYPE type, int quantity, int transferTime)
 {
     // defaults
@@ -16,6 +35,20 @@ StockpileNetworkDistribution::StockpileNetworkDistribution(int time, boost::shar
     transferTime_ = transferTime;
 }
 
+boost::shared_ptr<StockpileNetworkDistribution> StockpileNetworkDistribution::clone(const std::map<boost::shared_ptr<Stockpile>, boost::shared_ptr<Stockpile> > &stockpileMap)
+{
+    boost::shared_ptr<StockpileNetworkDistribution> distribution(new StockpileNetworkDistribution(time_, getMappedStockpile(stockpileMap, sourceStockpile_), getMappedStockpile(stockpileMap, destinationStockpile_), type_, quantity_, transferTime_));
+
+    distribution->clampedQuantity_ = clampedQuantity_;
+
+    for(std::map<boost::shared_ptr<Stockpile>, int>::iterator it=clampedQuantities_.begin(); it!=clampedQuantities_.end(); it++)
+    {
+        distribution->clampedQuantities_[getMappedStockpile(stockpileMap, it->first)] = it->second;
+    }
+
+    return distribution;
+}
+
 void StockpileNetworkDistribution::setNetwork(boost::shared_ptr<StockpileNetwork> network)
 {
     network_ = network;
@@ -31,7 +64,7 @@ void StockpileNetworkDistribution::apply(int nowTime)
         {
             if(clampedQuantity > sourceStockpile_->getNum(nowTime, type_))
             {
-                put_flog(LOG_INFO, "clamping transfer quantity to %i", sourceStockpile_->getNum(nowTime, type_));
+                put_slog(LOG_INFO, "event=clamped_distribution requested=%i available=%i", quantity_, sourceStockpile_->getNum(nowTime, type_));
 
                 clampedQuantity = sourceStockpile_->getNum(nowTime, type_);
             }
@@ -60,7 +93,7 @@ void StockpileNetworkDistribution::apply(int nowTime)
 
         if(destinationStockpile_ != NULL)
         {
-            put_flog(LOG_INFO, "applying distribution (outbound): %s --> %s, %i", sourceName.c_str(), destinationStockpile_->getName().c_str(), clampedQuantity_);
+            put_slog(LOG_INFO, "event=distribution_outbound time=%i source=\"%s\" destination=\"%s\" quantity=%i", nowTime, sourceName.c_str(), destinationStockpile_->getName().c_str(), clampedQuantity_);
 
             // go ahead and save to the map too, to simplify the inbound distribution
             clampedQuantities_[destinationStockpile_] = clampedQuantity_;
@@ -80,7 +113,7 @@ void StockpileNetworkDistribution::apply(int nowTime)
             }
 
             // total population
-            float totalPopulation = network->getDataSet()->getPopulation(network->getDataSet()->getNodeIds());
+            double totalPopulation = network->getTotalPopulation();
 
             std::vector<boost::shared_ptr<Stockpile> > stockpiles = network->getStockpiles();
 
@@ -89,12 +122,12 @@ void StockpileNetworkDistribution::apply(int nowTime)
                 if(stockpiles[i]->getNodeIds().size() > 0)
                 {
                     // population for nodeIds of this stockpile
-                    float stockpilePopulation = network->getDataSet()->getPopulation(stockpiles[i]->getNodeIds());
+                    double stockpilePopulation = network->getPopulation(stockpiles[i]);
 
                     // prorata to this stockpile by population
-                    clampedQuantities_[stockpiles[i]] = (int)(stockpilePopulation / totalPopulation * (float)clampedQuantity_);
+                    clampedQuantities_[stockpiles[i]] = (int)(stockpilePopulation / totalPopulation * (double)clampedQuantity_);
 
-                    put_flog(LOG_INFO, "applying split distribution (outbound): %s --> %s, %i", sourceName.c_str(), stockpiles[i]->getName().c_str(), clampedQuantities_[stockpiles[i]]);
+                    put_slog(LOG_INFO, "event=distribution_split_outbound time=%i source=\"%s\" destination=\"%s\" quantity=%i", nowTime, sourceName.c_str(), stockpiles[i]->getName().c_str(), clampedQuantities_[stockpiles[i]]);
                 }
             }
         }
@@ -119,7 +152,7 @@ void StockpileNetworkDistribution::apply(int nowTime)
             boost::shared_ptr<Stockpile> destinationStockpile = it->first;
             int clampedQuantity = it->second;
 
-            put_flog(LOG_INFO, "applying distribution (inbound): %s --> %s, %i", sourceName.c_str(), destinationStockpile->getName().c_str(), clampedQuantity);
+            put_slog(LOG_INFO, "event=distribution_inbound time=%i source=\"%s\" destination=\"%s\" quantity=%i", nowTime, sourceName.c_str(), destinationStockpile->getName().c_str(), clampedQuantity);
 
             // increment destination
             destinationStockpile->setNum(nowTime, destinationStockpile->getNum(nowTime, type_) + clampedQuantity, type_);
@@ -141,14 +174,11 @@ void StockpileNetworkDistribution::apply(int nowTime)
                 // at the end of the distribution the destination stockpile should be this
                 int destinationStockpileFinal = destinationStockpile->getNum(nowTime, type_) - clampedQuantity;
 
-                // total population
-                float totalPopulation = network->getDataSet()->getPopulation(destinationNodeIds);
+                // population fraction of each node served by the destination
+                const std::vector<float> &fractions = network->getNodePopulationFractions(destinationStockpile);
 
                 for(unsigned int i=0; i<destinationNodeIds.size(); i++)
                 {
-                    // population and stockpile for this nodeId
-                    float population = network->getDataSet()->getPopulation(destinationNodeIds[i]);
-
                     boost::shared_ptr<Stockpile> nodeStockpile = network->getNodeStockpile(destinationNodeIds[i]);
 
                     if(nodeStockpile == NULL)
@@ -158,12 +188,12 @@ void StockpileNetworkDistribution::apply(int nowTime)
                     }
 
                     // now, make the pro-rata distribution
-                    float fraction = population / totalPopulation;
+                    float fraction = fractions[i];
 
                     // todo: this truncates the decimal quantity...
                     int clampedQuantityFraction = (int)(fraction * (float)clampedQuantity);
 
-                    put_flog(LOG_INFO, "applying distribution (pro rata to nodes): %s --> %s, %i", destinationStockpile->getName().c_str(), nodeStockpile->getName().c_str(), clampedQuantityFraction);
+                    put_slog(LOG_DEBUG, "event=distribution_pro_rata time=%i source=\"%s\" node=\"%s\" quantity=%i", nowTime, destinationStockpile->getName().c_str(), nodeStockpile->getName().c_str(), clampedQuantityFraction);
 
                     // decrement original destination
                     destinationStockpile->setNum(nowTime, destinationStockpile->getNum(nowTime, type_) - clampedQuantityFraction, type_);
@@ -16,6 +16,10 @@ class StockpileNetworkDistribution : public QObject
 
         StockpileNetworkDistribution(int time, boost::shared_ptr<Stockpile> sourceStockpile, boost::shared_ptr<Stockpile> destinationStockpile, STOCKPILE_TYPE type, int quantity, int transferTime);
 
+        // a copy of this distribution, including its applied state, referencing the corresponding stockpiles in stockpileMap
+        // the copy is not associated with a network
+        boost::shared_ptr<StockpileNetworkDistribution> clone(const std::map<boost::shared_ptr<Stockpile>, boost::shared_ptr<Stockpile> > &stockpileMap);
+
         void setNetwork(boost::shared_ptr<StockpileNetwork> network);
 
         // execute the distribution if nowTime == time_, time_ + transferTime_
@@ -3,6 +3,7 @@
 #include "EpidemicSimulation.h"
 #include "StockpileNetwork.h"
 #include "StockpileNetworkDistribution.h"
+#include "StockpilePlanEvaluator.h"
 #include "log.h"
 
 // need Stockpile shared_ptr allowed as a QVariant
@@ -73,11 +74,16 @@ StockpileNetworkDistributionWidget::StockpileNetworkDistributionWidget(boost::sh
     // results label
     layout->addWidget(&resultLabel_);
 
+    // compare destinations button
+    QPushButton * compareDestinationsButton = new QPushButton("Compare Destinations...", this);
+    layout->addWidget(compareDestinationsButton);
+
     // execute button
     QPushButton * executeButton = new QPushButton("Execute", this);
     layout->addWidget(executeButton);
 
     // connections
+    connect(compareDestinationsButton, SIGNAL(clicked()), this, SLOT(compareDestinations()));
     connect(executeButton, SIGNAL(clicked()), this, SLOT(execute()));
 }
 
@@ -118,3 +124,84 @@ void StockpileNetworkDistributionWidget::execute()
     // connect signal so we get the clamped quantity when the transfer occurs
     connect(distribution.get(), SIGNAL(applied(int)), this, SLOT(applied(int)));
 }
+
+void StockpileNetworkDistributionWidget::compareDestinations()
+{
+    boost::shared_ptr<EpidemicSimulation> simulation = boost::dynamic_pointer_cast<EpidemicSimulation>(dataSet_);
+
+    if(simulation == NULL)
+    {
+        put_flog(LOG_ERROR, "not a valid simulation");
+        return;
+    }
+
+    // the "now" time
+    int time = dataSet_->getNumTimes();
+
+    boost::shared_ptr<Stockpile> sourceStockpile = sourceComboBox_.itemData(sourceComboBox_.currentIndex()).value<boost::shared_ptr<Stockpile> >();
+
+    StockpilePlanEvaluator evaluator(simulation);
+
+    // baseline
+    StockpilePlan noDistributionPlan;
+    noDistributionPlan.name = "No distribution";
+
+    evaluator.addPlan(noDistributionPlan);
+
+    // one plan for each destination
+    for(int i=0; i<destinationComboBox_.count(); i++)
+    {
+        boost::shared_ptr<Stockpile> destinationStockpile = destinationComboBox_.itemData(i).value<boost::shared_ptr<Stockpile> >();
+
+        if(destinationStockpile != NULL && destinationStockpile == sourceStockpile)
+        {
+            continue;
+        }
+
+        StockpilePlan plan;
+        plan.name = destinationComboBox_.itemText(i).toStdString();
+        plan.distributions.push_back(boost::shared_ptr<StockpileNetworkDistribution>(new StockpileNetworkDistribution(time, sourceStockpile, destinationStockpile, (STOCKPILE_TYPE)typeComboBox_.currentIndex(), quantitySpinBox_.value(), transferTimeSpinBox_.value())));
+
+        evaluator.addPlan(plan);
+    }
+
+    std::vector<StockpilePlanOutcome> outcomes;
+
+    if(evaluator.evaluate(outcomes, this) != true)
+    {
+        return;
+    }
+
+    // show ranked outcomes
+    QDialog dialog(this);
+    dialog.setWindowTitle("Compare Destinations");
+
+    QVBoxLayout * layout = new QVBoxLayout();
+    dialog.setLayout(layout);
+
+    layout->addWidget(new QLabel(QString("Expected outcomes over the next ") + QString::number(STOCKPILE_PLAN_EVALUATOR_DEFAULT_HORIZON) + " days (" + QString::number(STOCKPILE_PLAN_EVALUATOR_DEFAULT_NUM_REPLICATES) + " replicates each, mean +/- sample standard deviation), best first"));
+
+    QTableWidget * table = new QTableWidget(outcomes.size(), 3);
+    layout->addWidget(table);
+
+    QStringList headerLabels;
+    headerLabels << "Destination" << "New Infections" << "New Deaths";
+    table->setHorizontalHeaderLabels(headerLabels);
+
+    for(unsigned int i=0; i<outcomes.size(); i++)
+    {
+        table->setItem(i, 0, new QTableWidgetItem(outcomes[i].name.c_str()));
+        table->setItem(i, 1, new QTableWidgetItem(QString::number(outcomes[i].infectedMean, 'f', 0) + " +/- " + QString::number(outcomes[i].infectedStandardDeviation, 'f', 0)));
+        table->setItem(i, 2, new QTableWidgetItem(QString::number(outcomes[i].deceasedMean, 'f', 0) + " +/- " + QString::number(outcomes[i].deceasedStandardDeviation, 'f', 0)));
+    }
+
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->resizeColumnsToContents();
+
+    QDialogButtonBox * buttonBox = new QDialogButtonBox(QDialogButtonBox::Close);
+    layout->addWidget(buttonBox);
+
+    connect(buttonBox, SIGNAL(rejected()), &dialog, SLOT(reject()));
+
+    dialog.exec();
+}
@@ -38,6 +38,9 @@ class StockpileNetworkDistributionWidget : public QGroupBox
     private slots:
 
         void execute();
+
+        // evaluate the distribution to each possible destination (and no distribution) from the current simulation state
+        void compareDestinations();
 };
 
 #endif
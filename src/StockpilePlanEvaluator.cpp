@@ -0,0 +1,237 @@
+#include "StockpilePlanEvaluator.h"
+#include "EpidemicSimulation.h"
+#include "StockpileNetwork.h"
+#include "StockpileNetworkDistribution.h"
+#include "models/MersenneTwister.h"
+#include "log.h"
+#include <QtConcurrentMap>
+#include <algorithm>
+#include <cmath>
+
+// a single forward run of a plan, on its own copy of the simulation
+struct StockpilePlanReplicate
+{
+    int planIndex;
+    boost::shared_ptr<EpidemicSimulation> simulation;
+};
+
+struct StockpilePlanReplicateResult
+{
+    int planIndex;
+    double infected;
+    double deceased;
+};
+
+// runs a replicate to the horizon; used from worker threads
+// each replicate only touches its own simulation copy
+struct StockpilePlanReplicateRunner
+{
+    typedef StockpilePlanReplicateResult result_type;
+
+    StockpilePlanReplicateRunner(int horizon, bool hasDeceased) : horizon_(horizon), hasDeceased_(hasDeceased) { }
+
+    StockpilePlanReplicateResult operator()(const StockpilePlanReplicate &replicate) const
+    {
+        boost::shared_ptr<EpidemicSimulation> simulation = replicate.simulation;
+
+        int startTime = simulation->getNumTimes() - 1;
+
+        double susceptible0 = simulation->getValue("susceptible", startTime, NODES_ALL);
+        double deceased0 = 0.;
+
+        if(hasDeceased_ == true)
+        {
+            deceased0 = simulation->getValue("deceased", startTime, NODES_ALL);
+        }
+
+        for(int i=0; i<horizon_; i++)
+        {
+            simulation->simulate();
+        }
+
+        int endTime = simulation->getNumTimes() - 1;
+
+        StockpilePlanReplicateResult result;
+        result.planIndex = replicate.planIndex;
+        result.infected = susceptible0 - simulation->getValue("susceptible", endTime, NODES_ALL);
+        result.deceased = 0.;
+
+        if(hasDeceased_ == true)
+        {
+            result.deceased = simulation->getValue("deceased", endTime, NODES_ALL) - deceased0;
+        }
+
+        return result;
+    }
+
+    int horizon_;
+    bool hasDeceased_;
+};
+
+static bool compareOutcomes(const StockpilePlanOutcome &lhs, const StockpilePlanOutcome &rhs)
+{
+    if(lhs.infectedMean != rhs.infectedMean)
+    {
+        return lhs.infectedMean < rhs.infectedMean;
+    }
+
+    return lhs.deceasedMean < rhs.deceasedMean;
+}
+
+StockpilePlanEvaluator::StockpilePlanEvaluator(boost::shared_ptr<EpidemicSimulation> simulation)
+{
+    simulation_ = simulation;
+
+    // defaults
+    horizon_ = STOCKPILE_PLAN_EVALUATOR_DEFAULT_HORIZON;
+    numReplicates_ = STOCKPILE_PLAN_EVALUATOR_DEFAULT_NUM_REPLICATES;
+}
+
+void StockpilePlanEvaluator::setHorizon(int horizon)
+{
+    horizon_ = horizon;
+}
+
+void StockpilePlanEvaluator::setNumReplicates(int numReplicates)
+{
+    numReplicates_ = numReplicates;
+}
+
+void StockpilePlanEvaluator::addPlan(const StockpilePlan &plan)
+{
+    plans_.push_back(plan);
+}
+
+bool StockpilePlanEvaluator::evaluate(std::vector<StockpilePlanOutcome> &outcomes, QWidget * progressParent)
+{
+    if(simulation_ == NULL || plans_.size() == 0 || numReplicates_ < 1 || horizon_ < 1)
+    {
+        put_flog(LOG_ERROR, "invalid simulation, plans, replicates or horizon");
+        return false;
+    }
+
+    std::vector<std::string> variableNames = simulation_->getVariableNames();
+    bool hasDeceased = (std::find(variableNames.begin(), variableNames.end(), "deceased") != variableNames.end());
+
+    // replicate r of every plan uses the same seed (common random numbers),
+    // so differences between plans are not hidden by differences in random draws
+    MTRand rand;
+
+    std::vector<unsigned long> seeds;
+
+    for(int r=0; r<numReplicates_; r++)
+    {
+        seeds.push_back(rand.randInt());
+    }
+
+    // copying reads the simulation, so all copies are made here before any worker starts
+    QList<StockpilePlanReplicate> replicates;
+
+    for(unsigned int p=0; p<plans_.size(); p++)
+    {
+        for(int r=0; r<numReplicates_; r++)
+        {
+            StockpilePlanReplicate replicate;
+            replicate.planIndex = p;
+            replicate.simulation = simulation_->clone();
+
+            if(replicate.simulation == NULL)
+            {
+                put_flog(LOG_ERROR, "could not copy simulation");
+                return false;
+            }
+
+            replicate.simulation->seed(seeds[r]);
+
+            // add the plan's distributions to the copy's network
+            boost::shared_ptr<StockpileNetwork> network = replicate.simulation->getStockpileNetwork();
+
+            std::map<boost::shared_ptr<Stockpile>, boost::shared_ptr<Stockpile> > stockpileMap = simulation_->getStockpileNetwork()->getStockpileMap(network);
+
+            for(unsigned int d=0; d<plans_[p].distributions.size(); d++)
+            {
+                network->addDistribution(plans_[p].distributions[d]->clone(stockpileMap));
+            }
+
+            replicates.push_back(replicate);
+        }
+    }
+
+    put_flog(LOG_INFO, "evaluating %i plans, %i replicates, %i days", (int)plans_.size(), numReplicates_, horizon_);
+
+    QProgressDialog progressDialog(progressParent);
+    progressDialog.setWindowModality(Qt::WindowModal);
+    progressDialog.setLabelText("Evaluating plans...");
+
+    QFutureWatcher<StockpilePlanReplicateResult> futureWatcher;
+
+    QObject::connect(&futureWatcher, SIGNAL(finished()), &progressDialog, SLOT(reset()));
+    QObject::connect(&progressDialog, SIGNAL(canceled()), &futureWatcher, SLOT(cancel()));
+    QObject::connect(&futureWatcher, SIGNAL(progressRangeChanged(int, int)), &progressDialog, SLOT(setRange(int, int)));
+    QObject::connect(&futureWatcher, SIGNAL(progressValueChanged(int)), &progressDialog, SLOT(setValue(int)));
+
+    futureWatcher.setFuture(QtConcurrent::mapped(replicates, StockpilePlanReplicateRunner(horizon_, hasDeceased)));
+
+    progressDialog.exec();
+
+    futureWatcher.waitForFinished();
+
+    if(futureWatcher.future().isCanceled() == true)
+    {
+        return false;
+    }
+
+    QList<StockpilePlanReplicateResult> results = futureWatcher.future().results();
+
+    // means for each plan
+    std::vector<double> infectedMeans(plans_.size(), 0.);
+    std::vector<double> deceasedMeans(plans_.size(), 0.);
+
+    for(int i=0; i<results.size(); i++)
+    {
+        int p = results[i].planIndex;
+
+        infectedMeans[p] += results[i].infected / (double)numReplicates_;
+        deceasedMeans[p] += results[i].deceased / (double)numReplicates_;
+    }
+
+    // sums of squared deviations from the means for each plan
+    std::vector<double> infectedSquareDeviations(plans_.size(), 0.);
+    std::vector<double> deceasedSquareDeviations(plans_.size(), 0.);
+
+    for(int i=0; i<results.size(); i++)
+    {
+        int p = results[i].planIndex;
+
+        infectedSquareDeviations[p] += (results[i].infected - infectedMeans[p]) * (results[i].infected - infectedMeans[p]);
+        deceasedSquareDeviations[p] += (results[i].deceased - deceasedMeans[p]) * (results[i].deceased - deceasedMeans[p]);
+    }
+
+    outcomes.clear();
+
+    for(unsigned int p=0; p<plans_.size(); p++)
+    {
+        StockpilePlanOutcome outcome;
+        outcome.name = plans_[p].name;
+        outcome.numReplicates = numReplicates_;
+
+        outcome.infectedMean = infectedMeans[p];
+        outcome.infectedStandardDeviation = 0.;
+
+        outcome.deceasedMean = deceasedMeans[p];
+        outcome.deceasedStandardDeviation = 0.;
+
+        // sample standard deviation, with n-1 degrees of freedom
+        if(numReplicates_ > 1)
+        {
+            outcome.infectedStandardDeviation = sqrt(infectedSquareDeviations[p] / (double)(numReplicates_ - 1));
+            outcome.deceasedStandardDeviation = sqrt(deceasedSquareDeviations[p] / (double)(numReplicates_ - 1));
+        }
+
+        outcomes.push_back(outcome);
+    }
+
+    std::stable_sort(outcomes.begin(), outcomes.end(), compareOutcomes);
+
+    return true;
+}
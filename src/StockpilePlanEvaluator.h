@@ -0,0 +1,69 @@
+#ifndef STOCKPILE_PLAN_EVALUATOR_H
+#define STOCKPILE_PLAN_EVALUATOR_H
+
+// defaults for what-if evaluations; short horizons and few replicates keep evaluations interactive
+#define STOCKPILE_PLAN_EVALUATOR_DEFAULT_HORIZON 14
+#define STOCKPILE_PLAN_EVALUATOR_DEFAULT_NUM_REPLICATES 4
+
+#include <QtGui>
+#include <boost/shared_ptr.hpp>
+#include <string>
+#include <vector>
+
+class EpidemicSimulation;
+class StockpileNetworkDistribution;
+
+// a candidate set of distributions
+struct StockpilePlan
+{
+    std::string name;
+
+    // distributions referencing stockpiles of the evaluated simulation's network; they are not added to that network
+    std::vector<boost::shared_ptr<StockpileNetworkDistribution> > distributions;
+};
+
+// expected outcomes of a plan over the evaluation horizon
+// each outcome is a mean and a sample standard deviation (n-1 denominator) over the replicates
+struct StockpilePlanOutcome
+{
+    std::string name;
+
+    int numReplicates;
+
+    // new infections (susceptible individuals becoming exposed) over the horizon
+    double infectedMean;
+    double infectedStandardDeviation;
+
+    // new deaths over the horizon
+    double deceasedMean;
+    double deceasedStandardDeviation;
+};
+
+// plays out candidate plans from the current state of a simulation
+// each plan is run forward for a number of replicates, each on its own copy of the simulation, in worker threads
+class StockpilePlanEvaluator
+{
+    public:
+
+        StockpilePlanEvaluator(boost::shared_ptr<EpidemicSimulation> simulation);
+
+        void setHorizon(int horizon);
+        void setNumReplicates(int numReplicates);
+
+        void addPlan(const StockpilePlan &plan);
+
+        // evaluate all plans; outcomes are ranked by expected new infections, then expected new deaths
+        // progress is shown in a dialog with parent progressParent; returns false on error or cancel
+        bool evaluate(std::vector<StockpilePlanOutcome> &outcomes, QWidget * progressParent=NULL);
+
+    private:
+
+        boost::shared_ptr<EpidemicSimulation> simulation_;
+
+        int horizon_;
+        int numReplicates_;
+
+        std::vector<StockpilePlan> plans_;
+};
+
+#endif
@@ -0,0 +1,143 @@
+#ifndef STRATIFIED_ARRAY_H
+#define STRATIFIED_ARRAY_H
+
+#include <string>
+#include <vector>
+
+// stratifications with extents known at compile time: [age group][risk group][vaccinated]
+//
+// data sets stay shaped by the stratifications file at runtime; models written against a layout check the file with
+// matches() and refuse to run if it differs, so they can index and sum stratifications in fixed-size, fully unrolled
+// loops without allocating
+
+template <int NumAgeGroups, int NumRiskGroups, int NumVaccinatedGroups> struct StratificationLayout
+{
+    enum
+    {
+        numAgeGroups = NumAgeGroups,
+        numRiskGroups = NumRiskGroups,
+        numVaccinatedGroups = NumVaccinatedGroups,
+        size = NumAgeGroups * NumRiskGroups * NumVaccinatedGroups
+    };
+
+    static int getOffset(int ageGroup, int riskGroup, int vaccinated)
+    {
+        return (ageGroup * NumRiskGroups + riskGroup) * NumVaccinatedGroups + vaccinated;
+    }
+
+    // whether stratifications read from the stratifications file have this layout
+    static bool matches(const std::vector<std::vector<std::string> > &stratifications)
+    {
+        return stratifications.size() == 3 && (int)stratifications[0].size() == NumAgeGroups && (int)stratifications[1].size() == NumRiskGroups && (int)stratifications[2].size() == NumVaccinatedGroups;
+    }
+};
+
+// the layout of the distributed stratifications file
+typedef StratificationLayout<5, 2, 2> DefaultStratificationLayout;
+
+// a single stratification (age group, risk group, vaccinated), passed by value in place of a std::vector<int>
+struct StratumIndex
+{
+    explicit StratumIndex(int ageGroup=0, int riskGroup=0, int vaccinated=0) : ageGroup(ageGroup), riskGroup(riskGroup), vaccinated(vaccinated) { }
+
+    // from stratification values with all three dimensions given
+    explicit StratumIndex(const std::vector<int> &stratificationValues) : ageGroup(stratificationValues[0]), riskGroup(stratificationValues[1]), vaccinated(stratificationValues[2]) { }
+
+    // for the data set interfaces taking stratification values
+    std::vector<int> getStratificationValues() const
+    {
+        std::vector<int> stratificationValues(3);
+        stratificationValues[0] = ageGroup;
+        stratificationValues[1] = riskGroup;
+        stratificationValues[2] = vaccinated;
+
+        return stratificationValues;
+    }
+
+    int ageGroup;
+    int riskGroup;
+    int vaccinated;
+};
+
+// a value for each stratification of a layout, stored inline
+template <typename T, typename Layout=DefaultStratificationLayout> class StratifiedArray
+{
+    public:
+
+        StratifiedArray() { }
+
+        explicit StratifiedArray(const T &value)
+        {
+            fill(value);
+        }
+
+        T &operator()(int ageGroup, int riskGroup, int vaccinated)
+        {
+            return values_[Layout::getOffset(ageGroup, riskGroup, vaccinated)];
+        }
+
+        const T &operator()(int ageGroup, int riskGroup, int vaccinated) const
+        {
+            return values_[Layout::getOffset(ageGroup, riskGroup, vaccinated)];
+        }
+
+        T &operator[](const StratumIndex &index)
+        {
+            return values_[Layout::getOffset(index.ageGroup, index.riskGroup, index.vaccinated)];
+        }
+
+        const T &operator[](const StratumIndex &index) const
+        {
+            return values_[Layout::getOffset(index.ageGroup, index.riskGroup, index.vaccinated)];
+        }
+
+        void fill(const T &value)
+        {
+            for(int i=0; i<Layout::size; i++)
+            {
+                values_[i] = value;
+            }
+        }
+
+        T sum() const
+        {
+            T sum = T();
+
+            for(int i=0; i<Layout::size; i++)
+            {
+                sum += values_[i];
+            }
+
+            return sum;
+        }
+
+        // sum over the vaccinated dimension
+        T sum(int ageGroup, int riskGroup) const
+        {
+            T sum = T();
+
+            for(int v=0; v<Layout::numVaccinatedGroups; v++)
+            {
+                sum += values_[Layout::getOffset(ageGroup, riskGroup, v)];
+            }
+
+            return sum;
+        }
+
+        // values in [age group][risk group][vaccinated] order, as in a data set's node slab
+        T * data()
+        {
+            return values_;
+        }
+
+        const T * data() const
+        {
+            return values_;
+        }
+
+    private:
+
+        T values_[Layout::size];
+};
+
+#endif
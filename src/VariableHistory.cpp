@@ -0,0 +1,141 @@
+#include "VariableHistory.h"
+#include "log.h"
+#include <algorithm>
+
+VariableHistory::VariableHistory(int numNodes, int blockSize)
+{
+    numNodes_ = numNodes;
+    blockSize_ = blockSize;
+    numMaskWords_ = (blockSize + 31) / 32;
+    numTimes_ = 0;
+
+    runs_.resize(numNodes);
+    masks_.resize(numNodes);
+    values_.resize(numNodes);
+}
+
+int VariableHistory::getNumTimes() const
+{
+    return numTimes_;
+}
+
+void VariableHistory::append(const int * values)
+{
+    for(int n=0; n<numNodes_; n++)
+    {
+        const int * block = values + n * blockSize_;
+
+        // continue the node's run if its block is unchanged
+        if(numTimes_ > 0 && std::equal(block, block + blockSize_, lastValues_.begin() + n * blockSize_) == true)
+        {
+            continue;
+        }
+
+        Run run;
+        run.time = numTimes_;
+        run.maskOffset = -1;
+        run.valueOffset = values_[n].size();
+
+        std::vector<unsigned int> mask(numMaskWords_, 0);
+        bool zero = true;
+
+        for(int i=0; i<blockSize_; i++)
+        {
+            if(block[i] != 0)
+            {
+                mask[i / 32] |= 1u << (i % 32);
+                values_[n].push_back(block[i]);
+
+                zero = false;
+            }
+        }
+
+        if(zero != true)
+        {
+            run.maskOffset = masks_[n].size();
+            masks_[n].insert(masks_[n].end(), mask.begin(), mask.end());
+        }
+
+        runs_[n].push_back(run);
+    }
+
+    lastValues_.assign(values, values + numNodes_ * blockSize_);
+
+    numTimes_++;
+}
+
+void VariableHistory::getBlock(int time, int nodeIndex, int * values) const
+{
+    std::fill(values, values + blockSize_, 0);
+
+    const unsigned int * mask;
+    const int * nonzeroValues;
+
+    if(findBlock(time, nodeIndex, mask, nonzeroValues) != true)
+    {
+        put_flog(LOG_ERROR, "time %i, node index %i not in history", time, nodeIndex);
+        return;
+    }
+
+    if(mask == NULL)
+    {
+        return;
+    }
+
+    for(int i=0; i<blockSize_; i++)
+    {
+        if((mask[i / 32] & (1u << (i % 32))) != 0)
+        {
+            values[i] = *(nonzeroValues++);
+        }
+    }
+}
+
+void VariableHistory::getTime(int time, int * values) const
+{
+    for(int n=0; n<numNodes_; n++)
+    {
+        getBlock(time, n, values + n * blockSize_);
+    }
+}
+
+bool VariableHistory::findBlock(int time, int nodeIndex, const unsigned int *&mask, const int *&values) const
+{
+    mask = NULL;
+    values = NULL;
+
+    if(time < 0 || time >= numTimes_ || nodeIndex < 0 || nodeIndex >= numNodes_)
+    {
+        return false;
+    }
+
+    const std::vector<Run> &runs = runs_[nodeIndex];
+
+    // the last run starting at or before time; the first run always starts at time 0
+    const Run &run = *(std::upper_bound(runs.begin(), runs.end(), time, compareTime) - 1);
+
+    if(run.maskOffset != -1)
+    {
+        mask = &masks_[nodeIndex][run.maskOffset];
+        values = &values_[nodeIndex][run.valueOffset];
+    }
+
+    return true;
+}
+
+long VariableHistory::getBytes() const
+{
+    long bytes = lastValues_.capacity() * sizeof(int);
+
+    for(int n=0; n<numNodes_; n++)
+    {
+        bytes += runs_[n].capacity() * sizeof(Run) + masks_[n].capacity() * sizeof(unsigned int) + values_[n].capacity() * sizeof(int);
+    }
+
+    return bytes;
+}
+
+bool VariableHistory::compareTime(int time, const Run &run)
+{
+    return time < run.time;
+}
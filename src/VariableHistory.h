@@ -0,0 +1,67 @@
+#ifndef VARIABLE_HISTORY_H
+#define VARIABLE_HISTORY_H
+
+#include <vector>
+
+// compressed past times of a regular variable: for each time, one block of counts per node (the node's
+// stratifications)
+//
+// each node's blocks are run-length encoded over time: a new run starts only when the block changes, so days where a
+// node's values are unchanged (recovered, deceased and population outside the epidemic) cost nothing
+// within a run, all-zero blocks are stored as a flag and other blocks as a bit mask of their nonzero values followed
+// by those values, so unvaccinated or uninfected stratifications are not stored either
+// any time is decoded independently by a binary search over the node's runs; there are no chains of deltas to replay
+class VariableHistory
+{
+    public:
+
+        VariableHistory(int numNodes=0, int blockSize=0);
+
+        // number of times stored, starting at time 0
+        int getNumTimes() const;
+
+        // append the next time: numNodes blocks of blockSize values, node by node
+        void append(const int * values);
+
+        // decode a node's block at time into blockSize values
+        void getBlock(int time, int nodeIndex, int * values) const;
+
+        // decode all blocks at time into numNodes * blockSize values
+        void getTime(int time, int * values) const;
+
+        // a node's block at time in place, without decoding: mask is NULL for an all-zero block, otherwise bit i of the
+        // mask marks value i as nonzero and values are the nonzero values in order
+        // returns false if time or nodeIndex are not valid; does not log, so it can be used by concurrent readers
+        bool findBlock(int time, int nodeIndex, const unsigned int *&mask, const int *&values) const;
+
+        // memory used, in bytes
+        long getBytes() const;
+
+    private:
+
+        int numNodes_;
+        int blockSize_;
+        int numMaskWords_;
+        int numTimes_;
+
+        // a block starting at time and lasting until the next run
+        // maskOffset is -1 for an all-zero block
+        struct Run
+        {
+            int time;
+            int maskOffset;
+            int valueOffset;
+        };
+
+        static bool compareTime(int time, const Run &run);
+
+        // by node index
+        std::vector<std::vector<Run> > runs_;
+        std::vector<std::vector<unsigned int> > masks_;
+        std::vector<std::vector<int> > values_;
+
+        // the last appended time, to detect unchanged blocks
+        std::vector<int> lastValues_;
+};
+
+#endif
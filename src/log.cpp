@@ -1,21 +1,359 @@
 #include "log.h"
+#include <QtCore>
 #include <stdarg.h>
 #include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <string>
 
-void put_log(int level, const char *format, ...)
+// a queued message
+// the queue is a bounded multiple-producer single-consumer ring buffer: each cell's sequence number
+// tells producers when the cell is free and the consumer when it has been written
+// plain data, so the queue is usable before static constructors have run
+struct LogMessage
+{
+    QBasicAtomicInt sequence;
+
+    int level;
+    bool structured;
+    time_t time;
+    const char * function;
+    char text[MAX_LOG_LENGTH];
+};
+
+static LogMessage logQueue[LOG_QUEUE_LENGTH];
+
+// queue positions; only the writer advances the dequeue position
+static QBasicAtomicInt logEnqueuePosition = Q_BASIC_ATOMIC_INITIALIZER(0);
+static QBasicAtomicInt logDequeuePosition = Q_BASIC_ATOMIC_INITIALIZER(0);
+static QBasicAtomicInt logQueueInitialized = Q_BASIC_ATOMIC_INITIALIZER(0);
+
+// messages dropped because the queue was full
+static QBasicAtomicInt logDropped = Q_BASIC_ATOMIC_INITIALIZER(0);
+
+// writer thread state
+enum LOG_WRITER_STATE { LOG_WRITER_NOT_STARTED, LOG_WRITER_STARTING, LOG_WRITER_RUNNING, LOG_WRITER_STOPPED };
+
+static QBasicAtomicInt logWriterState = Q_BASIC_ATOMIC_INITIALIZER(LOG_WRITER_NOT_STARTED);
+
+static const char * getLevelName(int level)
+{
+    switch(level)
+    {
+        case LOG_DEBUG: return "debug";
+        case LOG_INFO: return "info";
+        case LOG_WARN: return "warn";
+        case LOG_ERROR: return "error";
+        case LOG_FATAL: return "fatal";
+        default: return "unknown";
+    }
+}
+
+// "void Class::method(int, int)" -> "Class::method"
+static std::string getShortFunctionName(const char * function)
+{
+    std::string name(function);
+
+    size_t parenthesis = name.find('(');
+
+    if(parenthesis != std::string::npos)
+    {
+        name = name.substr(0, parenthesis);
+    }
+
+    size_t space = name.rfind(' ');
+
+    if(space != std::string::npos)
+    {
+        name = name.substr(space + 1);
+    }
+
+    return name;
+}
+
+// quote a logfmt value
+static std::string quote(const char * value)
+{
+    std::string quoted("\"");
+
+    for(const char * c=value; *c!='\0'; c++)
+    {
+        if(*c == '"' || *c == '\\')
+        {
+            quoted += '\\';
+            quoted += *c;
+        }
+        else if(*c == '\n')
+        {
+            quoted += "\\n";
+        }
+        else
+        {
+            quoted += *c;
+        }
+    }
+
+    quoted += "\"";
+
+    return quoted;
+}
+
+static void writeMessage(int level, bool structured, time_t messageTime, const char * function, const char * text)
+{
+    char timeString[32];
+    strftime(timeString, sizeof(timeString), "%Y-%m-%dT%H:%M:%S", localtime(&messageTime));
+
+    std::string line = std::string("time=") + timeString + " level=" + getLevelName(level) + " func=" + quote(getShortFunctionName(function).c_str());
+
+    if(structured == true)
+    {
+        line += std::string(" ") + text;
+    }
+    else
+    {
+        line += " msg=" + quote(text);
+    }
+
+    fprintf(stderr, "%s\n", line.c_str());
+}
+
+// a load with acquire semantics, pairing with the release stores publishing and freeing cells
+static int loadAcquire(QBasicAtomicInt &value)
+{
+    return value.fetchAndAddAcquire(0);
+}
+
+static void initializeQueue()
+{
+    // cell i is free for the producer at position i
+    for(int i=0; i<LOG_QUEUE_LENGTH; i++)
+    {
+        logQueue[i].sequence.fetchAndStoreRelaxed(i);
+    }
+}
+
+// write all messages completely written by producers; must only be called by one thread at a time
+static void drainQueue()
+{
+    while(true)
+    {
+        int position = logDequeuePosition;
+        LogMessage &message = logQueue[position & (LOG_QUEUE_LENGTH - 1)];
+
+        if(loadAcquire(message.sequence) - (position + 1) != 0)
+        {
+            break;
+        }
+
+        writeMessage(message.level, message.structured, message.time, message.function, message.text);
+
+        // free the cell for the producer one lap later
+        message.sequence.fetchAndStoreRelease(position + LOG_QUEUE_LENGTH);
+        logDequeuePosition.fetchAndStoreRelease(position + 1);
+    }
+
+    int dropped = logDropped.fetchAndStoreRelaxed(0);
+
+    if(dropped > 0)
+    {
+        char text[MAX_LOG_LENGTH];
+        snprintf(text, MAX_LOG_LENGTH, "event=dropped count=%i", dropped);
+
+        writeMessage(LOG_WARN, true, time(NULL), "log", text);
+    }
+
+    fflush(stderr);
+}
+
+class LogWriter : public QThread
+{
+    public:
+
+        LogWriter()
+        {
+            stop_.fetchAndStoreOrdered(0);
+        }
+
+        void stop()
+        {
+            stop_.fetchAndStoreOrdered(1);
+        }
+
+        static void sleepMilliseconds(unsigned long milliseconds)
+        {
+            msleep(milliseconds);
+        }
+
+    protected:
+
+        void run()
+        {
+            while((int)stop_ == 0)
+            {
+                drainQueue();
+                msleep(LOG_WRITER_INTERVAL_MS);
+            }
+
+            drainQueue();
+        }
+
+    private:
+
+        QBasicAtomicInt stop_;
+};
+
+static LogWriter * logWriter = NULL;
+
+// stops the writer and writes remaining messages at exit
+struct LogShutdown
+{
+    ~LogShutdown()
+    {
+        if(logWriterState.testAndSetOrdered(LOG_WRITER_RUNNING, LOG_WRITER_STOPPED) == true)
+        {
+            logWriter->stop();
+            logWriter->wait();
+        }
+        else
+        {
+            logWriterState.fetchAndStoreOrdered(LOG_WRITER_STOPPED);
+        }
+
+        drainQueue();
+    }
+};
+
+static LogShutdown logShutdown;
+
+static void startWriter()
+{
+    if(logWriterState.testAndSetOrdered(LOG_WRITER_NOT_STARTED, LOG_WRITER_STARTING) == true)
+    {
+        logWriter = new LogWriter();
+        logWriter->start(QThread::LowPriority);
+
+        logWriterState.fetchAndStoreOrdered(LOG_WRITER_RUNNING);
+    }
+}
+
+bool log_call_site_allow(LogCallSite * site, int level, const char * function)
+{
+    if(level < LOG_THRESHHOLD)
+    {
+        return false;
+    }
+
+    if(level >= LOG_ERROR)
+    {
+        return true;
+    }
+
+    int now = (int)time(NULL);
+    int windowStart = site->windowStart;
+
+    // first call in a new window resets the count and reports suppressed messages from the previous window
+    if(now != windowStart && site->windowStart.testAndSetOrdered(windowStart, now) == true)
+    {
+        site->count.fetchAndStoreOrdered(0);
+
+        int suppressed = site->suppressed.fetchAndStoreOrdered(0);
+
+        if(suppressed > 0)
+        {
+            put_log(level, function, true, "event=rate_limited suppressed=%i", suppressed);
+        }
+    }
+
+    if(site->count.fetchAndAddOrdered(1) < LOG_RATE_LIMIT_PER_SECOND)
+    {
+        return true;
+    }
+
+    site->suppressed.fetchAndAddOrdered(1);
+
+    return false;
+}
+
+void put_log(int level, const char * function, bool structured, const char * format, ...)
 {
     if(level < LOG_THRESHHOLD)
+    {
         return;
+    }
 
-    char log_string[MAX_LOG_LENGTH];
+    if(logQueueInitialized.testAndSetOrdered(0, 1) == true)
+    {
+        initializeQueue();
+        logQueueInitialized.fetchAndStoreOrdered(2);
+    }
+
+    char text[MAX_LOG_LENGTH];
 
-    // actual log message
     va_list ap;
     va_start(ap, format);
-    vsnprintf(log_string, MAX_LOG_LENGTH, format, ap);
+    vsnprintf(text, MAX_LOG_LENGTH, format, ap);
     va_end(ap);
 
-    fprintf(stderr, "%s\n", log_string);
+    // before the queue is ready or after the writer has stopped, write directly
+    if(logQueueInitialized != 2 || logWriterState == LOG_WRITER_STOPPED)
+    {
+        writeMessage(level, structured, time(NULL), function, text);
+        return;
+    }
+
+    startWriter();
+
+    // claim a cell
+    while(true)
+    {
+        int position = logEnqueuePosition;
+        LogMessage &message = logQueue[position & (LOG_QUEUE_LENGTH - 1)];
+
+        int difference = loadAcquire(message.sequence) - position;
+
+        if(difference == 0)
+        {
+            if(logEnqueuePosition.testAndSetOrdered(position, position + 1) == true)
+            {
+                message.level = level;
+                message.structured = structured;
+                message.time = time(NULL);
+                message.function = function;
+                memcpy(message.text, text, MAX_LOG_LENGTH);
+
+                // publish to the writer
+                message.sequence.fetchAndStoreRelease(position + 1);
+                break;
+            }
+        }
+        else if(difference < 0)
+        {
+            // queue full
+            logDropped.fetchAndAddRelaxed(1);
+            return;
+        }
+    }
+
+    if(level >= LOG_FATAL)
+    {
+        log_flush();
+    }
+}
+
+void log_flush()
+{
+    if(logWriterState == LOG_WRITER_RUNNING)
+    {
+        // wait for the writer to catch up to the current position
+        int position = logEnqueuePosition;
 
-    return;
+        for(int i=0; i<1000 && (int)logDequeuePosition - position < 0; i++)
+        {
+            LogWriter::sleepMilliseconds(1);
+        }
+    }
+    else if(logWriterState != LOG_WRITER_STARTING)
+    {
+        drainQueue();
+    }
 }
@@ -1,22 +1,79 @@
 #ifndef LOG_H
 #define LOG_H
 
+#include <QtCore/qatomic.h>
+
 #define LOG_DEBUG 1
 #define LOG_INFO 2
 #define LOG_WARN 3
 #define LOG_ERROR 4
 #define LOG_FATAL 5
 
+// messages below this level are not compiled in at all; set with -DLOG_COMPILE_LEVEL=...
+#ifndef LOG_COMPILE_LEVEL
+    #define LOG_COMPILE_LEVEL LOG_DEBUG
+#endif
+
+// messages below this level are discarded at runtime
 #define LOG_THRESHHOLD 1
 
 #define MAX_LOG_LENGTH 1024
 
-extern void put_log(int level, const char *format, ...);
+// messages queued for the writer thread; further messages are dropped (and counted) while the queue is full
+// must be a power of 2
+#define LOG_QUEUE_LENGTH 1024
+
+// interval at which the writer thread drains the queue
+#define LOG_WRITER_INTERVAL_MS 20
+
+// maximum messages per second from a single call site; errors and fatal messages are never limited
+// tool results are not log messages and should be written directly, not through put_flog()
+#define LOG_RATE_LIMIT_PER_SECOND 10
+
+// per call site rate limiting state; statically initialized, so safe to use from any thread
+struct LogCallSite
+{
+    QBasicAtomicInt windowStart;
+    QBasicAtomicInt count;
+    QBasicAtomicInt suppressed;
+};
+
+#define LOG_CALL_SITE_INITIALIZER { Q_BASIC_ATOMIC_INITIALIZER(0), Q_BASIC_ATOMIC_INITIALIZER(0), Q_BASIC_ATOMIC_INITIALIZER(0) }
+
+// true if a message from the call site should be logged
+extern bool log_call_site_allow(LogCallSite * site, int level, const char * function);
+
+// queue a message for the writer thread
+// output is one logfmt line per message: level=... func="..." followed by msg="..." or, for structured messages,
+// the formatted key=value fields as given
+extern void put_log(int level, const char * function, bool structured, const char * format, ...);
+
+// write all queued messages; called automatically for fatal messages and at exit
+extern void log_flush();
 
 #ifdef _WIN32
-    #define put_flog(l, fmt, ...) put_log(l, "%s: " fmt, __FUNCTION__, ##__VA_ARGS__)
+    #define LOG_FUNCTION __FUNCTION__
 #else
-    #define put_flog(l, fmt, ...) put_log(l, "%s: " fmt, __PRETTY_FUNCTION__, ##__VA_ARGS__)
+    #define LOG_FUNCTION __PRETTY_FUNCTION__
 #endif
 
+#define LOG_CALL(l, structured, fmt, ...) \
+    do \
+    { \
+        if((l) >= LOG_COMPILE_LEVEL) \
+        { \
+            static LogCallSite logCallSite = LOG_CALL_SITE_INITIALIZER; \
+            if(log_call_site_allow(&logCallSite, l, LOG_FUNCTION) == true) \
+            { \
+                put_log(l, LOG_FUNCTION, structured, fmt, ##__VA_ARGS__); \
+            } \
+        } \
+    } while(0)
+
+// free-form message
+#define put_flog(l, fmt, ...) LOG_CALL(l, false, fmt, ##__VA_ARGS__)
+
+// structured message: fmt is a list of logfmt key=value fields, e.g. put_slog(LOG_INFO, "quantity=%i source=\"%s\"", ...)
+#define put_slog(l, fmt, ...) LOG_CALL(l, true, fmt, ##__VA_ARGS__)
+
 #endif
@@ -1,5 +1,6 @@
 #include "main.h"
 #include "MainWindow.h"
+#include "DataPack.h"
 #include "log.h"
 #include <QtGui>
 #include <QtNetwork/QTcpSocket>
@@ -35,6 +36,12 @@ int main(int argc, char * argv[])
 
     put_flog(LOG_DEBUG, "data directory: %s", g_dataDirectory.c_str());
 
+    // regenerate the data pack for faster startups; failure (e.g. read-only data directory) is not fatal
+    if(DataPack::update() != true)
+    {
+        put_flog(LOG_WARN, "could not update data pack");
+    }
+
     // disable VTK console messages
     vtkObject::GlobalWarningDisplayOff();
 
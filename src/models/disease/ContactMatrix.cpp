@@ -0,0 +1,78 @@
+#include "ContactMatrix.h"
+#include "../../main.h"
+#include "../../DataPack.h"
+#include "../../log.h"
+
+// built-in values for 5 age groups, used if the data files are missing
+static const int defaultNumAgeGroups = 5;
+
+static const double defaultContactRates[defaultNumAgeGroups * defaultNumAgeGroups] = {
+    45.1228487783,8.7808312353,11.7757947836,6.10114751268,4.02227175596,
+    8.7808312353,41.2889143668,13.3332813497,7.847051289,4.22656343551,
+    11.7757947836,13.3332813497,21.4270155984,13.7392636644,6.92483172729,
+    6.10114751268,7.847051289,13.7392636644,18.0482119252,9.45371062356,
+    4.02227175596,4.22656343551,6.92483172729,9.45371062356,14.0529294262 };
+
+static const double defaultSusceptibilities[defaultNumAgeGroups] = { 1.00, 0.98, 0.94, 0.91, 0.66 };
+
+ContactMatrix::ContactMatrix(int numAgeGroups)
+{
+    numAgeGroups_ = numAgeGroups;
+
+    if(numAgeGroups_ <= 0)
+    {
+        return;
+    }
+
+    std::vector<float> contactRates;
+    std::vector<float> susceptibilities;
+
+    // use the data pack if it is current, otherwise read the source files
+    boost::shared_ptr<DataPack> dataPack = DataPack::open();
+
+    if(dataPack != NULL)
+    {
+        contactRates = dataPack->getFloats("contactRates");
+        susceptibilities = dataPack->getFloats("susceptibilities");
+    }
+    else
+    {
+        contactRates = DataPack::readValuesFile(g_dataDirectory + "/" + CONTACT_MATRIX_FILENAME);
+        susceptibilities = DataPack::readValuesFile(g_dataDirectory + "/" + CONTACT_MATRIX_SUSCEPTIBILITIES_FILENAME);
+    }
+
+    if((int)contactRates.size() == numAgeGroups_ * numAgeGroups_ && (int)susceptibilities.size() == numAgeGroups_)
+    {
+        contactRates_.assign(contactRates.begin(), contactRates.end());
+        susceptibilities_.assign(susceptibilities.begin(), susceptibilities.end());
+    }
+    else if(numAgeGroups_ == defaultNumAgeGroups)
+    {
+        put_flog(LOG_WARN, "no contact matrix for %i age groups (%i contact rates, %i susceptibilities), using built-in values", numAgeGroups_, (int)contactRates.size(), (int)susceptibilities.size());
+
+        contactRates_.assign(defaultContactRates, defaultContactRates + defaultNumAgeGroups * defaultNumAgeGroups);
+        susceptibilities_.assign(defaultSusceptibilities, defaultSusceptibilities + defaultNumAgeGroups);
+    }
+    else
+    {
+        put_flog(LOG_ERROR, "no contact matrix for %i age groups (%i contact rates, %i susceptibilities)", numAgeGroups_, (int)contactRates.size(), (int)susceptibilities.size());
+
+        contactRates_.assign(numAgeGroups_ * numAgeGroups_, 0.);
+        susceptibilities_.assign(numAgeGroups_, 0.);
+    }
+}
+
+int ContactMatrix::getNumAgeGroups() const
+{
+    return numAgeGroups_;
+}
+
+double ContactMatrix::getContactRate(int sourceAgeGroup, int targetAgeGroup) const
+{
+    return contactRates_[sourceAgeGroup * numAgeGroups_ + targetAgeGroup];
+}
+
+double ContactMatrix::getSusceptibility(int ageGroup) const
+{
+    return susceptibilities_[ageGroup];
+}
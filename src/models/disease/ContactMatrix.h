@@ -0,0 +1,38 @@
+#ifndef CONTACT_MATRIX_H
+#define CONTACT_MATRIX_H
+
+#include <vector>
+
+// source files in the data directory, read as whitespace-separated values
+// contacts: a row for each source age group, a column for each target age group
+// susceptibilities: one value for each age group
+#define CONTACT_MATRIX_FILENAME "contact_matrix.txt"
+#define CONTACT_MATRIX_SUSCEPTIBILITIES_FILENAME "age_group_susceptibilities.txt"
+
+// age group contact rates and susceptibilities used for transmission
+// loaded from the data pack if it is current, otherwise from the source files; built-in values are used if neither
+// has a value for each age group
+class ContactMatrix
+{
+    public:
+
+        ContactMatrix(int numAgeGroups=0);
+
+        int getNumAgeGroups() const;
+
+        // contacts per day of an individual of sourceAgeGroup with individuals of targetAgeGroup
+        double getContactRate(int sourceAgeGroup, int targetAgeGroup) const;
+
+        // relative susceptibility of individuals of ageGroup
+        double getSusceptibility(int ageGroup) const;
+
+    private:
+
+        int numAgeGroups_;
+
+        // [sourceAgeGroup * numAgeGroups_ + targetAgeGroup]
+        std::vector<double> contactRates_;
+        std::vector<double> susceptibilities_;
+};
+
+#endif
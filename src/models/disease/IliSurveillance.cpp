@@ -0,0 +1,217 @@
+#include "IliSurveillance.h"
+#include "../../main.h"
+#include "../../DataPack.h"
+#include "../../log.h"
+#include <algorithm>
+
+IliSurveillance::IliSurveillance()
+{
+    std::vector<int> numProviders;
+    std::vector<float> startProbabilities;
+    std::vector<float> stopProbabilities;
+
+    // use the data pack if it is current, otherwise read the source files
+    boost::shared_ptr<DataPack> dataPack = DataPack::open();
+
+    if(dataPack != NULL)
+    {
+        numProviders = dataPack->getInts("iliNumCountyProviders");
+        startProbabilities = dataPack->getFloats("iliProviderStartProbabilities");
+        stopProbabilities = dataPack->getFloats("iliProviderStopProbabilities");
+        noise_ = dataPack->getFloats("iliProviderNoise");
+    }
+    else
+    {
+        std::vector<float> numProvidersValues = DataPack::readValuesFile(g_dataDirectory + "/ILI/numCountyProviders.txt");
+        numProviders.assign(numProvidersValues.begin(), numProvidersValues.end());
+
+        startProbabilities = DataPack::readValuesFile(g_dataDirectory + "/ILI/providerStartProbabilities.txt");
+        stopProbabilities = DataPack::readValuesFile(g_dataDirectory + "/ILI/providerStopProbabilities.txt");
+        noise_ = DataPack::readValuesFile(g_dataDirectory + "/ILI/providerNoiseData.txt");
+    }
+
+    if(noise_.size() == 0)
+    {
+        put_flog(LOG_ERROR, "no ILI provider noise data");
+        noise_.push_back(0.);
+    }
+
+    noiseSecondMoment_ = 0.;
+
+    for(unsigned int i=0; i<noise_.size(); i++)
+    {
+        noiseSecondMoment_ += noise_[i] * noise_[i] / (float)noise_.size();
+    }
+
+    // flat provider arrays
+    providerOffsets_.push_back(0);
+
+    for(unsigned int i=0; i<numProviders.size(); i++)
+    {
+        std::vector<float> starts = sample(startProbabilities, numProviders[i]);
+        std::vector<float> stops = sample(stopProbabilities, numProviders[i]);
+
+        startProbabilities_.insert(startProbabilities_.end(), starts.begin(), starts.end());
+        continueProbabilities_.insert(continueProbabilities_.end(), stops.begin(), stops.end());
+
+        providerOffsets_.push_back(startProbabilities_.size());
+    }
+
+    // all providers initially reporting
+    status_.assign(startProbabilities_.size(), 1);
+
+    put_flog(LOG_DEBUG, "%i providers in %i nodes", (int)status_.size(), getNumNodes());
+}
+
+void IliSurveillance::seed(unsigned long seed)
+{
+    rand_.seed((MTRand::uint32)seed);
+}
+
+int IliSurveillance::getNumNodes()
+{
+    return (int)providerOffsets_.size() - 1;
+}
+
+int IliSurveillance::getNumProviders(int nodeIndex)
+{
+    if(nodeIndex < 0 || nodeIndex >= getNumNodes())
+    {
+        return 0;
+    }
+
+    return providerOffsets_[nodeIndex + 1] - providerOffsets_[nodeIndex];
+}
+
+void IliSurveillance::step(const std::vector<float> &infectious, const std::vector<float> &population, std::vector<float> &reports)
+{
+    int numNodes = std::min<int>(getNumNodes(), infectious.size());
+
+    // advance status of all providers: one uniform draw per provider
+    for(unsigned int p=0; p<status_.size(); p++)
+    {
+        float probability = status_[p] ? continueProbabilities_[p] : startProbabilities_[p];
+
+        status_[p] = (rand_.randExc() < probability) ? 1 : 0;
+    }
+
+    for(int i=0; i<numNodes; i++)
+    {
+        int begin = providerOffsets_[i];
+        int end = providerOffsets_[i + 1];
+
+        if(begin == end)
+        {
+            reports[i] = 0.;
+            continue;
+        }
+
+        // each reporting provider reports the infectious count plus noise (truncated at zero)
+        // non-reporting providers contribute zero, so no noise is drawn for them
+        float sum = 0.;
+
+        for(int p=begin; p<end; p++)
+        {
+            if(status_[p] != 0)
+            {
+                float report = infectious[i] + (float)rand_.randNorm(0., noise_[rand_.randInt(noise_.size() - 1)]);
+
+                if(report > 0.)
+                {
+                    sum += report;
+                }
+            }
+        }
+
+        // average over all providers
+        reports[i] = sum / (float)(end - begin) / population[i];
+    }
+}
+
+void IliSurveillance::getReportMoments(int nodeIndex, const std::vector<float> &infectious, float &mean, float &variance)
+{
+    mean = variance = 0.;
+
+    int numProviders = getNumProviders(nodeIndex);
+
+    if(numProviders == 0)
+    {
+        return;
+    }
+
+    int begin = providerOffsets_[nodeIndex];
+
+    getReportMoments(&startProbabilities_[begin], &continueProbabilities_[begin], numProviders, noiseSecondMoment_, infectious, mean, variance);
+}
+
+void IliSurveillance::getReportMoments(const float * startProbabilities, const float * continueProbabilities, int numProviders, float noiseSecondMoment, const std::vector<float> &infectious, float &mean, float &variance)
+{
+    mean = variance = 0.;
+
+    int numDays = infectious.size();
+
+    if(numProviders == 0 || numDays == 0)
+    {
+        return;
+    }
+
+    // provider p reports B_pt * (infectious_t + noise_pt) on day t, with B_pt its reporting status
+    double sumMean = 0.;
+    double sumVariance = 0.;
+
+    for(int p=0; p<numProviders; p++)
+    {
+        // stationary probability of the two-state reporting chain, and its autocorrelation at lag 1
+        double denominator = startProbabilities[p] + 1. - continueProbabilities[p];
+        double reporting = 1.;
+        double autocorrelation = 0.;
+
+        if(denominator > 0.)
+        {
+            reporting = startProbabilities[p] / denominator;
+            autocorrelation = continueProbabilities[p] - startProbabilities[p];
+        }
+
+        double statusVariance = reporting * (1. - reporting);
+
+        for(int t=0; t<numDays; t++)
+        {
+            sumMean += reporting * infectious[t];
+            sumVariance += reporting * noiseSecondMoment + statusVariance * infectious[t] * infectious[t];
+
+            // covariance with later days, through the status only
+            double lagCorrelation = 1.;
+
+            for(int u=t+1; u<numDays; u++)
+            {
+                lagCorrelation *= autocorrelation;
+
+                sumVariance += 2. * statusVariance * lagCorrelation * infectious[t] * infectious[u];
+            }
+        }
+    }
+
+    // average over all providers and days
+    double n = (double)numProviders * (double)numDays;
+
+    mean = (float)(sumMean / n);
+    variance = (float)(sumVariance / (n * n));
+}
+
+std::vector<float> IliSurveillance::sample(const std::vector<float> &values, int n)
+{
+    std::vector<float> samples;
+
+    if(values.size() == 0)
+    {
+        put_flog(LOG_ERROR, "no values to sample from");
+        return std::vector<float>(n, 0.);
+    }
+
+    for(int i=0; i<n; i++)
+    {
+        samples.push_back(values[rand_.randInt(values.size() - 1)]);
+    }
+
+    return samples;
+}
@@ -0,0 +1,61 @@
+#ifndef ILI_SURVEILLANCE_H
+#define ILI_SURVEILLANCE_H
+
+#include "../MersenneTwister.h"
+#include <vector>
+
+// influenza-like illness (ILI) surveillance through a network of reporting providers
+// each simulation owns its own instance (state and random number generator), so simulations can run concurrently
+class IliSurveillance
+{
+    public:
+
+        // loads provider data and samples provider start / stop probabilities for each node
+        IliSurveillance();
+
+        // copies must be seeded before use: the generator state is copied but not its position
+        void seed(unsigned long seed);
+
+        int getNumNodes();
+        int getNumProviders(int nodeIndex);
+
+        // advance provider reporting status one day and compute reported ILI as a fraction of population for each node
+        // infectious, population and reports are indexed by node index; reports must have getNumNodes() entries
+        void step(const std::vector<float> &infectious, const std::vector<float> &population, std::vector<float> &reports);
+
+        // mean and variance of the average of a node's reports (as counts: the report fraction times population) over
+        // consecutive days, given the infectious count of each day; used as an observation model for calibration
+        // each provider's reporting status is taken to be its two-state chain at stationarity, so reports of different
+        // days are correlated: status persists with lag-k autocorrelation (continue - start probability)^k
+        // report noise is independent between days, and truncation of reports at zero is ignored, which overstates
+        // the variance slightly when infectious is small
+        void getReportMoments(int nodeIndex, const std::vector<float> &infectious, float &mean, float &variance);
+
+        // the same for numProviders providers with the given probabilities and mean squared noise standard deviation
+        static void getReportMoments(const float * startProbabilities, const float * continueProbabilities, int numProviders, float noiseSecondMoment, const std::vector<float> &infectious, float &mean, float &variance);
+
+    private:
+
+        MTRand rand_;
+
+        // providers of node index i are [providerOffsets_[i], providerOffsets_[i+1])
+        std::vector<int> providerOffsets_;
+
+        // per provider: probability of starting to report if not reporting, probability of continuing if reporting
+        std::vector<float> startProbabilities_;
+        std::vector<float> continueProbabilities_;
+
+        // per provider: 1 if reporting, 0 otherwise
+        std::vector<unsigned char> status_;
+
+        // empirical distribution of report noise standard deviations
+        std::vector<float> noise_;
+
+        // mean of the squared noise standard deviations
+        float noiseSecondMoment_;
+
+        // random sample of n values from values
+        std::vector<float> sample(const std::vector<float> &values, int n);
+};
+
+#endif
@@ -6,12 +6,13 @@
 #include "../../PriorityGroup.h"
 #include "../../PriorityGroupSelections.h"
 #include "../../Npi.h"
+#include "../../RegionData.h"
 #include "../../log.h"
 #include <boost/bind.hpp>
 
-const int StochasticSEATIRD::numAgeGroups_ = 5;
-const int StochasticSEATIRD::numRiskGroups_ = 2;
-const int StochasticSEATIRD::numVaccinatedGroups_ = 2;
+const int StochasticSEATIRD::numAgeGroups_;
+const int StochasticSEATIRD::numRiskGroups_;
+const int StochasticSEATIRD::numVaccinatedGroups_;
 
 StochasticSEATIRD::StochasticSEATIRD()
 {
@@ -20,6 +21,8 @@ StochasticSEATIRD::StochasticSEATIRD()
     // defaults
     cachedTime_ = -1;
 
+    contactMatrix_ = ContactMatrix(StochasticSEATIRD::numAgeGroups_);
+
     // create other required variables for this model
     newVariable("asymptomatic");
     newVariable("treatable");
@@ -39,14 +42,21 @@ StochasticSEATIRD::StochasticSEATIRD()
     // need to keep track of number vaccinated each day
     newVariable("vaccinated (daily)");
 
+    // the "vaccinated" variable keeps track of those vaccinated; vaccine latency periods are differences of it
+    newVariable("vaccinated");
+
     // derived variables
-    derivedVariables_["All infected"] = boost::bind(&StochasticSEATIRD::getDerivedVarInfected, this, _1, _2, _3);
-    derivedVariables_["vaccinated in lag period"] = boost::bind(&StochasticSEATIRD::getDerivedVarPopulationInVaccineLatencyPeriod, this, _1, _2, _3);
-    derivedVariables_["vaccinated effective"] = boost::bind(&StochasticSEATIRD::getDerivedVarPopulationEffectiveVaccines, this, _1, _2, _3);
-    derivedVariables_["ILI reports"] = boost::bind(&StochasticSEATIRD::getDerivedVarILI, this, _1, _2, _3);
+    bindDerivedVariables();
 
-    // initialize ILI
-    iliProviders_ = iliInit();
+    // create a priority group selection for all of the population, for pure pro-rata treatments
+    std::vector<int> stratificationValues(1, STRATIFICATIONS_ALL);
+    std::vector<std::vector<int> > stratificationVectorValues(3, stratificationValues);
+    boost::shared_ptr<PriorityGroup> priorityGroupAll = boost::shared_ptr<PriorityGroup>(new PriorityGroup("_ALL_", stratificationVectorValues));
+    priorityGroupSelectionsAll_ = boost::shared_ptr<PriorityGroupSelections>(new PriorityGroupSelections(std::vector<boost::shared_ptr<PriorityGroup> >(1, priorityGroupAll)));
+
+    // event types counted in the profile, in StochasticSEATIRDEventType order
+    const char * eventTypeNames[] = { "none", "EtoA", "AtoT", "AtoR", "AtoD", "TtoI", "TtoR", "TtoD", "ItoR", "ItoD", "contact" };
+    profile_.setEventTypeNames(std::vector<std::string>(eventTypeNames, eventTypeNames + sizeof(eventTypeNames) / sizeof(eventTypeNames[0])));
 
     // initialize ILI values to zero
     std::vector<float> iliValues;
@@ -67,6 +77,43 @@ StochasticSEATIRD::StochasticSEATIRD()
     randGenerator_ = gsl_rng_alloc(gsl_rng_default);
 }
 
+StochasticSEATIRD::StochasticSEATIRD(const StochasticSEATIRD &simulation) : EpidemicSimulation(simulation), contactMatrix_(simulation.contactMatrix_), iliSurveillance_(simulation.iliSurveillance_)
+{
+    put_flog(LOG_DEBUG, "");
+
+    bindDerivedVariables();
+
+    time_ = simulation.time_;
+    now_ = simulation.now_;
+
+    scheduleEventQueues_ = simulation.scheduleEventQueues_;
+
+    cachedTime_ = simulation.cachedTime_;
+
+    // selections are immutable and can be shared
+    priorityGroupSelectionsAll_ = simulation.priorityGroupSelectionsAll_;
+
+    blitz::Array<double, 1> populationNodes = simulation.populationNodes_.copy();
+    populationNodes_.reference(populationNodes);
+
+    blitz::Array<int, 1+NUM_STRATIFICATION_DIMENSIONS> populations = simulation.populations_.copy();
+    populations_.reference(populations);
+
+    blitz::Array<int, 1+NUM_STRATIFICATION_DIMENSIONS-1> vaccineLatencyPopulations = simulation.vaccineLatencyPopulations_.copy();
+    vaccineLatencyPopulations_.reference(vaccineLatencyPopulations);
+
+    blitz::Array<double, 4> transmissionRates = simulation.transmissionRates_.copy();
+    transmissionRates_.reference(transmissionRates);
+
+    iliValues_ = simulation.iliValues_;
+
+    // new random number generators; the copy's random streams are independent of the original
+    gsl_rng_env_setup();
+    randGenerator_ = gsl_rng_alloc(gsl_rng_default);
+
+    seed(rand_.randInt());
+}
+
 StochasticSEATIRD::~StochasticSEATIRD()
 {
     put_flog(LOG_DEBUG, "");
@@ -74,7 +121,20 @@ StochasticSEATIRD::~StochasticSEATIRD()
     gsl_rng_free(randGenerator_);
 }
 
-int StochasticSEATIRD::expose(int num, int nodeId, std::vector<int> stratificationValues)
+boost::shared_ptr<EpidemicSimulation> StochasticSEATIRD::clone()
+{
+    return boost::shared_ptr<EpidemicSimulation>(new StochasticSEATIRD(*this));
+}
+
+void StochasticSEATIRD::seed(unsigned long seed)
+{
+    rand_.seed((MTRand::uint32)seed);
+    gsl_rng_set(randGenerator_, seed);
+
+    iliSurveillance_.seed(rand_.randInt());
+}
+
+int StochasticSEATIRD::expose(int num, int nodeId, const std::vector<int> &stratificationValues)
 {
     // expose() can be called outside of a simulation before we've simulated any time steps
     if(time_ == 0 && cachedTime_ == -1)
@@ -97,7 +157,7 @@ int StochasticSEATIRD::expose(int num, int nodeId, std::vector<int> stratificati
     // create events based on these new exposures
     for(int i=0; i<numExposed; i++)
     {
-        StochasticSEATIRDSchedule schedule(now_, rand_, stratificationValues);
+        StochasticSEATIRDSchedule schedule(now_, rand_, getParameters(), stratificationValues);
 
         initializeContactEvents(schedule, nodeId, stratificationValues);
 
@@ -105,6 +165,8 @@ int StochasticSEATIRD::expose(int num, int nodeId, std::vector<int> stratificati
         scheduleEventQueues_[nodeId].push(schedule);
     }
 
+    profile_.countExposures(numExposed);
+
     return numExposed;
 }
 
@@ -113,6 +175,8 @@ void StochasticSEATIRD::simulate()
     // we are simulating from time_ to time_+1
     now_ = (double)time_;
 
+    profile_.beginDay(time_+1);
+
     // base class simulate(): copies variables to new time step (time_+1) and evolves stockpile network
     EpidemicSimulation::simulate();
 
@@ -126,34 +190,43 @@ void StochasticSEATIRD::simulate()
 
     // apply treatments
 
-    // create a priority group selection for all of the population, for pure pro-rata treatments
-    std::vector<int> stratificationValues(1, STRATIFICATIONS_ALL);
-    std::vector<std::vector<int> > stratificationVectorValues(3, stratificationValues);
-    boost::shared_ptr<PriorityGroup> priorityGroupAll = boost::shared_ptr<PriorityGroup>(new PriorityGroup("_ALL_", stratificationVectorValues));
-    boost::shared_ptr<PriorityGroupSelections> priorityGroupSelectionsAll(new PriorityGroupSelections(std::vector<boost::shared_ptr<PriorityGroup> >(1, priorityGroupAll)));
-
     // reset number treated for today
     // do this here since we may have multiple treatments in one day
-    variables_["treated (daily)"](time_+1, blitz::Range::all(), blitz::Range::all(), blitz::Range::all(), blitz::Range::all()) = 0.;
-    variables_["treated (ineffective daily)"](time_+1, blitz::Range::all(), blitz::Range::all(), blitz::Range::all(), blitz::Range::all()) = 0.;
-    variables_["vaccinated (daily)"](time_+1, blitz::Range::all(), blitz::Range::all(), blitz::Range::all(), blitz::Range::all()) = 0.;
+    variables_["treated (daily)"](getDenseTimeIndex(time_+1), blitz::Range::all(), blitz::Range::all(), blitz::Range::all(), blitz::Range::all()) = 0.;
+    variables_["treated (ineffective daily)"](getDenseTimeIndex(time_+1), blitz::Range::all(), blitz::Range::all(), blitz::Range::all(), blitz::Range::all()) = 0.;
+    variables_["vaccinated (daily)"](getDenseTimeIndex(time_+1), blitz::Range::all(), blitz::Range::all(), blitz::Range::all(), blitz::Range::all()) = 0.;
 
     // apply treatments to priority group selections; then remaining to the entire population
-    applyAntiviralsToPriorityGroupSelections(g_parameters.getAntiviralPriorityGroupSelections());
-    applyAntiviralsToPriorityGroupSelections(priorityGroupSelectionsAll);
+    profile_.beginPhase(SIMULATION_PHASE_ANTIVIRALS);
+
+    applyAntiviralsToPriorityGroupSelections(getParameters().getAntiviralPriorityGroupSelections());
+    applyAntiviralsToPriorityGroupSelections(priorityGroupSelectionsAll_);
+
+    profile_.endPhase(SIMULATION_PHASE_ANTIVIRALS);
+    profile_.beginPhase(SIMULATION_PHASE_VACCINES);
 
-    applyVaccinesToPriorityGroupSelections(g_parameters.getVaccinePriorityGroupSelections());
-    applyVaccinesToPriorityGroupSelections(priorityGroupSelectionsAll);
+    applyVaccinesToPriorityGroupSelections(getParameters().getVaccinePriorityGroupSelections());
+    applyVaccinesToPriorityGroupSelections(priorityGroupSelectionsAll_);
+
+    profile_.endPhase(SIMULATION_PHASE_VACCINES);
 
     // pre-compute some frequently used values
     // this should be done after applyVaccines() since individuals may be changing stratifications
     // we operate on the new time step (time_+1) to capture such stratification changes
+    profile_.beginPhase(SIMULATION_PHASE_PRECOMPUTE);
+
     precompute(time_+1);
 
+    profile_.endPhase(SIMULATION_PHASE_PRECOMPUTE);
+
+    const std::vector<int> &nodeIds = regionData_->getNodeIds();
+
     // process events for each node
-    for(unsigned int i=0; i<nodeIds_.size(); i++)
+    profile_.beginPhase(SIMULATION_PHASE_EVENTS);
+
+    for(unsigned int i=0; i<nodeIds.size(); i++)
     {
-        int nodeId = nodeIds_[i];
+        int nodeId = nodeIds[i];
 
         while(scheduleEventQueues_[nodeId].empty() != true && scheduleEventQueues_[nodeId].top().getTopEvent().time < (double)time_+1.)
         {
@@ -173,6 +246,8 @@ void StochasticSEATIRD::simulate()
 
                 processEvent(nodeId, event);
 
+                profile_.countEvent(event.type);
+
                 // re-insert the schedule back into the schedule queue
                 // it will be sorted corresponding to its next event
                 if(schedule.empty() != true)
@@ -183,33 +258,58 @@ void StochasticSEATIRD::simulate()
         }
     }
 
+    profile_.endPhase(SIMULATION_PHASE_EVENTS);
+
     // current event time is now the end of the current day
     now_ = (double)time_ + 1.;
 
     // travel between nodes
+    profile_.beginPhase(SIMULATION_PHASE_TRAVEL);
+
     travel();
 
+    profile_.endPhase(SIMULATION_PHASE_TRAVEL);
+
     // ILI
-    std::vector<float> infectious;
-    std::vector<float> population;
+    profile_.beginPhase(SIMULATION_PHASE_ILI);
 
-    std::vector<int> nodeIds = getNodeIds();
+    std::vector<float> infectious(nodeIds.size());
+    std::vector<float> population(nodeIds.size());
 
     for(unsigned int i=0; i<nodeIds.size(); i++)
     {
-        infectious.push_back(getDerivedVarInfected(time_, nodeIds[i]));
-        population.push_back(getPopulation(nodeIds[i]));
+        infectious[i] = getDerivedVarInfected(time_, nodeIds[i]);
+        population[i] = getPopulation(nodeIds[i]);
     }
 
-    std::vector<float> iliValues = iliView(infectious, population, iliProviders_);
+    std::vector<float> iliValues(nodeIds.size(), 0.);
+
+    iliSurveillance_.step(infectious, population, iliValues);
 
     iliValues_.push_back(iliValues);
 
+    profile_.endPhase(SIMULATION_PHASE_ILI);
+
+    // queue sizes are only counted when profiling
+    if(profile_.isEnabled() == true)
+    {
+        int queueSize = 0;
+
+        for(unsigned int i=0; i<nodeIds.size(); i++)
+        {
+            queueSize += scheduleEventQueues_[nodeIds[i]].size();
+        }
+
+        profile_.setQueueSize(queueSize);
+    }
+
+    profile_.endDay();
+
     // increment current time
     time_++;
 }
 
-float StochasticSEATIRD::getDerivedVarInfected(int time, int nodeId, std::vector<int> stratificationValues)
+float StochasticSEATIRD::getDerivedVarInfected(int time, int nodeId, const std::vector<int> &stratificationValues)
 {
     float infected = 0.;
     infected += getValue("asymptomatic", time, nodeId, stratificationValues);
@@ -219,27 +319,32 @@ float StochasticSEATIRD::getDerivedVarInfected(int time, int nodeId, std::vector
     return infected;
 }
 
-float StochasticSEATIRD::getDerivedVarPopulationInVaccineLatencyPeriod(int time, int nodeId, std::vector<int> stratificationValues)
+float StochasticSEATIRD::getDerivedVarPopulationInVaccineLatencyPeriod(int time, int nodeId, const std::vector<int> &stratificationValues)
 {
     // should match the other getPopulationInVaccineLatencyPeriod() method below
 
     // no need to limit to vaccinated stratification, since non-vaccinated will always be zero for this variable
 
-    int vaccineLatencyPeriod = g_parameters.getVaccineLatencyPeriod();
+    int vaccineLatencyPeriod = getParameters().getVaccineLatencyPeriod();
+
+    // vaccinated in (time - vaccineLatencyPeriod, time]
+    // a 0 day latency period will always return 0, as expected
+    if(vaccineLatencyPeriod <= 0)
+    {
+        return 0.;
+    }
 
-    float total = 0;
+    float total = getValue("vaccinated", time, nodeId, stratificationValues);
 
-    // with these inequalities, a 0 day latency period will always return 0, as expected
-    for(int t=time; t>=0 && t>(time - vaccineLatencyPeriod); t--)
+    if(time - vaccineLatencyPeriod >= 0)
     {
-        // vaccinated stratification == 1
-        total += getValue("vaccinated (daily)", t, nodeId, stratificationValues);
+        total -= getValue("vaccinated", time - vaccineLatencyPeriod, nodeId, stratificationValues);
     }
 
     return total;
 }
 
-float StochasticSEATIRD::getDerivedVarPopulationEffectiveVaccines(int time, int nodeId, std::vector<int> stratificationValues)
+float StochasticSEATIRD::getDerivedVarPopulationEffectiveVaccines(int time, int nodeId, const std::vector<int> &stratificationValues)
 {
     // vaccinated stratification == 1
     // return 0 if unvaccinated stratification was explicitly specified
@@ -249,48 +354,93 @@ float StochasticSEATIRD::getDerivedVarPopulationEffectiveVaccines(int time, int
     }
 
     // make sure stratifications size is full and choose vaccinated stratification
-    for(unsigned int i=stratificationValues.size(); i<3; i++)
+    std::vector<int> vaccinatedStratificationValues(stratificationValues);
+
+    for(unsigned int i=vaccinatedStratificationValues.size(); i<3; i++)
     {
-        stratificationValues.push_back(STRATIFICATIONS_ALL);
+        vaccinatedStratificationValues.push_back(STRATIFICATIONS_ALL);
     }
 
-    stratificationValues[2] = 1;
+    vaccinatedStratificationValues[2] = 1;
 
-    return getValue("population", time, nodeId, stratificationValues) - getDerivedVarPopulationInVaccineLatencyPeriod(time, nodeId, stratificationValues);
+    return getValue("population", time, nodeId, vaccinatedStratificationValues) - getDerivedVarPopulationInVaccineLatencyPeriod(time, nodeId, vaccinatedStratificationValues);
 }
 
-float StochasticSEATIRD::getDerivedVarILI(int time, int nodeId, std::vector<int> stratificationValues)
+float StochasticSEATIRD::getDerivedVarILI(int time, int nodeId, const std::vector<int> &stratificationValues)
 {
-    return iliValues_[time][nodeIdToIndex_[nodeId]] * getPopulation(nodeId);
+    if(nodeId == NODES_ALL)
+    {
+        std::vector<int> nodeIds = getNodeIds();
+
+        float total = 0.;
+
+        for(unsigned int i=0; i<nodeIds.size(); i++)
+        {
+            total += getDerivedVarILI(time, nodeIds[i], stratificationValues);
+        }
+
+        return total;
+    }
+
+    // reports are not stratified; they are attributed to the first stratum so sums over strata are correct
+    for(unsigned int i=0; i<stratificationValues.size(); i++)
+    {
+        if(stratificationValues[i] != STRATIFICATIONS_ALL && stratificationValues[i] != 0)
+        {
+            return 0.;
+        }
+    }
+
+    int nodeIndex = getNodeIndex(nodeId);
+
+    if(nodeIndex == -1)
+    {
+        return 0.;
+    }
+
+    return iliValues_[time][nodeIndex] * getPopulation(nodeId);
 }
 
-std::vector<Provider> StochasticSEATIRD::getIliProviders()
+int StochasticSEATIRD::getNumIliProviders(int nodeId)
 {
-    return iliProviders_;
+    return iliSurveillance_.getNumProviders(getNodeIndex(nodeId));
 }
 
-void StochasticSEATIRD::initializeContactEvents(StochasticSEATIRDSchedule &schedule, const int &nodeId, const std::vector<int> &stratificationValues)
+void StochasticSEATIRD::getIliReportMoments(int firstTime, int lastTime, int nodeId, float &mean, float &variance)
 {
-    // todo: beta should be age-specific considering PHA's
-    double beta = g_parameters.getR0() / g_parameters.getBetaScale();
+    // reports of a day are based on the infections at the start of that day, as in simulate()
+    std::vector<float> infectious;
+
+    for(int t=firstTime; t<=lastTime; t++)
+    {
+        infectious.push_back(getDerivedVarInfected(t - 1, nodeId));
+    }
 
-    // todo: should be in parameters
-    static double sigma[] = {1.00, 0.98, 0.94, 0.91, 0.66};
+    iliSurveillance_.getReportMoments(getNodeIndex(nodeId), infectious, mean, variance);
+}
+
+void StochasticSEATIRD::bindDerivedVariables()
+{
+    derivedVariables_["All infected"] = boost::bind(&StochasticSEATIRD::getDerivedVarInfected, this, _1, _2, _3);
+    derivedVariables_["vaccinated in lag period"] = boost::bind(&StochasticSEATIRD::getDerivedVarPopulationInVaccineLatencyPeriod, this, _1, _2, _3);
+    derivedVariables_["vaccinated effective"] = boost::bind(&StochasticSEATIRD::getDerivedVarPopulationEffectiveVaccines, this, _1, _2, _3);
+    derivedVariables_["ILI reports"] = boost::bind(&StochasticSEATIRD::getDerivedVarILI, this, _1, _2, _3);
 
-    // todo: should be in parameters
-    static double contact[5][5] = {    { 45.1228487783,8.7808312353,11.7757947836,6.10114751268,4.02227175596 },
-                                { 8.7808312353,41.2889143668,13.3332813497,7.847051289,4.22656343551 },
-                                { 11.7757947836,13.3332813497,21.4270155984,13.7392636644,6.92483172729 },
-                                { 6.10114751268,7.847051289,13.7392636644,18.0482119252,9.45371062356 },
-                                { 4.02227175596,4.22656343551,6.92483172729,9.45371062356,14.0529294262 }   };
+    // reports are per node only
+    unstratifiedVariables_.insert("ILI reports");
+}
 
+void StochasticSEATIRD::initializeContactEvents(StochasticSEATIRDSchedule &schedule, const int &nodeId, const std::vector<int> &stratificationValues)
+{
     // make sure we have expected stratifications
-    if((int)stratifications_[0].size() != StochasticSEATIRD::numAgeGroups_ || (int)stratifications_[1].size() != StochasticSEATIRD::numRiskGroups_ || (int)stratifications_[2].size() != StochasticSEATIRD::numVaccinatedGroups_)
+    if(DefaultStratificationLayout::matches(stratifications_) != true)
     {
         put_flog(LOG_ERROR, "wrong number of stratifications");
         return;
     }
 
+    int nodeIndex = getNodeIndex(nodeId);
+
     // contact events will only be targeted at (age group, risk group)
     // vaccinated status changes over time, and these events are all initiated at the point of exposure
     // when the contact event occurs, it will then be determined if the target individual is vaccinated or not
@@ -303,12 +453,8 @@ void StochasticSEATIRD::initializeContactEvents(StochasticSEATIRDSchedule &sched
             toStratificationValues[0] = a;
             toStratificationValues[1] = r;
 
-            // fraction of the to group in population; use cached values
-            // sum both unvaccinated and vaccinated stratifications
-            double toGroupFraction = (populations_(nodeIdToIndex_[nodeId], a, r, 0) + populations_(nodeIdToIndex_[nodeId], a, r, 1))  / populationNodes_(nodeIdToIndex_[nodeId]);
-
-            double contactRate = contact[stratificationValues[0]][a];
-            double transmissionRate = beta * contactRate * sigma[a] * toGroupFraction;
+            // precomputed for the cached populations
+            double transmissionRate = transmissionRates_(nodeIndex, stratificationValues[0], a, r);
 
             // contacts can occur within this time range
             double TcInit = schedule.getInfectedTMin(); // asymptomatic
@@ -330,46 +476,49 @@ void StochasticSEATIRD::initializeContactEvents(StochasticSEATIRDSchedule &sched
 
 bool StochasticSEATIRD::processEvent(const int &nodeId, const StochasticSEATIRDEvent &event)
 {
+    // the stratification of the individual the event belongs to
+    const StratumIndex fromStratumIndex(event.fromStratificationValues);
+
     switch(event.type)
     {
         case EtoA:
             // exposed -> asymptomatic
-            transition(1, "exposed", "asymptomatic", nodeId, event.fromStratificationValues);
+            transition(1, "exposed", "asymptomatic", nodeId, fromStratumIndex);
             break;
 
         case AtoT:
             // asymptomatic -> treatable
-            transition(1, "asymptomatic", "treatable", nodeId, event.fromStratificationValues);
+            transition(1, "asymptomatic", "treatable", nodeId, fromStratumIndex);
             break;
         case AtoR:
             // asymptomatic -> recovered
-            transition(1, "asymptomatic", "recovered", nodeId, event.fromStratificationValues);
+            transition(1, "asymptomatic", "recovered", nodeId, fromStratumIndex);
             break;
         case AtoD:
             // asymptomatic -> deceased
-            transition(1, "asymptomatic", "deceased", nodeId, event.fromStratificationValues);
+            transition(1, "asymptomatic", "deceased", nodeId, fromStratumIndex);
             break;
 
         case TtoI:
             // treatable -> infectious
-            transition(1, "treatable", "infectious", nodeId, event.fromStratificationValues);
+            transition(1, "treatable", "infectious", nodeId, fromStratumIndex);
             break;
         case TtoR:
             // treatable -> recovered
-            transition(1, "treatable", "recovered", nodeId, event.fromStratificationValues);
+            transition(1, "treatable", "recovered", nodeId, fromStratumIndex);
             break;
         case TtoD:
             // treatable -> deceased
-            transition(1, "treatable", "deceased", nodeId, event.fromStratificationValues);
+            transition(1, "treatable", "deceased", nodeId, fromStratumIndex);
             break;
 
         case ItoR:
             // infectious -> recovered
-            transition(1, "infectious", "recovered", nodeId, event.fromStratificationValues);
+            transition(1, "infectious", "recovered", nodeId, fromStratumIndex);
             break;
         case ItoD:
             // infectious -> deceased
-            transition(1, "infectious", "deceased", nodeId, event.fromStratificationValues);
+            transition(1, "infectious", "deceased", nodeId, fromStratumIndex);
             break;
 
         case CONTACT:
@@ -381,7 +530,7 @@ bool StochasticSEATIRD::processEvent(const int &nodeId, const StochasticSEATIRDE
             }
 
             // first, see if a Npi stops this contact from happening
-            bool npiEffective = Npi::isNpiEffective(g_parameters.getNpis(), nodeId, int(now_), event.fromStratificationValues[0], event.toStratificationValues[0]);
+            bool npiEffective = Npi::isNpiEffective(getParameters().getNpis(), nodeId, int(now_), event.fromStratificationValues[0], event.toStratificationValues[0], rand_);
 
             if(npiEffective == true)
             {
@@ -390,10 +539,10 @@ bool StochasticSEATIRD::processEvent(const int &nodeId, const StochasticSEATIRDE
             }
 
             // determine now if the target individual is vaccinated or not
-            int ageRiskPopulationSize = int(populations_(nodeIdToIndex_[nodeId], event.toStratificationValues[0], event.toStratificationValues[1], 0) + populations_(nodeIdToIndex_[nodeId], event.toStratificationValues[0], event.toStratificationValues[1], 1));
+            int ageRiskPopulationSize = populations_(getNodeIndex(nodeId), event.toStratificationValues[0], event.toStratificationValues[1], 0) + populations_(getNodeIndex(nodeId), event.toStratificationValues[0], event.toStratificationValues[1], 1);
 
             // vaccinated stratification == 1
-            int ageRiskVaccinatedPopulationSize = int(populations_(nodeIdToIndex_[nodeId], event.toStratificationValues[0], event.toStratificationValues[1], 1));
+            int ageRiskVaccinatedPopulationSize = populations_(getNodeIndex(nodeId), event.toStratificationValues[0], event.toStratificationValues[1], 1);
 
             // random integer between 1 and ageRiskPopulationSize
             int contact = rand_.randInt(ageRiskPopulationSize - 1) + 1;
@@ -417,7 +566,7 @@ bool StochasticSEATIRD::processEvent(const int &nodeId, const StochasticSEATIRDE
                     // the vaccine therefore might be effective
 
                     // todo: should be age-specific
-                    double vaccineEffectiveness = g_parameters.getVaccineEffectiveness();
+                    double vaccineEffectiveness = getParameters().getVaccineEffectiveness();
 
                     if(rand_.rand() <= vaccineEffectiveness)
                     {
@@ -431,7 +580,7 @@ bool StochasticSEATIRD::processEvent(const int &nodeId, const StochasticSEATIRDE
             std::vector<int> completeToStratificationValues = event.toStratificationValues;
             completeToStratificationValues.push_back(v);
 
-            int targetPopulationSize = int(populations_(nodeIdToIndex_[nodeId], completeToStratificationValues[0], completeToStratificationValues[1], completeToStratificationValues[2]));
+            int targetPopulationSize = populations_(getNodeIndex(nodeId), completeToStratificationValues[0], completeToStratificationValues[1], completeToStratificationValues[2]);
 
             if(event.fromStratificationValues == completeToStratificationValues)
             {
@@ -443,7 +592,7 @@ bool StochasticSEATIRD::processEvent(const int &nodeId, const StochasticSEATIRDE
                 // random integer between 1 and targetPopulationSize
                 contact = rand_.randInt(targetPopulationSize - 1) + 1;
 
-                if((int)getValue("susceptible", time_+1, nodeId, completeToStratificationValues) >= contact)
+                if(variables_["susceptible"](getDenseTimeIndex(time_+1), getNodeIndex(nodeId), completeToStratificationValues[0], completeToStratificationValues[1], completeToStratificationValues[2]) >= contact)
                 {
                     expose(1, nodeId, completeToStratificationValues);
                 }
@@ -457,22 +606,30 @@ bool StochasticSEATIRD::processEvent(const int &nodeId, const StochasticSEATIRDE
 
 void StochasticSEATIRD::applyAntiviralsToPriorityGroupSelections(boost::shared_ptr<PriorityGroupSelections> priorityGroupSelections)
 {
-    if(priorityGroupSelections == NULL || priorityGroupSelections->getPriorityGroups().size() == 0)
+    if(priorityGroupSelections == NULL || priorityGroupSelections->getStratumIndices().size() == 0)
     {
         put_flog(LOG_DEBUG, "no priority groups in selection");
         return;
     }
 
-    double antiviralEffectiveness = g_parameters.getAntiviralEffectiveness();
-    double antiviralAdherence = g_parameters.getAntiviralAdherence();
-    double antiviralCapacity = g_parameters.getAntiviralCapacity();
+    // stratifications in priority group selections
+    const std::vector<StratumIndex> &stratumIndices = priorityGroupSelections->getStratumIndices();
+
+    blitz::Array<int, 2+NUM_STRATIFICATION_DIMENSIONS> &treatable = variables_["treatable"];
+    blitz::Array<int, 2+NUM_STRATIFICATION_DIMENSIONS> &treated = variables_["treated"];
+    blitz::Array<int, 2+NUM_STRATIFICATION_DIMENSIONS> &treatedDaily = variables_["treated (daily)"];
+    blitz::Array<int, 2+NUM_STRATIFICATION_DIMENSIONS> &treatedIneffectiveDaily = variables_["treated (ineffective daily)"];
+
+    double antiviralEffectiveness = getParameters().getAntiviralEffectiveness();
+    double antiviralAdherence = getParameters().getAntiviralAdherence();
+    double antiviralCapacity = getParameters().getAntiviralCapacity();
 
     // treatments for each node
     std::vector<int> nodeIds = getNodeIds();
 
     for(unsigned int i=0; i<nodeIds.size(); i++)
     {
-        boost::shared_ptr<Stockpile> stockpile = getStockpileNetwork()->getNodeStockpile(nodeIds[i]);
+        boost::shared_ptr<Stockpile> stockpile = getStockpileNetwork()->getNodeStockpileByIndex(i);
 
         // do nothing if no stockpile is found
         if(stockpile == NULL)
@@ -491,8 +648,19 @@ void StochasticSEATIRD::applyAntiviralsToPriorityGroupSelections(boost::shared_p
 
         // the total populations below correspond to the priority group selections
 
+        int nodeIndex = getNodeIndex(nodeIds[i]);
+
         // determine total number of adherent treatable
-        float totalTreatable = getValue("treatable", time_+1, nodeIds[i], priorityGroupSelections->getStratificationValuesSet()) - getValue("treated (ineffective daily)", time_+1, nodeIds[i], priorityGroupSelections->getStratificationValuesSet());
+        int totalTreatableCount = 0;
+
+        for(unsigned int s=0; s<stratumIndices.size(); s++)
+        {
+            const StratumIndex &stratumIndex = stratumIndices[s];
+
+            totalTreatableCount += treatable(getDenseTimeIndex(time_+1), nodeIndex, stratumIndex.ageGroup, stratumIndex.riskGroup, stratumIndex.vaccinated) - treatedIneffectiveDaily(getDenseTimeIndex(time_+1), nodeIndex, stratumIndex.ageGroup, stratumIndex.riskGroup, stratumIndex.vaccinated);
+        }
+
+        float totalTreatable = totalTreatableCount;
 
         // do nothing if this population is zero
         if(totalTreatable <= 0.)
@@ -515,7 +683,7 @@ void StochasticSEATIRD::applyAntiviralsToPriorityGroupSelections(boost::shared_p
         float capacityTotalPopulation = getValue("population", time_+1, nodeIds[i]);
 
         // consider capacity used in previous treatments on this day
-        float todayUsedCapacity = blitz::sum(variables_["treated (daily)"](time_+1, nodeIdToIndex_[nodeIds[i]], blitz::Range::all(), blitz::Range::all(), blitz::Range::all()));
+        float todayUsedCapacity = blitz::sum(treatedDaily(getDenseTimeIndex(time_+1), nodeIndex, blitz::Range::all(), blitz::Range::all(), blitz::Range::all()));
 
         if(stockpileAmountUsed > (int)(antiviralCapacity * capacityTotalPopulation - todayUsedCapacity))
         {
@@ -533,38 +701,28 @@ void StochasticSEATIRD::applyAntiviralsToPriorityGroupSelections(boost::shared_p
 
         // apply antivirals pro-rata across all stratifications
 
-        blitz::Array<float, NUM_STRATIFICATION_DIMENSIONS> adherentTreatable(StochasticSEATIRD::numAgeGroups_, StochasticSEATIRD::numRiskGroups_, StochasticSEATIRD::numVaccinatedGroups_);
-        blitz::Array<int, NUM_STRATIFICATION_DIMENSIONS> numberTreated(StochasticSEATIRD::numAgeGroups_, StochasticSEATIRD::numRiskGroups_, StochasticSEATIRD::numVaccinatedGroups_);
-        blitz::Array<int, NUM_STRATIFICATION_DIMENSIONS> numberEffectivelyTreated(StochasticSEATIRD::numAgeGroups_, StochasticSEATIRD::numRiskGroups_, StochasticSEATIRD::numVaccinatedGroups_);
+        // initialized to zero, since we might not be seeing all possible stratifications
+        StratifiedArray<float> adherentTreatable(0.f);
+        StratifiedArray<int> numberTreated(0);
+        StratifiedArray<int> numberEffectivelyTreated(0);
 
         // we also need the number treatable for probabilistically choosing who got the treatment
-        blitz::Array<float, NUM_STRATIFICATION_DIMENSIONS> numberTreatable(StochasticSEATIRD::numAgeGroups_, StochasticSEATIRD::numRiskGroups_, StochasticSEATIRD::numVaccinatedGroups_);
-
-        // initialize to zero, since we might not be seeing all possible stratifications
-        adherentTreatable = 0.;
-        numberTreated = 0;
-        numberEffectivelyTreated = 0;
-        numberTreatable = 0.;
+        StratifiedArray<float> numberTreatable(0.f);
 
         // iterate through all stratifications in priority group selections
-        std::vector<std::vector<int> > stratificationValuesSet = priorityGroupSelections->getStratificationValuesSet();
-
-        for(unsigned int s=0; s<stratificationValuesSet.size(); s++)
+        for(unsigned int s=0; s<stratumIndices.size(); s++)
         {
-            int a = stratificationValuesSet[s][0];
-            int r = stratificationValuesSet[s][1];
-            int v = stratificationValuesSet[s][2];
+            const StratumIndex &stratumIndex = stratumIndices[s];
 
-            std::vector<int> stratificationValues;
-            stratificationValues.push_back(a);
-            stratificationValues.push_back(r);
-            stratificationValues.push_back(v);
+            int a = stratumIndex.ageGroup;
+            int r = stratumIndex.riskGroup;
+            int v = stratumIndex.vaccinated;
 
             // determine number of adherent treatable
-            float treatable = getValue("treatable", time_+1, nodeIds[i], stratificationValues) - getValue("treated (ineffective daily)", time_+1, nodeIds[i], stratificationValues);
+            float stratumTreatable = treatable(getDenseTimeIndex(time_+1), nodeIndex, a, r, v) - treatedIneffectiveDaily(getDenseTimeIndex(time_+1), nodeIndex, a, r, v);
 
             // do nothing if this population is zero
-            if(treatable <= 0.)
+            if(stratumTreatable <= 0.)
             {
                 adherentTreatable(a, r, v) = 0.;
                 numberTreated(a, r, v) = 0;
@@ -575,7 +733,7 @@ void StochasticSEATIRD::applyAntiviralsToPriorityGroupSelections(boost::shared_p
             }
 
             // since we fix the treatable period to one day, we can simplify our adherence calculations...
-            adherentTreatable(a, r, v) = antiviralAdherence * treatable;
+            adherentTreatable(a, r, v) = antiviralAdherence * stratumTreatable;
 
             // pro-rata by adherent treatable population
             numberTreated(a, r, v) = int(adherentTreatable(a, r, v) / totalAdherentTreatable * (float)stockpileAmountUsed);
@@ -584,7 +742,7 @@ void StochasticSEATIRD::applyAntiviralsToPriorityGroupSelections(boost::shared_p
             numberEffectivelyTreated(a, r, v) = int(antiviralEffectiveness * float(numberTreated(a, r, v)));
 
             // for probabilistically choosing who got the treatment
-            numberTreatable(a, r, v) = treatable;
+            numberTreatable(a, r, v) = stratumTreatable;
 
             if(numberTreated(a, r, v) <= 0)
             {
@@ -594,23 +752,23 @@ void StochasticSEATIRD::applyAntiviralsToPriorityGroupSelections(boost::shared_p
             // put_flog(LOG_DEBUG, "adherentTreatable = %f, numberTreated = %i, numberEffectivelyTreated = %i", adherentTreatable(a, r, v), numberTreated(a, r, v), numberEffectivelyTreated(a, r, v));
 
             // transition those effectively treated from "treatable" to "recovered"
-            transition(numberEffectivelyTreated(a, r, v), "treatable", "recovered", nodeIds[i], stratificationValues);
+            transition(numberEffectivelyTreated(a, r, v), "treatable", "recovered", nodeIds[i], stratumIndex);
 
             // need to keep track of number treated each day
-            variables_["treated (daily)"](time_+1, nodeIdToIndex_[nodeIds[i]], a, r, v) += numberTreated(a, r, v);
+            treatedDaily(getDenseTimeIndex(time_+1), nodeIndex, a, r, v) += numberTreated(a, r, v);
 
             // need to keep track of number ineffectively treated each day
-            variables_["treated (ineffective daily)"](time_+1, nodeIdToIndex_[nodeIds[i]], a, r, v) += (numberTreated(a, r, v) - numberEffectivelyTreated(a, r, v));
+            treatedIneffectiveDaily(getDenseTimeIndex(time_+1), nodeIndex, a, r, v) += (numberTreated(a, r, v) - numberEffectivelyTreated(a, r, v));
 
             // need to keep track of those treated (regardless of effectiveness)
-            variables_["treated"](time_+1, nodeIdToIndex_[nodeIds[i]], a, r, v) += numberTreated(a, r, v);
+            treated(getDenseTimeIndex(time_+1), nodeIndex, a, r, v) += numberTreated(a, r, v);
         }
 
         // the sum over numberTreated should equal stockpileAmountUsed
         // this can differ due to integer division issues with pro rata distributions
-        if(blitz::sum(numberTreated) != stockpileAmountUsed)
+        if(numberTreated.sum() != stockpileAmountUsed)
         {
-            put_flog(LOG_WARN, "numberTreated != stockpileAmountUsed (%i != %i)", blitz::sum(numberTreated), stockpileAmountUsed);
+            put_flog(LOG_WARN, "numberTreated != stockpileAmountUsed (%i != %i)", numberTreated.sum(), stockpileAmountUsed);
         }
 
         // now, adjust schedules for individuals that were effectively treated
@@ -620,31 +778,31 @@ void StochasticSEATIRD::applyAntiviralsToPriorityGroupSelections(boost::shared_p
 
         boost::heap::pairing_heap<StochasticSEATIRDSchedule, boost::heap::compare<StochasticSEATIRDSchedule::compareByNextEventTime> >::iterator it;
 
-        for(it=begin; it!=end && blitz::sum(numberEffectivelyTreated) > 0; it++)
+        for(it=begin; it!=end && numberEffectivelyTreated.sum() > 0; it++)
         {
             if((*it).getState() == T)
             {
-                std::vector<int> stratificationValues = (*it).getStratificationValues();
+                StratumIndex stratumIndex((*it).getStratificationValues());
 
-                if(numberEffectivelyTreated(BOOST_PP_ENUM(NUM_STRATIFICATION_DIMENSIONS, VECTOR_TO_ARGS, stratificationValues)) > 0)
+                if(numberEffectivelyTreated[stratumIndex] > 0)
                 {
-                    if((*it).canceled() != true && rand_.rand() <= float(numberEffectivelyTreated(BOOST_PP_ENUM(NUM_STRATIFICATION_DIMENSIONS, VECTOR_TO_ARGS, stratificationValues))) / numberTreatable(BOOST_PP_ENUM(NUM_STRATIFICATION_DIMENSIONS, VECTOR_TO_ARGS, stratificationValues)))
+                    if((*it).canceled() != true && rand_.rand() <= float(numberEffectivelyTreated[stratumIndex]) / numberTreatable[stratumIndex])
                     {
                         // cancel the remaining schedule
                         (*boost::heap::pairing_heap<StochasticSEATIRDSchedule, boost::heap::compare<StochasticSEATIRDSchedule::compareByNextEventTime> >::s_handle_from_iterator(it)).cancel();
 
-                        numberEffectivelyTreated(BOOST_PP_ENUM(NUM_STRATIFICATION_DIMENSIONS, VECTOR_TO_ARGS, stratificationValues))--;
+                        numberEffectivelyTreated[stratumIndex]--;
                     }
 
-                    numberTreatable(BOOST_PP_ENUM(NUM_STRATIFICATION_DIMENSIONS, VECTOR_TO_ARGS, stratificationValues))--;
+                    numberTreatable[stratumIndex]--;
                 }
             }
         }
 
         // the sum over numberEffectivelyTreated should now be zero if all events were unqueued
-        if(blitz::sum(numberEffectivelyTreated) != 0)
+        if(numberEffectivelyTreated.sum() != 0)
         {
-            put_flog(LOG_WARN, "numberEffectivelyTreated != 0 (%i)", blitz::sum(numberEffectivelyTreated));
+            put_flog(LOG_WARN, "numberEffectivelyTreated != 0 (%i)", numberEffectivelyTreated.sum());
         }
     }
 }
@@ -653,21 +811,57 @@ void StochasticSEATIRD::applyVaccinesToPriorityGroupSelections(boost::shared_ptr
 {
     // TODO: need to consider deceased in adherent individual totals! they reduce the adherent unvaccinated population
 
-    if(priorityGroupSelections == NULL || priorityGroupSelections->getPriorityGroups().size() == 0)
+    if(priorityGroupSelections == NULL || priorityGroupSelections->getAgeRiskStratumIndices().size() == 0)
     {
         put_flog(LOG_DEBUG, "no priority groups in selection");
         return;
     }
 
-    double vaccineAdherence = g_parameters.getVaccineAdherence();
-    double vaccineCapacity = g_parameters.getVaccineCapacity();
+    // stratifications in priority group selections (only for age group, risk group)
+    const std::vector<StratumIndex> &ageRiskStratumIndices = priorityGroupSelections->getAgeRiskStratumIndices();
+
+    blitz::Array<int, 2+NUM_STRATIFICATION_DIMENSIONS> &population = variables_["population"];
+    blitz::Array<int, 2+NUM_STRATIFICATION_DIMENSIONS> &vaccinatedDaily = variables_["vaccinated (daily)"];
+    blitz::Array<int, 2+NUM_STRATIFICATION_DIMENSIONS> &vaccinated = variables_["vaccinated"];
+
+    double vaccineAdherence = getParameters().getVaccineAdherence();
+    double vaccineCapacity = getParameters().getVaccineCapacity();
+
+    // these are the compartments we'll apply to
+    // don't apply to deceased...
+    // this MUST align with stateToCompartmentIndex below
+    std::vector<std::string> compartments;
+    compartments.push_back("susceptible");
+    compartments.push_back("exposed");
+    compartments.push_back("asymptomatic");
+    compartments.push_back("treatable");
+    compartments.push_back("infectious");
+    compartments.push_back("recovered");
+
+    // we only need to adjust schedules for event types originating with one of the vaccinated compartments
+    // these are "exposed", "asymptomatic", "treatable", "infectious", "recovered"
+    // this MUST align with compartments above
+    // in reality only E, A, T, I will be used
+    std::map<StochasticSEATIRDScheduleState, int> stateToCompartmentIndex;
+    stateToCompartmentIndex[E] = 1;
+    stateToCompartmentIndex[A] = 2;
+    stateToCompartmentIndex[T] = 3;
+    stateToCompartmentIndex[I] = 4;
+    stateToCompartmentIndex[R] = 5;
+
+    // number vaccinated for each compartment, from the unvaccinated stratum (age group, risk group, 0)
+    std::vector<StratifiedArray<int> > numberVaccinated(compartments.size());
+
+    // number vaccinatable for each compartment, from the unvaccinated stratum (age group, risk group, 0)
+    // for probabilistically choosing which event schedules to change stratifications
+    std::vector<StratifiedArray<int> > numberVaccinatable(compartments.size());
 
     // treatments for each node
     std::vector<int> nodeIds = getNodeIds();
 
     for(unsigned int i=0; i<nodeIds.size(); i++)
     {
-        boost::shared_ptr<Stockpile> stockpile = getStockpileNetwork()->getNodeStockpile(nodeIds[i]);
+        boost::shared_ptr<Stockpile> stockpile = getStockpileNetwork()->getNodeStockpileByIndex(i);
 
         // do nothing if no stockpile is found
         if(stockpile == NULL)
@@ -686,10 +880,23 @@ void StochasticSEATIRD::applyVaccinesToPriorityGroupSelections(boost::shared_ptr
 
         // the total populations below correspond to the priority group selections
 
+        int nodeIndex = getNodeIndex(nodeIds[i]);
+
         // determine total number of adherent unvaccinated
-        float totalPopulation = getValue("population", time_+1, nodeIds[i], priorityGroupSelections->getStratificationValuesSet2(STRATIFICATIONS_ALL));
-        float totalVaccinatedPopulation = getValue("population", time_+1, nodeIds[i], priorityGroupSelections->getStratificationValuesSet2(1)); // vaccinated == 1
-        float totalUnvaccinatedPopulation = getValue("population", time_+1, nodeIds[i], priorityGroupSelections->getStratificationValuesSet2(0)); // unvaccinated == 0
+        int totalVaccinatedCount = 0;
+        int totalUnvaccinatedCount = 0;
+
+        for(unsigned int s=0; s<ageRiskStratumIndices.size(); s++)
+        {
+            const StratumIndex &stratumIndex = ageRiskStratumIndices[s];
+
+            totalVaccinatedCount += population(getDenseTimeIndex(time_+1), nodeIndex, stratumIndex.ageGroup, stratumIndex.riskGroup, 1); // vaccinated == 1
+            totalUnvaccinatedCount += population(getDenseTimeIndex(time_+1), nodeIndex, stratumIndex.ageGroup, stratumIndex.riskGroup, 0); // unvaccinated == 0
+        }
+
+        float totalPopulation = totalVaccinatedCount + totalUnvaccinatedCount;
+        float totalVaccinatedPopulation = totalVaccinatedCount;
+        float totalUnvaccinatedPopulation = totalUnvaccinatedCount;
 
         // do nothing if this population is zero
         if(totalUnvaccinatedPopulation <= 0.)
@@ -712,7 +919,17 @@ void StochasticSEATIRD::applyVaccinesToPriorityGroupSelections(boost::shared_ptr
         float capacityTotalPopulation = getValue("population", time_+1, nodeIds[i]);
 
         // consider capacity used in previous treatments on this day
-        float todayUsedCapacity = blitz::sum(variables_["vaccinated (daily)"](time_+1, nodeIdToIndex_[nodeIds[i]], blitz::Range::all(), blitz::Range::all(), 1));
+        int todayUsedCapacityCount = 0;
+
+        for(int a=0; a<StochasticSEATIRD::numAgeGroups_; a++)
+        {
+            for(int r=0; r<StochasticSEATIRD::numRiskGroups_; r++)
+            {
+                todayUsedCapacityCount += vaccinatedDaily(getDenseTimeIndex(time_+1), nodeIndex, a, r, 1);
+            }
+        }
+
+        float todayUsedCapacity = todayUsedCapacityCount;
 
         if(stockpileAmountUsed > (int)(vaccineCapacity * capacityTotalPopulation - todayUsedCapacity))
         {
@@ -730,122 +947,89 @@ void StochasticSEATIRD::applyVaccinesToPriorityGroupSelections(boost::shared_ptr
 
         // apply vaccines pro-rata across all compartments and stratifications
 
-        // these are the compartments we'll apply to
-        // don't apply to deceased...
-        // this MUST align with stateToCompartmentIndex below
-        std::vector<std::string> compartments;
-        compartments.push_back("susceptible");
-        compartments.push_back("exposed");
-        compartments.push_back("asymptomatic");
-        compartments.push_back("treatable");
-        compartments.push_back("infectious");
-        compartments.push_back("recovered");
-
-        // number vaccinated for (compartment, age group, risk group)
-        blitz::Array<int, 1 + NUM_STRATIFICATION_DIMENSIONS-1> numberVaccinated(compartments.size(), StochasticSEATIRD::numAgeGroups_, StochasticSEATIRD::numRiskGroups_);
-
-        // number vaccinatable for (compartment, age group, risk group)
-        // for probabilistically choosing which event schedules to change stratifications
-        blitz::Array<int, 1 + NUM_STRATIFICATION_DIMENSIONS-1> numberVaccinatable(compartments.size(), StochasticSEATIRD::numAgeGroups_, StochasticSEATIRD::numRiskGroups_);
-
         // initialize to zero, since we might not be seeing all possible stratifications
-        numberVaccinated = 0;
-        numberVaccinatable = 0;
-
         for(unsigned int c=0; c<compartments.size(); c++)
         {
-            blitz::Array<float, NUM_STRATIFICATION_DIMENSIONS-1> adherentCompartmentUnvaccinated(StochasticSEATIRD::numAgeGroups_, StochasticSEATIRD::numRiskGroups_);
+            numberVaccinated[c].fill(0);
+            numberVaccinatable[c].fill(0);
+        }
 
-            adherentCompartmentUnvaccinated = 0.;
+        int totalNumberVaccinated = 0;
 
-            // iterate through all stratifications in priority group selections (only for age group, risk group)
-            std::vector<std::vector<int> > stratificationValuesSet2 = priorityGroupSelections->getStratificationValuesSet2(STRATIFICATIONS_ALL);
+        for(unsigned int c=0; c<compartments.size(); c++)
+        {
+            blitz::Array<int, 2+NUM_STRATIFICATION_DIMENSIONS> &compartment = variables_[compartments[c]];
 
-            for(unsigned int s=0; s<stratificationValuesSet2.size(); s++)
+            // iterate through all stratifications in priority group selections (only for age group, risk group)
+            for(unsigned int s=0; s<ageRiskStratumIndices.size(); s++)
             {
-                int a = stratificationValuesSet2[s][0];
-                int r = stratificationValuesSet2[s][1];
-
-                std::vector<int> stratificationValues(3, STRATIFICATIONS_ALL);
-                stratificationValues[0] = a;
-                stratificationValues[1] = r;
+                int a = ageRiskStratumIndices[s].ageGroup;
+                int r = ageRiskStratumIndices[s].riskGroup;
 
                 // determine number of adherent compartment unvaccinated
-                stratificationValues[2] = STRATIFICATIONS_ALL;
-                float population = getValue("population", time_+1, nodeIds[i], stratificationValues);
-
-                stratificationValues[2] = 1; // vaccinated
-                float vaccinatedPopulation = getValue("population", time_+1, nodeIds[i], stratificationValues);
-
-                stratificationValues[2] = 0; // unvaccinated
-                float unvaccinatedPopulation = getValue("population", time_+1, nodeIds[i], stratificationValues);
-                float compartmentUnvaccinated = getValue(compartments[c], time_+1, nodeIds[i], stratificationValues);
+                float vaccinatedPopulation = population(getDenseTimeIndex(time_+1), nodeIndex, a, r, 1); // vaccinated
+                float unvaccinatedPopulation = population(getDenseTimeIndex(time_+1), nodeIndex, a, r, 0); // unvaccinated
+                float stratumPopulation = vaccinatedPopulation + unvaccinatedPopulation;
+                float compartmentUnvaccinated = compartment(getDenseTimeIndex(time_+1), nodeIndex, a, r, 0);
 
                 // for probabilistically choosing which event schedules to change stratifications
-                numberVaccinatable((int)c, a, r) = int(compartmentUnvaccinated);
+                numberVaccinatable[c](a, r, 0) = int(compartmentUnvaccinated);
 
                 // do nothing if this population is zero
                 if(unvaccinatedPopulation <= 0.)
                 {
-                    adherentCompartmentUnvaccinated(a, r) = 0.;
-                    numberVaccinated((int)c, a, r) = 0;
-
                     continue;
                 }
 
                 // == (adherent unvaccinated population) * (fraction of unvaccinated population that is in compartment)
-                adherentCompartmentUnvaccinated(a, r) = (vaccineAdherence * population - vaccinatedPopulation) * compartmentUnvaccinated / unvaccinatedPopulation;
+                float adherentCompartmentUnvaccinated = (vaccineAdherence * stratumPopulation - vaccinatedPopulation) * compartmentUnvaccinated / unvaccinatedPopulation;
 
                 // pro-rata by adherent compartment unvaccinated population
-                numberVaccinated((int)c, a, r) = int(adherentCompartmentUnvaccinated(a, r) / totalAdherentUnvaccinated * (float)stockpileAmountUsed);
+                int number = int(adherentCompartmentUnvaccinated / totalAdherentUnvaccinated * (float)stockpileAmountUsed);
 
-                if(numberVaccinated((int)c, a, r) <= 0)
+                if(number <= 0)
                 {
                     continue;
                 }
 
-                // put_flog(LOG_DEBUG, "adherentCompartmentUnvaccinated = %f, numberVaccinated = %i", adherentCompartmentUnvaccinated(a, r), numberVaccinated((int)c, a, r));
+                numberVaccinated[c](a, r, 0) += number;
+                totalNumberVaccinated += number;
+
+                // put_flog(LOG_DEBUG, "adherentCompartmentUnvaccinated = %f, numberVaccinated = %i", adherentCompartmentUnvaccinated, number);
 
                 // move individuals from compartment unvaccinated to compartment vaccinated
-                variables_[compartments[c]](time_+1, nodeIdToIndex_[nodeIds[i]], a, r, 0) -= numberVaccinated((int)c, a, r);
-                variables_[compartments[c]](time_+1, nodeIdToIndex_[nodeIds[i]], a, r, 1) += numberVaccinated((int)c, a, r);
+                compartment(getDenseTimeIndex(time_+1), nodeIndex, a, r, 0) -= number;
+                compartment(getDenseTimeIndex(time_+1), nodeIndex, a, r, 1) += number;
 
                 // need to also manipulate the total population variable: individuals are changing stratifications as well as state
-                variables_["population"](time_+1, nodeIdToIndex_[nodeIds[i]], a, r, 0) -= numberVaccinated((int)c, a, r);
-                variables_["population"](time_+1, nodeIdToIndex_[nodeIds[i]], a, r, 1) += numberVaccinated((int)c, a, r);
+                population(getDenseTimeIndex(time_+1), nodeIndex, a, r, 0) -= number;
+                population(getDenseTimeIndex(time_+1), nodeIndex, a, r, 1) += number;
 
                 // need to keep track of number vaccinated each day
-                variables_["vaccinated (daily)"](time_+1, nodeIdToIndex_[nodeIds[i]], a, r, 1) += numberVaccinated((int)c, a, r);
+                vaccinatedDaily(getDenseTimeIndex(time_+1), nodeIndex, a, r, 1) += number;
+
+                // need to keep track of those vaccinated
+                vaccinated(getDenseTimeIndex(time_+1), nodeIndex, a, r, 1) += number;
             }
         }
 
         // the sum over numberVaccinated should equal stockpileAmountUsed
         // this can differ due to integer division issues with pro rata distributions
-        if(blitz::sum(numberVaccinated) != stockpileAmountUsed)
+        if(totalNumberVaccinated != stockpileAmountUsed)
         {
-            put_flog(LOG_WARN, "numberVaccinated != stockpileAmountUsed (%i != %i)", blitz::sum(numberVaccinated), stockpileAmountUsed);
+            put_flog(LOG_WARN, "numberVaccinated != stockpileAmountUsed (%i != %i)", totalNumberVaccinated, stockpileAmountUsed);
         }
 
         // no need to adjust schedules since susceptible individuals are not scheduled yet, and vaccination has no effect on exposed+ individuals
         // however, we are changing individuals to the vaccinated stratification, so we need to modify schedules' fromStratificationValues!
-
-        // we only need to do this for event types originating with one of the vaccinated compartments
-        // these are "exposed", "asymptomatic", "treatable", "infectious", "recovered"
-        // this MUST align with compartments above
-        // in reality only E, A, T, I will be used
-        std::map<StochasticSEATIRDScheduleState, int> stateToCompartmentIndex;
-        stateToCompartmentIndex[E] = 1;
-        stateToCompartmentIndex[A] = 2;
-        stateToCompartmentIndex[T] = 3;
-        stateToCompartmentIndex[I] = 4;
-        stateToCompartmentIndex[R] = 5;
+        // this is only needed for the compartments in stateToCompartmentIndex
 
         boost::heap::pairing_heap<StochasticSEATIRDSchedule, boost::heap::compare<StochasticSEATIRDSchedule::compareByNextEventTime> >::iterator begin = scheduleEventQueues_[nodeIds[i]].begin();
         boost::heap::pairing_heap<StochasticSEATIRDSchedule, boost::heap::compare<StochasticSEATIRDSchedule::compareByNextEventTime> >::iterator end = scheduleEventQueues_[nodeIds[i]].end();
 
         boost::heap::pairing_heap<StochasticSEATIRDSchedule, boost::heap::compare<StochasticSEATIRDSchedule::compareByNextEventTime> >::iterator it;
 
-        for(it=begin; it!=end && blitz::sum(numberVaccinated) > 0; it++)
+        for(it=begin; it!=end && totalNumberVaccinated > 0; it++)
         {
             StochasticSEATIRDScheduleState state = (*it).getState();
 
@@ -853,29 +1037,30 @@ void StochasticSEATIRD::applyVaccinesToPriorityGroupSelections(boost::shared_ptr
             {
                 int c = stateToCompartmentIndex[state];
 
-                std::vector<int> stratificationValues = (*it).getStratificationValues();
+                StratumIndex stratumIndex((*it).getStratificationValues());
 
                 // only consider unvaccinated for stratification change
                 // vaccinated stratification == 1
-                if(stratificationValues[2] == 1)
+                if(stratumIndex.vaccinated == 1)
                 {
                     continue;
                 }
 
-                if(numberVaccinated(c, stratificationValues[0], stratificationValues[1]) > 0)
+                if(numberVaccinated[c][stratumIndex] > 0)
                 {
-                    if((*it).canceled() != true && rand_.rand() <= float(numberVaccinated(c, stratificationValues[0], stratificationValues[1])) / float(numberVaccinatable(c, stratificationValues[0], stratificationValues[1])))
+                    if((*it).canceled() != true && rand_.rand() <= float(numberVaccinated[c][stratumIndex]) / float(numberVaccinatable[c][stratumIndex]))
                     {
                         // change stratification to vaccinated
                         // vaccinated stratification == 1
-                        stratificationValues[2] = 1;
+                        StratumIndex vaccinatedStratumIndex(stratumIndex.ageGroup, stratumIndex.riskGroup, 1);
 
-                        (*boost::heap::pairing_heap<StochasticSEATIRDSchedule, boost::heap::compare<StochasticSEATIRDSchedule::compareByNextEventTime> >::s_handle_from_iterator(it)).changeStratificationValues(stratificationValues);
+                        (*boost::heap::pairing_heap<StochasticSEATIRDSchedule, boost::heap::compare<StochasticSEATIRDSchedule::compareByNextEventTime> >::s_handle_from_iterator(it)).changeStratificationValues(vaccinatedStratumIndex.getStratificationValues());
 
-                        numberVaccinated(c, stratificationValues[0], stratificationValues[1])--;
+                        numberVaccinated[c][stratumIndex]--;
+                        totalNumberVaccinated--;
                     }
 
-                    numberVaccinatable(c, stratificationValues[0], stratificationValues[1])--;
+                    numberVaccinatable[c][stratumIndex]--;
                 }
             }
         }
@@ -888,68 +1073,98 @@ int StochasticSEATIRD::getPopulationInVaccineLatencyPeriod(int nodeId, int ageGr
 {
     // should match the derived variable method above
 
-    int vaccineLatencyPeriod = g_parameters.getVaccineLatencyPeriod();
-
-    int total = 0;
-
-    // people are vaccinated in the "morning", changing the daily count for time_+1
-    // therefore we start in that bin when we're counting vaccinations
-    // with these inequalities, a 0 day latency period will always return 0, as expected
-    for(int t=time_+1; t>=0 && t>(time_+1 - vaccineLatencyPeriod); t--)
-    {
-        // vaccinated stratification == 1
-        total += int(variables_["vaccinated (daily)"](t, nodeIdToIndex_[nodeId], ageGroup, riskGroup, 1));
-    }
-
-    return total;
+    // people are vaccinated in the "morning", changing the counts for time_+1
+    // these are cached by precompute(time_+1), which follows vaccinations
+    return vaccineLatencyPopulations_(getNodeIndex(nodeId), ageGroup, riskGroup);
 }
 
 void StochasticSEATIRD::travel()
 {
     // TODO: review where travel() is called time-wise, and which time indices it uses here!
 
-    // todo: these should be parameters defined elsewhere
-    double RHO = 0.39;
+    double rho = getParameters().getRho();
 
-    double sigma[] = { 1.00, 0.98, 0.94, 0.91, 0.66 };
+    // todo: beta should be age-specific considering PHA's
+    double beta = getParameters().getR0() / getParameters().getBetaScale();
 
-    double contact[5][5] = {    { 45.1228487783,8.7808312353,11.7757947836,6.10114751268,4.02227175596 },
-                                { 8.7808312353,41.2889143668,13.3332813497,7.847051289,4.22656343551 },
-                                { 11.7757947836,13.3332813497,21.4270155984,13.7392636644,6.92483172729 },
-                                { 6.10114751268,7.847051289,13.7392636644,18.0482119252,9.45371062356 },
-                                { 4.02227175596,4.22656343551,6.92483172729,9.45371062356,14.0529294262 }   };
+    double vaccineEffectiveness = getParameters().getVaccineEffectiveness();
 
-    double vaccineEffectiveness = g_parameters.getVaccineEffectiveness();
+    std::vector<double> ageBasedFlowReductions(StochasticSEATIRD::numAgeGroups_);
 
-    for(unsigned int sinkNodeIndex=0; sinkNodeIndex < nodeIds_.size(); sinkNodeIndex++)
+    for(int a=0; a<StochasticSEATIRD::numAgeGroups_; a++)
     {
-        int sinkNodeId = nodeIds_[sinkNodeIndex];
+        ageBasedFlowReductions[a] = getParameters().getTravelReduction(a);
+    }
 
-        double populationSink = populationNodes_(nodeIdToIndex_[sinkNodeId]);
+    const std::vector<int> &nodeIds = regionData_->getNodeIds();
 
-        std::vector<double> unvaccinatedProbabilities(StochasticSEATIRD::numAgeGroups_, 0.0);
+    // NPI effectiveness at each node for contacts between age groups today
+    // this only depends on the node, so it is computed once rather than for every (sink, source) pair
+    std::vector<boost::shared_ptr<Npi> > npis = getParameters().getNpis();
 
-        std::vector<double> ageBasedFlowReductions (5, 1.0);
-        ageBasedFlowReductions[0] = 10; // 0-4  year olds
-        ageBasedFlowReductions[1] = 2;  // 5-24 year olds
-        ageBasedFlowReductions[4] = 2;  // 65+  year olds
+    blitz::Array<double, 3> npiEffectiveness(numNodes_, StochasticSEATIRD::numAgeGroups_, StochasticSEATIRD::numAgeGroups_); // [nodeIndex, a, b]
+    npiEffectiveness = 0.;
 
-        for(unsigned int sourceNodeIndex=0; sourceNodeIndex < nodeIds_.size(); sourceNodeIndex++)
+    if(npis.size() > 0)
+    {
+        for(int i=0; i<numNodes_; i++)
         {
-            int sourceNodeId = nodeIds_[sourceNodeIndex];
+            for(int a=0; a<StochasticSEATIRD::numAgeGroups_; a++)
+            {
+                for(int b=0; b<StochasticSEATIRD::numAgeGroups_; b++)
+                {
+                    npiEffectiveness(i, a, b) = Npi::getNpiEffectiveness(npis, nodeIds[i], int(now_), a, b);
+                }
+            }
+        }
+    }
+
+    // asymptomatic and transmitting (asymptomatic, treatable or infectious) counts of each node by age group
+    // these only depend on the source node, so they are summed once rather than for every (sink, source) pair
+    int timeIndex = getDenseTimeIndex(time_+1);
+
+    const blitz::Array<int, 2+NUM_STRATIFICATION_DIMENSIONS> &asymptomaticCounts = variables_["asymptomatic"];
+    const blitz::Array<int, 2+NUM_STRATIFICATION_DIMENSIONS> &treatableCounts = variables_["treatable"];
+    const blitz::Array<int, 2+NUM_STRATIFICATION_DIMENSIONS> &infectiousCounts = variables_["infectious"];
 
-            double populationSource = populationNodes_(nodeIdToIndex_[sourceNodeId]);
+    blitz::Array<double, 2> asymptomatics(numNodes_, StochasticSEATIRD::numAgeGroups_); // [nodeIndex, age]
+    blitz::Array<double, 2> transmittings(numNodes_, StochasticSEATIRD::numAgeGroups_); // [nodeIndex, age]
 
-            // pre-compute some frequently needed quantities
-            std::vector<double> asymptomatics(StochasticSEATIRD::numAgeGroups_);
-            std::vector<double> transmittings(StochasticSEATIRD::numAgeGroups_);
+    for(int i=0; i<numNodes_; i++)
+    {
+        for(int a=0; a<StochasticSEATIRD::numAgeGroups_; a++)
+        {
+            int asymptomatic = 0;
+            int transmitting = 0;
 
-            for(int age=0; age<StochasticSEATIRD::numAgeGroups_; age++)
+            for(int r=0; r<StochasticSEATIRD::numRiskGroups_; r++)
             {
-                asymptomatics[age] = getValue("asymptomatic", time_+1, sourceNodeId, std::vector<int>(1,age));
-                transmittings[age] = asymptomatics[age] + getValue("treatable", time_+1, sourceNodeId, std::vector<int>(1,age)) + getValue("infectious", time_+1, sourceNodeId, std::vector<int>(1,age));
+                for(int v=0; v<StochasticSEATIRD::numVaccinatedGroups_; v++)
+                {
+                    asymptomatic += asymptomaticCounts(timeIndex, i, a, r, v);
+                    transmitting += asymptomaticCounts(timeIndex, i, a, r, v) + treatableCounts(timeIndex, i, a, r, v) + infectiousCounts(timeIndex, i, a, r, v);
+                }
             }
 
+            asymptomatics(i, a) = (double)asymptomatic;
+            transmittings(i, a) = (double)transmitting;
+        }
+    }
+
+    for(unsigned int sinkNodeIndex=0; sinkNodeIndex < nodeIds.size(); sinkNodeIndex++)
+    {
+        int sinkNodeId = nodeIds[sinkNodeIndex];
+
+        double populationSink = populationNodes_(getNodeIndex(sinkNodeId));
+
+        std::vector<double> unvaccinatedProbabilities(StochasticSEATIRD::numAgeGroups_, 0.0);
+
+        for(unsigned int sourceNodeIndex=0; sourceNodeIndex < nodeIds.size(); sourceNodeIndex++)
+        {
+            int sourceNodeId = nodeIds[sourceNodeIndex];
+
+            double populationSource = populationNodes_(getNodeIndex(sourceNodeId));
+
             if(sinkNodeId != sourceNodeId)
             {
                 // flow data
@@ -963,22 +1178,19 @@ void StochasticSEATIRD::travel()
                         double numberOfInfectiousContactsIJ = 0.;
                         double numberOfInfectiousContactsJI = 0.;
 
-                        // todo: beta should be age-specific considering PHA's
-                        double beta = g_parameters.getR0() / g_parameters.getBetaScale();
-
                         for(int b=0; b<StochasticSEATIRD::numAgeGroups_; b++)
                         {
-                            double asymptomatic = asymptomatics[b];
+                            double asymptomatic = asymptomatics(sourceNodeIndex, b);
 
-                            double transmitting = transmittings[b];
+                            double transmitting = transmittings(sourceNodeIndex, b);
 
-                            double contactRate = contact[a][b];
+                            double contactRate = contactMatrix_.getContactRate(a, b);
 
-                            double npiEffectivenessAtI = Npi::getNpiEffectiveness(g_parameters.getNpis(), sinkNodeId, int(now_), a, b);
-                            double npiEffectivenessAtJ = Npi::getNpiEffectiveness(g_parameters.getNpis(), sourceNodeId, int(now_), a, b);
+                            double npiEffectivenessAtI = npiEffectiveness(sinkNodeIndex, a, b);
+                            double npiEffectivenessAtJ = npiEffectiveness(sourceNodeIndex, a, b);
 
-                            numberOfInfectiousContactsIJ += (1. - npiEffectivenessAtJ) * transmitting * beta * RHO * contactRate * sigma[a] / ageBasedFlowReductions[a];
-                            numberOfInfectiousContactsJI += (1. - npiEffectivenessAtI) * asymptomatic * beta * RHO * contactRate * sigma[a] / ageBasedFlowReductions[b];
+                            numberOfInfectiousContactsIJ += (1. - npiEffectivenessAtJ) * transmitting * beta * rho * contactRate * contactMatrix_.getSusceptibility(a) / ageBasedFlowReductions[a];
+                            numberOfInfectiousContactsJI += (1. - npiEffectivenessAtI) * asymptomatic * beta * rho * contactRate * contactMatrix_.getSusceptibility(a) / ageBasedFlowReductions[b];
                         }
 
                         unvaccinatedProbabilities[a] += travelFractionIJ * numberOfInfectiousContactsIJ / populationSource;
@@ -1004,7 +1216,7 @@ void StochasticSEATIRD::travel()
                         // - total vaccinated
                         // - => those with effective vaccinations
                         int ageRiskVaccinatedLatencyPopulationSize = getPopulationInVaccineLatencyPeriod(sinkNodeId, a, r);
-                        int ageRiskVaccinatedPopulationSize = populations_(nodeIdToIndex_[sinkNodeId], a, r, 1);
+                        int ageRiskVaccinatedPopulationSize = populations_(getNodeIndex(sinkNodeId), a, r, 1);
 
                         int ageRiskVaccinatedEffectivePopulationSize = ageRiskVaccinatedPopulationSize - ageRiskVaccinatedLatencyPopulationSize;
 
@@ -1014,18 +1226,17 @@ void StochasticSEATIRD::travel()
                         probability *= (1. - effectiveVaccineEffectiveness);
                     }
 
-                    std::vector<int> stratificationValues;
-                    stratificationValues.push_back(a);
-                    stratificationValues.push_back(r);
-                    stratificationValues.push_back(v);
-
-                    int sinkNumSusceptible = (int)(variables_["susceptible"](time_+1, nodeIdToIndex_[sinkNodeId], a, r, v) + 0.5); // continuity correction
+                    int sinkNumSusceptible = variables_["susceptible"](getDenseTimeIndex(time_+1), getNodeIndex(sinkNodeId), a, r, v);
 
                     if(sinkNumSusceptible > 0)
                     {
                         int numberOfExposures = (int)gsl_ran_binomial(randGenerator_, probability, sinkNumSusceptible);
 
-                        expose(numberOfExposures, sinkNodeId, stratificationValues);
+                        // schedules keep their stratification values as a vector; only build one for actual exposures
+                        if(numberOfExposures > 0)
+                        {
+                            expose(numberOfExposures, sinkNodeId, StratumIndex(a, r, v).getStratificationValues());
+                        }
                     }
                 }
             }
@@ -1045,33 +1256,79 @@ void StochasticSEATIRD::precompute(int time)
     shape(2) = StochasticSEATIRD::numRiskGroups_;
     shape(3) = StochasticSEATIRD::numVaccinatedGroups_;
 
-    blitz::Array<double, 1+NUM_STRATIFICATION_DIMENSIONS> populations(shape); // [nodeIndex, a, r, v]
+    blitz::Array<int, 1+NUM_STRATIFICATION_DIMENSIONS> populations(shape); // [nodeIndex, a, r, v]
+
+    // the population counts at time
+    populations = getCountsAtTime("population", time);
 
-    for(unsigned int i=0; i<nodeIds_.size(); i++)
+    for(int i=0; i<numNodes_; i++)
     {
-        int nodeId = nodeIds_[i];
+        populationNodes(i) = (double)blitz::sum(populations(i, blitz::Range::all(), blitz::Range::all(), blitz::Range::all()));
+    }
 
-        populationNodes((int)i) = getValue("population", time, nodeId);
+    populationNodes_.reference(populationNodes);
+    populations_.reference(populations);
+
+    // contact event rates for exposures until the next precompute
+    // todo: beta should be age-specific considering PHA's
+    double beta = getParameters().getR0() / getParameters().getBetaScale();
 
+    blitz::Array<double, 4> transmissionRates(numNodes_, StochasticSEATIRD::numAgeGroups_, StochasticSEATIRD::numAgeGroups_, StochasticSEATIRD::numRiskGroups_);
+
+    for(int i=0; i<numNodes_; i++)
+    {
         for(int a=0; a<StochasticSEATIRD::numAgeGroups_; a++)
         {
             for(int r=0; r<StochasticSEATIRD::numRiskGroups_; r++)
             {
-                for(int v=0; v<StochasticSEATIRD::numVaccinatedGroups_; v++)
-                {
-                    std::vector<int> stratificationValues;
-                    stratificationValues.push_back(a);
-                    stratificationValues.push_back(r);
-                    stratificationValues.push_back(v);
+                // fraction of the to group in population
+                // sum both unvaccinated and vaccinated stratifications
+                double toGroupFraction = (populations(i, a, r, 0) + populations(i, a, r, 1)) / populationNodes(i);
 
-                    populations((int)i, a, r, v) = getValue("population", time, nodeId, stratificationValues);
+                for(int sourceAge=0; sourceAge<StochasticSEATIRD::numAgeGroups_; sourceAge++)
+                {
+                    transmissionRates(i, sourceAge, a, r) = beta * contactMatrix_.getContactRate(sourceAge, a) * contactMatrix_.getSusceptibility(a) * toGroupFraction;
                 }
             }
         }
     }
 
-    populationNodes_.reference(populationNodes);
-    populations_.reference(populations);
+    transmissionRates_.reference(transmissionRates);
+
+    // vaccinated individuals in the vaccine latency period: vaccinated in (time - vaccineLatencyPeriod, time]
+    // a 0 day latency period will always give 0, as expected
+    int vaccineLatencyPeriod = getParameters().getVaccineLatencyPeriod();
+
+    blitz::Array<int, 1+NUM_STRATIFICATION_DIMENSIONS-1> vaccineLatencyPopulations(numNodes_, StochasticSEATIRD::numAgeGroups_, StochasticSEATIRD::numRiskGroups_);
+    vaccineLatencyPopulations = 0;
+
+    if(vaccineLatencyPeriod > 0)
+    {
+        // vaccinated stratification == 1
+        blitz::Array<int, 1+NUM_STRATIFICATION_DIMENSIONS> vaccinated = getCountsAtTime("vaccinated", time);
+        vaccineLatencyPopulations = vaccinated(blitz::Range::all(), blitz::Range::all(), blitz::Range::all(), 1);
+
+        if(time - vaccineLatencyPeriod >= 0)
+        {
+            blitz::Array<int, 1+NUM_STRATIFICATION_DIMENSIONS> vaccinatedBefore = getCountsAtTime("vaccinated", time - vaccineLatencyPeriod);
+            vaccineLatencyPopulations -= vaccinatedBefore(blitz::Range::all(), blitz::Range::all(), blitz::Range::all(), 1);
+        }
+    }
+
+    vaccineLatencyPopulations_.reference(vaccineLatencyPopulations);
+}
+
+blitz::Array<int, 1+NUM_STRATIFICATION_DIMENSIONS> StochasticSEATIRD::getCountsAtTime(const std::string &varName, int time)
+{
+    blitz::Array<int, 2+NUM_STRATIFICATION_DIMENSIONS> &variable = variables_[varName];
+
+    // times before the dense times are in the compressed history
+    if(time < getFirstDenseTime(varName))
+    {
+        return getHistorySlab(varName, time);
+    }
+
+    return variable(getDenseTimeIndex(time), blitz::Range::all(), blitz::Range::all(), blitz::Range::all(), blitz::Range::all()).copy();
 }
 
 int StochasticSEATIRD::getScheduleCount(const int &nodeId, const StochasticSEATIRDScheduleState &state, const std::vector<int> &stratificationValues)
@@ -1108,10 +1365,7 @@ bool StochasticSEATIRD::verifyScheduleCounts()
             {
                 for(int v=0; v<StochasticSEATIRD::numVaccinatedGroups_; v++)
                 {
-                    std::vector<int> stratificationValues;
-                    stratificationValues.push_back(a);
-                    stratificationValues.push_back(r);
-                    stratificationValues.push_back(v);
+                    std::vector<int> stratificationValues = StratumIndex(a, r, v).getStratificationValues();
 
                     // only verify exposed, asymptomatic, treatable, infectious, as these are the only states having events
 
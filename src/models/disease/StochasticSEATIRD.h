@@ -4,7 +4,8 @@
 #include "../../EpidemicSimulation.h"
 #include "StochasticSEATIRDEvent.h"
 #include "StochasticSEATIRDSchedule.h"
-#include "iliView.h"
+#include "IliSurveillance.h"
+#include "ContactMatrix.h"
 #include <boost/heap/pairing_heap.hpp>
 #include <gsl/gsl_rng.h>
 #include <gsl/gsl_randist.h>
@@ -18,25 +19,36 @@ class StochasticSEATIRD : public EpidemicSimulation
         StochasticSEATIRD();
         ~StochasticSEATIRD();
 
-        int expose(int num, int nodeId, std::vector<int> stratificationValues);
+        // reimplemented from EpidemicSimulation
+        boost::shared_ptr<EpidemicSimulation> clone();
+        void seed(unsigned long seed);
+
+        int expose(int num, int nodeId, const std::vector<int> &stratificationValues);
 
         void simulate();
 
         // derived variables
-        float getDerivedVarInfected(int time, int nodeId, std::vector<int> stratificationValues=std::vector<int>());
-        float getDerivedVarPopulationInVaccineLatencyPeriod(int time, int nodeId, std::vector<int> stratificationValues=std::vector<int>());
-        float getDerivedVarPopulationEffectiveVaccines(int time, int nodeId, std::vector<int> stratificationValues=std::vector<int>());
-        float getDerivedVarILI(int time, int nodeId, std::vector<int> stratificationValues=std::vector<int>());
+        float getDerivedVarInfected(int time, int nodeId, const std::vector<int> &stratificationValues=std::vector<int>());
+        float getDerivedVarPopulationInVaccineLatencyPeriod(int time, int nodeId, const std::vector<int> &stratificationValues=std::vector<int>());
+        float getDerivedVarPopulationEffectiveVaccines(int time, int nodeId, const std::vector<int> &stratificationValues=std::vector<int>());
+        float getDerivedVarILI(int time, int nodeId, const std::vector<int> &stratificationValues=std::vector<int>());
 
         // other ILI information
-        std::vector<Provider> getIliProviders();
+        int getNumIliProviders(int nodeId);
+
+        // mean and variance of the average "ILI reports" value of nodeId over [firstTime, lastTime] under the
+        // surveillance model, given the simulated infections; times must be in [1, getNumTimes())
+        void getIliReportMoments(int firstTime, int lastTime, int nodeId, float &mean, float &variance);
 
     private:
 
-        // dimensions of stratifications
-        static const int numAgeGroups_;
-        static const int numRiskGroups_;
-        static const int numVaccinatedGroups_;
+        // deep copy used by clone()
+        StochasticSEATIRD(const StochasticSEATIRD &simulation);
+
+        // dimensions of stratifications; the stratifications file must match
+        static const int numAgeGroups_ = DefaultStratificationLayout::numAgeGroups;
+        static const int numRiskGroups_ = DefaultStratificationLayout::numRiskGroups;
+        static const int numVaccinatedGroups_ = DefaultStratificationLayout::numVaccinatedGroups;
 
         // random number generators
         MTRand rand_;
@@ -54,12 +66,25 @@ class StochasticSEATIRD : public EpidemicSimulation
         // cached values
         int cachedTime_;
         blitz::Array<double, 1> populationNodes_;
-        blitz::Array<double, 1+NUM_STRATIFICATION_DIMENSIONS> populations_;
+        blitz::Array<int, 1+NUM_STRATIFICATION_DIMENSIONS> populations_;
+
+        // vaccinated individuals in the vaccine latency period: [nodeIndex, age group, risk group]
+        blitz::Array<int, 1+NUM_STRATIFICATION_DIMENSIONS-1> vaccineLatencyPopulations_;
+
+        // contact rates and susceptibilities by age group
+        ContactMatrix contactMatrix_;
+
+        // contact event rates of an exposed individual, rebuilt with the cached populations
+        // [nodeIndex, source age group, target age group, target risk group]
+        blitz::Array<double, 4> transmissionRates_;
 
         // ILI information
-        std::vector<Provider> iliProviders_;
+        IliSurveillance iliSurveillance_;
         std::vector<std::vector<float> > iliValues_;
 
+        // bind derived variable functions to this object
+        void bindDerivedVariables();
+
         // create contact events and insert them into the schedule
         void initializeContactEvents(StochasticSEATIRDSchedule &schedule, const int &nodeId, const std::vector<int> &stratificationValues);
 
@@ -67,6 +92,10 @@ class StochasticSEATIRD : public EpidemicSimulation
         bool processEvent(const int &nodeId, const StochasticSEATIRDEvent &event);
 
         // treatments
+
+        // priority group selection for all of the population, for pure pro-rata treatments
+        boost::shared_ptr<PriorityGroupSelections> priorityGroupSelectionsAll_;
+
         void applyAntiviralsToPriorityGroupSelections(boost::shared_ptr<PriorityGroupSelections> priorityGroupSelections);
         void applyVaccinesToPriorityGroupSelections(boost::shared_ptr<PriorityGroupSelections> priorityGroupSelections);
 
@@ -79,6 +108,9 @@ class StochasticSEATIRD : public EpidemicSimulation
         // precompute / cache values for each time step
         void precompute(int time);
 
+        // counts of a regular variable at time, from the dense times or the history: [nodeIndex, a, r, v]
+        blitz::Array<int, 1+NUM_STRATIFICATION_DIMENSIONS> getCountsAtTime(const std::string &varName, int time);
+
         // count number of active (not canceled) events in schedules corresponding to state and stratifications for nodeId
         int getScheduleCount(const int &nodeId, const StochasticSEATIRDScheduleState &state, const std::vector<int> &stratificationValues);
 
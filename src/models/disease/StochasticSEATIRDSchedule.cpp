@@ -3,7 +3,7 @@
 #include "../random.h"
 #include "../../log.h"
 
-StochasticSEATIRDSchedule::StochasticSEATIRDSchedule(const double &now, MTRand &rand, const std::vector<int> &stratificationValues)
+StochasticSEATIRDSchedule::StochasticSEATIRDSchedule(const double &now, MTRand &rand, Parameters &parameters, const std::vector<int> &stratificationValues)
 {
     stratificationValues_ = stratificationValues;
 
@@ -16,7 +16,7 @@ StochasticSEATIRDSchedule::StochasticSEATIRDSchedule(const double &now, MTRand &
     // generate all transitions starting from "exposed"
 
     // time to progress from exposed to asymptomatic
-    double Ta = now + random_exponential(1. / g_parameters.getTau(), &rand);
+    double Ta = now + random_exponential(1. / parameters.getTau(), &rand);
 
     // infected period begins at asymptomatic
     infectedTMin_ = Ta;
@@ -26,11 +26,11 @@ StochasticSEATIRDSchedule::StochasticSEATIRDSchedule(const double &now, MTRand &
     eventQueue_.push(StochasticSEATIRDEvent(now, Ta, EtoA, stratificationValues, stratificationValues));
 
     // compute nu (rate) from nu (CFR)
-    double nu = -1./g_parameters.getGamma() * log(1. - g_parameters.getNu(stratificationValues[0]));
+    double nu = -1./parameters.getGamma() * log(1. - parameters.getNu(stratificationValues[0]));
 
     // asymptomatic transition: -> treatable, -> recovered, or -> deceased
-    double Tt =  Ta + random_exponential(1. / g_parameters.getKappa(), &rand); // time to progress from asymptomatic to treatable
-    double Tr_a = Ta + random_exponential(1. / g_parameters.getGamma(), &rand); // time to recover from asymptomatic
+    double Tt =  Ta + random_exponential(1. / parameters.getKappa(), &rand); // time to progress from asymptomatic to treatable
+    double Tr_a = Ta + random_exponential(1. / parameters.getGamma(), &rand); // time to recover from asymptomatic
     double Td_a = Ta + random_exponential(nu, &rand); // time to death from asymptomatic
 
     if(Tt < Tr_a && Tt < Td_a)
@@ -39,8 +39,8 @@ StochasticSEATIRDSchedule::StochasticSEATIRDSchedule(const double &now, MTRand &
         eventQueue_.push(StochasticSEATIRDEvent(Ta, Tt, AtoT, stratificationValues, stratificationValues));
 
         // treatable transitions: -> infectious, -> recovered, or -> deceased
-        double Ti = Tt + g_parameters.getChi(); // time to progress from treatable to infectious
-        double Tr_ti = Tt + random_exponential(1. / g_parameters.getGamma(), &rand); // time to recover from treatable/infectious
+        double Ti = Tt + parameters.getChi(); // time to progress from treatable to infectious
+        double Tr_ti = Tt + random_exponential(1. / parameters.getGamma(), &rand); // time to recover from treatable/infectious
         double Td_ti = Tt + random_exponential(nu, &rand); // time to death from treatable/infectious
 
         if(Ti < Tr_ti && Ti < Td_ti)
@@ -152,7 +152,7 @@ void StochasticSEATIRDSchedule::popTopEvent()
     eventQueue_.pop();
 }
 
-std::vector<int> StochasticSEATIRDSchedule::getStratificationValues() const
+const std::vector<int> &StochasticSEATIRDSchedule::getStratificationValues() const
 {
     return stratificationValues_;
 }
@@ -182,7 +182,7 @@ void StochasticSEATIRDSchedule::cancel()
     canceled_ = true;
 }
 
-void StochasticSEATIRDSchedule::changeStratificationValues(std::vector<int> stratificationValues)
+void StochasticSEATIRDSchedule::changeStratificationValues(const std::vector<int> &stratificationValues)
 {
     stratificationValues_ = stratificationValues;
 
@@ -5,6 +5,8 @@
 #include "../MersenneTwister.h"
 #include <boost/heap/pairing_heap.hpp>
 
+class Parameters;
+
 // an individual corresponding to a schedule can be in any of these states
 // susceptible is not included, since events start after exposure
 // if these are modified, need to modify applyVaccines()!
@@ -22,7 +24,7 @@ class StochasticSEATIRDSchedule
 {
     public:
 
-        StochasticSEATIRDSchedule(const double &now, MTRand &rand, const std::vector<int> &stratificationValues);
+        StochasticSEATIRDSchedule(const double &now, MTRand &rand, Parameters &parameters, const std::vector<int> &stratificationValues);
 
         void insertEvent(const StochasticSEATIRDEvent &event);
 
@@ -37,7 +39,7 @@ class StochasticSEATIRDSchedule
         void popTopEvent();
 
         // get stratification of individual corresponding to this schedule
-        std::vector<int> getStratificationValues() const;
+        const std::vector<int> &getStratificationValues() const;
 
         // get state of individual corresponding to this schedule
         StochasticSEATIRDScheduleState getState() const;
@@ -53,7 +55,7 @@ class StochasticSEATIRDSchedule
         void cancel();
 
         // change stratifications (this is used when scheduled individuals are vaccinated)
-        void changeStratificationValues(std::vector<int> stratificationValues);
+        void changeStratificationValues(const std::vector<int> &stratificationValues);
 
         // todo: we could save the latest event time in this class to make the comparisons faster...
         class compareByNextEventTime
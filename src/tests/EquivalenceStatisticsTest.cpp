@@ -0,0 +1,97 @@
+// exercise-test-equivalence-statistics: two-sample tests and the Holm correction against hand-computed values
+
+#include "../tools/EquivalenceStatistics.h"
+#include "check.h"
+#include <vector>
+
+static std::vector<double> getSample(double a, double b, double c)
+{
+    std::vector<double> sample;
+    sample.push_back(a);
+    sample.push_back(b);
+    sample.push_back(c);
+
+    return sample;
+}
+
+int main(int argc, char * argv[])
+{
+    // Kolmogorov-Smirnov
+    {
+        // x = 1 2 3 4, y = 3 4 5 6: the distribution functions differ by 1/2 after 2, 3 and 4
+        std::vector<double> x;
+        std::vector<double> y;
+
+        for(int i=1; i<=4; i++)
+        {
+            x.push_back(i);
+            y.push_back(i + 2);
+        }
+
+        CHECK_CLOSE(getKolmogorovSmirnovStatistic(x, y), 0.5, 1e-12);
+        CHECK_CLOSE(getKolmogorovSmirnovStatistic(y, x), 0.5, 1e-12);
+        CHECK_CLOSE(getKolmogorovSmirnovStatistic(x, x), 0., 1e-12);
+
+        // ties across the samples are stepped past together: x = 1 2 2, y = 2 2 3 differ by 1/3 after 1 and 2
+        CHECK_CLOSE(getKolmogorovSmirnovStatistic(getSample(1., 2., 2.), getSample(2., 2., 3.)), 1. / 3., 1e-12);
+
+        // disjoint samples
+        CHECK_CLOSE(getKolmogorovSmirnovStatistic(getSample(1., 2., 3.), getSample(4., 5., 6.)), 1., 1e-12);
+
+        // tabulated critical values of the Kolmogorov distribution: Q(1.3581) = 0.05, Q(1.6276) = 0.01
+        CHECK_CLOSE(getKolmogorovProbability(1.3581), 0.05, 1e-4);
+        CHECK_CLOSE(getKolmogorovProbability(1.6276), 0.01, 1e-4);
+        CHECK(getKolmogorovProbability(0.1) == 1.);
+
+        // n = 4 * 4 / 8 = 2: lambda = (sqrt(2) + 0.12 + 0.11 / sqrt(2)) * 0.5 = 0.80600
+        CHECK_CLOSE(getKolmogorovSmirnovPValue(x, y), 0.534416, 1e-5);
+    }
+
+    // Mann-Whitney
+    {
+        // x entirely below y: U = 0, variance 3 * 3 / 12 * 7 = 5.25, z = (4.5 - 0.5) / sqrt(5.25)
+        CHECK_CLOSE(getMannWhitneyU(getSample(1., 2., 3.), getSample(4., 5., 6.)), 0., 1e-12);
+        CHECK_CLOSE(getMannWhitneyU(getSample(4., 5., 6.), getSample(1., 2., 3.)), 9., 1e-12);
+        CHECK_CLOSE(getMannWhitneyPValue(getSample(1., 2., 3.), getSample(4., 5., 6.)), 0.0808556, 1e-6);
+
+        // x = 1 2 2, y = 2 2 3: the four 2s share rank 3.5, so U = 1 + 3.5 + 3.5 - 6 = 2
+        // tie correction 4^3 - 4 = 60: variance 0.75 * (7 - 60 / 30) = 3.75, z = (2.5 - 0.5) / sqrt(3.75)
+        CHECK_CLOSE(getMannWhitneyU(getSample(1., 2., 2.), getSample(2., 2., 3.)), 2., 1e-12);
+        CHECK_CLOSE(getMannWhitneyPValue(getSample(1., 2., 2.), getSample(2., 2., 3.)), 0.301700, 1e-6);
+
+        // identical samples
+        CHECK_CLOSE(getMannWhitneyPValue(getSample(1., 2., 3.), getSample(1., 2., 3.)), 1., 1e-12);
+        CHECK_CLOSE(getMannWhitneyPValue(getSample(2., 2., 2.), getSample(2., 2., 2.)), 1., 1e-12);
+    }
+
+    // Holm-Bonferroni
+    {
+        // alpha 0.05 over 4 tests: thresholds 0.0125, 0.0167, 0.025, 0.05
+        std::vector<double> pValues;
+        pValues.push_back(0.001);
+        pValues.push_back(0.01);
+        pValues.push_back(0.02);
+        pValues.push_back(0.5);
+
+        CHECK(getHolmNumRejections(pValues, 0.05) == 3);
+        CHECK(getHolmNumRejections(pValues, 0.001) == 0);
+
+        // stops at the first acceptance, even if later p-values are below their own thresholds
+        pValues.clear();
+        pValues.push_back(0.03);
+        pValues.push_back(0.04);
+
+        CHECK(getHolmNumRejections(pValues, 0.05) == 0);
+
+        // a p-value equal to its threshold is rejected
+        pValues.clear();
+        pValues.push_back(0.01);
+        pValues.push_back(0.02);
+
+        CHECK(getHolmNumRejections(pValues, 0.02) == 2);
+
+        CHECK(getHolmNumRejections(std::vector<double>(), 0.05) == 0);
+    }
+
+    return CHECK_RESULT();
+}
@@ -0,0 +1,94 @@
+// exercise-test-ili-surveillance: report moments of the ILI surveillance model against hand-computed values
+
+#include "../main.h"
+#include "../models/disease/IliSurveillance.h"
+#include "check.h"
+#include <vector>
+
+// unused, but required by the simulation core
+std::string g_dataDirectory;
+
+int main(int argc, char * argv[])
+{
+    // mean squared noise standard deviation
+    float noiseSecondMoment = 4.f;
+
+    float mean, variance;
+
+    // start 0.5, continue 0.5: stationary probability 0.5, no autocorrelation
+    // one day of 10 infectious: mean 0.5 * 10, variance 0.5 * 4 + 0.25 * 100
+    {
+        float start[] = { 0.5f };
+        float cont[] = { 0.5f };
+
+        std::vector<float> infectious(1, 10.f);
+
+        IliSurveillance::getReportMoments(start, cont, 1, noiseSecondMoment, infectious, mean, variance);
+
+        CHECK_CLOSE(mean, 5., 1e-5);
+        CHECK_CLOSE(variance, 27., 1e-4);
+
+        // two independent days of 10 and 20: mean (5 + 10) / 2, variance (27 + 102) / 4
+        infectious.push_back(20.f);
+
+        IliSurveillance::getReportMoments(start, cont, 1, noiseSecondMoment, infectious, mean, variance);
+
+        CHECK_CLOSE(mean, 7.5, 1e-5);
+        CHECK_CLOSE(variance, 32.25, 1e-4);
+    }
+
+    // start 0.2, continue 0.8: stationary probability 0.5, lag-1 autocorrelation 0.6
+    // days of 10 and 20 add a covariance of 2 * 0.25 * 0.6 * 10 * 20 = 60: variance (129 + 60) / 4
+    {
+        float start[] = { 0.2f };
+        float cont[] = { 0.8f };
+
+        std::vector<float> infectious;
+        infectious.push_back(10.f);
+        infectious.push_back(20.f);
+
+        IliSurveillance::getReportMoments(start, cont, 1, noiseSecondMoment, infectious, mean, variance);
+
+        CHECK_CLOSE(mean, 7.5, 1e-5);
+        CHECK_CLOSE(variance, 47.25, 1e-4);
+
+        // a third day of 30: covariances 0.25 * 0.6 * (10 * 20 + 20 * 30) at lag 1, 0.25 * 0.36 * 10 * 30 at lag 2
+        // variance (27 + 102 + 227 + 2 * (120 + 27)) / 9
+        infectious.push_back(30.f);
+
+        IliSurveillance::getReportMoments(start, cont, 1, noiseSecondMoment, infectious, mean, variance);
+
+        CHECK_CLOSE(mean, 10., 1e-5);
+        CHECK_CLOSE(variance, 650. / 9., 1e-4);
+    }
+
+    // a provider that always reports adds only noise: with the first provider above on one day of 10,
+    // mean (5 + 10) / 2, variance (27 + 4) / 4
+    {
+        float start[] = { 0.5f, 1.f };
+        float cont[] = { 0.5f, 1.f };
+
+        std::vector<float> infectious(1, 10.f);
+
+        IliSurveillance::getReportMoments(start, cont, 2, noiseSecondMoment, infectious, mean, variance);
+
+        CHECK_CLOSE(mean, 7.5, 1e-5);
+        CHECK_CLOSE(variance, 7.75, 1e-5);
+    }
+
+    // no providers or no days
+    {
+        float start[] = { 0.5f };
+        float cont[] = { 0.5f };
+
+        IliSurveillance::getReportMoments(start, cont, 0, noiseSecondMoment, std::vector<float>(1, 10.f), mean, variance);
+
+        CHECK(mean == 0.f && variance == 0.f);
+
+        IliSurveillance::getReportMoments(start, cont, 1, noiseSecondMoment, std::vector<float>(), mean, variance);
+
+        CHECK(mean == 0.f && variance == 0.f);
+    }
+
+    return CHECK_RESULT();
+}
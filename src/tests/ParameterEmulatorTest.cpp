@@ -0,0 +1,138 @@
+// exercise-test-parameter-emulator: Legendre polynomials, the Cholesky solve and a quadratic fit of the parameter emulator
+
+#include "../ParameterEmulator.h"
+#include "../ParameterSweep.h"
+#include "check.h"
+#include <QtCore>
+#include <string>
+#include <vector>
+
+// unused, but required by the simulation core
+std::string g_dataDirectory;
+
+int main(int argc, char * argv[])
+{
+    // Legendre polynomials at 0.5: 1, 0.5, (3 * 0.25 - 1) / 2, (5 * 0.125 - 3 * 0.5) / 2
+    {
+        std::vector<double> values;
+
+        ParameterEmulator::getLegendrePolynomials(0.5, 3, values);
+
+        CHECK(values.size() == 4);
+        CHECK_CLOSE(values[0], 1., 1e-12);
+        CHECK_CLOSE(values[1], 0.5, 1e-12);
+        CHECK_CLOSE(values[2], -0.125, 1e-12);
+        CHECK_CLOSE(values[3], -0.4375, 1e-12);
+
+        // P_n(1) = 1 and P_n(-1) = (-1)^n
+        ParameterEmulator::getLegendrePolynomials(-1., 4, values);
+
+        CHECK_CLOSE(values[3], -1., 1e-12);
+        CHECK_CLOSE(values[4], 1., 1e-12);
+
+        ParameterEmulator::getLegendrePolynomials(0.3, 0, values);
+
+        CHECK(values.size() == 1);
+        CHECK_CLOSE(values[0], 1., 1e-12);
+    }
+
+    // [4 2; 2 3] x = b for b = (2, 1) and (6, 7): x = (0.5, 0) and (0.5, 2)
+    {
+        double matrixValues[] = { 4., 2., 2., 3. };
+        double rightHandSideValues[] = { 2., 6., 1., 7. };
+
+        std::vector<double> matrix(matrixValues, matrixValues + 4);
+        std::vector<double> rightHandSides(rightHandSideValues, rightHandSideValues + 4);
+        std::vector<double> solutions;
+
+        CHECK(ParameterEmulator::solveNormalEquations(2, matrix, rightHandSides, 2, solutions) == true);
+        CHECK(solutions.size() == 4);
+        CHECK_CLOSE(solutions[0], 0.5, 1e-12);
+        CHECK_CLOSE(solutions[1], 0.5, 1e-12);
+        CHECK_CLOSE(solutions[2], 0., 1e-12);
+        CHECK_CLOSE(solutions[3], 2., 1e-12);
+
+        // the Cholesky factor: [2 0; 1 sqrt(2)]
+        CHECK_CLOSE(matrix[0], 2., 1e-12);
+        CHECK_CLOSE(matrix[2], 1., 1e-12);
+        CHECK_CLOSE(matrix[3], sqrt(2.), 1e-12);
+    }
+
+    // a singular matrix is rejected
+    {
+        std::vector<double> matrix(4, 1.);
+        std::vector<double> rightHandSides(2, 1.);
+        std::vector<double> solutions;
+
+        CHECK(ParameterEmulator::solveNormalEquations(2, matrix, rightHandSides, 1, solutions) != true);
+    }
+
+    // a degree 2 fit to outputs that are exactly quadratic in one parameter recovers them everywhere in the range:
+    // 1 + 2x + 3x^2 and 4 - x, for x = 0 .. 4 with two replicates each
+    {
+        QString filename = QDir::temp().filePath("exercise-test-parameter-emulator.sweep");
+        QFile::remove(filename);
+
+        std::vector<std::string> parameterNames(1, "x");
+        std::vector<std::vector<double> > designPoints;
+
+        for(int p=0; p<5; p++)
+        {
+            designPoints.push_back(std::vector<double>(1, (double)p));
+        }
+
+        std::vector<std::string> metricNames;
+        metricNames.push_back("quadratic");
+        metricNames.push_back("linear");
+
+        ParameterSweepCube cube;
+
+        CHECK(cube.open(filename.toStdString(), parameterNames, designPoints, metricNames, 2, 1, 1) == true);
+
+        for(int p=0; p<5; p++)
+        {
+            double x = designPoints[p][0];
+
+            std::vector<float> metrics;
+            metrics.push_back((float)(1. + 2.*x + 3.*x*x));
+            metrics.push_back((float)(4. - x));
+
+            for(int r=0; r<2; r++)
+            {
+                CHECK(cube.setResult(p, r, metrics) == true);
+            }
+        }
+
+        ParameterEmulator emulator;
+
+        CHECK(emulator.train(cube, 2, 0., 0) == true);
+        CHECK(emulator.getNumTerms() == 3);
+
+        double min, max;
+        emulator.getParameterRange(0, min, max);
+
+        CHECK_CLOSE(min, 0., 1e-12);
+        CHECK_CLOSE(max, 4., 1e-12);
+
+        std::vector<double> outputs;
+
+        CHECK(emulator.predict(std::vector<double>(1, 2.5), outputs) == true);
+        CHECK(outputs.size() == 2);
+        CHECK_CLOSE(outputs[0], 24.75, 1e-4);
+        CHECK_CLOSE(outputs[1], 1.5, 1e-5);
+
+        // outside the range: clamped to x = 4
+        CHECK(emulator.predict(std::vector<double>(1, 5.), outputs) != true);
+        CHECK_CLOSE(outputs[0], 57., 1e-4);
+        CHECK_CLOSE(outputs[1], 0., 1e-5);
+
+        // holding out every other point leaves 2 points (4 replicates) for 3 terms; still enough rows, but the
+        // design then only varies over x = 1 and 3, so a degree 2 fit is singular
+        CHECK(emulator.train(cube, 2, 0., 2) != true);
+        CHECK(emulator.isValid() != true);
+
+        QFile::remove(filename);
+    }
+
+    return CHECK_RESULT();
+}
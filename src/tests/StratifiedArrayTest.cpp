@@ -0,0 +1,123 @@
+// exercise-test-stratified-array: offsets, layout matching and sums of compile-time stratified arrays
+
+#include "../StratifiedArray.h"
+#include "check.h"
+#include <string>
+#include <vector>
+
+int main(int argc, char * argv[])
+{
+    // row-major offsets, as in a data set's [age group][risk group][vaccinated] node slab
+    {
+        CHECK(DefaultStratificationLayout::size == 20);
+        CHECK(DefaultStratificationLayout::getOffset(0, 0, 0) == 0);
+        CHECK(DefaultStratificationLayout::getOffset(0, 0, 1) == 1);
+        CHECK(DefaultStratificationLayout::getOffset(0, 1, 0) == 2);
+        CHECK(DefaultStratificationLayout::getOffset(1, 0, 0) == 4);
+        CHECK(DefaultStratificationLayout::getOffset(3, 1, 1) == 15);
+        CHECK(DefaultStratificationLayout::getOffset(4, 1, 1) == 19);
+
+        typedef StratificationLayout<3, 4, 1> Layout;
+
+        CHECK(Layout::size == 12);
+        CHECK(Layout::getOffset(2, 3, 0) == 11);
+        CHECK(Layout::getOffset(1, 2, 0) == 6);
+    }
+
+    // layout matching against stratifications read from a file
+    {
+        std::vector<std::vector<std::string> > stratifications(3);
+        stratifications[0].resize(5);
+        stratifications[1].resize(2);
+        stratifications[2].resize(2);
+
+        CHECK(DefaultStratificationLayout::matches(stratifications) == true);
+
+        stratifications[0].resize(4);
+
+        CHECK(DefaultStratificationLayout::matches(stratifications) != true);
+
+        stratifications[0].resize(5);
+        stratifications.push_back(std::vector<std::string>(1));
+
+        CHECK(DefaultStratificationLayout::matches(stratifications) != true);
+    }
+
+    // stratum indices round trip through stratification values
+    {
+        StratumIndex index(3, 1, 0);
+
+        std::vector<int> stratificationValues = index.getStratificationValues();
+
+        CHECK(stratificationValues.size() == 3);
+        CHECK(stratificationValues[0] == 3);
+        CHECK(stratificationValues[1] == 1);
+        CHECK(stratificationValues[2] == 0);
+
+        StratumIndex copy(stratificationValues);
+
+        CHECK(copy.ageGroup == 3);
+        CHECK(copy.riskGroup == 1);
+        CHECK(copy.vaccinated == 0);
+
+        StratumIndex defaultIndex;
+
+        CHECK(defaultIndex.ageGroup == 0 && defaultIndex.riskGroup == 0 && defaultIndex.vaccinated == 0);
+    }
+
+    // element access, fill and sums; the value of each stratification is its offset
+    {
+        StratifiedArray<float> array(2.f);
+
+        CHECK_CLOSE(array.sum(), 40., 1e-6);
+
+        for(int a=0; a<5; a++)
+        {
+            for(int r=0; r<2; r++)
+            {
+                for(int v=0; v<2; v++)
+                {
+                    array(a, r, v) = (float)DefaultStratificationLayout::getOffset(a, r, v);
+                }
+            }
+        }
+
+        // 0 + 1 + ... + 19
+        CHECK_CLOSE(array.sum(), 190., 1e-6);
+
+        // offsets 14 and 15
+        CHECK_CLOSE(array.sum(3, 1), 29., 1e-6);
+
+        CHECK_CLOSE(array[StratumIndex(4, 0, 1)], 17., 1e-6);
+
+        array[StratumIndex(4, 0, 1)] = -1.f;
+
+        CHECK_CLOSE(array(4, 0, 1), -1., 1e-6);
+
+        const StratifiedArray<float> &constArray = array;
+
+        for(int i=0; i<DefaultStratificationLayout::size; i++)
+        {
+            CHECK_CLOSE(constArray.data()[i], i == 17 ? -1. : (double)i, 1e-6);
+        }
+
+        array.fill(0.5f);
+
+        CHECK_CLOSE(array.sum(), 10., 1e-6);
+        CHECK_CLOSE(array.sum(0, 0), 1., 1e-6);
+    }
+
+    // a non-default layout and an integer type
+    {
+        StratifiedArray<int, StratificationLayout<2, 1, 3> > array(1);
+
+        array(1, 0, 2) = 5;
+
+        CHECK(array.sum() == 10);
+        CHECK(array.sum(1, 0) == 7);
+        CHECK(array.sum(0, 0) == 3);
+        CHECK(array.data()[5] == 5);
+    }
+
+    return CHECK_RESULT();
+}
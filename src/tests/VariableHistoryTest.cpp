@@ -0,0 +1,103 @@
+// exercise-test-variable-history: VariableHistory decodes every appended time exactly
+
+#include "../VariableHistory.h"
+#include "check.h"
+#include <vector>
+
+#define NUM_NODES 3
+#define BLOCK_SIZE 40
+#define NUM_TIMES 50
+
+// counts of a node at a time: node 0 never changes, node 1 is all zero except every 10th time, and node 2 changes
+// every 3rd time with mostly zero values; the block spans two mask words
+static int getCount(int time, int nodeIndex, int i)
+{
+    if(nodeIndex == 0)
+    {
+        return i + 1;
+    }
+    else if(nodeIndex == 1)
+    {
+        return (time % 10 == 0 && i == 35) ? time + 1 : 0;
+    }
+
+    int run = time / 3;
+
+    return ((i + run) % 7 == 0) ? 1000 * run + i : 0;
+}
+
+int main(int argc, char * argv[])
+{
+    VariableHistory history(NUM_NODES, BLOCK_SIZE);
+
+    CHECK(history.getNumTimes() == 0);
+
+    std::vector<int> values(NUM_NODES * BLOCK_SIZE);
+
+    for(int t=0; t<NUM_TIMES; t++)
+    {
+        for(int n=0; n<NUM_NODES; n++)
+        {
+            for(int i=0; i<BLOCK_SIZE; i++)
+            {
+                values[n * BLOCK_SIZE + i] = getCount(t, n, i);
+            }
+        }
+
+        history.append(&values[0]);
+    }
+
+    CHECK(history.getNumTimes() == NUM_TIMES);
+
+    // times decoded whole, by node, and in place, in an order unrelated to the appends
+    for(int k=0; k<NUM_TIMES; k++)
+    {
+        int t = (k * 17) % NUM_TIMES;
+
+        std::vector<int> time(NUM_NODES * BLOCK_SIZE, -1);
+        history.getTime(t, &time[0]);
+
+        for(int n=0; n<NUM_NODES; n++)
+        {
+            std::vector<int> block(BLOCK_SIZE, -1);
+            history.getBlock(t, n, &block[0]);
+
+            const unsigned int * mask;
+            const int * nonzeroValues;
+
+            CHECK(history.findBlock(t, n, mask, nonzeroValues) == true);
+
+            for(int i=0; i<BLOCK_SIZE; i++)
+            {
+                int expected = getCount(t, n, i);
+
+                CHECK(time[n * BLOCK_SIZE + i] == expected);
+                CHECK(block[i] == expected);
+
+                // in place: set bits of the mask mark the nonzero values, in order
+                bool nonzero = (mask != NULL && (mask[i / 32] & (1u << (i % 32))) != 0);
+
+                CHECK(nonzero == (expected != 0));
+
+                if(nonzero == true)
+                {
+                    CHECK(*nonzeroValues == expected);
+                    nonzeroValues++;
+                }
+            }
+        }
+    }
+
+    // out of range
+    const unsigned int * mask;
+    const int * nonzeroValues;
+
+    CHECK(history.findBlock(NUM_TIMES, 0, mask, nonzeroValues) == false);
+    CHECK(history.findBlock(-1, 0, mask, nonzeroValues) == false);
+    CHECK(history.findBlock(0, NUM_NODES, mask, nonzeroValues) == false);
+
+    // unchanged blocks are not stored again: node 0 is a single run, so the history is far smaller than the dense times
+    CHECK(history.getBytes() < (long)(NUM_TIMES * NUM_NODES * BLOCK_SIZE * sizeof(int)) / 4);
+
+    return CHECK_RESULT();
+}
@@ -0,0 +1,37 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <math.h>
+#include <stdio.h>
+
+// minimal checks for the unit tests: each failure is reported and counted, and main() returns CHECK_RESULT()
+// so ctest sees a non-zero exit status
+
+static int g_numCheckFailures = 0;
+
+#define CHECK(condition) \
+    do \
+    { \
+        if(!(condition)) \
+        { \
+            fprintf(stderr, "%s:%i: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            g_numCheckFailures++; \
+        } \
+    } while(0)
+
+// |actual - expected| <= tolerance
+#define CHECK_CLOSE(actual, expected, tolerance) \
+    do \
+    { \
+        double checkActual = (double)(actual); \
+        double checkExpected = (double)(expected); \
+        if(!(fabs(checkActual - checkExpected) <= (tolerance))) \
+        { \
+            fprintf(stderr, "%s:%i: check failed: %s == %.9g, expected %.9g\n", __FILE__, __LINE__, #actual, checkActual, checkExpected); \
+            g_numCheckFailures++; \
+        } \
+    } while(0)
+
+#define CHECK_RESULT() (g_numCheckFailures == 0 ? 0 : 1)
+
+#endif
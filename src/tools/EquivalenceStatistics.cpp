@@ -0,0 +1,161 @@
+#include "EquivalenceStatistics.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+double getKolmogorovSmirnovStatistic(const std::vector<double> &x, const std::vector<double> &y)
+{
+    unsigned int i = 0;
+    unsigned int j = 0;
+
+    double d = 0.;
+
+    while(i < x.size() && j < y.size())
+    {
+        // step past all values equal to the smallest remaining one, in both samples
+        double value = std::min(x[i], y[j]);
+
+        while(i < x.size() && x[i] == value)
+        {
+            i++;
+        }
+
+        while(j < y.size() && y[j] == value)
+        {
+            j++;
+        }
+
+        d = std::max(d, fabs((double)i / (double)x.size() - (double)j / (double)y.size()));
+    }
+
+    return d;
+}
+
+double getKolmogorovProbability(double lambda)
+{
+    // the series converges slowly for small lambda, where the probability is 1 to many digits
+    if(lambda < 0.2)
+    {
+        return 1.;
+    }
+
+    double p = 0.;
+
+    for(int k=1; k<=100; k++)
+    {
+        double term = 2. * ((k % 2 == 1) ? 1. : -1.) * exp(-2. * (double)(k*k) * lambda * lambda);
+
+        p += term;
+
+        if(fabs(term) < 1e-12)
+        {
+            break;
+        }
+    }
+
+    return std::min(1., std::max(0., p));
+}
+
+double getKolmogorovSmirnovPValue(const std::vector<double> &x, const std::vector<double> &y)
+{
+    double d = getKolmogorovSmirnovStatistic(x, y);
+
+    double n = (double)x.size() * (double)y.size() / (double)(x.size() + y.size());
+
+    return getKolmogorovProbability((sqrt(n) + 0.12 + 0.11 / sqrt(n)) * d);
+}
+
+// U statistic of x and its variance under the null hypothesis, with ties given their average rank
+static void getMannWhitneyMoments(const std::vector<double> &x, const std::vector<double> &y, double &u, double &variance)
+{
+    // ranks of the pooled samples
+    std::vector<std::pair<double, int> > pooled;
+
+    for(unsigned int i=0; i<x.size(); i++)
+    {
+        pooled.push_back(std::pair<double, int>(x[i], 0));
+    }
+
+    for(unsigned int i=0; i<y.size(); i++)
+    {
+        pooled.push_back(std::pair<double, int>(y[i], 1));
+    }
+
+    std::sort(pooled.begin(), pooled.end());
+
+    double n1 = (double)x.size();
+    double n2 = (double)y.size();
+    double n = n1 + n2;
+
+    double rankSumX = 0.;
+    double tieSum = 0.;
+
+    for(unsigned int i=0; i<pooled.size(); )
+    {
+        unsigned int j = i;
+
+        while(j < pooled.size() && pooled[j].first == pooled[i].first)
+        {
+            j++;
+        }
+
+        double averageRank = 0.5 * (double)(i + 1 + j);
+        double ties = (double)(j - i);
+
+        tieSum += ties * ties * ties - ties;
+
+        for(unsigned int k=i; k<j; k++)
+        {
+            if(pooled[k].second == 0)
+            {
+                rankSumX += averageRank;
+            }
+        }
+
+        i = j;
+    }
+
+    u = rankSumX - n1 * (n1 + 1.) / 2.;
+    variance = n1 * n2 / 12. * ((n + 1.) - tieSum / (n * (n - 1.)));
+}
+
+double getMannWhitneyU(const std::vector<double> &x, const std::vector<double> &y)
+{
+    double u, variance;
+    getMannWhitneyMoments(x, y, u, variance);
+
+    return u;
+}
+
+double getMannWhitneyPValue(const std::vector<double> &x, const std::vector<double> &y)
+{
+    double u, variance;
+    getMannWhitneyMoments(x, y, u, variance);
+
+    // all values equal
+    if(variance <= 0.)
+    {
+        return 1.;
+    }
+
+    double z = (fabs(u - (double)x.size() * (double)y.size() / 2.) - 0.5) / sqrt(variance);
+
+    return std::min(1., erfc(std::max(0., z) / sqrt(2.)));
+}
+
+int getHolmNumRejections(const std::vector<double> &sortedPValues, double alpha)
+{
+    int numRejections = 0;
+
+    for(unsigned int i=0; i<sortedPValues.size(); i++)
+    {
+        if(sortedPValues[i] > alpha / (double)(sortedPValues.size() - i))
+        {
+            break;
+        }
+
+        numRejections++;
+    }
+
+    return numRejections;
+}
@@ -0,0 +1,28 @@
+#ifndef EQUIVALENCE_STATISTICS_H
+#define EQUIVALENCE_STATISTICS_H
+
+#include <vector>
+
+// two-sample tests used by the equivalence tool to compare fingerprints of different builds
+// samples x and y must be sorted
+
+// the largest difference between the empirical distribution functions of x and y
+double getKolmogorovSmirnovStatistic(const std::vector<double> &x, const std::vector<double> &y);
+
+// Q_KS(lambda) = 2 sum_k (-1)^(k-1) exp(-2 k^2 lambda^2), the asymptotic probability of a larger scaled statistic
+double getKolmogorovProbability(double lambda);
+
+// two-sided p-value of the two-sample Kolmogorov-Smirnov test (asymptotic distribution, with Stephens' correction)
+double getKolmogorovSmirnovPValue(const std::vector<double> &x, const std::vector<double> &y);
+
+// U statistic of x: the number of pairs (x_i, y_j) with x_i > y_j, ties counting 1/2
+double getMannWhitneyU(const std::vector<double> &x, const std::vector<double> &y);
+
+// two-sided p-value of the Mann-Whitney U test (normal approximation with continuity and tie corrections)
+double getMannWhitneyPValue(const std::vector<double> &x, const std::vector<double> &y);
+
+// Holm-Bonferroni: number of hypotheses rejected at family-wise level alpha, given p-values in increasing order
+// the i-th smallest p-value (from 0) is rejected while p <= alpha / (number of p-values - i)
+int getHolmNumRejections(const std::vector<double> &sortedPValues, double alpha);
+
+#endif
@@ -0,0 +1,26 @@
+#include "ReferenceScenario.h"
+#include "../EpidemicSimulation.h"
+
+std::vector<int> getReferenceScenarioNodeIds()
+{
+    // same as the defaults in EpidemicInitialCasesWidget
+    std::vector<int> nodeIds;
+
+    nodeIds.push_back(453);
+    nodeIds.push_back(113);
+    nodeIds.push_back(201);
+    nodeIds.push_back(141);
+    nodeIds.push_back(375);
+
+    return nodeIds;
+}
+
+void exposeReferenceScenarioCases(boost::shared_ptr<EpidemicSimulation> simulation)
+{
+    std::vector<int> nodeIds = getReferenceScenarioNodeIds();
+
+    for(unsigned int i=0; i<nodeIds.size(); i++)
+    {
+        simulation->expose(REFERENCE_SCENARIO_NUM_CASES, nodeIds[i], std::vector<int>(NUM_STRATIFICATION_DIMENSIONS, 0));
+    }
+}
@@ -0,0 +1,21 @@
+#ifndef REFERENCE_SCENARIO_H
+#define REFERENCE_SCENARIO_H
+
+#include <boost/shared_ptr.hpp>
+#include <vector>
+
+class EpidemicSimulation;
+
+// the reference configuration used by the benchmark and equivalence tools:
+// default parameters and the application's default initial cases
+
+#define REFERENCE_SCENARIO_NUM_CASES 10000
+#define REFERENCE_SCENARIO_NUM_DAYS 120
+
+// nodes with initial cases
+std::vector<int> getReferenceScenarioNodeIds();
+
+// expose the initial cases; the simulation must not have been simulated yet
+void exposeReferenceScenarioCases(boost::shared_ptr<EpidemicSimulation> simulation);
+
+#endif
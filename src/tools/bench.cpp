@@ -0,0 +1,711 @@
+// exercise-bench: microbenchmarks of simulation hot paths, and an end-to-end simulation benchmark
+//
+// usage: exercise-bench [options] [data directory]
+//
+//   --repetitions N        repetitions of each benchmark; the median is reported (default 5)
+//   --filter TEXT          only run benchmarks whose name contains TEXT
+//   --output FILE          write results as JSON to FILE (default: standard output)
+//   --compare FILE         compare against a baseline written by --output
+//   --threshold PERCENT    slowdown reported as a regression by --compare (default 10)
+//
+// all inputs are generated from fixed seeds, so runs are comparable across builds
+// with --compare, the exit status is 2 if any benchmark regressed
+
+#include "../main.h"
+#include "../EpidemicSimulation.h"
+#include "../Parameters.h"
+#include "../Npi.h"
+#include "../models/disease/StochasticSEATIRD.h"
+#include "../models/disease/StochasticSEATIRDSchedule.h"
+#include "../models/disease/IliSurveillance.h"
+#include "../models/MersenneTwister.h"
+#include "../log.h"
+#include "ReferenceScenario.h"
+#include <QtCore>
+#include <QElapsedTimer>
+#include <QtConcurrentMap>
+#include <algorithm>
+#include <map>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BENCH_SEED 1
+
+std::string g_dataDirectory;
+
+struct BenchmarkResult
+{
+    std::string name;
+
+    // operations per repetition
+    int iterations;
+
+    // nanoseconds per operation over the repetitions
+    double medianNs;
+    double minNs;
+    double maxNs;
+};
+
+// options
+static int repetitions = 5;
+static std::string filter;
+
+static std::vector<BenchmarkResult> results;
+
+static bool isSelected(const std::string &name)
+{
+    return filter.empty() == true || name.find(filter) != std::string::npos;
+}
+
+// record per-operation timings (one per repetition)
+static void addResult(const std::string &name, int iterations, std::vector<double> nsPerOperation)
+{
+    std::sort(nsPerOperation.begin(), nsPerOperation.end());
+
+    BenchmarkResult result;
+    result.name = name;
+    result.iterations = iterations;
+    result.medianNs = nsPerOperation[nsPerOperation.size() / 2];
+    result.minNs = nsPerOperation.front();
+    result.maxNs = nsPerOperation.back();
+
+    results.push_back(result);
+
+    // results are written directly, since log messages from a call site are rate limited
+    fprintf(stdout, "%s: %g ns (min %g, max %g)\n", name.c_str(), result.medianNs, result.minNs, result.maxNs);
+    fflush(stdout);
+}
+
+// a seeded StochasticSEATIRD with the reference scenario's initial cases
+static boost::shared_ptr<StochasticSEATIRD> newStandardSimulation()
+{
+    boost::shared_ptr<StochasticSEATIRD> simulation(new StochasticSEATIRD());
+    simulation->seed(BENCH_SEED);
+
+    exposeReferenceScenarioCases(simulation);
+
+    return simulation;
+}
+
+static std::vector<int> getRandomStratificationValues(MTRand &rand)
+{
+    std::vector<std::vector<std::string> > stratifications = EpidemicDataSet::getStratifications();
+
+    std::vector<int> stratificationValues;
+
+    for(unsigned int i=0; i<stratifications.size(); i++)
+    {
+        stratificationValues.push_back(rand.randInt(stratifications[i].size() - 1));
+    }
+
+    return stratificationValues;
+}
+
+static void benchmarkGetValue(boost::shared_ptr<EpidemicSimulation> simulation)
+{
+    const int iterations = 100000;
+
+    std::vector<int> nodeIds = simulation->getNodeIds();
+
+    // same lookups in every repetition
+    MTRand rand(BENCH_SEED);
+
+    std::vector<int> times(iterations);
+    std::vector<int> nodes(iterations);
+
+    for(int i=0; i<iterations; i++)
+    {
+        times[i] = rand.randInt(simulation->getNumTimes() - 1);
+        nodes[i] = nodeIds[rand.randInt(nodeIds.size() - 1)];
+    }
+
+    const char * names[] = { "getValue.node", "getValue.derived", "getValue.allNodes" };
+    const char * varNames[] = { "infectious", "All infected", "infectious" };
+
+    for(int b=0; b<3; b++)
+    {
+        if(isSelected(names[b]) != true)
+        {
+            continue;
+        }
+
+        // fewer iterations for the all-nodes sums
+        int numIterations = (b == 2) ? iterations / 100 : iterations;
+
+        std::string varName(varNames[b]);
+
+        std::vector<double> nsPerOperation;
+        volatile float sink = 0.;
+
+        for(int r=0; r<repetitions; r++)
+        {
+            QElapsedTimer timer;
+            timer.start();
+
+            for(int i=0; i<numIterations; i++)
+            {
+                sink += simulation->getValue(varName, times[i], (b == 2) ? NODES_ALL : nodes[i]);
+            }
+
+            nsPerOperation.push_back((double)timer.nsecsElapsed() / (double)numIterations);
+        }
+
+        addResult(names[b], numIterations, nsPerOperation);
+    }
+}
+
+// a share of the concurrent lookups, run by one thread
+struct ConcurrentLookups
+{
+    const EpidemicDataSet * dataSet;
+    const std::string * varName;
+    const std::vector<int> * times;
+    const std::vector<int> * nodeIndices;
+    int begin;
+    int end;
+    long long sum;
+};
+
+static void runConcurrentLookups(ConcurrentLookups &lookups)
+{
+    // empty: all stratifications
+    const std::vector<int> stratificationValues;
+
+    for(int i=lookups.begin; i<lookups.end; i++)
+    {
+        long long count;
+
+        if(lookups.dataSet->getCount(*lookups.varName, (*lookups.times)[i], (*lookups.nodeIndices)[i], stratificationValues, count) == true)
+        {
+            lookups.sum += count;
+        }
+    }
+}
+
+// the const query API from all cores at once; time per operation is wall time over all threads' operations
+static void benchmarkConcurrentGetCount(boost::shared_ptr<EpidemicSimulation> simulation)
+{
+    if(isSelected("getCount.concurrent") != true)
+    {
+        return;
+    }
+
+    const int iterations = 1000000;
+
+    const std::string varName("infectious");
+
+    // same lookups in every repetition
+    MTRand rand(BENCH_SEED);
+
+    std::vector<int> times(iterations);
+    std::vector<int> nodeIndices(iterations);
+
+    for(int i=0; i<iterations; i++)
+    {
+        times[i] = rand.randInt(simulation->getNumTimes() - 1);
+        nodeIndices[i] = rand.randInt(simulation->getNumNodes() - 1);
+    }
+
+    int numThreads = std::max(1, QThread::idealThreadCount());
+
+    std::vector<double> nsPerOperation;
+    volatile long long sink = 0;
+
+    for(int r=0; r<repetitions; r++)
+    {
+        std::vector<ConcurrentLookups> lookups(numThreads);
+
+        for(int t=0; t<numThreads; t++)
+        {
+            lookups[t].dataSet = simulation.get();
+            lookups[t].varName = &varName;
+            lookups[t].times = &times;
+            lookups[t].nodeIndices = &nodeIndices;
+            lookups[t].begin = (int)((long long)iterations * t / numThreads);
+            lookups[t].end = (int)((long long)iterations * (t+1) / numThreads);
+            lookups[t].sum = 0;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+
+        QtConcurrent::blockingMap(lookups, runConcurrentLookups);
+
+        nsPerOperation.push_back((double)timer.nsecsElapsed() / (double)iterations);
+
+        for(int t=0; t<numThreads; t++)
+        {
+            sink += lookups[t].sum;
+        }
+    }
+
+    addResult("getCount.concurrent", iterations, nsPerOperation);
+}
+
+static void benchmarkTransition()
+{
+    if(isSelected("transition") != true)
+    {
+        return;
+    }
+
+    const int iterations = 100000;
+
+    // the base simulation's expose() is a single susceptible -> exposed transition
+    EpidemicSimulation simulation;
+
+    std::vector<int> nodeIds = simulation.getNodeIds();
+
+    MTRand rand(BENCH_SEED);
+
+    std::vector<int> nodes(iterations);
+    std::vector<std::vector<int> > stratificationValues(iterations);
+
+    for(int i=0; i<iterations; i++)
+    {
+        nodes[i] = nodeIds[rand.randInt(nodeIds.size() - 1)];
+        stratificationValues[i] = getRandomStratificationValues(rand);
+    }
+
+    std::vector<double> nsPerOperation;
+
+    for(int r=0; r<repetitions; r++)
+    {
+        QElapsedTimer timer;
+        timer.start();
+
+        for(int i=0; i<iterations; i++)
+        {
+            simulation.expose(1, nodes[i], stratificationValues[i]);
+        }
+
+        nsPerOperation.push_back((double)timer.nsecsElapsed() / (double)iterations);
+    }
+
+    addResult("transition", iterations, nsPerOperation);
+}
+
+static void benchmarkScheduleConstruction()
+{
+    if(isSelected("schedule.construct") != true)
+    {
+        return;
+    }
+
+    const int iterations = 100000;
+
+    std::vector<double> nsPerOperation;
+
+    for(int r=0; r<repetitions; r++)
+    {
+        MTRand rand(BENCH_SEED);
+        std::vector<int> stratificationValues(NUM_STRATIFICATION_DIMENSIONS, 0);
+
+        QElapsedTimer timer;
+        timer.start();
+
+        for(int i=0; i<iterations; i++)
+        {
+            stratificationValues[0] = i % 5;
+
+            StochasticSEATIRDSchedule schedule(0., rand, g_parameters, stratificationValues);
+        }
+
+        nsPerOperation.push_back((double)timer.nsecsElapsed() / (double)iterations);
+    }
+
+    addResult("schedule.construct", iterations, nsPerOperation);
+}
+
+static void benchmarkIli(boost::shared_ptr<EpidemicSimulation> simulation)
+{
+    if(isSelected("ili.step") != true)
+    {
+        return;
+    }
+
+    const int iterations = 100;
+
+    IliSurveillance iliSurveillance;
+
+    std::vector<int> nodeIds = simulation->getNodeIds();
+
+    std::vector<float> infectious(nodeIds.size());
+    std::vector<float> population(nodeIds.size());
+
+    for(unsigned int i=0; i<nodeIds.size(); i++)
+    {
+        infectious[i] = simulation->getValue("All infected", simulation->getNumTimes() - 1, nodeIds[i]);
+        population[i] = simulation->getPopulation(nodeIds[i]);
+    }
+
+    std::vector<float> reports(nodeIds.size());
+    std::vector<double> nsPerOperation;
+
+    for(int r=0; r<repetitions; r++)
+    {
+        iliSurveillance.seed(BENCH_SEED);
+
+        QElapsedTimer timer;
+        timer.start();
+
+        for(int i=0; i<iterations; i++)
+        {
+            iliSurveillance.step(infectious, population, reports);
+        }
+
+        nsPerOperation.push_back((double)timer.nsecsElapsed() / (double)iterations);
+    }
+
+    addResult("ili.step", iterations, nsPerOperation);
+}
+
+static void benchmarkNpiEffectiveness(boost::shared_ptr<EpidemicSimulation> simulation)
+{
+    if(isSelected("npi.effectiveness") != true)
+    {
+        return;
+    }
+
+    const int iterations = 100000;
+
+    MTRand rand(BENCH_SEED);
+
+    std::vector<int> nodeIds = simulation->getNodeIds();
+
+    // ten NPIs, each over a tenth of the nodes
+    std::vector<boost::shared_ptr<Npi> > npis;
+
+    for(int n=0; n<10; n++)
+    {
+        std::vector<double> ageEffectiveness(5, 0.1 * (double)(n+1));
+
+        std::vector<int> npiNodeIds;
+
+        for(unsigned int i=n; i<nodeIds.size(); i+=10)
+        {
+            npiNodeIds.push_back(nodeIds[i]);
+        }
+
+        npis.push_back(boost::shared_ptr<Npi>(new Npi("bench", n, 30, ageEffectiveness, npiNodeIds)));
+    }
+
+    std::vector<int> nodes(iterations);
+    std::vector<int> times(iterations);
+
+    for(int i=0; i<iterations; i++)
+    {
+        nodes[i] = nodeIds[rand.randInt(nodeIds.size() - 1)];
+        times[i] = rand.randInt(60);
+    }
+
+    std::vector<double> nsPerOperation;
+    volatile double sink = 0.;
+
+    for(int r=0; r<repetitions; r++)
+    {
+        QElapsedTimer timer;
+        timer.start();
+
+        for(int i=0; i<iterations; i++)
+        {
+            sink += Npi::getNpiEffectiveness(npis, nodes[i], times[i], i % 5, (i / 5) % 5);
+        }
+
+        nsPerOperation.push_back((double)timer.nsecsElapsed() / (double)iterations);
+    }
+
+    addResult("npi.effectiveness", iterations, nsPerOperation);
+}
+
+// a year of the reference scenario: memory of the variables against dense storage, and lookups in the compressed
+// history
+static void benchmarkHistory()
+{
+    if(isSelected("getValue.history") != true)
+    {
+        return;
+    }
+
+    const int numDays = 365;
+    const int iterations = 100000;
+
+    boost::shared_ptr<StochasticSEATIRD> simulation = newStandardSimulation();
+
+    for(int d=0; d<numDays; d++)
+    {
+        simulation->simulate();
+    }
+
+    long bytes, denseBytes;
+    simulation->getVariableMemoryUsage(bytes, denseBytes);
+
+    put_flog(LOG_INFO, "%i days: variables use %.1f MB, %.1f MB if dense (%.1fx smaller)", numDays, (double)bytes / 1048576., (double)denseBytes / 1048576., (double)denseBytes / (double)std::max(bytes, 1L));
+
+    std::vector<int> nodeIds = simulation->getNodeIds();
+
+    MTRand rand(BENCH_SEED);
+
+    std::vector<int> times(iterations);
+    std::vector<int> nodes(iterations);
+
+    // times before the dense times
+    for(int i=0; i<iterations; i++)
+    {
+        times[i] = rand.randInt(numDays - DENSE_VARIABLE_TIMES);
+        nodes[i] = nodeIds[rand.randInt(nodeIds.size() - 1)];
+    }
+
+    std::vector<double> nsPerOperation;
+    volatile float sink = 0.;
+
+    for(int r=0; r<repetitions; r++)
+    {
+        QElapsedTimer timer;
+        timer.start();
+
+        for(int i=0; i<iterations; i++)
+        {
+            sink += simulation->getValue("infectious", times[i], nodes[i]);
+        }
+
+        nsPerOperation.push_back((double)timer.nsecsElapsed() / (double)iterations);
+    }
+
+    addResult("getValue.history", iterations, nsPerOperation);
+}
+
+// simulate the reference scenario
+// the per-phase results (including travel) are the per-day medians from the simulation profile
+static void benchmarkSimulate()
+{
+    if(isSelected("simulate") != true)
+    {
+        return;
+    }
+
+    std::vector<double> nsPerDay;
+    std::map<int, std::vector<double> > nsPerPhase;
+
+    for(int r=0; r<repetitions; r++)
+    {
+        boost::shared_ptr<StochasticSEATIRD> simulation = newStandardSimulation();
+        simulation->getProfile().setEnabled(true);
+
+        QElapsedTimer timer;
+        timer.start();
+
+        for(int d=0; d<REFERENCE_SCENARIO_NUM_DAYS; d++)
+        {
+            simulation->simulate();
+        }
+
+        nsPerDay.push_back((double)timer.nsecsElapsed() / (double)REFERENCE_SCENARIO_NUM_DAYS);
+
+        const std::vector<SimulationProfileDay> &days = simulation->getProfile().getDays();
+
+        for(int p=0; p<NUM_SIMULATION_PHASES; p++)
+        {
+            std::vector<double> phaseNs;
+
+            for(unsigned int d=0; d<days.size(); d++)
+            {
+                phaseNs.push_back((double)days[d].phaseDurations[p] * 1000.);
+            }
+
+            if(phaseNs.size() > 0)
+            {
+                std::sort(phaseNs.begin(), phaseNs.end());
+                nsPerPhase[p].push_back(phaseNs[phaseNs.size() / 2]);
+            }
+        }
+    }
+
+    addResult("simulate.day", REFERENCE_SCENARIO_NUM_DAYS, nsPerDay);
+
+    for(std::map<int, std::vector<double> >::iterator iter=nsPerPhase.begin(); iter!=nsPerPhase.end(); iter++)
+    {
+        QString phaseName = QString(SimulationProfile::getPhaseName((SIMULATION_PHASE)iter->first).c_str()).replace(' ', '_');
+
+        addResult(std::string("simulate.phase.") + phaseName.toStdString(), REFERENCE_SCENARIO_NUM_DAYS, iter->second);
+    }
+}
+
+static bool writeResults(FILE * file)
+{
+    fprintf(file, "{\n");
+    fprintf(file, "\"repetitions\": %i,\n", repetitions);
+    fprintf(file, "\"benchmarks\": [\n");
+
+    for(unsigned int i=0; i<results.size(); i++)
+    {
+        fprintf(file, "{\"name\": \"%s\", \"iterations\": %i, \"median_ns\": %.3f, \"min_ns\": %.3f, \"max_ns\": %.3f}%s\n", results[i].name.c_str(), results[i].iterations, results[i].medianNs, results[i].minNs, results[i].maxNs, (i+1 < results.size()) ? "," : "");
+    }
+
+    fprintf(file, "]\n");
+    fprintf(file, "}\n");
+
+    return ferror(file) == 0;
+}
+
+// read the medians of a results file written by writeResults()
+static bool readBaseline(std::string filename, std::map<std::string, double> &medians)
+{
+    QFile file(filename.c_str());
+
+    if(file.open(QIODevice::ReadOnly | QIODevice::Text) != true)
+    {
+        put_flog(LOG_ERROR, "could not open %s", filename.c_str());
+        return false;
+    }
+
+    QRegExp regExp("\"name\": \"([^\"]+)\".*\"median_ns\": ([0-9.eE+-]+)");
+
+    while(file.atEnd() != true)
+    {
+        QString line = QString(file.readLine());
+
+        if(regExp.indexIn(line) != -1)
+        {
+            medians[regExp.cap(1).toStdString()] = regExp.cap(2).toDouble();
+        }
+    }
+
+    return true;
+}
+
+// returns the number of regressions
+static int compareResults(const std::map<std::string, double> &baselineMedians, double threshold)
+{
+    int numRegressions = 0;
+
+    fprintf(stderr, "%-32s %14s %14s %9s\n", "benchmark", "baseline ns", "current ns", "change");
+
+    for(unsigned int i=0; i<results.size(); i++)
+    {
+        std::map<std::string, double>::const_iterator iter = baselineMedians.find(results[i].name);
+
+        if(iter == baselineMedians.end() || iter->second <= 0.)
+        {
+            fprintf(stderr, "%-32s %14s %14.1f %9s\n", results[i].name.c_str(), "-", results[i].medianNs, "new");
+            continue;
+        }
+
+        double change = results[i].medianNs / iter->second - 1.;
+
+        const char * flag = "";
+
+        if(change > threshold)
+        {
+            flag = "  REGRESSION";
+            numRegressions++;
+        }
+        else if(change < -threshold)
+        {
+            flag = "  improved";
+        }
+
+        fprintf(stderr, "%-32s %14.1f %14.1f %+8.1f%%%s\n", results[i].name.c_str(), iter->second, results[i].medianNs, change * 100., flag);
+    }
+
+    return numRegressions;
+}
+
+int main(int argc, char * argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    std::string outputFilename;
+    std::string baselineFilename;
+    double threshold = 0.1;
+
+    g_dataDirectory = QDir::current().absolutePath().toStdString();
+
+    for(int i=1; i<argc; i++)
+    {
+        std::string arg(argv[i]);
+
+        if(arg == "--repetitions" && i+1 < argc)
+        {
+            repetitions = std::max(1, atoi(argv[++i]));
+        }
+        else if(arg == "--filter" && i+1 < argc)
+        {
+            filter = argv[++i];
+        }
+        else if(arg == "--output" && i+1 < argc)
+        {
+            outputFilename = argv[++i];
+        }
+        else if(arg == "--compare" && i+1 < argc)
+        {
+            baselineFilename = argv[++i];
+        }
+        else if(arg == "--threshold" && i+1 < argc)
+        {
+            threshold = atof(argv[++i]) / 100.;
+        }
+        else if(arg.size() > 0 && arg[0] != '-')
+        {
+            g_dataDirectory = QDir(argv[i]).absolutePath().toStdString();
+        }
+        else
+        {
+            put_flog(LOG_ERROR, "usage: %s [--repetitions N] [--filter TEXT] [--output FILE] [--compare FILE] [--threshold PERCENT] [data directory]", argv[0]);
+            return 1;
+        }
+    }
+
+    // read the baseline first, so a bad filename fails before running
+    std::map<std::string, double> baselineMedians;
+
+    if(baselineFilename.empty() != true && readBaseline(baselineFilename, baselineMedians) != true)
+    {
+        return 1;
+    }
+
+    put_flog(LOG_INFO, "data directory %s, %i repetitions", g_dataDirectory.c_str(), repetitions);
+
+    // a simulation a few weeks in, for the lookup benchmarks
+    boost::shared_ptr<StochasticSEATIRD> simulation = newStandardSimulation();
+
+    for(int d=0; d<30; d++)
+    {
+        simulation->simulate();
+    }
+
+    benchmarkGetValue(simulation);
+    benchmarkConcurrentGetCount(simulation);
+    benchmarkTransition();
+    benchmarkScheduleConstruction();
+    benchmarkIli(simulation);
+    benchmarkNpiEffectiveness(simulation);
+    benchmarkHistory();
+    benchmarkSimulate();
+
+    log_flush();
+
+    if(outputFilename.empty() == true)
+    {
+        writeResults(stdout);
+    }
+    else
+    {
+        FILE * file = fopen(outputFilename.c_str(), "w");
+
+        if(file == NULL || writeResults(file) != true)
+        {
+            put_flog(LOG_ERROR, "could not write %s", outputFilename.c_str());
+            return 1;
+        }
+
+        fclose(file);
+    }
+
+    if(baselineFilename.empty() != true && compareResults(baselineMedians, threshold) > 0)
+    {
+        return 2;
+    }
+
+    return 0;
+}
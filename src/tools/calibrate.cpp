@@ -0,0 +1,157 @@
+// exercise-calibrate: calibrates the reference scenario against observed ILI with a particle filter
+//
+// usage: exercise-calibrate [options] --observations FILE [data directory]
+//
+//   --observations FILE    CSV file with lines: day, node id, mean daily ILI reports over the week ending on day
+//   --particles N          number of particles (default 200)
+//   --threshold F          resample when the effective sample size falls below F times the particles (default 0.5)
+//   --seed N               seed of the particles and resampling (default 1)
+//   --output FILE          write one row per observation to FILE: day, effective sample size, log-likelihood,
+//                          weighted mean and 5% / 95% quantiles of all infected, and seconds taken
+//
+// a filter assimilates each observation once, so updating an existing calibration with a new week only costs
+// simulating that week for every particle
+
+#include "../main.h"
+#include "../EpidemicSimulation.h"
+#include "../IliParticleFilter.h"
+#include "../models/disease/StochasticSEATIRD.h"
+#include "../log.h"
+#include "ReferenceScenario.h"
+#include <QtCore>
+#include <QElapsedTimer>
+#include <stdio.h>
+#include <stdlib.h>
+
+std::string g_dataDirectory;
+
+int main(int argc, char * argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    std::string observationsFilename;
+    int numParticles = ILI_PARTICLE_FILTER_DEFAULT_NUM_PARTICLES;
+    double resampleThreshold = ILI_PARTICLE_FILTER_DEFAULT_RESAMPLE_THRESHOLD;
+    unsigned long seed = 1;
+    std::string outputFilename;
+
+    g_dataDirectory = QDir::current().absolutePath().toStdString();
+
+    for(int i=1; i<argc; i++)
+    {
+        std::string arg(argv[i]);
+
+        if(arg == "--observations" && i+1 < argc)
+        {
+            observationsFilename = argv[++i];
+        }
+        else if(arg == "--particles" && i+1 < argc)
+        {
+            numParticles = std::max(1, atoi(argv[++i]));
+        }
+        else if(arg == "--threshold" && i+1 < argc)
+        {
+            resampleThreshold = atof(argv[++i]);
+        }
+        else if(arg == "--seed" && i+1 < argc)
+        {
+            seed = strtoul(argv[++i], NULL, 10);
+        }
+        else if(arg == "--output" && i+1 < argc)
+        {
+            outputFilename = argv[++i];
+        }
+        else if(arg.size() > 0 && arg[0] != '-')
+        {
+            g_dataDirectory = QDir(argv[i]).absolutePath().toStdString();
+        }
+        else
+        {
+            observationsFilename.clear();
+            break;
+        }
+    }
+
+    if(observationsFilename.empty() == true)
+    {
+        put_flog(LOG_ERROR, "usage: %s --observations FILE [--particles N] [--threshold F] [--seed N] [--output FILE] [data directory]", argv[0]);
+        return 1;
+    }
+
+    std::vector<IliObservation> observations;
+
+    if(IliParticleFilter::readObservations(observationsFilename, observations) != true)
+    {
+        return 1;
+    }
+
+    FILE * file = NULL;
+
+    if(outputFilename.empty() != true)
+    {
+        file = fopen(outputFilename.c_str(), "w");
+
+        if(file == NULL)
+        {
+            put_flog(LOG_ERROR, "could not open %s", outputFilename.c_str());
+            return 1;
+        }
+
+        fprintf(file, "day,ess,log_likelihood,infected_mean,infected_q05,infected_q95,seconds\n");
+    }
+
+    put_flog(LOG_INFO, "data directory %s", g_dataDirectory.c_str());
+
+    boost::shared_ptr<EpidemicSimulation> simulation(new StochasticSEATIRD());
+    exposeReferenceScenarioCases(simulation);
+
+    IliParticleFilter filter(simulation);
+    filter.setNumParticles(numParticles);
+    filter.setResampleThreshold(resampleThreshold);
+    filter.setSeed(seed);
+
+    fprintf(stdout, "%6s %10s %16s %14s %14s %14s %10s\n", "day", "ESS", "log-likelihood", "infected", "5%", "95%", "seconds");
+
+    bool success = true;
+
+    for(unsigned int i=0; i<observations.size(); i++)
+    {
+        QElapsedTimer timer;
+        timer.start();
+
+        if(filter.assimilate(observations[i]) != true)
+        {
+            success = false;
+            break;
+        }
+
+        double seconds = (double)timer.nsecsElapsed() / 1000000000.;
+
+        int time = observations[i].time;
+
+        double mean = filter.getWeightedMean("All infected", time, NODES_ALL);
+        double q05 = filter.getWeightedQuantile("All infected", time, NODES_ALL, 0.05);
+        double q95 = filter.getWeightedQuantile("All infected", time, NODES_ALL, 0.95);
+
+        fprintf(stdout, "%6i %10.1f %16.4f %14.0f %14.0f %14.0f %10.3f\n", time, filter.getEffectiveSampleSize(), filter.getLogLikelihood(), mean, q05, q95, seconds);
+
+        if(file != NULL)
+        {
+            fprintf(file, "%i,%.9g,%.9g,%.9g,%.9g,%.9g,%.6f\n", time, filter.getEffectiveSampleSize(), filter.getLogLikelihood(), mean, q05, q95, seconds);
+        }
+    }
+
+    if(file != NULL)
+    {
+        if(ferror(file) != 0)
+        {
+            success = false;
+        }
+
+        fclose(file);
+    }
+
+    log_flush();
+
+    return (success == true) ? 0 : 1;
+}
@@ -0,0 +1,52 @@
+// exercise-datapack: generate the binary data pack from the source files in a data directory
+//
+// usage: exercise-datapack [data directory]
+//
+// the application regenerates the pack at startup when it is missing or out of date;
+// this tool allows generating it ahead of time, e.g. when installing to a read-only location
+
+#include "../main.h"
+#include "../DataPack.h"
+#include "../log.h"
+#include <QtCore>
+
+std::string g_dataDirectory;
+
+int main(int argc, char * argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    if(argc > 2)
+    {
+        put_flog(LOG_ERROR, "usage: %s [data directory]", argv[0]);
+        return 1;
+    }
+
+    if(argc == 2)
+    {
+        g_dataDirectory = QDir(argv[1]).absolutePath().toStdString();
+    }
+    else
+    {
+        g_dataDirectory = QDir::current().absolutePath().toStdString();
+    }
+
+    put_flog(LOG_INFO, "building data pack in %s", g_dataDirectory.c_str());
+
+    if(DataPack::build() != true)
+    {
+        put_flog(LOG_ERROR, "could not build data pack %s", DataPack::getFilename().c_str());
+        return 1;
+    }
+
+    // verify the result maps and is current
+    if(DataPack::open() == NULL)
+    {
+        put_flog(LOG_ERROR, "could not open generated data pack %s", DataPack::getFilename().c_str());
+        return 1;
+    }
+
+    put_flog(LOG_INFO, "wrote %s", DataPack::getFilename().c_str());
+
+    return 0;
+}
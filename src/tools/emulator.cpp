@@ -0,0 +1,191 @@
+// exercise-emulator: trains a ParameterEmulator from an exercise-sweep result file
+//
+// usage: exercise-emulator [options] SWEEP_FILE
+//
+//   --degree N             total degree of the polynomial expansion (default 2)
+//   --ridge L              ridge penalty, relative to the number of replicates (default 1e-6)
+//   --validate K           first train without every K-th design point and report the error on those points
+//   --output FILE          write the emulator (trained on all design points) to FILE, for loading in the application
+//
+// for curves in the emulator, the sweep needs --curves; a Latin hypercube design covers the parameter space with
+// far fewer points than a grid for the same degree
+
+#include "../main.h"
+#include "../ParameterSweep.h"
+#include "../ParameterEmulator.h"
+#include "../log.h"
+#include <QtCore>
+#include <QElapsedTimer>
+#include <cmath>
+#include <stdio.h>
+#include <stdlib.h>
+
+// unused, but required by the simulation core
+std::string g_dataDirectory;
+
+// error of emulated outputs against the replicate means of held-out design points
+// reports each scalar metric, and all curve outputs pooled
+static void validate(const ParameterSweepCube &cube, int degree, double ridge, int holdoutStride)
+{
+    ParameterEmulator emulator;
+
+    if(emulator.train(cube, degree, ridge, holdoutStride) != true)
+    {
+        return;
+    }
+
+    std::vector<std::vector<double> > designPoints = cube.getDesignPoints();
+    std::vector<std::string> metricNames = cube.getMetricNames();
+
+    // sums of squared errors and of squares about the mean, for "curves" at index metricNames.size()
+    std::vector<double> sumSquaredErrors(metricNames.size() + 1, 0.);
+    std::vector<double> sums(metricNames.size() + 1, 0.);
+    std::vector<double> sumSquares(metricNames.size() + 1, 0.);
+    std::vector<int> counts(metricNames.size() + 1, 0);
+
+    std::vector<double> outputs;
+
+    for(unsigned int p=0; p<designPoints.size(); p+=holdoutStride)
+    {
+        emulator.predict(designPoints[p], outputs);
+
+        for(unsigned int m=0; m<metricNames.size(); m++)
+        {
+            double mean, standardDeviation;
+
+            if(cube.getSummary(p, m, mean, standardDeviation) != true)
+            {
+                continue;
+            }
+
+            int index = (metricNames[m].compare(0, 9, "infected.") == 0) ? metricNames.size() : m;
+
+            sumSquaredErrors[index] += (outputs[m] - mean) * (outputs[m] - mean);
+            sums[index] += mean;
+            sumSquares[index] += mean * mean;
+            counts[index]++;
+        }
+    }
+
+    fprintf(stdout, "validation on every %i-th design point:\n", holdoutStride);
+    fprintf(stdout, "%-24s %8s %14s %10s\n", "output", "points", "RMSE", "R^2");
+
+    for(unsigned int m=0; m<=metricNames.size(); m++)
+    {
+        if(counts[m] == 0)
+        {
+            continue;
+        }
+
+        double n = (double)counts[m];
+        double variance = sumSquares[m] / n - (sums[m] / n) * (sums[m] / n);
+
+        double rSquared = 1.;
+
+        if(variance > 0.)
+        {
+            rSquared = 1. - sumSquaredErrors[m] / n / variance;
+        }
+
+        fprintf(stdout, "%-24s %8i %14.6g %10.4f\n", (m < metricNames.size()) ? metricNames[m].c_str() : "curves", counts[m], sqrt(sumSquaredErrors[m] / n), rSquared);
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    int degree = PARAMETER_EMULATOR_DEFAULT_DEGREE;
+    double ridge = PARAMETER_EMULATOR_DEFAULT_RIDGE;
+    int holdoutStride = 0;
+    std::string outputFilename;
+    std::string sweepFilename;
+
+    for(int i=1; i<argc; i++)
+    {
+        std::string arg(argv[i]);
+
+        if(arg == "--degree" && i+1 < argc)
+        {
+            degree = std::max(0, atoi(argv[++i]));
+        }
+        else if(arg == "--ridge" && i+1 < argc)
+        {
+            ridge = atof(argv[++i]);
+        }
+        else if(arg == "--validate" && i+1 < argc)
+        {
+            holdoutStride = std::max(2, atoi(argv[++i]));
+        }
+        else if(arg == "--output" && i+1 < argc)
+        {
+            outputFilename = argv[++i];
+        }
+        else if(arg.size() > 0 && arg[0] != '-')
+        {
+            sweepFilename = arg;
+        }
+        else
+        {
+            sweepFilename.clear();
+            break;
+        }
+    }
+
+    if(sweepFilename.empty() == true)
+    {
+        put_flog(LOG_ERROR, "usage: %s [--degree N] [--ridge L] [--validate K] [--output FILE] SWEEP_FILE", argv[0]);
+        return 1;
+    }
+
+    ParameterSweepCube cube;
+
+    if(cube.open(sweepFilename) != true)
+    {
+        return 1;
+    }
+
+    if(holdoutStride > 0)
+    {
+        validate(cube, degree, ridge, holdoutStride);
+    }
+
+    if(outputFilename.empty() != true)
+    {
+        ParameterEmulator emulator;
+
+        if(emulator.train(cube, degree, ridge) != true || emulator.save(outputFilename) != true)
+        {
+            return 1;
+        }
+
+        // evaluation cost at the center of the design
+        std::vector<double> center;
+
+        for(unsigned int i=0; i<emulator.getParameterNames().size(); i++)
+        {
+            double min, max;
+            emulator.getParameterRange(i, min, max);
+
+            center.push_back(0.5 * (min + max));
+        }
+
+        std::vector<double> outputs;
+
+        QElapsedTimer timer;
+        timer.start();
+
+        int numEvaluations = 1000;
+
+        for(int i=0; i<numEvaluations; i++)
+        {
+            emulator.predict(center, outputs);
+        }
+
+        fprintf(stdout, "%i terms, %i outputs: %.2f microseconds per evaluation\n", emulator.getNumTerms(), (int)outputs.size(), (double)timer.nsecsElapsed() / 1000. / (double)numEvaluations);
+    }
+
+    log_flush();
+
+    return 0;
+}
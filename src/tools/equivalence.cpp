@@ -0,0 +1,427 @@
+// exercise-equivalence: distributional fingerprints of the reference scenario, for checking that changes to the
+// model's scheduling or sampling leave its behavior statistically unchanged
+//
+// usage: exercise-equivalence [options] [data directory]
+//
+//   --replicates N         number of replicates (default 200)
+//   --first-seed N         seed of the first replicate; replicate i uses first-seed + i (default 1)
+//   --record FILE          write the fingerprint to FILE
+//   --compare FILE         compare with a fingerprint recorded by another build
+//   --alpha A              family-wise significance level for --compare (default 0.01)
+//
+// a fingerprint holds, for every replicate: final size and peak day, overall and for each group (HSR), and each
+// compartment of each group at fixed checkpoint days
+// --compare runs two-sample Kolmogorov-Smirnov and Mann-Whitney U tests on every metric, with a Holm correction
+// for the number of tests; the exit status is 2 if any difference is significant
+//
+// compare against a fingerprint from a different range of seeds (--first-seed) to avoid comparing identical samples
+
+#include "../main.h"
+#include "../EpidemicSimulation.h"
+#include "../models/disease/StochasticSEATIRD.h"
+#include "../log.h"
+#include "ReferenceScenario.h"
+#include "EquivalenceStatistics.h"
+#include <QtCore>
+#include <QtConcurrentMap>
+#include <algorithm>
+#include <map>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define EQUIVALENCE_DEFAULT_NUM_REPLICATES 200
+#define EQUIVALENCE_DEFAULT_ALPHA 0.01
+
+std::string g_dataDirectory;
+
+// metric name -> value for each replicate
+typedef std::map<std::string, std::vector<double> > Fingerprint;
+
+static const char * compartmentNames[] = { "exposed", "asymptomatic", "treatable", "infectious", "recovered", "deceased" };
+static const int numCompartments = sizeof(compartmentNames) / sizeof(compartmentNames[0]);
+
+static const int checkpointDays[] = { 30, 60, REFERENCE_SCENARIO_NUM_DAYS };
+static const int numCheckpointDays = sizeof(checkpointDays) / sizeof(checkpointDays[0]);
+
+static std::string getMetricName(std::string prefix, std::string groupName)
+{
+    // names are whitespace-separated in the fingerprint file
+    std::replace(groupName.begin(), groupName.end(), ' ', '_');
+
+    return prefix + "." + groupName;
+}
+
+struct Replicate
+{
+    boost::shared_ptr<EpidemicSimulation> simulation;
+};
+
+// runs a replicate and returns its metrics; used from worker threads on the replicate's own copy of the simulation
+struct ReplicateRunner
+{
+    typedef std::map<std::string, double> result_type;
+
+    std::map<std::string, double> operator()(const Replicate &replicate) const
+    {
+        boost::shared_ptr<EpidemicSimulation> simulation = replicate.simulation;
+
+        exposeReferenceScenarioCases(simulation);
+
+        for(int d=0; d<REFERENCE_SCENARIO_NUM_DAYS; d++)
+        {
+            simulation->simulate();
+        }
+
+        std::map<std::string, double> metrics;
+
+        std::vector<std::string> groupNames = simulation->getGroupNames();
+        groupNames.insert(groupNames.begin(), "all");
+
+        int endTime = simulation->getNumTimes() - 1;
+
+        for(unsigned int g=0; g<groupNames.size(); g++)
+        {
+            std::vector<int> nodeIds;
+
+            if(g == 0)
+            {
+                nodeIds = simulation->getNodeIds();
+            }
+            else
+            {
+                nodeIds = simulation->getNodeIds(groupNames[g]);
+            }
+
+            // final size: everyone who left the susceptible compartment
+            double population = simulation->getPopulation(nodeIds);
+            double susceptible = 0.;
+
+            for(unsigned int i=0; i<nodeIds.size(); i++)
+            {
+                susceptible += simulation->getValue("susceptible", endTime, nodeIds[i]);
+            }
+
+            metrics[getMetricName("final_size", groupNames[g])] = population - susceptible;
+
+            // peak day and height of all infected
+            int peakDay = 0;
+            double peakInfected = -1.;
+
+            for(int t=0; t<=endTime; t++)
+            {
+                double infected = 0.;
+
+                for(unsigned int i=0; i<nodeIds.size(); i++)
+                {
+                    infected += simulation->getValue("All infected", t, nodeIds[i]);
+                }
+
+                if(infected > peakInfected)
+                {
+                    peakDay = t;
+                    peakInfected = infected;
+                }
+            }
+
+            metrics[getMetricName("peak_day", groupNames[g])] = peakDay;
+            metrics[getMetricName("peak_infected", groupNames[g])] = peakInfected;
+
+            // compartments at the checkpoints
+            for(int c=0; c<numCompartments; c++)
+            {
+                for(int d=0; d<numCheckpointDays; d++)
+                {
+                    double value = 0.;
+
+                    for(unsigned int i=0; i<nodeIds.size(); i++)
+                    {
+                        value += simulation->getValue(compartmentNames[c], std::min(checkpointDays[d], endTime), nodeIds[i]);
+                    }
+
+                    metrics[getMetricName(std::string(compartmentNames[c]) + ".day" + QString::number(checkpointDays[d]).toStdString(), groupNames[g])] = value;
+                }
+            }
+        }
+
+        return metrics;
+    }
+};
+
+static bool runReplicates(int numReplicates, unsigned long firstSeed, Fingerprint &fingerprint)
+{
+    // replicates are copies of one initial simulation, so the data are only loaded once
+    boost::shared_ptr<EpidemicSimulation> initialSimulation(new StochasticSEATIRD());
+
+    // bounded batches keep memory use to a few simulations per thread
+    int batchSize = 2 * std::max(1, QThread::idealThreadCount());
+
+    for(int first=0; first<numReplicates; first+=batchSize)
+    {
+        // copying reads the initial simulation, so all copies are made here before any worker starts
+        QList<Replicate> replicates;
+
+        for(int r=first; r<std::min(first + batchSize, numReplicates); r++)
+        {
+            Replicate replicate;
+            replicate.simulation = initialSimulation->clone();
+
+            if(replicate.simulation == NULL)
+            {
+                put_flog(LOG_ERROR, "could not copy simulation");
+                return false;
+            }
+
+            replicate.simulation->seed(firstSeed + r);
+
+            replicates.push_back(replicate);
+        }
+
+        QList<std::map<std::string, double> > results = QtConcurrent::blockingMapped<QList<std::map<std::string, double> > >(replicates, ReplicateRunner());
+
+        for(int i=0; i<results.size(); i++)
+        {
+            for(std::map<std::string, double>::iterator iter=results[i].begin(); iter!=results[i].end(); iter++)
+            {
+                fingerprint[iter->first].push_back(iter->second);
+            }
+        }
+
+        put_flog(LOG_INFO, "simulated %i / %i replicates", std::min(first + batchSize, numReplicates), numReplicates);
+    }
+
+    return true;
+}
+
+// one metric per line: name followed by the value of each replicate
+static bool writeFingerprint(std::string filename, const Fingerprint &fingerprint, unsigned long firstSeed)
+{
+    FILE * file = fopen(filename.c_str(), "w");
+
+    if(file == NULL)
+    {
+        put_flog(LOG_ERROR, "could not open %s", filename.c_str());
+        return false;
+    }
+
+    fprintf(file, "# exercise-equivalence fingerprint, first seed %lu\n", firstSeed);
+
+    for(Fingerprint::const_iterator iter=fingerprint.begin(); iter!=fingerprint.end(); iter++)
+    {
+        fprintf(file, "%s", iter->first.c_str());
+
+        for(unsigned int i=0; i<iter->second.size(); i++)
+        {
+            fprintf(file, " %.9g", iter->second[i]);
+        }
+
+        fprintf(file, "\n");
+    }
+
+    bool success = (ferror(file) == 0);
+
+    fclose(file);
+
+    return success;
+}
+
+static bool readFingerprint(std::string filename, Fingerprint &fingerprint)
+{
+    QFile file(filename.c_str());
+
+    if(file.open(QIODevice::ReadOnly | QIODevice::Text) != true)
+    {
+        put_flog(LOG_ERROR, "could not open %s", filename.c_str());
+        return false;
+    }
+
+    while(file.atEnd() != true)
+    {
+        QStringList fields = QString(file.readLine()).split(' ', QString::SkipEmptyParts);
+
+        if(fields.size() < 2 || fields[0].startsWith("#") == true)
+        {
+            continue;
+        }
+
+        std::vector<double> &values = fingerprint[fields[0].toStdString()];
+
+        for(int i=1; i<fields.size(); i++)
+        {
+            values.push_back(fields[i].trimmed().toDouble());
+        }
+    }
+
+    return true;
+}
+
+static double getQuantile(const std::vector<double> &sortedValues, double q)
+{
+    return sortedValues[(int)(q * (double)(sortedValues.size() - 1) + 0.5)];
+}
+
+struct MetricComparison
+{
+    std::string name;
+    double pValue;
+    std::string test;
+};
+
+static bool comparePValues(const MetricComparison &lhs, const MetricComparison &rhs)
+{
+    return lhs.pValue < rhs.pValue;
+}
+
+// returns the number of metrics that differ significantly
+static int compareFingerprints(const Fingerprint &baseline, const Fingerprint &current, double alpha)
+{
+    std::vector<MetricComparison> comparisons;
+
+    fprintf(stderr, "%-40s %28s %28s %9s %9s\n", "metric", "baseline 5% / 50% / 95%", "current 5% / 50% / 95%", "KS p", "MW p");
+
+    for(Fingerprint::const_iterator iter=current.begin(); iter!=current.end(); iter++)
+    {
+        Fingerprint::const_iterator baselineIter = baseline.find(iter->first);
+
+        if(baselineIter == baseline.end() || baselineIter->second.size() < 2 || iter->second.size() < 2)
+        {
+            fprintf(stderr, "%-40s not in baseline\n", iter->first.c_str());
+            continue;
+        }
+
+        std::vector<double> x = baselineIter->second;
+        std::vector<double> y = iter->second;
+
+        std::sort(x.begin(), x.end());
+        std::sort(y.begin(), y.end());
+
+        double ksPValue = getKolmogorovSmirnovPValue(x, y);
+        double mwPValue = getMannWhitneyPValue(x, y);
+
+        fprintf(stderr, "%-40s %9.4g %9.4g %9.4g %9.4g %9.4g %9.4g %9.3g %9.3g\n", iter->first.c_str(), getQuantile(x, 0.05), getQuantile(x, 0.5), getQuantile(x, 0.95), getQuantile(y, 0.05), getQuantile(y, 0.5), getQuantile(y, 0.95), ksPValue, mwPValue);
+
+        MetricComparison comparison;
+        comparison.name = iter->first;
+
+        comparison.pValue = ksPValue;
+        comparison.test = "Kolmogorov-Smirnov";
+        comparisons.push_back(comparison);
+
+        comparison.pValue = mwPValue;
+        comparison.test = "Mann-Whitney";
+        comparisons.push_back(comparison);
+    }
+
+    // Holm-Bonferroni: reject in order of increasing p-value while p <= alpha / (number of remaining tests)
+    std::sort(comparisons.begin(), comparisons.end(), comparePValues);
+
+    std::vector<double> pValues;
+
+    for(unsigned int i=0; i<comparisons.size(); i++)
+    {
+        pValues.push_back(comparisons[i].pValue);
+    }
+
+    int numRejections = getHolmNumRejections(pValues, alpha);
+
+    std::vector<std::string> differing;
+
+    for(int i=0; i<numRejections; i++)
+    {
+        fprintf(stderr, "DIFFERENT: %s (%s p = %.3g)\n", comparisons[i].name.c_str(), comparisons[i].test.c_str(), comparisons[i].pValue);
+
+        if(std::find(differing.begin(), differing.end(), comparisons[i].name) == differing.end())
+        {
+            differing.push_back(comparisons[i].name);
+        }
+    }
+
+    fprintf(stderr, "%i tests, %i metrics differ at family-wise alpha = %g\n", (int)comparisons.size(), (int)differing.size(), alpha);
+
+    return differing.size();
+}
+
+int main(int argc, char * argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    int numReplicates = EQUIVALENCE_DEFAULT_NUM_REPLICATES;
+    unsigned long firstSeed = 1;
+    std::string recordFilename;
+    std::string baselineFilename;
+    double alpha = EQUIVALENCE_DEFAULT_ALPHA;
+
+    g_dataDirectory = QDir::current().absolutePath().toStdString();
+
+    for(int i=1; i<argc; i++)
+    {
+        std::string arg(argv[i]);
+
+        if(arg == "--replicates" && i+1 < argc)
+        {
+            numReplicates = std::max(2, atoi(argv[++i]));
+        }
+        else if(arg == "--first-seed" && i+1 < argc)
+        {
+            firstSeed = strtoul(argv[++i], NULL, 10);
+        }
+        else if(arg == "--record" && i+1 < argc)
+        {
+            recordFilename = argv[++i];
+        }
+        else if(arg == "--compare" && i+1 < argc)
+        {
+            baselineFilename = argv[++i];
+        }
+        else if(arg == "--alpha" && i+1 < argc)
+        {
+            alpha = atof(argv[++i]);
+        }
+        else if(arg.size() > 0 && arg[0] != '-')
+        {
+            g_dataDirectory = QDir(argv[i]).absolutePath().toStdString();
+        }
+        else
+        {
+            put_flog(LOG_ERROR, "usage: %s [--replicates N] [--first-seed N] [--record FILE] [--compare FILE] [--alpha A] [data directory]", argv[0]);
+            return 1;
+        }
+    }
+
+    if(recordFilename.empty() == true && baselineFilename.empty() == true)
+    {
+        put_flog(LOG_ERROR, "nothing to do: give --record and / or --compare");
+        return 1;
+    }
+
+    // read the baseline first, so a bad filename fails before running
+    Fingerprint baseline;
+
+    if(baselineFilename.empty() != true && readFingerprint(baselineFilename, baseline) != true)
+    {
+        return 1;
+    }
+
+    put_flog(LOG_INFO, "data directory %s, %i replicates from seed %lu", g_dataDirectory.c_str(), numReplicates, firstSeed);
+
+    Fingerprint fingerprint;
+
+    if(runReplicates(numReplicates, firstSeed, fingerprint) != true)
+    {
+        return 1;
+    }
+
+    if(recordFilename.empty() != true && writeFingerprint(recordFilename, fingerprint, firstSeed) != true)
+    {
+        put_flog(LOG_ERROR, "could not write %s", recordFilename.c_str());
+        return 1;
+    }
+
+    log_flush();
+
+    if(baselineFilename.empty() != true && compareFingerprints(baseline, fingerprint, alpha) > 0)
+    {
+        return 2;
+    }
+
+    return 0;
+}
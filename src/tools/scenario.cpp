@@ -0,0 +1,644 @@
+// exercise-scenario: generate a synthetic region with an arbitrary number of nodes, for scaling tests
+//
+// usage: exercise-scenario [options] <output directory>
+//
+//   --nodes N              number of nodes (default 1000, at most REGION_MAX_NODES = 46340)
+//   --groups G             number of groups (HSRs) (default 11)
+//   --mean-population P    mean population per node (default 100000; census tracts are ~4000)
+//   --destinations K       travel destinations per node besides itself (default 20)
+//   --seed S               random seed (default 1)
+//   --source DIR           data directory to take stratifications, risk fractions, contact data and ILI provider pools from
+//                          (default: current directory)
+//   --geometry             also write placeholder county shapes, one square per node
+//
+// the output directory can be used as the data directory of the application and the tools unchanged: it has the
+// same files as the data directory, with nodes in place of counties
+//
+// nodes are clustered around cities, with log-normal populations; travel follows a gravity model (destination
+// population over squared distance; the origin's population only scales its row), truncated to the K strongest
+// destinations, so the travel matrix has the sparsity of real commuting data
+//
+// the travel file is a dense N x N matrix, since that is what the data set reads: it is written row by row, but it
+// is ~2 N^2 bytes on disk and 4 N^2 bytes in memory once loaded (e.g. 4.3 GB and 8.6 GB for 46340 nodes), so the
+// number of nodes is limited to what region data can load
+
+#include "../log.h"
+#include "../RegionData.h"
+#include "../models/disease/ContactMatrix.h"
+#include <QtCore>
+#include <ogrsf_frmts.h>
+#include <boost/tokenizer.hpp>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <stdio.h>
+#include <stdlib.h>
+#include "../models/MersenneTwister.h"
+
+// bounding box of the placeholder geography (longitude, latitude): that of the Texas counties, so maps frame it
+#define SCENARIO_MIN_LONGITUDE -106.6
+#define SCENARIO_MAX_LONGITUDE -93.5
+#define SCENARIO_MIN_LATITUDE 25.8
+#define SCENARIO_MAX_LATITUDE 36.5
+
+// nodes per city cluster, and fraction of nodes outside any cluster
+#define SCENARIO_NODES_PER_CITY 50
+#define SCENARIO_RURAL_FRACTION 0.3
+
+// the largest nodes are travel destinations for every node
+#define SCENARIO_NUM_HUBS 50
+
+// candidate destinations considered per node, as a multiple of the number of destinations kept
+#define SCENARIO_CANDIDATE_FACTOR 4
+
+// age group shares of the population (Texas); the source stratifications must have this many age groups
+static const double ageFractions[] = { 0.076, 0.296, 0.356, 0.164, 0.108 };
+static const int numAgeGroups = sizeof(ageFractions) / sizeof(ageFractions[0]);
+
+struct ScenarioNode
+{
+    int id;
+    double x;
+    double y;
+    int group;
+    std::vector<double> populations;
+    double population;
+};
+
+// options
+static int numNodes = 1000;
+static int numGroups = 11;
+static double meanPopulation = 100000.;
+static int numDestinations = 20;
+static unsigned long seed = 1;
+static std::string sourceDirectory;
+static bool writeGeometry = false;
+
+static int countSourceAgeGroups()
+{
+    std::ifstream in((sourceDirectory + "/stratifications.csv").c_str());
+
+    if(in.is_open() != true)
+    {
+        return -1;
+    }
+
+    typedef boost::tokenizer< boost::escaped_list_separator<char> > Tokenizer;
+
+    // names of the stratifications, then the values of the first one
+    std::string line;
+    getline(in, line);
+    getline(in, line);
+
+    Tokenizer tok(line);
+
+    return std::distance(tok.begin(), tok.end());
+}
+
+static void generateNodes(MTRand &rand, std::vector<ScenarioNode> &nodes)
+{
+    // city centers, with heavy-tailed sizes
+    int numCities = std::max(1, numNodes / SCENARIO_NODES_PER_CITY);
+
+    std::vector<double> cityX(numCities);
+    std::vector<double> cityY(numCities);
+    std::vector<double> cityRadius(numCities);
+
+    for(int c=0; c<numCities; c++)
+    {
+        cityX[c] = rand.randExc();
+        cityY[c] = rand.randExc();
+        cityRadius[c] = 0.3 / sqrt((double)numCities) * exp(rand.randNorm(0., 0.5));
+    }
+
+    // group centers; nodes belong to the nearest one
+    std::vector<double> groupX(numGroups);
+    std::vector<double> groupY(numGroups);
+
+    for(int g=0; g<numGroups; g++)
+    {
+        groupX[g] = rand.randExc();
+        groupY[g] = rand.randExc();
+    }
+
+    nodes.resize(numNodes);
+
+    double totalPopulation = 0.;
+
+    for(int i=0; i<numNodes; i++)
+    {
+        ScenarioNode &node = nodes[i];
+
+        node.id = i + 1;
+
+        if(rand.randExc() < SCENARIO_RURAL_FRACTION)
+        {
+            node.x = rand.randExc();
+            node.y = rand.randExc();
+        }
+        else
+        {
+            int c = rand.randInt(numCities - 1);
+
+            node.x = std::min(1., std::max(0., cityX[c] + rand.randNorm(0., cityRadius[c])));
+            node.y = std::min(1., std::max(0., cityY[c] + rand.randNorm(0., cityRadius[c])));
+        }
+
+        node.group = 0;
+
+        for(int g=1; g<numGroups; g++)
+        {
+            if(pow(node.x - groupX[g], 2.) + pow(node.y - groupY[g], 2.) < pow(node.x - groupX[node.group], 2.) + pow(node.y - groupY[node.group], 2.))
+            {
+                node.group = g;
+            }
+        }
+
+        // log-normal population, normalized below
+        node.population = exp(rand.randNorm(0., 1.2));
+
+        totalPopulation += node.population;
+    }
+
+    for(int i=0; i<numNodes; i++)
+    {
+        ScenarioNode &node = nodes[i];
+
+        node.population = std::max(10., floor(node.population / totalPopulation * meanPopulation * (double)numNodes));
+
+        // age distribution varies a little between nodes
+        double sum = 0.;
+
+        node.populations.resize(numAgeGroups);
+
+        for(int a=0; a<numAgeGroups; a++)
+        {
+            node.populations[a] = ageFractions[a] * std::max(0.1, 1. + rand.randNorm(0., 0.1));
+            sum += node.populations[a];
+        }
+
+        for(int a=0; a<numAgeGroups; a++)
+        {
+            node.populations[a] = floor(node.populations[a] / sum * node.population + 0.5);
+        }
+    }
+}
+
+static bool writeNodeNameGroupFile(std::string filename, const std::vector<ScenarioNode> &nodes)
+{
+    FILE * file = fopen(filename.c_str(), "w");
+
+    if(file == NULL)
+    {
+        return false;
+    }
+
+    fprintf(file, "\"fips\",\"county name\",\"HSR\"\n");
+
+    for(unsigned int i=0; i<nodes.size(); i++)
+    {
+        fprintf(file, "%i,Node %i,HSR %i\n", nodes[i].id, nodes[i].id, nodes[i].group + 1);
+    }
+
+    bool success = (ferror(file) == 0);
+
+    fclose(file);
+
+    return success;
+}
+
+static bool writePopulationFile(std::string filename, const std::vector<ScenarioNode> &nodes)
+{
+    FILE * file = fopen(filename.c_str(), "w");
+
+    if(file == NULL)
+    {
+        return false;
+    }
+
+    fprintf(file, "\"fips\",\"0-4\",\"5-24\",\"25-49\",\"50-64\",\"65+\"\n");
+
+    for(unsigned int i=0; i<nodes.size(); i++)
+    {
+        fprintf(file, "%i", nodes[i].id);
+
+        for(int a=0; a<numAgeGroups; a++)
+        {
+            fprintf(file, ",%.0f", nodes[i].populations[a]);
+        }
+
+        fprintf(file, "\n");
+    }
+
+    bool success = (ferror(file) == 0);
+
+    fclose(file);
+
+    return success;
+}
+
+// gravity model travel: for each node, the fraction of its population traveling to each of its strongest destinations
+static void generateTravel(MTRand &rand, const std::vector<ScenarioNode> &nodes, std::vector<std::vector<std::pair<int, double> > > &travel)
+{
+    // spatial grid with a few nodes per cell, for finding nearby candidates
+    int gridSize = std::max(1, (int)sqrt((double)numNodes / 4.));
+
+    std::vector<std::vector<int> > grid(gridSize * gridSize);
+
+    for(int i=0; i<numNodes; i++)
+    {
+        int gx = std::min(gridSize - 1, (int)(nodes[i].x * gridSize));
+        int gy = std::min(gridSize - 1, (int)(nodes[i].y * gridSize));
+
+        grid[gy * gridSize + gx].push_back(i);
+    }
+
+    // hubs: the largest nodes
+    std::vector<std::pair<double, int> > populations;
+
+    for(int i=0; i<numNodes; i++)
+    {
+        populations.push_back(std::pair<double, int>(nodes[i].population, i));
+    }
+
+    int numHubs = std::min(numNodes, SCENARIO_NUM_HUBS);
+
+    std::partial_sort(populations.begin(), populations.begin() + numHubs, populations.end(), std::greater<std::pair<double, int> >());
+
+    // distances are softened by about a cell, so neighbors in the same cell don't dominate
+    double softening = 0.5 / (double)gridSize;
+
+    int numCandidates = SCENARIO_CANDIDATE_FACTOR * numDestinations;
+
+    travel.resize(numNodes);
+
+    for(int i=0; i<numNodes; i++)
+    {
+        // nearby nodes, in rings of cells of increasing radius
+        std::vector<int> candidates;
+
+        int gx = std::min(gridSize - 1, (int)(nodes[i].x * gridSize));
+        int gy = std::min(gridSize - 1, (int)(nodes[i].y * gridSize));
+
+        for(int r=0; r<gridSize && (int)candidates.size() < numCandidates; r++)
+        {
+            for(int y=gy-r; y<=gy+r; y++)
+            {
+                for(int x=gx-r; x<=gx+r; x++)
+                {
+                    // only the ring
+                    if(x < 0 || y < 0 || x >= gridSize || y >= gridSize || (abs(x - gx) != r && abs(y - gy) != r))
+                    {
+                        continue;
+                    }
+
+                    const std::vector<int> &cell = grid[y * gridSize + x];
+
+                    candidates.insert(candidates.end(), cell.begin(), cell.end());
+                }
+            }
+        }
+
+        for(int h=0; h<numHubs; h++)
+        {
+            candidates.push_back(populations[h].second);
+        }
+
+        std::sort(candidates.begin(), candidates.end());
+        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+        // gravity weights
+        std::vector<std::pair<double, int> > weights;
+
+        for(unsigned int c=0; c<candidates.size(); c++)
+        {
+            int j = candidates[c];
+
+            if(j == i)
+            {
+                continue;
+            }
+
+            double distance = sqrt(pow(nodes[i].x - nodes[j].x, 2.) + pow(nodes[i].y - nodes[j].y, 2.)) + softening;
+
+            weights.push_back(std::pair<double, int>(nodes[j].population / (distance * distance), j));
+        }
+
+        int numKept = std::min<int>(numDestinations, weights.size());
+
+        std::partial_sort(weights.begin(), weights.begin() + numKept, weights.end(), std::greater<std::pair<double, int> >());
+
+        double weightSum = 0.;
+
+        for(int k=0; k<numKept; k++)
+        {
+            weightSum += weights[k].first;
+        }
+
+        // 5% - 25% of the population travels; the rest stays
+        double travelingFraction = (weightSum > 0.) ? 0.05 + 0.2 * rand.randExc() : 0.;
+
+        travel[i].push_back(std::pair<int, double>(i, 1. - travelingFraction));
+
+        for(int k=0; k<numKept; k++)
+        {
+            travel[i].push_back(std::pair<int, double>(weights[k].second, travelingFraction * weights[k].first / weightSum));
+        }
+
+        std::sort(travel[i].begin(), travel[i].end());
+    }
+}
+
+static bool writeTravelFile(std::string filename, const std::vector<std::vector<std::pair<int, double> > > &travel)
+{
+    FILE * file = fopen(filename.c_str(), "w");
+
+    if(file == NULL)
+    {
+        return false;
+    }
+
+    fprintf(file, "# fraction of population traveling from county to county\n");
+
+    // a run of zeros, copied between the nonzero values of each row
+    std::string zeros;
+
+    for(int j=0; j<numNodes; j++)
+    {
+        zeros += "0,";
+    }
+
+    std::string row;
+    char value[32];
+
+    for(int i=0; i<numNodes; i++)
+    {
+        row.clear();
+
+        int column = 0;
+
+        for(unsigned int k=0; k<travel[i].size(); k++)
+        {
+            row.append(zeros, 0, 2 * (travel[i][k].first - column));
+
+            snprintf(value, sizeof(value), "%.9g,", travel[i][k].second);
+            row += value;
+
+            column = travel[i][k].first + 1;
+        }
+
+        row.append(zeros, 0, 2 * (numNodes - column));
+
+        // no separator after the last value
+        row[row.size() - 1] = '\n';
+
+        fwrite(row.data(), 1, row.size(), file);
+
+        if(i % 10000 == 9999)
+        {
+            put_flog(LOG_INFO, "wrote %i / %i travel rows", i + 1, numNodes);
+        }
+    }
+
+    bool success = (ferror(file) == 0);
+
+    fclose(file);
+
+    return success;
+}
+
+static bool writeIliProvidersFile(MTRand &rand, std::string filename, const std::vector<ScenarioNode> &nodes)
+{
+    // about one provider per 100000 people, as in the Texas data
+    FILE * file = fopen(filename.c_str(), "w");
+
+    if(file == NULL)
+    {
+        return false;
+    }
+
+    for(unsigned int i=0; i<nodes.size(); i++)
+    {
+        double expected = nodes[i].population / 100000.;
+
+        int numProviders = (int)floor(expected) + ((rand.randExc() < expected - floor(expected)) ? 1 : 0);
+
+        fprintf(file, "%i\n", numProviders);
+    }
+
+    bool success = (ferror(file) == 0);
+
+    fclose(file);
+
+    return success;
+}
+
+// one square per node, in a shapefile with the same name and fields as the county shapes
+static bool writeGeometryFiles(std::string directory, const std::vector<ScenarioNode> &nodes)
+{
+    OGRRegisterAll();
+
+    OGRSFDriver * driver = OGRSFDriverRegistrar::GetRegistrar()->GetDriverByName("ESRI Shapefile");
+
+    if(driver == NULL)
+    {
+        put_flog(LOG_ERROR, "no shapefile driver");
+        return false;
+    }
+
+    std::string filename = directory + "/tl_2009_48_county00.shp";
+
+    OGRDataSource * dataSource = driver->CreateDataSource(filename.c_str(), NULL);
+
+    if(dataSource == NULL)
+    {
+        put_flog(LOG_ERROR, "could not create %s", filename.c_str());
+        return false;
+    }
+
+    OGRLayer * layer = dataSource->CreateLayer("tl_2009_48_county00", NULL, wkbPolygon, NULL);
+
+    OGRFieldDefn field("COUNTYFP00", OFTInteger);
+
+    if(layer == NULL || layer->CreateField(&field) != OGRERR_NONE)
+    {
+        put_flog(LOG_ERROR, "could not create layer");
+        OGRDataSource::DestroyDataSource(dataSource);
+        return false;
+    }
+
+    // squares about the size of a node's share of the area
+    double halfWidth = 0.4 / sqrt((double)numNodes) * (SCENARIO_MAX_LONGITUDE - SCENARIO_MIN_LONGITUDE);
+    double halfHeight = 0.4 / sqrt((double)numNodes) * (SCENARIO_MAX_LATITUDE - SCENARIO_MIN_LATITUDE);
+
+    bool success = true;
+
+    for(unsigned int i=0; i<nodes.size() && success == true; i++)
+    {
+        double longitude = SCENARIO_MIN_LONGITUDE + nodes[i].x * (SCENARIO_MAX_LONGITUDE - SCENARIO_MIN_LONGITUDE);
+        double latitude = SCENARIO_MIN_LATITUDE + nodes[i].y * (SCENARIO_MAX_LATITUDE - SCENARIO_MIN_LATITUDE);
+
+        OGRLinearRing ring;
+        ring.addPoint(longitude - halfWidth, latitude - halfHeight);
+        ring.addPoint(longitude + halfWidth, latitude - halfHeight);
+        ring.addPoint(longitude + halfWidth, latitude + halfHeight);
+        ring.addPoint(longitude - halfWidth, latitude + halfHeight);
+        ring.closeRings();
+
+        OGRPolygon polygon;
+        polygon.addRing(&ring);
+
+        OGRFeature * feature = OGRFeature::CreateFeature(layer->GetLayerDefn());
+        feature->SetField("COUNTYFP00", nodes[i].id);
+        feature->SetGeometry(&polygon);
+
+        success = (layer->CreateFeature(feature) == OGRERR_NONE);
+
+        OGRFeature::DestroyFeature(feature);
+    }
+
+    OGRDataSource::DestroyDataSource(dataSource);
+
+    return success;
+}
+
+// copy a file that doesn't depend on the nodes from the source directory
+static bool copySourceFile(std::string name, std::string outputDirectory)
+{
+    std::string source = sourceDirectory + "/" + name;
+    std::string destination = outputDirectory + "/" + name;
+
+    QFile::remove(destination.c_str());
+
+    if(QFile::copy(source.c_str(), destination.c_str()) != true)
+    {
+        put_flog(LOG_ERROR, "could not copy %s to %s", source.c_str(), destination.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char * argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    std::string outputDirectory;
+
+    sourceDirectory = QDir::current().absolutePath().toStdString();
+
+    for(int i=1; i<argc; i++)
+    {
+        std::string arg(argv[i]);
+
+        if(arg == "--nodes" && i+1 < argc)
+        {
+            numNodes = atoi(argv[++i]);
+        }
+        else if(arg == "--groups" && i+1 < argc)
+        {
+            numGroups = atoi(argv[++i]);
+        }
+        else if(arg == "--mean-population" && i+1 < argc)
+        {
+            meanPopulation = atof(argv[++i]);
+        }
+        else if(arg == "--destinations" && i+1 < argc)
+        {
+            numDestinations = atoi(argv[++i]);
+        }
+        else if(arg == "--seed" && i+1 < argc)
+        {
+            seed = strtoul(argv[++i], NULL, 10);
+        }
+        else if(arg == "--source" && i+1 < argc)
+        {
+            sourceDirectory = QDir(argv[++i]).absolutePath().toStdString();
+        }
+        else if(arg == "--geometry")
+        {
+            writeGeometry = true;
+        }
+        else if(arg.size() > 0 && arg[0] != '-' && outputDirectory.empty() == true)
+        {
+            outputDirectory = QDir(argv[i]).absolutePath().toStdString();
+        }
+        else
+        {
+            outputDirectory.clear();
+            break;
+        }
+    }
+
+    if(outputDirectory.empty() == true || numNodes < 2 || numGroups < 1 || numGroups > numNodes || numDestinations < 0 || meanPopulation < 1.)
+    {
+        put_flog(LOG_ERROR, "usage: %s [--nodes N] [--groups G] [--mean-population P] [--destinations K] [--seed S] [--source DIR] [--geometry] <output directory>", argv[0]);
+        return 1;
+    }
+
+    if(countSourceAgeGroups() != numAgeGroups)
+    {
+        put_flog(LOG_ERROR, "expected %i age groups in %s/stratifications.csv", numAgeGroups, sourceDirectory.c_str());
+        return 1;
+    }
+
+    if(numNodes > REGION_MAX_NODES)
+    {
+        put_flog(LOG_ERROR, "region data can load at most %i nodes", REGION_MAX_NODES);
+        return 1;
+    }
+
+    if(numNodes > 20000)
+    {
+        put_flog(LOG_WARN, "the dense travel file for %i nodes is about %.1f GB", numNodes, 2. * (double)numNodes * (double)numNodes / 1e9);
+    }
+
+    QDir directory;
+
+    if(directory.mkpath((outputDirectory + "/ILI").c_str()) != true || (writeGeometry == true && directory.mkpath((outputDirectory + "/counties").c_str()) != true))
+    {
+        put_flog(LOG_ERROR, "could not create %s", outputDirectory.c_str());
+        return 1;
+    }
+
+    MTRand rand((MTRand::uint32)seed);
+
+    put_flog(LOG_INFO, "generating %i nodes in %i groups", numNodes, numGroups);
+
+    std::vector<ScenarioNode> nodes;
+    generateNodes(rand, nodes);
+
+    std::vector<std::vector<std::pair<int, double> > > travel;
+    generateTravel(rand, nodes, travel);
+
+    if(writeNodeNameGroupFile(outputDirectory + "/fips_county_names_HSRs.csv", nodes) != true
+        || writePopulationFile(outputDirectory + "/fips_age_group_populations.csv", nodes) != true
+        || writeIliProvidersFile(rand, outputDirectory + "/ILI/numCountyProviders.txt", nodes) != true
+        || writeTravelFile(outputDirectory + "/county_travel_fractions.csv", travel) != true)
+    {
+        put_flog(LOG_ERROR, "could not write scenario files to %s", outputDirectory.c_str());
+        return 1;
+    }
+
+    if(copySourceFile("stratifications.csv", outputDirectory) != true
+        || copySourceFile("age_groups_low_risk_fraction.csv", outputDirectory) != true
+        || copySourceFile("ILI/providerStartProbabilities.txt", outputDirectory) != true
+        || copySourceFile("ILI/providerStopProbabilities.txt", outputDirectory) != true
+        || copySourceFile("ILI/providerNoiseData.txt", outputDirectory) != true
+        || copySourceFile(CONTACT_MATRIX_FILENAME, outputDirectory) != true
+        || copySourceFile(CONTACT_MATRIX_SUSCEPTIBILITIES_FILENAME, outputDirectory) != true)
+    {
+        return 1;
+    }
+
+    if(writeGeometry == true && writeGeometryFiles(outputDirectory + "/counties", nodes) != true)
+    {
+        put_flog(LOG_ERROR, "could not write geometry");
+        return 1;
+    }
+
+    put_flog(LOG_INFO, "wrote scenario to %s", outputDirectory.c_str());
+
+    return 0;
+}
@@ -0,0 +1,306 @@
+// exercise-sweep: parameter sweeps of the reference scenario, run on all cores
+//
+// usage: exercise-sweep [options] --output FILE [data directory]
+//
+//   --parameter NAME:MIN:MAX[:LEVELS]   swept parameter and its range; may be repeated
+//                                       names are those of Parameters::getValueNames() (R0, betaScale, tau, ...)
+//   --design grid|lhs      full factorial grid over the parameter levels, or a Latin hypercube (default grid)
+//   --levels N             levels of parameters given without LEVELS, for grid designs (default 5)
+//   --points N             design points of a Latin hypercube (default 50)
+//   --design-seed N        seed of the Latin hypercube (default 1)
+//   --replicates N         replicates of each design point (default 10)
+//   --days N               simulated days (default 120)
+//   --first-seed N         seed of the first replicate; replicate r uses first-seed + r at every point (default 1)
+//   --curves               also record the daily curve of all infected in each group (training data for exercise-emulator)
+//   --threads N            worker threads (default: number of cores)
+//   --output FILE          binary result file; running again with the same file and options resumes the sweep
+//   --csv FILE             write the mean and standard deviation of each metric at each design point to FILE
+//
+// with --csv and no --parameter, an existing result file is only summarized
+// parameters not swept keep their defaults
+
+#include "../main.h"
+#include "../EpidemicSimulation.h"
+#include "../Parameters.h"
+#include "../ParameterSweep.h"
+#include "../models/disease/StochasticSEATIRD.h"
+#include "../log.h"
+#include "ReferenceScenario.h"
+#include <QtCore>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define SWEEP_DEFAULT_NUM_LEVELS 5
+#define SWEEP_DEFAULT_NUM_POINTS 50
+
+std::string g_dataDirectory;
+
+static bool parseRange(std::string spec, int defaultLevels, ParameterSweepRange &range)
+{
+    QStringList fields = QString(spec.c_str()).split(':');
+
+    if(fields.size() != 3 && fields.size() != 4)
+    {
+        put_flog(LOG_ERROR, "expected NAME:MIN:MAX[:LEVELS], got %s", spec.c_str());
+        return false;
+    }
+
+    bool ok[3] = { true, true, true };
+
+    range.name = fields[0].toStdString();
+    range.min = fields[1].toDouble(&ok[0]);
+    range.max = fields[2].toDouble(&ok[1]);
+    range.levels = defaultLevels;
+
+    if(fields.size() == 4)
+    {
+        range.levels = fields[3].toInt(&ok[2]);
+    }
+
+    if(ok[0] != true || ok[1] != true || ok[2] != true)
+    {
+        put_flog(LOG_ERROR, "could not parse %s", spec.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+// one row per design point: parameter values, number of completed replicates, then mean and standard deviation of each metric
+static bool writeSummary(std::string cubeFilename, std::string filename)
+{
+    ParameterSweepCube cube;
+
+    if(cube.open(cubeFilename) != true)
+    {
+        return false;
+    }
+
+    FILE * file = fopen(filename.c_str(), "w");
+
+    if(file == NULL)
+    {
+        put_flog(LOG_ERROR, "could not open %s", filename.c_str());
+        return false;
+    }
+
+    std::vector<std::string> parameterNames = cube.getParameterNames();
+    std::vector<std::vector<double> > designPoints = cube.getDesignPoints();
+    std::vector<std::string> metricNames = cube.getMetricNames();
+
+    for(unsigned int i=0; i<parameterNames.size(); i++)
+    {
+        fprintf(file, "%s,", parameterNames[i].c_str());
+    }
+
+    fprintf(file, "replicates");
+
+    for(unsigned int m=0; m<metricNames.size(); m++)
+    {
+        fprintf(file, ",%s_mean,%s_sd", metricNames[m].c_str(), metricNames[m].c_str());
+    }
+
+    fprintf(file, "\n");
+
+    for(unsigned int p=0; p<designPoints.size(); p++)
+    {
+        for(unsigned int i=0; i<designPoints[p].size(); i++)
+        {
+            fprintf(file, "%.9g,", designPoints[p][i]);
+        }
+
+        int numComplete = 0;
+
+        for(int r=0; r<cube.getNumReplicates(); r++)
+        {
+            if(cube.isComplete(p, r) == true)
+            {
+                numComplete++;
+            }
+        }
+
+        fprintf(file, "%i", numComplete);
+
+        for(unsigned int m=0; m<metricNames.size(); m++)
+        {
+            double mean, standardDeviation;
+
+            if(cube.getSummary(p, m, mean, standardDeviation) == true)
+            {
+                fprintf(file, ",%.9g,%.9g", mean, standardDeviation);
+            }
+            else
+            {
+                fprintf(file, ",,");
+            }
+        }
+
+        fprintf(file, "\n");
+    }
+
+    bool success = (ferror(file) == 0);
+
+    fclose(file);
+
+    put_flog(LOG_INFO, "wrote %i design points to %s", (int)designPoints.size(), filename.c_str());
+
+    return success;
+}
+
+int main(int argc, char * argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    std::vector<std::string> rangeSpecs;
+    std::string design = "grid";
+    int numLevels = SWEEP_DEFAULT_NUM_LEVELS;
+    int numPoints = SWEEP_DEFAULT_NUM_POINTS;
+    unsigned long designSeed = 1;
+    int numReplicates = PARAMETER_SWEEP_DEFAULT_NUM_REPLICATES;
+    int numDays = PARAMETER_SWEEP_DEFAULT_NUM_DAYS;
+    unsigned long firstSeed = 1;
+    bool recordCurves = false;
+    int numThreads = QThread::idealThreadCount();
+    std::string outputFilename;
+    std::string csvFilename;
+
+    g_dataDirectory = QDir::current().absolutePath().toStdString();
+
+    for(int i=1; i<argc; i++)
+    {
+        std::string arg(argv[i]);
+
+        if(arg == "--parameter" && i+1 < argc)
+        {
+            rangeSpecs.push_back(argv[++i]);
+        }
+        else if(arg == "--design" && i+1 < argc)
+        {
+            design = argv[++i];
+        }
+        else if(arg == "--levels" && i+1 < argc)
+        {
+            numLevels = std::max(1, atoi(argv[++i]));
+        }
+        else if(arg == "--points" && i+1 < argc)
+        {
+            numPoints = std::max(1, atoi(argv[++i]));
+        }
+        else if(arg == "--design-seed" && i+1 < argc)
+        {
+            designSeed = strtoul(argv[++i], NULL, 10);
+        }
+        else if(arg == "--replicates" && i+1 < argc)
+        {
+            numReplicates = std::max(1, atoi(argv[++i]));
+        }
+        else if(arg == "--days" && i+1 < argc)
+        {
+            numDays = std::max(1, atoi(argv[++i]));
+        }
+        else if(arg == "--first-seed" && i+1 < argc)
+        {
+            firstSeed = strtoul(argv[++i], NULL, 10);
+        }
+        else if(arg == "--curves")
+        {
+            recordCurves = true;
+        }
+        else if(arg == "--threads" && i+1 < argc)
+        {
+            numThreads = std::max(1, atoi(argv[++i]));
+        }
+        else if(arg == "--output" && i+1 < argc)
+        {
+            outputFilename = argv[++i];
+        }
+        else if(arg == "--csv" && i+1 < argc)
+        {
+            csvFilename = argv[++i];
+        }
+        else if(arg.size() > 0 && arg[0] != '-')
+        {
+            g_dataDirectory = QDir(argv[i]).absolutePath().toStdString();
+        }
+        else
+        {
+            put_flog(LOG_ERROR, "usage: %s [--parameter NAME:MIN:MAX[:LEVELS]]... [--design grid|lhs] [--levels N] [--points N] [--design-seed N] [--replicates N] [--days N] [--first-seed N] [--curves] [--threads N] --output FILE [--csv FILE] [data directory]", argv[0]);
+            return 1;
+        }
+    }
+
+    if(outputFilename.empty() == true)
+    {
+        put_flog(LOG_ERROR, "no result file given (--output)");
+        return 1;
+    }
+
+    if(design != "grid" && design != "lhs")
+    {
+        put_flog(LOG_ERROR, "unknown design %s", design.c_str());
+        return 1;
+    }
+
+    bool complete = true;
+
+    if(rangeSpecs.size() > 0)
+    {
+        std::vector<ParameterSweepRange> ranges;
+
+        for(unsigned int i=0; i<rangeSpecs.size(); i++)
+        {
+            ParameterSweepRange range;
+
+            if(parseRange(rangeSpecs[i], numLevels, range) != true)
+            {
+                return 1;
+            }
+
+            ranges.push_back(range);
+        }
+
+        ParameterSweep sweep;
+
+        bool designed;
+
+        if(design == "grid")
+        {
+            designed = sweep.setGridDesign(ranges);
+        }
+        else
+        {
+            designed = sweep.setLatinHypercubeDesign(ranges, numPoints, designSeed);
+        }
+
+        if(designed != true)
+        {
+            return 1;
+        }
+
+        sweep.setNumReplicates(numReplicates);
+        sweep.setNumDays(numDays);
+        sweep.setFirstSeed(firstSeed);
+        sweep.setRecordCurves(recordCurves);
+
+        put_flog(LOG_INFO, "data directory %s", g_dataDirectory.c_str());
+
+        // replicates are copies of one initial simulation, so the data are only loaded once
+        boost::shared_ptr<EpidemicSimulation> initialSimulation(new StochasticSEATIRD());
+
+        complete = sweep.run(outputFilename, initialSimulation, g_parameters, exposeReferenceScenarioCases, numThreads);
+    }
+    else if(csvFilename.empty() == true)
+    {
+        put_flog(LOG_ERROR, "nothing to do: give --parameter and / or --csv");
+        return 1;
+    }
+
+    if(csvFilename.empty() != true && writeSummary(outputFilename, csvFilename) != true)
+    {
+        return 1;
+    }
+
+    log_flush();
+
+    return (complete == true) ? 0 : 1;
+}